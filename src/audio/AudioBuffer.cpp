@@ -32,6 +32,7 @@ namespace avg {
 
 AudioBuffer::AudioBuffer(int numFrames, AudioParams ap)
     : m_NumFrames(numFrames),
+      m_MaxFrames(numFrames),
       m_AP(ap)
 {
     m_pData = new short[numFrames*sizeof(short)*ap.m_Channels];
@@ -77,6 +78,16 @@ void AudioBuffer::clear()
     memset(m_pData, 0, m_NumFrames*sizeof(short)*m_AP.m_Channels);
 }
 
+void AudioBuffer::setNumFrames(int numFrames)
+{
+    if (numFrames > m_MaxFrames) {
+        delete[] m_pData;
+        m_pData = new short[numFrames*sizeof(short)*m_AP.m_Channels];
+        m_MaxFrames = numFrames;
+    }
+    m_NumFrames = numFrames;
+}
+
 void AudioBuffer::volumize(float lastVol, float curVol)
 {
     float volDiff = lastVol - curVol;
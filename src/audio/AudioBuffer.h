@@ -45,11 +45,16 @@ class AVG_API AudioBuffer
         int getNumChannels();
         int getRate();
         void clear();
+        // Changes the number of frames. The memory is only reallocated if the buffer
+        // grows beyond its largest size so far, so buffers can be reused cheaply. The
+        // contents are undefined afterwards.
+        void setNumFrames(int numFrames);
 
         void volumize(float lastVol, float curVol);
 
     private:
         int m_NumFrames;
+        int m_MaxFrames;
         short* m_pData;
         AudioParams m_AP;
 };
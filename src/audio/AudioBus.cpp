@@ -0,0 +1,134 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "AudioBus.h"
+
+#include "Dynamics.h"
+#include "AudioMix.h"
+
+#include "../base/Exception.h"
+#include "../base/StringHelper.h"
+
+#include <cstring>
+
+namespace avg {
+
+template<int CHANNELS>
+static IProcessor<float>* createDynamics(float sampleRate)
+{
+    Dynamics<float, CHANNELS>* pLimiter = new Dynamics<float, CHANNELS>(sampleRate);
+    pLimiter->setThreshold(0.f); // in dB
+    pLimiter->setAttackTime(0.f); // in seconds
+    pLimiter->setReleaseTime(0.05f); // in seconds
+    pLimiter->setRmsTime(0.f); // in seconds
+    pLimiter->setRatio(std::numeric_limits<float>::infinity());
+    pLimiter->setMakeupGain(0.f); // in dB
+    return pLimiter;
+}
+
+static IProcessor<float>* createLimiter(int channels, float sampleRate)
+{
+    switch (channels) {
+        case 1:
+            return createDynamics<1>(sampleRate);
+        case 2:
+            return createDynamics<2>(sampleRate);
+        case 3:
+            return createDynamics<3>(sampleRate);
+        case 4:
+            return createDynamics<4>(sampleRate);
+        case 5:
+            return createDynamics<5>(sampleRate);
+        case 6:
+            return createDynamics<6>(sampleRate);
+        case 7:
+            return createDynamics<7>(sampleRate);
+        case 8:
+            return createDynamics<8>(sampleRate);
+        default:
+            throw Exception(AVG_ERR_UNSUPPORTED, "Unsupported number of audio channels: "
+                    + toString(channels) + ".");
+    }
+}
+
+AudioBus::AudioBus(const AudioParams& ap, float gain, bool bLimiterEnabled)
+    : m_Channels(ap.m_Channels),
+      m_bLimiterEnabled(bLimiterEnabled),
+      m_Gain(gain),
+      m_LastGain(gain)
+{
+    m_pLimiter = createLimiter(m_Channels, float(ap.m_SampleRate));
+    m_pBuffer = new float[ap.m_OutputBufferSamples*m_Channels];
+}
+
+AudioBus::~AudioBus()
+{
+    delete m_pLimiter;
+    delete[] m_pBuffer;
+}
+
+void AudioBus::setGain(float gain)
+{
+    m_Gain = gain;
+}
+
+float AudioBus::getGain() const
+{
+    return m_Gain;
+}
+
+void AudioBus::setLimiterEnabled(bool bEnabled)
+{
+    m_bLimiterEnabled = bEnabled;
+}
+
+bool AudioBus::isLimiterEnabled() const
+{
+    return m_bLimiterEnabled;
+}
+
+float* AudioBus::getBuffer()
+{
+    return m_pBuffer;
+}
+
+void AudioBus::clear(int numFrames)
+{
+    memset(m_pBuffer, 0, numFrames*m_Channels*sizeof(float));
+}
+
+void AudioBus::process(int numFrames)
+{
+    float gain = m_Gain;
+    applyGainRamp(m_pBuffer, numFrames, m_Channels, m_LastGain, gain);
+    m_LastGain = gain;
+    if (m_bLimiterEnabled) {
+        m_pLimiter->processBlock(m_pBuffer, numFrames);
+    }
+}
+
+void AudioBus::mixInto(float* pDest, int numFrames, const int* pChannelMap)
+{
+    addChannels(pDest, m_pBuffer, numFrames, m_Channels, pChannelMap);
+}
+
+}
@@ -0,0 +1,70 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _AudioBus_H_
+#define _AudioBus_H_
+
+#include "../api.h"
+#include "AudioParams.h"
+#include "IProcessor.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
+
+namespace avg {
+
+// Node of the AudioEngine mix graph. A bus sums the sources and buses routed to it,
+// applies its gain and optionally a limiter and passes the result on to its output
+// bus. The master bus goes to the audio device.
+class AVG_API AudioBus
+{
+public:
+    AudioBus(const AudioParams& ap, float gain, bool bLimiterEnabled);
+    virtual ~AudioBus();
+
+    // These are called from the main thread and never block the audio thread.
+    void setGain(float gain);
+    float getGain() const;
+    void setLimiterEnabled(bool bEnabled);
+    bool isLimiterEnabled() const;
+
+    // Called in the audio callback.
+    float* getBuffer();
+    void clear(int numFrames);
+    void process(int numFrames);
+    // Adds the bus contents to pDest. pChannelMap is as in addChannels().
+    void mixInto(float* pDest, int numFrames, const int* pChannelMap);
+
+private:
+    int m_Channels;
+    float* m_pBuffer;
+    IProcessor<float>* m_pLimiter;
+    boost::atomic<bool> m_bLimiterEnabled;
+    boost::atomic<float> m_Gain;
+    float m_LastGain;
+};
+
+typedef boost::shared_ptr<AudioBus> AudioBusPtr;
+
+}
+
+#endif
@@ -23,12 +23,18 @@
 
 #include "AudioEngine.h"
 
-#include "Dynamics.h"
+#include "AudioMix.h"
+#include "SDLAudioOutput.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
+#include "../base/StringHelper.h"
+
+#include <boost/thread/thread.hpp>
 
 #include <iostream>
+#include <cstring>
+#include <algorithm>
 
 using namespace std;
 using namespace boost;
@@ -42,28 +48,32 @@ AudioEngine* AudioEngine::get()
     return s_pInstance;
 }
 
-AudioEngine::AudioEngine()
-    : m_pTempBuffer(),
-      m_pMixBuffer(0),
-      m_pLimiter(0),
+AudioEngine::AudioEngine(AudioOutputPtr pOutput)
+    : m_pOutput(pOutput),
+      m_pTempBuffer(),
       m_bEnabled(true),
+      m_NextBusID(0),
+      m_pGraph(new AudioMixGraph),
+      m_pMixingGraph(0),
+      m_NextSampleID(0),
       m_Volume(1)
 {
     AVG_ASSERT(s_pInstance == 0);
-    if (SDL_InitSubSystem(SDL_INIT_AUDIO) == -1) {
-        AVG_LOG_ERROR("Can't init SDL audio subsystem.");
-        exit(-1);
+    if (!m_pOutput) {
+        m_pOutput = AudioOutputPtr(new SDLAudioOutput());
     }
     s_pInstance = this;
 }
 
 AudioEngine::~AudioEngine()
 {
-    if (m_pMixBuffer) {
-        delete[] m_pMixBuffer;
-    }
-    SDL_QuitSubSystem(SDL_INIT_AUDIO);
     m_AudioSources.clear();
+    m_Buses.clear();
+    deleteRetiredGraphs(true);
+    delete m_pGraph.load();
+    m_pOutput = AudioOutputPtr();
+    m_SamplePlayer.reset();
+    s_pInstance = 0;
 }
 
 int AudioEngine::getChannels()
@@ -87,140 +97,330 @@ const AudioParams * AudioEngine::getParams()
 
 void AudioEngine::init(const AudioParams& ap, float volume) 
 {
+    if (ap.m_Channels < 1 || ap.m_Channels > AVG_MAX_AUDIO_CHANNELS) {
+        throw Exception(AVG_ERR_UNSUPPORTED, "Unsupported number of audio channels: "
+                + toString(ap.m_Channels) + ".");
+    }
     m_Volume = volume;
     m_AP = ap;
-    Dynamics<float, 2>* pLimiter = new Dynamics<float, 2>(float(m_AP.m_SampleRate));
-    pLimiter->setThreshold(0.f); // in dB
-    pLimiter->setAttackTime(0.f); // in seconds
-    pLimiter->setReleaseTime(0.05f); // in seconds
-    pLimiter->setRmsTime(0.f); // in seconds
-    pLimiter->setRatio(std::numeric_limits<float>::infinity());
-    pLimiter->setMakeupGain(0.f); // in dB
-    m_pLimiter = pLimiter;
-    
-    SDL_AudioSpec desired;
-    desired.freq = m_AP.m_SampleRate;
-    desired.format = AUDIO_S16SYS;
-    desired.channels = m_AP.m_Channels;
-    desired.silence = 0;
-    desired.samples = m_AP.m_OutputBufferSamples;
-    desired.callback = audioCallback;
-    desired.userdata = this;
-
-    int err = SDL_OpenAudio(&desired, 0);
-    if (err < 0) {
-        static bool bWarned = false;
-        if (!bWarned) {
-            AVG_TRACE(Logger::category::CONFIG, Logger::severity::WARNING,
-                    "Can't open audio: " << SDL_GetError());
-            bWarned = true;
-        }
+
+    // The callback mixes in chunks of this size, so it never needs to allocate.
+    m_pTempBuffer = AudioBufferPtr(new AudioBuffer(m_AP.m_OutputBufferSamples, m_AP));
+    {
+        lock_guard lock(m_Mutex);
+        m_Buses.clear();
+        BusInfo& master = m_Buses[0];
+        master.m_pBus = AudioBusPtr(new AudioBus(m_AP, m_Volume, true));
+        master.m_OutputBusID = -1;
+        m_NextBusID = 1;
+        publishGraph();
     }
+    
+    m_pOutput->open(m_AP, audioCallback, this);
 }
 
 void AudioEngine::teardown()
 {
-    {
-        lock_guard lock(m_Mutex);
-        SDL_PauseAudio(1);
-    }
+    // Waits for a running callback to finish.
+    m_pOutput->lock();
+    m_pOutput->setPaused(true);
+    m_pOutput->unlock();
     // Optimized away - takes too long.
 //    SDL_CloseAudio();
 
+    lock_guard lock(m_Mutex);
     m_AudioSources.clear();
-    if (m_pLimiter) {
-        delete m_pLimiter;
-        m_pLimiter = 0;
-    }
+    m_SourceBusIDs.clear();
+    m_Buses.clear();
+    publishGraph();
+    deleteRetiredGraphs(true);
+    m_SamplePlayer.reset();
+    m_Samples.clear();
+    m_pRetiredSamples.clear();
 }
 
 void AudioEngine::setAudioEnabled(bool bEnabled)
 {
-    SDL_LockAudio();
-    lock_guard lock(m_Mutex);
-    AVG_ASSERT(m_AudioSources.empty());
-    m_bEnabled = bEnabled;
-    if (m_bEnabled) {
-        play();
-    } else {
-        pause();
+    m_pOutput->lock();
+    {
+        lock_guard lock(m_Mutex);
+        AVG_ASSERT(m_AudioSources.empty());
+        m_bEnabled = bEnabled;
+        if (m_bEnabled) {
+            play();
+        } else {
+            pause();
+        }
     }
-    SDL_UnlockAudio();
+    m_pOutput->unlock();
 }
 
 void AudioEngine::play()
 {
-    SDL_PauseAudio(0);
+    m_pOutput->setPaused(false);
 }
 
 void AudioEngine::pause()
 {
-    SDL_PauseAudio(1);
+    m_pOutput->setPaused(true);
 }
 
 int AudioEngine::addSource(AudioMsgQueue& dataQ, AudioMsgQueue& statusQ)
 {
-    SDL_LockAudio();
     lock_guard lock(m_Mutex);
     static int nextID = -1;
     nextID++;
     AudioSourcePtr pSrc(new AudioSource(dataQ, statusQ, m_AP.m_SampleRate));
     m_AudioSources[nextID] = pSrc;
-    SDL_UnlockAudio();
+    m_SourceBusIDs[nextID] = 0;
+    publishGraph();
     return nextID;
 }
 
 void AudioEngine::removeSource(int id)
 {
-    SDL_LockAudio();
     lock_guard lock(m_Mutex);
     int numErased = m_AudioSources.erase(id);
     AVG_ASSERT(numErased == 1);
-    SDL_UnlockAudio();
+    m_SourceBusIDs.erase(id);
+    publishGraph();
+    // The source references the caller's queues, which may be deleted as soon as this
+    // returns. Wait until the callback has stopped mixing the graphs that contain it.
+    while (!m_pRetiredGraphs.empty()) {
+        boost::this_thread::yield();
+        deleteRetiredGraphs(false);
+    }
 }
 
 void AudioEngine::pauseSource(int id)
 {
     lock_guard lock(m_Mutex);
-    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
-    AVG_ASSERT(itSource != m_AudioSources.end());
-    AudioSourcePtr pSource = itSource->second;
-    pSource->pause();
+    getSource(id)->pause();
 }
 
 void AudioEngine::playSource(int id)
 {
     lock_guard lock(m_Mutex);
-    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
-    AVG_ASSERT(itSource != m_AudioSources.end());
-    AudioSourcePtr pSource = itSource->second;
-    pSource->play();
+    getSource(id)->play();
 }
 
 void AudioEngine::notifySeek(int id)
 {
     lock_guard lock(m_Mutex);
-    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
-    AVG_ASSERT(itSource != m_AudioSources.end());
-    AudioSourcePtr pSource = itSource->second;
-    pSource->notifySeek();
+    getSource(id)->notifySeek();
 }
 
 void AudioEngine::setSourceVolume(int id, float volume)
 {
     lock_guard lock(m_Mutex);
-    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
-    AVG_ASSERT(itSource != m_AudioSources.end());
-    AudioSourcePtr pSource = itSource->second;
-    pSource->setVolume(volume);
+    getSource(id)->setVolume(volume);
+}
+
+// Side of each channel in the default channel layouts: -1 is left, 1 is right and 0 is
+// center or LFE.
+static const int s_ChannelSides[AVG_MAX_AUDIO_CHANNELS][AVG_MAX_AUDIO_CHANNELS] = {
+    {0},
+    {-1, 1},
+    {-1, 1, 0},
+    {-1, 1, -1, 1},
+    {-1, 1, 0, -1, 1},
+    {-1, 1, 0, 0, -1, 1},
+    {-1, 1, 0, 0, 0, -1, 1},
+    {-1, 1, 0, 0, -1, 1, -1, 1}
+};
+
+void AudioEngine::setSourcePan(int id, float pan)
+{
+    vector<float> gains;
+    panToChannelGains(pan, gains);
+    setSourceChannelGains(id, gains);
+}
+
+void AudioEngine::setSourceChannelGains(int id, const vector<float>& gains)
+{
+    if (int(gains.size()) != getChannels()) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, "Expected " + toString(getChannels()) +
+                " channel gains, got " + toString(gains.size()) + ".");
+    }
+    lock_guard lock(m_Mutex);
+    getSource(id)->setChannelGains(&gains[0], int(gains.size()));
+}
+
+void AudioEngine::setSourceBus(int id, int busID)
+{
+    lock_guard lock(m_Mutex);
+    getSource(id);
+    getBus(busID);
+    m_SourceBusIDs[id] = busID;
+    publishGraph();
+}
+
+int AudioEngine::addBus(int outputBusID)
+{
+    lock_guard lock(m_Mutex);
+    getBus(outputBusID);
+    int busID = m_NextBusID;
+    m_NextBusID++;
+    BusInfo& bus = m_Buses[busID];
+    bus.m_pBus = AudioBusPtr(new AudioBus(m_AP, 1.f, false));
+    bus.m_OutputBusID = outputBusID;
+    publishGraph();
+    return busID;
+}
+
+void AudioEngine::removeBus(int busID)
+{
+    lock_guard lock(m_Mutex);
+    getBus(busID);
+    if (busID == 0) {
+        throw Exception(AVG_ERR_INVALID_ARGS, "The master audio bus can't be removed.");
+    }
+    // Everything routed to the bus goes to its output bus instead.
+    int outputBusID = m_Buses[busID].m_OutputBusID;
+    for (AudioBusMap::iterator it = m_Buses.begin(); it != m_Buses.end(); ++it) {
+        if (it->second.m_OutputBusID == busID) {
+            it->second.m_OutputBusID = outputBusID;
+        }
+    }
+    map<int, int>::iterator it;
+    for (it = m_SourceBusIDs.begin(); it != m_SourceBusIDs.end(); ++it) {
+        if (it->second == busID) {
+            it->second = outputBusID;
+        }
+    }
+    m_Buses.erase(busID);
+    publishGraph();
+}
+
+void AudioEngine::setBusGain(int busID, float gain)
+{
+    lock_guard lock(m_Mutex);
+    getBus(busID)->setGain(gain);
+    if (busID == 0) {
+        m_Volume = gain;
+    }
+}
+
+float AudioEngine::getBusGain(int busID)
+{
+    lock_guard lock(m_Mutex);
+    return getBus(busID)->getGain();
+}
+
+void AudioEngine::setBusLimiterEnabled(int busID, bool bEnabled)
+{
+    lock_guard lock(m_Mutex);
+    getBus(busID)->setLimiterEnabled(bEnabled);
+}
+
+void AudioEngine::setBusChannelMap(int busID, const vector<int>& channelMap)
+{
+    lock_guard lock(m_Mutex);
+    getBus(busID);
+    if (busID == 0 && !channelMap.empty()) {
+        throw Exception(AVG_ERR_INVALID_ARGS,
+                "The master audio bus can't have a channel map.");
+    }
+    int channels = getChannels();
+    if (!channelMap.empty() && int(channelMap.size()) != channels) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, "Expected a channel map with " +
+                toString(channels) + " entries, got " + toString(channelMap.size()) +
+                ".");
+    }
+    for (unsigned i = 0; i < channelMap.size(); ++i) {
+        if (channelMap[i] < -1 || channelMap[i] >= channels) {
+            throw Exception(AVG_ERR_OUT_OF_RANGE, "Invalid channel in channel map: " +
+                    toString(channelMap[i]) + ".");
+        }
+    }
+    m_Buses[busID].m_ChannelMap = channelMap;
+    publishGraph();
+}
+
+int AudioEngine::addSample(AudioBufferPtr pSample)
+{
+    if (pSample->getNumChannels() != getChannels() ||
+            pSample->getRate() != getSampleRate())
+    {
+        throw Exception(AVG_ERR_UNSUPPORTED, "Audio sample format (" +
+                toString(pSample->getNumChannels()) + " channels, " +
+                toString(pSample->getRate()) + " Hz) doesn't match audio output.");
+    }
+    lock_guard lock(m_Mutex);
+    int sampleID = m_NextSampleID;
+    m_NextSampleID++;
+    m_Samples[sampleID] = pSample;
+    return sampleID;
+}
+
+void AudioEngine::removeSample(int sampleID)
+{
+    lock_guard lock(m_Mutex);
+    map<int, AudioBufferPtr>::iterator it = m_Samples.find(sampleID);
+    if (it == m_Samples.end()) {
+        throw Exception(AVG_ERR_INVALID_ARGS, "Unknown audio sample: " +
+                toString(sampleID) + ".");
+    }
+    m_pRetiredSamples.push_back(it->second);
+    m_Samples.erase(it);
+    deleteRetiredSamples();
+}
+
+int AudioEngine::playSample(int sampleID, float volume, float pan, int busID)
+{
+    lock_guard lock(m_Mutex);
+    map<int, AudioBufferPtr>::iterator it = m_Samples.find(sampleID);
+    if (it == m_Samples.end()) {
+        throw Exception(AVG_ERR_INVALID_ARGS, "Unknown audio sample: " +
+                toString(sampleID) + ".");
+    }
+    getBus(busID);
+    deleteRetiredSamples();
+    if (pan == 0.f) {
+        return m_SamplePlayer.play(it->second, volume, 0, busID);
+    } else {
+        vector<float> gains;
+        panToChannelGains(pan, gains);
+        return m_SamplePlayer.play(it->second, volume, &gains[0], busID);
+    }
+}
+
+void AudioEngine::stopVoice(int voiceID)
+{
+    lock_guard lock(m_Mutex);
+    m_SamplePlayer.stop(voiceID);
+}
+
+void AudioEngine::setMaxVoices(int maxVoices)
+{
+    m_SamplePlayer.setMaxVoices(maxVoices);
+}
+
+int AudioEngine::getMaxVoices() const
+{
+    return m_SamplePlayer.getMaxVoices();
+}
+
+int AudioEngine::getNumVoices() const
+{
+    return m_SamplePlayer.getNumVoices();
+}
+
+void AudioEngine::deleteRetiredObjects()
+{
+    lock_guard lock(m_Mutex);
+    deleteRetiredSamples();
+    deleteRetiredGraphs(false);
 }
 
 void AudioEngine::setVolume(float volume)
 {
-    SDL_LockAudio();
     lock_guard lock(m_Mutex);
     m_Volume = volume;
-    SDL_UnlockAudio();
+    AudioBusMap::iterator it = m_Buses.find(0);
+    if (it != m_Buses.end()) {
+        it->second.m_pBus->setGain(volume);
+    }
 }
 
 float AudioEngine::getVolume() const
@@ -237,58 +437,170 @@ void AudioEngine::mixAudio(Uint8 *pDestBuffer, int destBufferLen)
 {
     int numFrames = destBufferLen/(2*getChannels()); // 16 bit samples.
 
-    if (m_AudioSources.size() == 0) {
-        return;
+    AudioMixGraph* pGraph = acquireGraph();
+    m_SamplePlayer.processCommands();
+    bool bHasInput = !pGraph->m_Sources.empty() || m_SamplePlayer.getNumVoices() > 0;
+    if (bHasInput && !pGraph->m_Buses.empty()) {
+        short* pDest = (short*)pDestBuffer;
+        int chunkFrames = m_pTempBuffer->getNumFrames();
+        for (int i = 0; i < numFrames; i += chunkFrames) {
+            int framesToMix = min(chunkFrames, numFrames-i);
+            mixChunk(*pGraph, pDest+i*getChannels(), framesToMix);
+        }
+    } else {
+        memset(pDestBuffer, 0, destBufferLen);
+    }
+    releaseGraph();
+}
+
+void AudioEngine::audioCallback(void *userData, Uint8 *audioBuffer, int audioBufferLen)
+{
+    AudioEngine *pThis = (AudioEngine*)userData;
+    pThis->mixAudio(audioBuffer, audioBufferLen);
+}
+
+void AudioEngine::mixChunk(const AudioMixGraph& graph, short* pDest, int numFrames)
+{
+    const vector<AudioBusPtr>& buses = graph.m_Buses;
+    for (unsigned i = 0; i < buses.size(); ++i) {
+        buses[i]->clear(numFrames);
     }
-    if (!m_pTempBuffer || m_pTempBuffer->getNumFrames() < numFrames) {
-        if (m_pTempBuffer) {
-            delete[] m_pMixBuffer;
+    for (unsigned i = 0; i < graph.m_Sources.size(); ++i) {
+        graph.m_Sources[i]->mixAudio(graph.m_SourceBuses[i]->getBuffer(), m_pTempBuffer,
+                numFrames);
+    }
+    m_SamplePlayer.mixAudio(graph.m_BusIDs, buses, numFrames);
+    // Children come after their parents, so this finishes each bus before it is used.
+    for (int i = int(buses.size())-1; i > 0; --i) {
+        buses[i]->process(numFrames);
+        const vector<int>& channelMap = graph.m_BusChannelMaps[i];
+        const int* pChannelMap = 0;
+        if (!channelMap.empty()) {
+            pChannelMap = &channelMap[0];
         }
-        m_pTempBuffer = AudioBufferPtr(new AudioBuffer(numFrames, m_AP));
-        m_pMixBuffer = new float[getChannels()*numFrames];
+        buses[i]->mixInto(graph.m_BusOutputs[i]->getBuffer(), numFrames, pChannelMap);
     }
+    AudioBus& master = *buses[0];
+    master.process(numFrames);
+    floatToS16(master.getBuffer(), pDest, numFrames*getChannels());
+}
 
-    for (int i = 0; i < getChannels()*numFrames; ++i) {
-        m_pMixBuffer[i]=0;
+AudioSourcePtr AudioEngine::getSource(int id)
+{
+    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
+    AVG_ASSERT(itSource != m_AudioSources.end());
+    return itSource->second;
+}
+
+AudioBusPtr AudioEngine::getBus(int busID)
+{
+    AudioBusMap::iterator it = m_Buses.find(busID);
+    if (it == m_Buses.end()) {
+        throw Exception(AVG_ERR_INVALID_ARGS, "Unknown audio bus: " + toString(busID) +
+                ".");
     }
-    {
-        lock_guard lock(m_Mutex);
-        AudioSourceMap::iterator it;
-        for (it = m_AudioSources.begin(); it != m_AudioSources.end(); it++) {
-            m_pTempBuffer->clear();
-            it->second->fillAudioBuffer(m_pTempBuffer);
-            addBuffers(m_pMixBuffer, m_pTempBuffer);
+    return it->second.m_pBus;
+}
+
+void AudioEngine::panToChannelGains(float pan, vector<float>& gains)
+{
+    // Balance control: panning attenuates the channels on the opposite side and leaves
+    // the rest alone, so a centered source is unchanged.
+    pan = max(-1.f, min(1.f, pan));
+    int channels = getChannels();
+    gains.resize(channels);
+    for (int i = 0; i < channels; ++i) {
+        switch (s_ChannelSides[channels-1][i]) {
+            case -1:
+                gains[i] = min(1.f, 1.f-pan);
+                break;
+            case 1:
+                gains[i] = min(1.f, 1.f+pan);
+                break;
+            default:
+                gains[i] = 1.f;
         }
     }
-    calcVolume(m_pMixBuffer, numFrames*getChannels(), getVolume());
-    for (int i = 0; i < numFrames; ++i) {
-        m_pLimiter->process(m_pMixBuffer+i*getChannels());
-        for (int j = 0; j < getChannels(); ++j) {
-            ((short*)pDestBuffer)[i*2+j]=short(m_pMixBuffer[i*2+j]*32768);
+}
+
+void AudioEngine::deleteRetiredSamples()
+{
+    vector<AudioBufferPtr>::iterator it = m_pRetiredSamples.begin();
+    while (it != m_pRetiredSamples.end()) {
+        if (it->unique()) {
+            // The audio thread has released the sample. Make sure it is done reading.
+            boost::atomic_thread_fence(boost::memory_order_acquire);
+            it = m_pRetiredSamples.erase(it);
+        } else {
+            ++it;
         }
     }
 }
 
-void AudioEngine::audioCallback(void *userData, Uint8 *audioBuffer, int audioBufferLen)
+AudioMixGraph* AudioEngine::acquireGraph()
 {
-    AudioEngine *pThis = (AudioEngine*)userData;
-    pThis->mixAudio(audioBuffer, audioBufferLen);
+    // Announce the graph before using it. If it was retired in the meantime, the main
+    // thread may not have seen the announcement, so try again with the new graph.
+    AudioMixGraph* pGraph;
+    do {
+        pGraph = m_pGraph.load();
+        m_pMixingGraph.store(pGraph);
+    } while (m_pGraph.load() != pGraph);
+    return pGraph;
 }
 
-void AudioEngine::addBuffers(float *pDest, AudioBufferPtr pSrc)
+void AudioEngine::releaseGraph()
 {
-    int numFrames = pSrc->getNumFrames();
-    short * pData = pSrc->getData();
-    for(int i = 0; i < numFrames*getChannels(); ++i) {
-        pDest[i] += pData[i]/32768.0f;
+    m_pMixingGraph.store(0);
+}
+
+void AudioEngine::publishGraph()
+{
+    AudioMixGraph* pNewGraph = new AudioMixGraph;
+    // Bus ids are handed out in increasing order and a bus can only output to a bus
+    // that already exists, so sorting by id puts parents before children.
+    map<int, int> busIndexes;
+    for (AudioBusMap::iterator it = m_Buses.begin(); it != m_Buses.end(); ++it) {
+        const BusInfo& bus = it->second;
+        busIndexes[it->first] = int(pNewGraph->m_Buses.size());
+        pNewGraph->m_Buses.push_back(bus.m_pBus);
+        pNewGraph->m_BusIDs.push_back(it->first);
+        if (bus.m_OutputBusID == -1) {
+            pNewGraph->m_BusOutputs.push_back(0);
+        } else {
+            AVG_ASSERT(bus.m_OutputBusID < it->first);
+            pNewGraph->m_BusOutputs.push_back(m_Buses[bus.m_OutputBusID].m_pBus.get());
+        }
+        pNewGraph->m_BusChannelMaps.push_back(bus.m_ChannelMap);
     }
+    if (!m_Buses.empty()) {
+        for (AudioSourceMap::iterator it = m_AudioSources.begin();
+                it != m_AudioSources.end(); ++it)
+        {
+            pNewGraph->m_Sources.push_back(it->second);
+            int busIndex = busIndexes[m_SourceBusIDs[it->first]];
+            pNewGraph->m_SourceBuses.push_back(pNewGraph->m_Buses[busIndex].get());
+        }
+    }
+    AudioMixGraph* pOldGraph = m_pGraph.exchange(pNewGraph);
+    m_pRetiredGraphs.push_back(pOldGraph);
+    deleteRetiredGraphs(false);
 }
 
-void AudioEngine::calcVolume(float *pBuffer, int numSamples, float volume)
+void AudioEngine::deleteRetiredGraphs(bool bAll)
 {
-    // TODO: We need a VolumeFader class that keeps state.
-    for(int i = 0; i < numSamples; ++i) {
-        pBuffer[i] *= volume;
+    AudioMixGraph* pInUse = 0;
+    if (!bAll) {
+        pInUse = m_pMixingGraph.load();
+    }
+    vector<AudioMixGraph*>::iterator it = m_pRetiredGraphs.begin();
+    while (it != m_pRetiredGraphs.end()) {
+        if (*it == pInUse) {
+            ++it;
+        } else {
+            delete *it;
+            it = m_pRetiredGraphs.erase(it);
+        }
     }
 }
 
@@ -28,23 +28,44 @@
 #include "AudioSource.h"
 #include "AudioParams.h"
 #include "AudioBuffer.h"
-#include "IProcessor.h"
+#include "AudioBus.h"
+#include "AudioOutput.h"
+#include "AudioSamplePlayer.h"
 
 #include <SDL/SDL.h>
 
 #include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
 
 #include <map>
+#include <vector>
 
 namespace avg {
 
 typedef std::map<int, AudioSourcePtr> AudioSourceMap;
+typedef std::vector<AudioSourcePtr> AudioSourceList;
+
+// Immutable snapshot of the sources and buses, used by the audio callback.
+struct AudioMixGraph {
+    AudioSourceList m_Sources;
+    // Bus each source is mixed into, parallel to m_Sources.
+    std::vector<AudioBus*> m_SourceBuses;
+    // Parents come before their children. m_Buses[0] is the master bus.
+    std::vector<AudioBusPtr> m_Buses;
+    // Parallel to m_Buses.
+    std::vector<int> m_BusIDs;
+    // Parallel to m_Buses. The master bus has no output bus and no channel map.
+    std::vector<AudioBus*> m_BusOutputs;
+    // An empty channel map routes each channel to the same channel of the output bus.
+    std::vector<std::vector<int> > m_BusChannelMaps;
+};
 
 class AVG_API AudioEngine
 {
     public:
         static AudioEngine* get();
-        AudioEngine();
+        // Uses SDL for output if pOutput is empty.
+        AudioEngine(AudioOutputPtr pOutput=AudioOutputPtr());
         virtual ~AudioEngine();
 
         int getChannels();
@@ -59,31 +80,104 @@ class AVG_API AudioEngine
         void play();
         void pause();
         
+        // The queues must stay alive until removeSource() returns. removeSource() waits
+        // for a callback that is mixing the source to finish.
         int addSource(AudioMsgQueue& dataQ, AudioMsgQueue& statusQ);
         void removeSource(int id);
         void pauseSource(int id);
         void playSource(int id);
         void notifySeek(int id);
         void setSourceVolume(int id, float volume);
+        void setSourcePan(int id, float pan);
+        void setSourceChannelGains(int id, const std::vector<float>& gains);
+        void setSourceBus(int id, int busID);
+
+        // Buses are created by init() and destroyed by teardown(). Bus 0 is the master
+        // bus. Its gain is the engine volume and its limiter is enabled by default.
+        int addBus(int outputBusID=0);
+        void removeBus(int busID);
+        void setBusGain(int busID, float gain);
+        float getBusGain(int busID);
+        void setBusLimiterEnabled(int busID, bool bEnabled);
+        // channelMap[i] is the output bus channel that channel i is added to, or -1 to
+        // drop the channel. An empty map routes each channel to itself.
+        void setBusChannelMap(int busID, const std::vector<int>& channelMap);
+
+        // Sample bank for short sounds that are played from memory. Samples must have
+        // the engine's sample rate and channel count. playSample() returns a voice id.
+        int addSample(AudioBufferPtr pSample);
+        void removeSample(int sampleID);
+        int playSample(int sampleID, float volume=1.f, float pan=0.f, int busID=0);
+        void stopVoice(int voiceID);
+        void setMaxVoices(int maxVoices);
+        int getMaxVoices() const;
+        // Number of voices that are playing, as of the last callback.
+        int getNumVoices() const;
+
+        // Frees removed samples and old mix graphs once the audio callback is done
+        // with them. Called by the Player once per frame.
+        void deleteRetiredObjects();
 
         void setVolume(float volume);
         float getVolume() const;
         bool isEnabled() const;
         
-    private:
+        // Runs in the audio callback. Doesn't allocate or free memory (see
+        // AudioSource). It only takes a lock to wake up a decoder thread that waits for
+        // room in its queue, or if a source's status queue is a locking queue. Public
+        // so tests can drive it without an audio device.
         void mixAudio(Uint8 *pDestBuffer, int destBufferLen);
+
+    private:
         static void audioCallback(void *userData, Uint8 *audioBuffer, int audioBufferLen);
-        void addBuffers(float *pDest, AudioBufferPtr pSrc);
-        void calcVolume(float *pBuffer, int numSamples, float volume);
+        void mixChunk(const AudioMixGraph& graph, short* pDest, int numFrames);
+
+        AudioSourcePtr getSource(int id);
+        AudioBusPtr getBus(int busID);
+        void panToChannelGains(float pan, std::vector<float>& gains);
+        void deleteRetiredSamples();
+
+        AudioMixGraph* acquireGraph();
+        void releaseGraph();
+        void publishGraph();
+        void deleteRetiredGraphs(bool bAll);
         
+        struct BusInfo {
+            AudioBusPtr m_pBus;
+            int m_OutputBusID;
+            std::vector<int> m_ChannelMap;
+        };
+        typedef std::map<int, BusInfo> AudioBusMap;
+
+        AudioOutputPtr m_pOutput;
         AudioParams m_AP;
         AudioBufferPtr m_pTempBuffer;
-        float * m_pMixBuffer;
-        IProcessor<float>* m_pLimiter;
+        // Serializes changes to the sources and buses. Never taken in the audio
+        // callback.
         boost::mutex m_Mutex;
 
         bool m_bEnabled;
         AudioSourceMap m_AudioSources;
+        std::map<int, int> m_SourceBusIDs;
+        AudioBusMap m_Buses;
+        int m_NextBusID;
+
+        // Read-copy-update of the mix graph: the main thread publishes an immutable
+        // snapshot of the sources and buses and the callback announces which snapshot
+        // it is mixing, so retired snapshots (and the sources and buses only they
+        // reference) are deleted in the main thread once the callback is done with
+        // them.
+        boost::atomic<AudioMixGraph*> m_pGraph;
+        boost::atomic<AudioMixGraph*> m_pMixingGraph;
+        std::vector<AudioMixGraph*> m_pRetiredGraphs;
+
+        AudioSamplePlayer m_SamplePlayer;
+        std::map<int, AudioBufferPtr> m_Samples;
+        int m_NextSampleID;
+        // Removed samples that voices may still be playing. They are deleted in the
+        // main thread once the audio thread has released them.
+        std::vector<AudioBufferPtr> m_pRetiredSamples;
+
         float m_Volume;
         
         static AudioEngine* s_pInstance;
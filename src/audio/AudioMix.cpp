@@ -0,0 +1,442 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "AudioMix.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AVG_AUDIO_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define AVG_AUDIO_NEON
+#include <arm_neon.h>
+#endif
+
+namespace avg {
+
+#if defined(AVG_AUDIO_SSE2) || defined(AVG_AUDIO_NEON)
+static bool s_bSIMDEnabled = true;
+#else
+static bool s_bSIMDEnabled = false;
+#endif
+
+void setAudioMixSIMDEnabled(bool bEnabled)
+{
+#if defined(AVG_AUDIO_SSE2) || defined(AVG_AUDIO_NEON)
+    s_bSIMDEnabled = bEnabled;
+#endif
+}
+
+bool isAudioMixSIMDEnabled()
+{
+    return s_bSIMDEnabled;
+}
+
+// Interleaved samples repeat their channel layout every lcm(4, channels) samples.
+// The vector loops process one such period at a time using precomputed per-lane frame
+// offsets and channel gains, so they work for any number of channels.
+struct LanePattern {
+    int m_NumSamples;
+    int m_NumFrames;
+    float m_FrameOffsets[4*AVG_MAX_AUDIO_CHANNELS];
+    float m_ChannelGains[4*AVG_MAX_AUDIO_CHANNELS];
+};
+
+static void initLanePattern(int channels, const float* pChannelGains,
+        LanePattern& pattern)
+{
+    int period = channels;
+    while (period % 4 != 0) {
+        period += channels;
+    }
+    pattern.m_NumSamples = period;
+    pattern.m_NumFrames = period/channels;
+    for (int i = 0; i < period; ++i) {
+        pattern.m_FrameOffsets[i] = float(i/channels);
+        if (pChannelGains) {
+            pattern.m_ChannelGains[i] = pChannelGains[i%channels];
+        } else {
+            pattern.m_ChannelGains[i] = 1.f;
+        }
+    }
+}
+
+// The scalar loops are the reference implementation and also handle the samples left
+// over by the vector loops.
+
+static void mixS16ToFloatScalar(float* pDest, const short* pSrc, int firstFrame,
+        int numFrames, int channels, float startGain, float gainStep,
+        const float* pChannelGains)
+{
+    for (int f = firstFrame; f < numFrames; ++f) {
+        float scale = (startGain + gainStep*float(f))*(1.f/32768);
+        for (int c = 0; c < channels; ++c) {
+            int i = f*channels+c;
+            float channelScale = scale;
+            if (pChannelGains) {
+                channelScale *= pChannelGains[c];
+            }
+            pDest[i] += float(pSrc[i])*channelScale;
+        }
+    }
+}
+
+static void applyGainRampScalar(float* pBuffer, int firstFrame, int numFrames,
+        int channels, float startGain, float gainStep)
+{
+    for (int f = firstFrame; f < numFrames; ++f) {
+        float gain = startGain + gainStep*float(f);
+        for (int c = 0; c < channels; ++c) {
+            pBuffer[f*channels+c] *= gain;
+        }
+    }
+}
+
+static void floatToS16Scalar(const float* pSrc, short* pDest, int first, int numSamples)
+{
+    for (int i = first; i < numSamples; ++i) {
+        float s = pSrc[i]*32768;
+        if (s > 32767) {
+            s = 32767;
+        } else if (s < -32768) {
+            s = -32768;
+        }
+        pDest[i] = short(s);
+    }
+}
+
+template<typename T>
+static void interleaveScalar(T* pDest, const T* const* ppPlanes, int firstFrame,
+        int numFrames, int channels)
+{
+    for (int f = firstFrame; f < numFrames; ++f) {
+        for (int c = 0; c < channels; ++c) {
+            pDest[f*channels+c] = ppPlanes[c][f];
+        }
+    }
+}
+
+#ifdef AVG_AUDIO_SSE2
+
+// Processes whole periods and returns the number of frames done.
+static int mixS16ToFloatSSE2(float* pDest, const short* pSrc, int numFrames,
+        int channels, float startGain, float gainStep, const float* pChannelGains)
+{
+    LanePattern pattern;
+    initLanePattern(channels, pChannelGains, pattern);
+    int numPeriods = numFrames/pattern.m_NumFrames;
+    __m128 start = _mm_set1_ps(startGain);
+    __m128 step = _mm_set1_ps(gainStep);
+    __m128 norm = _mm_set1_ps(1.f/32768);
+    const short* pCurSrc = pSrc;
+    float* pCurDest = pDest;
+    for (int p = 0; p < numPeriods; ++p) {
+        __m128 baseFrame = _mm_set1_ps(float(p*pattern.m_NumFrames));
+        for (int i = 0; i < pattern.m_NumSamples; i += 4) {
+            __m128 frame = _mm_add_ps(baseFrame, _mm_loadu_ps(pattern.m_FrameOffsets+i));
+            __m128 scale = _mm_mul_ps(_mm_add_ps(start, _mm_mul_ps(step, frame)), norm);
+            scale = _mm_mul_ps(scale, _mm_loadu_ps(pattern.m_ChannelGains+i));
+            __m128i s = _mm_loadl_epi64((const __m128i*)pCurSrc);
+            // Sign-extend by moving the samples into the upper halves of 32-bit lanes.
+            __m128 samples = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+            _mm_storeu_ps(pCurDest,
+                    _mm_add_ps(_mm_loadu_ps(pCurDest), _mm_mul_ps(samples, scale)));
+            pCurSrc += 4;
+            pCurDest += 4;
+        }
+    }
+    return numPeriods*pattern.m_NumFrames;
+}
+
+static int applyGainRampSSE2(float* pBuffer, int numFrames, int channels,
+        float startGain, float gainStep)
+{
+    LanePattern pattern;
+    initLanePattern(channels, 0, pattern);
+    int numPeriods = numFrames/pattern.m_NumFrames;
+    __m128 start = _mm_set1_ps(startGain);
+    __m128 step = _mm_set1_ps(gainStep);
+    float* pCur = pBuffer;
+    for (int p = 0; p < numPeriods; ++p) {
+        __m128 baseFrame = _mm_set1_ps(float(p*pattern.m_NumFrames));
+        for (int i = 0; i < pattern.m_NumSamples; i += 4) {
+            __m128 frame = _mm_add_ps(baseFrame, _mm_loadu_ps(pattern.m_FrameOffsets+i));
+            __m128 gain = _mm_add_ps(start, _mm_mul_ps(step, frame));
+            _mm_storeu_ps(pCur, _mm_mul_ps(_mm_loadu_ps(pCur), gain));
+            pCur += 4;
+        }
+    }
+    return numPeriods*pattern.m_NumFrames;
+}
+
+// Only stereo is vectorized. Returns the number of frames done.
+static int interleaveS16SSE2(short* pDest, const short* const* ppPlanes, int numFrames,
+        int channels)
+{
+    if (channels != 2) {
+        return 0;
+    }
+    int f = 0;
+    for (; f+8 <= numFrames; f += 8) {
+        __m128i left = _mm_loadu_si128((const __m128i*)(ppPlanes[0]+f));
+        __m128i right = _mm_loadu_si128((const __m128i*)(ppPlanes[1]+f));
+        _mm_storeu_si128((__m128i*)(pDest+2*f), _mm_unpacklo_epi16(left, right));
+        _mm_storeu_si128((__m128i*)(pDest+2*f+8), _mm_unpackhi_epi16(left, right));
+    }
+    return f;
+}
+
+static int interleaveFloatSSE2(float* pDest, const float* const* ppPlanes, int numFrames,
+        int channels)
+{
+    if (channels != 2) {
+        return 0;
+    }
+    int f = 0;
+    for (; f+4 <= numFrames; f += 4) {
+        __m128 left = _mm_loadu_ps(ppPlanes[0]+f);
+        __m128 right = _mm_loadu_ps(ppPlanes[1]+f);
+        _mm_storeu_ps(pDest+2*f, _mm_unpacklo_ps(left, right));
+        _mm_storeu_ps(pDest+2*f+4, _mm_unpackhi_ps(left, right));
+    }
+    return f;
+}
+
+static int floatToS16SSE2(const float* pSrc, short* pDest, int numSamples)
+{
+    __m128 scale = _mm_set1_ps(32768);
+    __m128 maxVal = _mm_set1_ps(32767);
+    __m128 minVal = _mm_set1_ps(-32768);
+    int i = 0;
+    for (; i+8 <= numSamples; i += 8) {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(pSrc+i), scale);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(pSrc+i+4), scale);
+        lo = _mm_max_ps(_mm_min_ps(lo, maxVal), minVal);
+        hi = _mm_max_ps(_mm_min_ps(hi, maxVal), minVal);
+        // Truncates like the scalar cast.
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(lo), _mm_cvttps_epi32(hi));
+        _mm_storeu_si128((__m128i*)(pDest+i), packed);
+    }
+    return i;
+}
+
+#endif
+
+#ifdef AVG_AUDIO_NEON
+
+static int mixS16ToFloatNEON(float* pDest, const short* pSrc, int numFrames,
+        int channels, float startGain, float gainStep, const float* pChannelGains)
+{
+    LanePattern pattern;
+    initLanePattern(channels, pChannelGains, pattern);
+    int numPeriods = numFrames/pattern.m_NumFrames;
+    float32x4_t start = vdupq_n_f32(startGain);
+    float32x4_t step = vdupq_n_f32(gainStep);
+    float32x4_t norm = vdupq_n_f32(1.f/32768);
+    const short* pCurSrc = pSrc;
+    float* pCurDest = pDest;
+    for (int p = 0; p < numPeriods; ++p) {
+        float32x4_t baseFrame = vdupq_n_f32(float(p*pattern.m_NumFrames));
+        for (int i = 0; i < pattern.m_NumSamples; i += 4) {
+            float32x4_t frame = vaddq_f32(baseFrame, vld1q_f32(pattern.m_FrameOffsets+i));
+            float32x4_t scale = vmulq_f32(vaddq_f32(start, vmulq_f32(step, frame)), norm);
+            scale = vmulq_f32(scale, vld1q_f32(pattern.m_ChannelGains+i));
+            float32x4_t samples = vcvtq_f32_s32(vmovl_s16(vld1_s16(pCurSrc)));
+            vst1q_f32(pCurDest, vaddq_f32(vld1q_f32(pCurDest), vmulq_f32(samples, scale)));
+            pCurSrc += 4;
+            pCurDest += 4;
+        }
+    }
+    return numPeriods*pattern.m_NumFrames;
+}
+
+static int applyGainRampNEON(float* pBuffer, int numFrames, int channels,
+        float startGain, float gainStep)
+{
+    LanePattern pattern;
+    initLanePattern(channels, 0, pattern);
+    int numPeriods = numFrames/pattern.m_NumFrames;
+    float32x4_t start = vdupq_n_f32(startGain);
+    float32x4_t step = vdupq_n_f32(gainStep);
+    float* pCur = pBuffer;
+    for (int p = 0; p < numPeriods; ++p) {
+        float32x4_t baseFrame = vdupq_n_f32(float(p*pattern.m_NumFrames));
+        for (int i = 0; i < pattern.m_NumSamples; i += 4) {
+            float32x4_t frame = vaddq_f32(baseFrame, vld1q_f32(pattern.m_FrameOffsets+i));
+            float32x4_t gain = vaddq_f32(start, vmulq_f32(step, frame));
+            vst1q_f32(pCur, vmulq_f32(vld1q_f32(pCur), gain));
+            pCur += 4;
+        }
+    }
+    return numPeriods*pattern.m_NumFrames;
+}
+
+static int interleaveS16NEON(short* pDest, const short* const* ppPlanes, int numFrames,
+        int channels)
+{
+    if (channels != 2) {
+        return 0;
+    }
+    int f = 0;
+    for (; f+8 <= numFrames; f += 8) {
+        int16x8x2_t frames;
+        frames.val[0] = vld1q_s16(ppPlanes[0]+f);
+        frames.val[1] = vld1q_s16(ppPlanes[1]+f);
+        vst2q_s16(pDest+2*f, frames);
+    }
+    return f;
+}
+
+static int interleaveFloatNEON(float* pDest, const float* const* ppPlanes, int numFrames,
+        int channels)
+{
+    if (channels != 2) {
+        return 0;
+    }
+    int f = 0;
+    for (; f+4 <= numFrames; f += 4) {
+        float32x4x2_t frames;
+        frames.val[0] = vld1q_f32(ppPlanes[0]+f);
+        frames.val[1] = vld1q_f32(ppPlanes[1]+f);
+        vst2q_f32(pDest+2*f, frames);
+    }
+    return f;
+}
+
+static int floatToS16NEON(const float* pSrc, short* pDest, int numSamples)
+{
+    float32x4_t maxVal = vdupq_n_f32(32767);
+    float32x4_t minVal = vdupq_n_f32(-32768);
+    int i = 0;
+    for (; i+8 <= numSamples; i += 8) {
+        float32x4_t lo = vmulq_n_f32(vld1q_f32(pSrc+i), 32768);
+        float32x4_t hi = vmulq_n_f32(vld1q_f32(pSrc+i+4), 32768);
+        lo = vmaxq_f32(vminq_f32(lo, maxVal), minVal);
+        hi = vmaxq_f32(vminq_f32(hi, maxVal), minVal);
+        int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(lo)),
+                vqmovn_s32(vcvtq_s32_f32(hi)));
+        vst1q_s16(pDest+i, packed);
+    }
+    return i;
+}
+
+#endif
+
+void mixS16ToFloat(float* pDest, const short* pSrc, int numFrames, int channels,
+        float startGain, float endGain, const float* pChannelGains)
+{
+    float gainStep = (endGain-startGain)/numFrames;
+    int framesDone = 0;
+    if (s_bSIMDEnabled) {
+#if defined(AVG_AUDIO_SSE2)
+        framesDone = mixS16ToFloatSSE2(pDest, pSrc, numFrames, channels, startGain,
+                gainStep, pChannelGains);
+#elif defined(AVG_AUDIO_NEON)
+        framesDone = mixS16ToFloatNEON(pDest, pSrc, numFrames, channels, startGain,
+                gainStep, pChannelGains);
+#endif
+    }
+    mixS16ToFloatScalar(pDest, pSrc, framesDone, numFrames, channels, startGain,
+            gainStep, pChannelGains);
+}
+
+void applyGainRamp(float* pBuffer, int numFrames, int channels, float startGain,
+        float endGain)
+{
+    if (startGain == 1.f && endGain == 1.f) {
+        return;
+    }
+    float gainStep = (endGain-startGain)/numFrames;
+    int framesDone = 0;
+    if (s_bSIMDEnabled) {
+#if defined(AVG_AUDIO_SSE2)
+        framesDone = applyGainRampSSE2(pBuffer, numFrames, channels, startGain,
+                gainStep);
+#elif defined(AVG_AUDIO_NEON)
+        framesDone = applyGainRampNEON(pBuffer, numFrames, channels, startGain,
+                gainStep);
+#endif
+    }
+    applyGainRampScalar(pBuffer, framesDone, numFrames, channels, startGain, gainStep);
+}
+
+void addChannels(float* pDest, const float* pSrc, int numFrames, int channels,
+        const int* pChannelMap)
+{
+    if (pChannelMap) {
+        for (int f = 0; f < numFrames; ++f) {
+            for (int c = 0; c < channels; ++c) {
+                int destChannel = pChannelMap[c];
+                if (destChannel >= 0) {
+                    pDest[f*channels+destChannel] += pSrc[f*channels+c];
+                }
+            }
+        }
+    } else {
+        // Vectorized by the compiler.
+        int numSamples = numFrames*channels;
+        for (int i = 0; i < numSamples; ++i) {
+            pDest[i] += pSrc[i];
+        }
+    }
+}
+
+void interleaveS16(short* pDest, const short* const* ppPlanes, int numFrames,
+        int channels)
+{
+    int framesDone = 0;
+    if (s_bSIMDEnabled) {
+#if defined(AVG_AUDIO_SSE2)
+        framesDone = interleaveS16SSE2(pDest, ppPlanes, numFrames, channels);
+#elif defined(AVG_AUDIO_NEON)
+        framesDone = interleaveS16NEON(pDest, ppPlanes, numFrames, channels);
+#endif
+    }
+    interleaveScalar(pDest, ppPlanes, framesDone, numFrames, channels);
+}
+
+void interleaveFloat(float* pDest, const float* const* ppPlanes, int numFrames,
+        int channels)
+{
+    int framesDone = 0;
+    if (s_bSIMDEnabled) {
+#if defined(AVG_AUDIO_SSE2)
+        framesDone = interleaveFloatSSE2(pDest, ppPlanes, numFrames, channels);
+#elif defined(AVG_AUDIO_NEON)
+        framesDone = interleaveFloatNEON(pDest, ppPlanes, numFrames, channels);
+#endif
+    }
+    interleaveScalar(pDest, ppPlanes, framesDone, numFrames, channels);
+}
+
+void floatToS16(const float* pSrc, short* pDest, int numSamples)
+{
+    int samplesDone = 0;
+    if (s_bSIMDEnabled) {
+#if defined(AVG_AUDIO_SSE2)
+        samplesDone = floatToS16SSE2(pSrc, pDest, numSamples);
+#elif defined(AVG_AUDIO_NEON)
+        samplesDone = floatToS16NEON(pSrc, pDest, numSamples);
+#endif
+    }
+    floatToS16Scalar(pSrc, pDest, samplesDone, numSamples);
+}
+
+}
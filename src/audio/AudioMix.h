@@ -0,0 +1,66 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _AudioMix_H_
+#define _AudioMix_H_
+
+#include "../api.h"
+
+#define AVG_MAX_AUDIO_CHANNELS 8
+
+namespace avg {
+
+// Sample kernels used by the audio callback. They work on interleaved buffers, never
+// allocate and use SSE2 or NEON if the compiler targets it. They support up to
+// AVG_MAX_AUDIO_CHANNELS channels. Gains are ramped linearly
+// per frame: frame i gets startGain + (endGain-startGain)*i/numFrames, so a buffer
+// ends just short of endGain and the next one continues from there.
+
+// pDest[i] += pSrc[i]/32768 * gain * pChannelGains[channel]. pChannelGains can be 0.
+AVG_API void mixS16ToFloat(float* pDest, const short* pSrc, int numFrames, int channels,
+        float startGain, float endGain, const float* pChannelGains=0);
+
+// pBuffer[i] *= gain.
+AVG_API void applyGainRamp(float* pBuffer, int numFrames, int channels,
+        float startGain, float endGain);
+
+// Adds channel c of pSrc to channel pChannelMap[c] of pDest. Channels mapped to -1 are
+// dropped. pChannelMap can be 0 for a one-to-one mapping.
+AVG_API void addChannels(float* pDest, const float* pSrc, int numFrames, int channels,
+        const int* pChannelMap=0);
+
+// Interleaves channels planes of numFrames samples each, as delivered by planar
+// decoders.
+AVG_API void interleaveS16(short* pDest, const short* const* ppPlanes, int numFrames,
+        int channels);
+AVG_API void interleaveFloat(float* pDest, const float* const* ppPlanes, int numFrames,
+        int channels);
+
+// Converts to 16 bit, clamping to the representable range.
+AVG_API void floatToS16(const float* pSrc, short* pDest, int numSamples);
+
+// Lets tests and benchmarks compare against the scalar code.
+AVG_API void setAudioMixSIMDEnabled(bool bEnabled);
+AVG_API bool isAudioMixSIMDEnabled();
+
+}
+
+#endif
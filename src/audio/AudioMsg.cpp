@@ -155,7 +155,8 @@ void AudioMsg::dump()
     
 void AudioMsg::setType(MsgType msgType)
 {
-    AVG_ASSERT(m_MsgType == NONE);
+    // Messages can be reused for messages of the same type.
+    AVG_ASSERT(m_MsgType == NONE || m_MsgType == msgType);
     m_MsgType = msgType;
 }
 
@@ -0,0 +1,56 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _AudioOutput_H_
+#define _AudioOutput_H_
+
+#include "../api.h"
+#include "AudioParams.h"
+
+#include <SDL/SDL.h>
+
+#include <boost/shared_ptr.hpp>
+
+namespace avg {
+
+// Device that the AudioEngine renders into. The device calls the mix callback
+// whenever it needs another buffer of interleaved 16 bit samples.
+class AVG_API AudioOutput
+{
+public:
+    typedef void (*MixCallback)(void* pUserData, Uint8* pBuffer, int bufferLen);
+
+    virtual ~AudioOutput() {};
+
+    virtual void open(const AudioParams& ap, MixCallback pCallback, void* pUserData) = 0;
+    virtual void setPaused(bool bPaused) = 0;
+
+    // While the device is locked, the mix callback isn't running.
+    virtual void lock() = 0;
+    virtual void unlock() = 0;
+};
+
+typedef boost::shared_ptr<AudioOutput> AudioOutputPtr;
+
+}
+
+#endif
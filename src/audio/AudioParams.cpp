@@ -27,13 +27,16 @@
 
 namespace avg {
     AudioParams::AudioParams()
+        : m_ResampleQuality(RESAMPLE_MEDIUM)
     {
     }
 
-    AudioParams::AudioParams(int sampleRate, int channels, int outputBufferSamples)
+    AudioParams::AudioParams(int sampleRate, int channels, int outputBufferSamples,
+            ResampleQuality resampleQuality)
         : m_SampleRate(sampleRate),
           m_Channels(channels),
-          m_OutputBufferSamples(outputBufferSamples)
+          m_OutputBufferSamples(outputBufferSamples),
+          m_ResampleQuality(resampleQuality)
     {
     }
 }
@@ -27,11 +27,16 @@
 namespace avg {
 
 struct AudioParams {
+    // Tradeoff between CPU usage and aliasing when decoders resample.
+    enum ResampleQuality {RESAMPLE_LOW, RESAMPLE_MEDIUM, RESAMPLE_HIGH};
+
     AudioParams();
-    AudioParams(int sampleRate, int channels, int outputBufferSamples);
+    AudioParams(int sampleRate, int channels, int outputBufferSamples,
+            ResampleQuality resampleQuality=RESAMPLE_MEDIUM);
     int m_SampleRate;
     int m_Channels;
     int m_OutputBufferSamples;
+    ResampleQuality m_ResampleQuality;
 };
 
 }
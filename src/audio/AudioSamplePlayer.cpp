@@ -0,0 +1,235 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "AudioSamplePlayer.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/StringHelper.h"
+
+#include <algorithm>
+
+#define NUM_VOICE_SLOTS (2*AVG_MAX_AUDIO_VOICES)
+
+using namespace std;
+
+namespace avg {
+
+AudioSamplePlayer::AudioSamplePlayer()
+    : m_NextVoiceID(0),
+      m_MaxVoices(32),
+      m_NumVoices(0)
+{
+}
+
+AudioSamplePlayer::~AudioSamplePlayer()
+{
+}
+
+int AudioSamplePlayer::play(AudioBufferPtr pSample, float volume,
+        const float* pChannelGains, int busID)
+{
+    Command cmd;
+    cmd.m_Type = Command::PLAY;
+    cmd.m_VoiceID = m_NextVoiceID;
+    m_NextVoiceID++;
+    cmd.m_pSample = pSample;
+    cmd.m_Volume = volume;
+    cmd.m_bHasChannelGains = (pChannelGains != 0);
+    if (pChannelGains) {
+        copy(pChannelGains, pChannelGains+pSample->getNumChannels(), cmd.m_ChannelGains);
+    }
+    cmd.m_BusID = busID;
+    if (!m_Commands.push(cmd)) {
+        AVG_LOG_WARNING("Too many audio samples started in one audio buffer, sample not played.");
+    }
+    return cmd.m_VoiceID;
+}
+
+void AudioSamplePlayer::stop(int voiceID)
+{
+    Command cmd;
+    cmd.m_Type = Command::STOP;
+    cmd.m_VoiceID = voiceID;
+    cmd.m_Volume = 0.f;
+    cmd.m_bHasChannelGains = false;
+    cmd.m_BusID = 0;
+    m_Commands.push(cmd);
+}
+
+void AudioSamplePlayer::setMaxVoices(int maxVoices)
+{
+    if (maxVoices < 1 || maxVoices > AVG_MAX_AUDIO_VOICES) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE,
+                "Number of audio voices must be between 1 and " +
+                toString(AVG_MAX_AUDIO_VOICES) + ", got " + toString(maxVoices) + ".");
+    }
+    m_MaxVoices = maxVoices;
+}
+
+int AudioSamplePlayer::getMaxVoices() const
+{
+    return m_MaxVoices;
+}
+
+int AudioSamplePlayer::getNumVoices() const
+{
+    return m_NumVoices;
+}
+
+void AudioSamplePlayer::reset()
+{
+    Command cmd;
+    while (m_Commands.pop(cmd)) {
+    }
+    for (int i = 0; i < NUM_VOICE_SLOTS; ++i) {
+        m_Voices[i].m_pSample = AudioBufferPtr();
+    }
+    m_NumVoices = 0;
+}
+
+void AudioSamplePlayer::processCommands()
+{
+    Command cmd;
+    while (m_Commands.pop(cmd)) {
+        switch (cmd.m_Type) {
+            case Command::PLAY:
+                startVoice(cmd);
+                break;
+            case Command::STOP:
+                releaseVoice(cmd.m_VoiceID);
+                break;
+        }
+    }
+    int numVoices = 0;
+    for (int i = 0; i < NUM_VOICE_SLOTS; ++i) {
+        if (m_Voices[i].m_pSample) {
+            numVoices++;
+        }
+    }
+    m_NumVoices = numVoices;
+}
+
+void AudioSamplePlayer::mixAudio(const vector<int>& busIDs,
+        const vector<AudioBusPtr>& buses, int numFrames)
+{
+    int numVoices = 0;
+    for (int i = 0; i < NUM_VOICE_SLOTS; ++i) {
+        Voice& voice = m_Voices[i];
+        if (!voice.m_pSample) {
+            continue;
+        }
+        float* pDest = buses[0]->getBuffer();
+        for (unsigned j = 0; j < busIDs.size(); ++j) {
+            if (busIDs[j] == voice.m_BusID) {
+                pDest = buses[j]->getBuffer();
+                break;
+            }
+        }
+        AudioBuffer& sample = *voice.m_pSample;
+        int channels = sample.getNumChannels();
+        int framesToMix = min(numFrames, sample.getNumFrames()-voice.m_Pos);
+        if (framesToMix > 0) {
+            float endGain = voice.m_bReleasing ? 0.f : voice.m_Volume;
+            const float* pChannelGains = 0;
+            if (voice.m_bHasChannelGains) {
+                pChannelGains = voice.m_ChannelGains;
+            }
+            mixS16ToFloat(pDest, sample.getData()+voice.m_Pos*channels, framesToMix,
+                    channels, voice.m_Volume, endGain, pChannelGains);
+            voice.m_Pos += framesToMix;
+        }
+        if (voice.m_bReleasing || voice.m_Pos >= sample.getNumFrames()) {
+            // The engine still references the sample, so this doesn't free memory.
+            voice.m_pSample = AudioBufferPtr();
+        } else {
+            numVoices++;
+        }
+    }
+    m_NumVoices = numVoices;
+}
+
+void AudioSamplePlayer::startVoice(const Command& cmd)
+{
+    int maxVoices = m_MaxVoices;
+    int numPlaying = 0;
+    for (int i = 0; i < NUM_VOICE_SLOTS; ++i) {
+        if (m_Voices[i].m_pSample && !m_Voices[i].m_bReleasing) {
+            numPlaying++;
+        }
+    }
+    for (; numPlaying >= maxVoices; --numPlaying) {
+        m_Voices[findOldestVoice(false)].m_bReleasing = true;
+    }
+    int slot = findFreeSlot();
+    if (slot == -1) {
+        // Too many voices were stolen during this callback: cut off a fading one.
+        slot = findOldestVoice(true);
+    }
+    Voice& voice = m_Voices[slot];
+    voice.m_pSample = cmd.m_pSample;
+    voice.m_ID = cmd.m_VoiceID;
+    voice.m_Pos = 0;
+    voice.m_Volume = cmd.m_Volume;
+    voice.m_bHasChannelGains = cmd.m_bHasChannelGains;
+    if (cmd.m_bHasChannelGains) {
+        copy(cmd.m_ChannelGains, cmd.m_ChannelGains+AVG_MAX_AUDIO_CHANNELS,
+                voice.m_ChannelGains);
+    }
+    voice.m_BusID = cmd.m_BusID;
+    voice.m_bReleasing = false;
+}
+
+void AudioSamplePlayer::releaseVoice(int voiceID)
+{
+    for (int i = 0; i < NUM_VOICE_SLOTS; ++i) {
+        if (m_Voices[i].m_pSample && m_Voices[i].m_ID == voiceID) {
+            m_Voices[i].m_bReleasing = true;
+        }
+    }
+}
+
+int AudioSamplePlayer::findFreeSlot()
+{
+    for (int i = 0; i < NUM_VOICE_SLOTS; ++i) {
+        if (!m_Voices[i].m_pSample) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int AudioSamplePlayer::findOldestVoice(bool bReleasing)
+{
+    // Voice ids increase, so the smallest id was started first.
+    int oldest = -1;
+    for (int i = 0; i < NUM_VOICE_SLOTS; ++i) {
+        const Voice& voice = m_Voices[i];
+        if (voice.m_pSample && voice.m_bReleasing == bReleasing &&
+                (oldest == -1 || voice.m_ID < m_Voices[oldest].m_ID))
+        {
+            oldest = i;
+        }
+    }
+    return oldest;
+}
+
+}
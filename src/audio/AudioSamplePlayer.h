@@ -0,0 +1,112 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _AudioSamplePlayer_H_
+#define _AudioSamplePlayer_H_
+
+#include "../api.h"
+#include "AudioBuffer.h"
+#include "AudioBus.h"
+#include "AudioMix.h"
+
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/atomic.hpp>
+
+#include <vector>
+
+#define AVG_MAX_AUDIO_VOICES 64
+
+namespace avg {
+
+// Plays samples that are already in memory, so short sounds start without a decoder.
+// Each play() starts a voice. Voices are started and stopped from the main thread
+// through a lock-free queue and mixed in the audio callback. If more than the maximum
+// number of voices would play, the oldest one is faded out over one chunk.
+class AVG_API AudioSamplePlayer
+{
+public:
+    AudioSamplePlayer();
+    virtual ~AudioSamplePlayer();
+
+    // These are called from the main thread and never block the audio thread. pSample
+    // must have the engine's sample rate and channel count and stay referenced
+    // elsewhere until the audio thread has released it (see AudioEngine).
+    // pChannelGains can be 0. Returns the id of the new voice.
+    int play(AudioBufferPtr pSample, float volume, const float* pChannelGains,
+            int busID);
+    void stop(int voiceID);
+    void setMaxVoices(int maxVoices);
+    int getMaxVoices() const;
+    // Number of voices that are playing or fading out, as of the last callback.
+    int getNumVoices() const;
+    // Stops all voices immediately. Only called while the audio callback isn't running.
+    void reset();
+
+    // Called in the audio callback. processCommands() applies the play() and stop()
+    // calls made since the last callback, mixAudio() adds the next numFrames frames of
+    // each voice to its bus. busIDs is parallel to buses, voices whose bus is gone
+    // are mixed into buses[0].
+    void processCommands();
+    void mixAudio(const std::vector<int>& busIDs, const std::vector<AudioBusPtr>& buses,
+            int numFrames);
+
+private:
+    struct Command {
+        enum Type {PLAY, STOP};
+        Type m_Type;
+        int m_VoiceID;
+        AudioBufferPtr m_pSample;
+        float m_Volume;
+        bool m_bHasChannelGains;
+        float m_ChannelGains[AVG_MAX_AUDIO_CHANNELS];
+        int m_BusID;
+    };
+
+    struct Voice {
+        // Empty if the voice slot is unused.
+        AudioBufferPtr m_pSample;
+        int m_ID;
+        int m_Pos;
+        float m_Volume;
+        bool m_bHasChannelGains;
+        float m_ChannelGains[AVG_MAX_AUDIO_CHANNELS];
+        int m_BusID;
+        bool m_bReleasing;
+    };
+
+    void startVoice(const Command& cmd);
+    void releaseVoice(int voiceID);
+    int findFreeSlot();
+    int findOldestVoice(bool bReleasing);
+
+    boost::lockfree::spsc_queue<Command, boost::lockfree::capacity<256> > m_Commands;
+    int m_NextVoiceID;
+
+    // Stolen voices fade out while the new voice starts, so there are twice as many
+    // slots as voices.
+    Voice m_Voices[2*AVG_MAX_AUDIO_VOICES];
+    boost::atomic<int> m_MaxVoices;
+    boost::atomic<int> m_NumVoices;
+};
+
+}
+
+#endif
@@ -21,9 +21,13 @@
 
 #include "AudioSource.h"
 #include "AudioEngine.h"
+#include "AudioMix.h"
 
 #include <string>
 #include <algorithm>
+#include <cstring>
+
+#define NUM_TIME_MSGS 4
 
 using namespace std;
 
@@ -33,11 +37,19 @@ AudioSource::AudioSource(AudioMsgQueue& msgQ, AudioMsgQueue& statusQ, int sample
     : m_MsgQ(msgQ),
       m_StatusQ(statusQ),
       m_SampleRate(sampleRate),
+      m_pInputAudioBuffer(0),
       m_bPaused(false),
-      m_bSeeking(false),
+      m_NumPendingSeeks(0),
       m_Volume(1.0),
-      m_LastVolume(1.0)
+      m_LastVolume(1.0),
+      m_bHasChannelGains(false)
 {
+    for (int i = 0; i < AVG_MAX_AUDIO_CHANNELS; ++i) {
+        m_ChannelGains[i] = 1.f;
+    }
+    for (int i = 0; i < NUM_TIME_MSGS; ++i) {
+        m_pTimeMsgs.push_back(AudioMsgPtr(new AudioMsg));
+    }
 }
 
 AudioSource::~AudioSource()
@@ -56,10 +68,8 @@ void AudioSource::play()
 
 void AudioSource::notifySeek()
 {
-    while (m_bSeeking) {
-        processNextMsg(true);
-    }
-    m_bSeeking = true;
+    // The audio thread discards everything up to the matching SEEK_DONE message.
+    m_NumPendingSeeks++;
 }
     
 void AudioSource::setVolume(float volume)
@@ -67,82 +77,113 @@ void AudioSource::setVolume(float volume)
     m_Volume = volume;
 }
 
-void AudioSource::fillAudioBuffer(AudioBufferPtr pBuffer)
+void AudioSource::setChannelGains(const float* pGains, int channels)
 {
-    bool bContinue = true;
-    while (bContinue && m_bSeeking) {
-        bContinue = processNextMsg(false);
+    AVG_ASSERT(channels <= AVG_MAX_AUDIO_CHANNELS);
+    bool bHasChannelGains = false;
+    for (int i = 0; i < channels; ++i) {
+        m_ChannelGains[i] = pGains[i];
+        if (pGains[i] != 1.f) {
+            bHasChannelGains = true;
+        }
     }
-    if (!m_bPaused) {
-        unsigned char* pDest = (unsigned char *)(pBuffer->getData());
-        int framesLeftToFill = pBuffer->getNumFrames();
-        AudioMsgPtr pMsg;
-        while (framesLeftToFill > 0) {
-            int framesLeftInBuffer = 0;
-            if (m_pInputAudioBuffer) {
-                framesLeftInBuffer = m_pInputAudioBuffer->getNumFrames()
-                        - m_CurInputAudioPos;
-            }
-            while (framesLeftInBuffer > 0 && framesLeftToFill > 0) {
-                int framesToCopy = min(framesLeftToFill, framesLeftInBuffer);
-    //            cerr << "framesToCopy: " << framesToCopy << endl;
-                char * pInputPos = (char*)m_pInputAudioBuffer->getData() + 
-                        m_CurInputAudioPos*pBuffer->getFrameSize();
-                int bytesToCopy = framesToCopy*pBuffer->getFrameSize();
-                memcpy(pDest, pInputPos, bytesToCopy);
-                m_CurInputAudioPos += framesToCopy;
-                framesLeftToFill -= framesToCopy;
-                framesLeftInBuffer -= framesToCopy;
-                pDest += bytesToCopy;
-
-                m_LastTime += framesToCopy/m_SampleRate;
-    //            cerr << "  " << m_LastTime << endl;
-            }
-            if (framesLeftToFill != 0) {
-                bool bContinue = processNextMsg(false);
-                if (!bContinue) {
-                    framesLeftToFill = 0;
-                }
-            }
+    m_bHasChannelGains = bHasChannelGains;
+}
+
+void AudioSource::mixAudio(float* pDest, AudioBufferPtr pTempBuffer, int numFrames)
+{
+    if (m_pInputMsg && m_pInputMsg->getType() != AudioMsg::AUDIO) {
+        // A SEEK_DONE or END_OF_FILE that didn't fit into the status queue last time.
+        passOnInputMsg();
+    }
+    while (m_NumPendingSeeks > 0 && processNextMsg()) {
+    }
+    if (m_bPaused || m_NumPendingSeeks > 0) {
+        return;
+    }
+    fillAudioBuffer(pTempBuffer, numFrames);
+    float volume = m_Volume;
+    int channels = pTempBuffer->getNumChannels();
+    float channelGains[AVG_MAX_AUDIO_CHANNELS];
+    float* pChannelGains = 0;
+    if (m_bHasChannelGains) {
+        for (int i = 0; i < channels; ++i) {
+            channelGains[i] = m_ChannelGains[i];
+        }
+        pChannelGains = channelGains;
+    }
+    mixS16ToFloat(pDest, pTempBuffer->getData(), numFrames, channels, m_LastVolume,
+            volume, pChannelGains);
+    m_LastVolume = volume;
+    sendAudioTime();
+}
+
+void AudioSource::fillAudioBuffer(AudioBufferPtr pBuffer, int numFrames)
+{
+    unsigned char* pDest = (unsigned char *)(pBuffer->getData());
+    int framesLeftToFill = numFrames;
+    while (framesLeftToFill > 0) {
+        int framesLeftInBuffer = 0;
+        if (m_pInputAudioBuffer) {
+            framesLeftInBuffer = m_pInputAudioBuffer->getNumFrames()
+                    - m_CurInputAudioPos;
         }
-        pBuffer->volumize(m_LastVolume, m_Volume);
-        m_LastVolume = m_Volume;
+        while (framesLeftInBuffer > 0 && framesLeftToFill > 0) {
+            int framesToCopy = min(framesLeftToFill, framesLeftInBuffer);
+//            cerr << "framesToCopy: " << framesToCopy << endl;
+            char * pInputPos = (char*)m_pInputAudioBuffer->getData() + 
+                    m_CurInputAudioPos*pBuffer->getFrameSize();
+            int bytesToCopy = framesToCopy*pBuffer->getFrameSize();
+            memcpy(pDest, pInputPos, bytesToCopy);
+            m_CurInputAudioPos += framesToCopy;
+            framesLeftToFill -= framesToCopy;
+            framesLeftInBuffer -= framesToCopy;
+            pDest += bytesToCopy;
 
-        AudioMsgPtr pStatusMsg(new AudioMsg);
-        pStatusMsg->setAudioTime(m_LastTime);
-        m_StatusQ.push(pStatusMsg);
+            m_LastTime += framesToCopy/m_SampleRate;
+//            cerr << "  " << m_LastTime << endl;
+        }
+        if (framesLeftToFill != 0) {
+            bool bContinue = processNextMsg();
+            if (!bContinue) {
+                // Buffer underrun or end of file.
+                memset(pDest, 0, framesLeftToFill*pBuffer->getFrameSize());
+                framesLeftToFill = 0;
+            }
+        }
     }
 }
     
-bool AudioSource::processNextMsg(bool bWait)
+bool AudioSource::processNextMsg()
 {
-    AudioMsgPtr pMsg = m_MsgQ.pop(bWait);
+    if (!passOnInputMsg()) {
+        return false;
+    }
+    AudioMsgPtr pMsg = m_MsgQ.pop(false);
     if (pMsg) {
+        m_pInputMsg = pMsg;
         switch (pMsg->getType()) {
             case AudioMsg::AUDIO:
-                m_pInputAudioBuffer = pMsg->getAudioBuffer();
+                m_pInputAudioBuffer = pMsg->getAudioBuffer().get();
                 m_CurInputAudioPos = 0;
                 m_LastTime = pMsg->getAudioTime();
 //                cerr << "  New buffer: " << m_LastTime << endl;
                 return true;
-            case AudioMsg::END_OF_FILE: {
+            case AudioMsg::END_OF_FILE:
 //                cerr << "        AudioSource: EOF" << endl;
-                m_bSeeking = false;
-                AudioMsgPtr pStatusMsg(new AudioMsg);
-                pStatusMsg->setEOF();
-                m_StatusQ.push(pStatusMsg);
+                // Seeks can't complete anymore. notifySeek() may have added one in the
+                // meantime, so only the seeks seen here are cancelled.
+                m_NumPendingSeeks -= m_NumPendingSeeks.load();
+                passOnInputMsg();
                 return false;
-            }
-            case AudioMsg::SEEK_DONE: {
+            case AudioMsg::SEEK_DONE:
 //                cerr << "        AudioSource: SEEK_DONE" << endl;
-                m_bSeeking = false;
-                m_pInputAudioBuffer = AudioBufferPtr();
+                if (m_NumPendingSeeks > 0) {
+                    m_NumPendingSeeks--;
+                }
                 m_LastTime = pMsg->getSeekTime();
-                AudioMsgPtr pStatusMsg(new AudioMsg);
-                pStatusMsg->setSeekDone(pMsg->getSeekSeqNum(), m_LastTime);
-                m_StatusQ.push(pStatusMsg);
+                passOnInputMsg();
                 return true;
-            }
             default:
                 AVG_ASSERT(false);
                 return false;
@@ -153,4 +194,31 @@ bool AudioSource::processNextMsg(bool bWait)
     }
 }
 
+bool AudioSource::passOnInputMsg()
+{
+    if (m_pInputMsg) {
+        // The status queue keeps the message, so dropping it here doesn't free it.
+        if (!m_StatusQ.tryPush(m_pInputMsg)) {
+            return false;
+        }
+        m_pInputMsg = AudioMsgPtr();
+        m_pInputAudioBuffer = 0;
+    }
+    return true;
+}
+
+void AudioSource::sendAudioTime()
+{
+    // A time message can be reused once the thread reading the status queue has
+    // dropped it. If none is free, that thread is behind and gets the next update.
+    for (unsigned i = 0; i < m_pTimeMsgs.size(); ++i) {
+        if (m_pTimeMsgs[i].unique()) {
+            boost::atomic_thread_fence(boost::memory_order_acquire);
+            m_pTimeMsgs[i]->setAudioTime(m_LastTime);
+            m_StatusQ.tryPush(m_pTimeMsgs[i]);
+            return;
+        }
+    }
+}
+
 }
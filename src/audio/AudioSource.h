@@ -25,8 +25,12 @@
 #include "../api.h"
 
 #include "AudioMsg.h"
+#include "AudioMix.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
+
+#include <vector>
 
 namespace avg
 {
@@ -37,26 +41,48 @@ public:
     AudioSource(AudioMsgQueue& msgQ, AudioMsgQueue& statusQ, int sampleRate);
     virtual ~AudioSource();
 
+    // These are called from the main thread and never block the audio thread.
     void pause();
     void play();
     void notifySeek();
     void setVolume(float volume);
+    // Per-channel gains on top of the volume, used for panning. Changes take effect
+    // at the start of the next buffer.
+    void setChannelGains(const float* pGains, int channels);
 
-    void fillAudioBuffer(AudioBufferPtr pBuffer);
+    // Called in the audio callback. Adds numFrames frames of audio to pDest, using
+    // pTempBuffer as scratch space.
+    // The audio thread never allocates or frees messages or buffers: Every message
+    // taken from msgQ is passed on to statusQ once the source is done with it, so the
+    // thread that reads statusQ frees it. If statusQ is full, the source stops reading
+    // msgQ until there is room again. AUDIO_TIME messages come from a small pool and are
+    // reused once the reader has dropped them. statusQ should be a bounded lock-free
+    // queue, otherwise pushing takes its mutex.
+    void mixAudio(float* pDest, AudioBufferPtr pTempBuffer, int numFrames);
 
 private:
-    bool processNextMsg(bool bWait);
+    void fillAudioBuffer(AudioBufferPtr pBuffer, int numFrames);
+    bool processNextMsg();
+    bool passOnInputMsg();
+    void sendAudioTime();
 
     AudioMsgQueue& m_MsgQ;    
     AudioMsgQueue& m_StatusQ;
     int m_SampleRate;
-    AudioBufferPtr m_pInputAudioBuffer;
+    // The last message taken from m_MsgQ, until it has been passed on to m_StatusQ.
+    AudioMsgPtr m_pInputMsg;
+    // Owned by m_pInputMsg, 0 if there is no current buffer.
+    AudioBuffer* m_pInputAudioBuffer;
+    std::vector<AudioMsgPtr> m_pTimeMsgs;
     float m_LastTime;
     int m_CurInputAudioPos;
-    bool m_bPaused;
-    bool m_bSeeking;
-    float m_Volume;
+    boost::atomic<bool> m_bPaused;
+    // Number of seeks whose SEEK_DONE message hasn't arrived yet.
+    boost::atomic<int> m_NumPendingSeeks;
+    boost::atomic<float> m_Volume;
     float m_LastVolume;
+    boost::atomic<float> m_ChannelGains[AVG_MAX_AUDIO_CHANNELS];
+    boost::atomic<bool> m_bHasChannelGains;
 };
 
 typedef boost::shared_ptr<AudioSource> AudioSourcePtr;
@@ -36,6 +36,7 @@
 #define LOOKAHEAD 64
 #define AVG1 27
 #define AVG2 38
+#define DYNAMICS_BLOCK_SIZE 64
 
 namespace avg {
 
@@ -47,6 +48,7 @@ class AVG_API Dynamics: public IProcessor<T>
         Dynamics(T fs);
         virtual ~Dynamics();
         virtual void process(T* pSamples);
+        virtual void processBlock(T* pSamples, int numFrames);
 
         void setThreshold(T threshold);
         T getThreshold() const;
@@ -62,7 +64,7 @@ class AVG_API Dynamics: public IProcessor<T>
         T getMakeupGain() const;
 
     private:
-        void maxFilter(T& rms);
+        void processSubBlock(T* pSamples, int numFrames);
 
         T m_fs;
 
@@ -88,12 +90,14 @@ class AVG_API Dynamics: public IProcessor<T>
         T* avg1Buf_;
         int avg1BufRIdx_;
         int avg1BufWIdx_;
-        T avg1Old_;
+        // The moving sums are kept in double precision. In float, they slowly drift
+        // by an amount that depends on how the compiler orders the additions.
+        double avg1Old_;
 
         T* avg2Buf_;
         int avg2BufRIdx_;
         int avg2BufWIdx_;
-        T avg2Old_;
+        double avg2Old_;
 
         T* delayBuf_;
         int delayBufIdx_;
@@ -166,89 +170,139 @@ Dynamics<T, CHANNELS>::~Dynamics()
 }
 
 template<typename T, int CHANNELS>
-void Dynamics<T, CHANNELS>::maxFilter(T& rms)
+void Dynamics<T, CHANNELS>::process(T* pSamples)
+{
+    processSubBlock(pSamples, 1);
+}
+
+// The block version splits processing into stages: The peak, rms and output loops
+// run over the whole block and are vectorized by the compiler, while the stages
+// that depend on the previous sample (lookahead, envelope, smoothing) run in one
+// loop that keeps the filter state in local variables. process() is a block of one
+// frame, so both can be mixed freely and the results don't depend on the block size.
+template<typename T, int CHANNELS>
+void Dynamics<T, CHANNELS>::processBlock(T* pSamples, int numFrames)
 {
-    int j = lookaheadBufIdx_;
-    for (int i = 0; i < LOOKAHEAD; i++)
-    {
-        j = (j+1)&(LOOKAHEAD-1);
-        if (lookaheadBuf_[j] < rms) {
-            lookaheadBuf_[j] = rms;
+    for (int i = 0; i < numFrames; i += DYNAMICS_BLOCK_SIZE) {
+        int framesInBlock = numFrames-i;
+        if (framesInBlock > DYNAMICS_BLOCK_SIZE) {
+            framesInBlock = DYNAMICS_BLOCK_SIZE;
         }
+        processSubBlock(pSamples+i*CHANNELS, framesInBlock);
     }
 }
 
 template<typename T, int CHANNELS>
-void Dynamics<T, CHANNELS>::process(T* pSamples)
+void Dynamics<T, CHANNELS>::processSubBlock(T* pSamples, int numFrames)
 {
+    T rms[DYNAMICS_BLOCK_SIZE];
+    T gain[DYNAMICS_BLOCK_SIZE];
 
     //---------------- Preprocessing
-    T x = 0.f;
-    for (int i = 0; i < CHANNELS; i++) {
-        // Apply pregain
-        const T tmp = pSamples[i] * preGain_;
-
-        T abs = std::fabs(tmp);
-        if (abs > x) {
-            x = abs;
+    for (int f = 0; f < numFrames; f++) {
+        T x = 0.f;
+        for (int i = 0; i < CHANNELS; i++) {
+            T abs = std::fabs(pSamples[f*CHANNELS+i] * preGain_);
+            if (abs > x) {
+                x = abs;
+            }
         }
+        rms[f] = x;
     }
 
     //---------------- RMS
-    T rms = (1.f - rmsCoef_) * x * x + rmsCoef_ * rms1_;
-    rms1_ = rms;
-    rms   = sqrt(rms);
-
-    //---------------- Max filter
-    if (rms > 1.) {
-        maxFilter(rms);
-    }
-
-    //---------------- Ratio
-    T dbMax  = std::log10(lookaheadBuf_[lookaheadBufIdx_]);
-    T dbComp = dbMax * inverseRatio_;
-    T comp   = std::pow(static_cast<T>(10.), dbComp);
-    T c      = comp / lookaheadBuf_[lookaheadBufIdx_];
-
-    lookaheadBuf_[lookaheadBufIdx_] = 1.;
-    lookaheadBufIdx_ = (lookaheadBufIdx_+1)%LOOKAHEAD;
-
-    //---------------- Attack/release envelope
-    if (env1_ <= c) {
-        c = c + (env1_ - c) * relCoef_;
+    if (rmsCoef_ == 0.f) {
+        // Without averaging, the rms value is the peak value. Using it directly
+        // instead of sqrt(x*x) keeps -ffast-math from rounding differently depending
+        // on the block size.
+        rms1_ = rms[numFrames-1] * rms[numFrames-1];
     } else {
-        c = c + (env1_ - c) * attCoef_;
+        T rms1 = rms1_;
+        for (int f = 0; f < numFrames; f++) {
+            rms1 = (1.f - rmsCoef_) * rms[f] * rms[f] + rmsCoef_ * rms1;
+            rms[f] = rms1;
+        }
+        rms1_ = rms1;
+        for (int f = 0; f < numFrames; f++) {
+            rms[f] = sqrt(rms[f]);
+        }
     }
-    env1_ = c;
 
-    //---------------- Smoothing
-    const T tmp1           = avg1Old_ + c - avg1Buf_[avg1BufRIdx_];
-    avg1Old_               = tmp1;
-    avg1Buf_[avg1BufWIdx_] = c;
-    c = tmp1;
-    avg1BufRIdx_ = (avg1BufRIdx_+1)%AVG1;
-    avg1BufWIdx_ = (avg1BufWIdx_+1)%AVG1;
+    //---------------- Max filter, ratio, envelope and smoothing
+    int lookaheadBufIdx = lookaheadBufIdx_;
+    T env1 = env1_;
+    int avg1BufRIdx = avg1BufRIdx_;
+    int avg1BufWIdx = avg1BufWIdx_;
+    double avg1Old = avg1Old_;
+    int avg2BufRIdx = avg2BufRIdx_;
+    int avg2BufWIdx = avg2BufWIdx_;
+    double avg2Old = avg2Old_;
+    for (int f = 0; f < numFrames; f++) {
+        if (rms[f] > 1.) {
+            // All elements are raised, so the order doesn't matter and the loop
+            // vectorizes.
+            const T r = rms[f];
+            for (int i = 0; i < LOOKAHEAD; i++) {
+                lookaheadBuf_[i] = lookaheadBuf_[i] < r ? r : lookaheadBuf_[i];
+            }
+        }
 
-    const T tmp2           = avg2Old_ + c - avg2Buf_[avg2BufRIdx_];
-    avg2Old_               = tmp2;
-    avg2Buf_[avg2BufWIdx_] = c;
-    c = tmp2;
-    avg2BufRIdx_ = (avg2BufRIdx_+1)%AVG2;
-    avg2BufWIdx_ = (avg2BufWIdx_+1)%AVG2;
+        T c;
+        const T peak = lookaheadBuf_[lookaheadBufIdx];
+        if (peak == 1.) {
+            // Below the threshold: log10 and pow would return exactly 1.
+            c = 1.;
+        } else {
+            T dbComp = std::log10(peak) * inverseRatio_;
+            c = std::pow(static_cast<T>(10.), dbComp) / peak;
+        }
+        lookaheadBuf_[lookaheadBufIdx] = 1.;
+        lookaheadBufIdx = (lookaheadBufIdx+1)%LOOKAHEAD;
 
-    c = c / (static_cast<T>(AVG1) * static_cast<T>(AVG2));
+        if (env1 <= c) {
+            c = c + (env1 - c) * relCoef_;
+        } else {
+            c = c + (env1 - c) * attCoef_;
+        }
+        env1 = c;
+
+        const double tmp1 = avg1Old + c - avg1Buf_[avg1BufRIdx];
+        avg1Old = tmp1;
+        avg1Buf_[avg1BufWIdx] = c;
+        c = T(tmp1);
+        avg1BufRIdx = (avg1BufRIdx+1)%AVG1;
+        avg1BufWIdx = (avg1BufWIdx+1)%AVG1;
+
+        const double tmp2 = avg2Old + c - avg2Buf_[avg2BufRIdx];
+        avg2Old = tmp2;
+        avg2Buf_[avg2BufWIdx] = c;
+        c = T(tmp2);
+        avg2BufRIdx = (avg2BufRIdx+1)%AVG2;
+        avg2BufWIdx = (avg2BufWIdx+1)%AVG2;
+
+        gain[f] = c / (static_cast<T>(AVG1) * static_cast<T>(AVG2));
+    }
+    lookaheadBufIdx_ = lookaheadBufIdx;
+    env1_ = env1;
+    avg1BufRIdx_ = avg1BufRIdx;
+    avg1BufWIdx_ = avg1BufWIdx;
+    avg1Old_ = avg1Old;
+    avg2BufRIdx_ = avg2BufRIdx;
+    avg2BufWIdx_ = avg2BufWIdx;
+    avg2Old_ = avg2Old;
 
     //---------------- Postprocessing
-    for (int i = 0; i < CHANNELS; i++) {
-        // Delay input samples
-        const T in                 = delayBuf_[delayBufIdx_*CHANNELS+i];
-        delayBuf_[delayBufIdx_*CHANNELS+i] = pSamples[i];
-
-        // Apply control signal
-        pSamples[i] = in * c * postGain_;
+    int delayBufIdx = delayBufIdx_;
+    for (int f = 0; f < numFrames; f++) {
+        T* pDelayed = delayBuf_ + delayBufIdx*CHANNELS;
+        for (int i = 0; i < CHANNELS; i++) {
+            const T in = pDelayed[i];
+            pDelayed[i] = pSamples[f*CHANNELS+i];
+            pSamples[f*CHANNELS+i] = in * gain[f] * postGain_;
+        }
+        delayBufIdx = (delayBufIdx+1)&(LOOKAHEAD-1);
     }
-
-    delayBufIdx_ = (delayBufIdx_+1)&(LOOKAHEAD-1);
+    delayBufIdx_ = delayBufIdx;
 }
 
 template<typename T, int CHANNELS>
@@ -29,7 +29,11 @@ class AVG_API IProcessor
 {
 public:
     virtual ~IProcessor() {};
+    // Processes one frame of interleaved samples in place.
     virtual void process(T* pSamples) = 0;
+    // Processes numFrames frames. Gives the same results as calling process() for
+    // every frame.
+    virtual void processBlock(T* pSamples, int numFrames) = 0;
 
 };
 
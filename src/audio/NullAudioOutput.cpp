@@ -0,0 +1,147 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "NullAudioOutput.h"
+
+#include "../base/Exception.h"
+
+#include <string.h>
+
+using namespace std;
+
+namespace avg {
+
+NullAudioOutput::NullAudioOutput(const string& sFilename)
+    : m_sFilename(sFilename),
+      m_pFile(0),
+      m_pCallback(0),
+      m_pUserData(0),
+      m_bPaused(true),
+      m_NumFramesRendered(0)
+{
+}
+
+NullAudioOutput::~NullAudioOutput()
+{
+    closeFile();
+}
+
+void NullAudioOutput::open(const AudioParams& ap, MixCallback pCallback,
+        void* pUserData)
+{
+    boost::recursive_mutex::scoped_lock lock(m_Mutex);
+    m_AP = ap;
+    m_pCallback = pCallback;
+    m_pUserData = pUserData;
+    if (!m_sFilename.empty() && !m_pFile) {
+        m_pFile = fopen(m_sFilename.c_str(), "wb");
+        if (!m_pFile) {
+            throw Exception(AVG_ERR_FILEIO, "Can't open audio output file '" +
+                    m_sFilename + "'.");
+        }
+        writeWAVHeader();
+    }
+}
+
+void NullAudioOutput::setPaused(bool bPaused)
+{
+    boost::recursive_mutex::scoped_lock lock(m_Mutex);
+    m_bPaused = bPaused;
+}
+
+void NullAudioOutput::lock()
+{
+    m_Mutex.lock();
+}
+
+void NullAudioOutput::unlock()
+{
+    m_Mutex.unlock();
+}
+
+const short* NullAudioOutput::render(int numFrames)
+{
+    boost::recursive_mutex::scoped_lock lock(m_Mutex);
+    AVG_ASSERT(m_pCallback);
+    m_Buffer.resize(numFrames*m_AP.m_Channels);
+    if (m_bPaused) {
+        memset(&m_Buffer[0], 0, m_Buffer.size()*sizeof(short));
+    } else {
+        m_pCallback(m_pUserData, (Uint8*)&m_Buffer[0],
+                int(m_Buffer.size()*sizeof(short)));
+        m_NumFramesRendered += numFrames;
+        if (m_pFile) {
+            fwrite(&m_Buffer[0], sizeof(short), m_Buffer.size(), m_pFile);
+        }
+    }
+    return &m_Buffer[0];
+}
+
+long long NullAudioOutput::getNumFramesRendered() const
+{
+    return m_NumFramesRendered;
+}
+
+static void writeU32(unsigned char* pDest, unsigned val)
+{
+    for (int i = 0; i < 4; ++i) {
+        pDest[i] = (unsigned char)(val >> (8*i));
+    }
+}
+
+static void writeU16(unsigned char* pDest, unsigned val)
+{
+    pDest[0] = (unsigned char)val;
+    pDest[1] = (unsigned char)(val >> 8);
+}
+
+void NullAudioOutput::writeWAVHeader()
+{
+    // Canonical 44 byte PCM header. Sizes are filled in by closeFile().
+    unsigned dataSize = unsigned(m_NumFramesRendered*m_AP.m_Channels*sizeof(short));
+    unsigned char header[44];
+    memcpy(header, "RIFF", 4);
+    writeU32(header+4, 36+dataSize);
+    memcpy(header+8, "WAVEfmt ", 8);
+    writeU32(header+16, 16);
+    writeU16(header+20, 1);
+    writeU16(header+22, m_AP.m_Channels);
+    writeU32(header+24, m_AP.m_SampleRate);
+    writeU32(header+28, m_AP.m_SampleRate*m_AP.m_Channels*2);
+    writeU16(header+32, m_AP.m_Channels*2);
+    writeU16(header+34, 16);
+    memcpy(header+36, "data", 4);
+    writeU32(header+40, dataSize);
+    fwrite(header, 1, 44, m_pFile);
+}
+
+void NullAudioOutput::closeFile()
+{
+    if (m_pFile) {
+        fseek(m_pFile, 0, SEEK_SET);
+        writeWAVHeader();
+        fclose(m_pFile);
+        m_pFile = 0;
+    }
+}
+
+}
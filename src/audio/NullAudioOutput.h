@@ -0,0 +1,76 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _NullAudioOutput_H_
+#define _NullAudioOutput_H_
+
+#include "../api.h"
+#include "AudioOutput.h"
+
+#include <boost/thread/recursive_mutex.hpp>
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+namespace avg {
+
+// Output device without a sound card. Audio is only mixed when render() is called, in
+// the calling thread, which makes it possible to test and benchmark the AudioEngine
+// headless. If a filename is given, the output is also written to a wav file. Samples
+// are written in host byte order, which matches the format on little-endian machines.
+class AVG_API NullAudioOutput: public AudioOutput
+{
+public:
+    NullAudioOutput(const std::string& sFilename="");
+    virtual ~NullAudioOutput();
+
+    virtual void open(const AudioParams& ap, MixCallback pCallback, void* pUserData);
+    virtual void setPaused(bool bPaused);
+
+    virtual void lock();
+    virtual void unlock();
+
+    // Mixes numFrames frames unless the output is paused. Returns the mixed samples.
+    const short* render(int numFrames);
+    long long getNumFramesRendered() const;
+
+private:
+    void writeWAVHeader();
+    void closeFile();
+
+    std::string m_sFilename;
+    FILE* m_pFile;
+    AudioParams m_AP;
+    MixCallback m_pCallback;
+    void* m_pUserData;
+    bool m_bPaused;
+    std::vector<short> m_Buffer;
+    long long m_NumFramesRendered;
+    boost::recursive_mutex m_Mutex;
+};
+
+typedef boost::shared_ptr<NullAudioOutput> NullAudioOutputPtr;
+
+}
+
+#endif
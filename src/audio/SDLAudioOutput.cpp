@@ -0,0 +1,81 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "SDLAudioOutput.h"
+
+#include "../base/Logger.h"
+
+#include <stdlib.h>
+
+namespace avg {
+
+SDLAudioOutput::SDLAudioOutput()
+{
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) == -1) {
+        AVG_LOG_ERROR("Can't init SDL audio subsystem.");
+        exit(-1);
+    }
+}
+
+SDLAudioOutput::~SDLAudioOutput()
+{
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+void SDLAudioOutput::open(const AudioParams& ap, MixCallback pCallback, void* pUserData)
+{
+    SDL_AudioSpec desired;
+    desired.freq = ap.m_SampleRate;
+    desired.format = AUDIO_S16SYS;
+    desired.channels = ap.m_Channels;
+    desired.silence = 0;
+    desired.samples = ap.m_OutputBufferSamples;
+    desired.callback = pCallback;
+    desired.userdata = pUserData;
+
+    int err = SDL_OpenAudio(&desired, 0);
+    if (err < 0) {
+        static bool bWarned = false;
+        if (!bWarned) {
+            AVG_TRACE(Logger::category::CONFIG, Logger::severity::WARNING,
+                    "Can't open audio: " << SDL_GetError());
+            bWarned = true;
+        }
+    }
+}
+
+void SDLAudioOutput::setPaused(bool bPaused)
+{
+    SDL_PauseAudio(bPaused);
+}
+
+void SDLAudioOutput::lock()
+{
+    SDL_LockAudio();
+}
+
+void SDLAudioOutput::unlock()
+{
+    SDL_UnlockAudio();
+}
+
+}
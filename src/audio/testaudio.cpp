@@ -0,0 +1,977 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "AudioEngine.h"
+#include "AudioMix.h"
+#include "NullAudioOutput.h"
+
+#include "../base/TestSuite.h"
+#include "../base/Exception.h"
+#include "../base/TimeSource.h"
+#include "../base/MathHelper.h"
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <iostream>
+#include <vector>
+#include <set>
+#include <algorithm>
+
+using namespace avg;
+using namespace std;
+
+class AudioMixTest: public Test {
+public:
+    AudioMixTest()
+        : Test("AudioMixTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        int channelCounts[] = {1, 2, 3, 4, 6, 8};
+        for (int i = 0; i < 6; ++i) {
+            testMix(channelCounts[i], 1021, 1.f, 1.f, false);
+            testMix(channelCounts[i], 1021, 0.2f, 0.9f, false);
+            testMix(channelCounts[i], 1021, 0.2f, 0.9f, true);
+            testGainRamp(channelCounts[i], 1021, 1.f, 0.3f);
+        }
+        testConvert();
+        testAddChannels();
+        testInterleave(1);
+        testInterleave(2);
+        testInterleave(6);
+    }
+
+private:
+    void testMix(int channels, int numFrames, float startGain, float endGain,
+            bool bChannelGains)
+    {
+        float channelGains[AVG_MAX_AUDIO_CHANNELS];
+        for (int i = 0; i < AVG_MAX_AUDIO_CHANNELS; ++i) {
+            channelGains[i] = 1.f-i*0.1f;
+        }
+        float* pChannelGains = 0;
+        if (bChannelGains) {
+            pChannelGains = channelGains;
+        }
+        int numSamples = numFrames*channels;
+        vector<short> src(numSamples);
+        for (int i = 0; i < numSamples; ++i) {
+            src[i] = short((i*7919) % 65536 - 32768);
+        }
+        vector<float> simdDest(numSamples, 0.25f);
+        vector<float> scalarDest(numSamples, 0.25f);
+        mixS16ToFloat(&simdDest[0], &src[0], numFrames, channels, startGain, endGain,
+                pChannelGains);
+        setAudioMixSIMDEnabled(false);
+        mixS16ToFloat(&scalarDest[0], &src[0], numFrames, channels, startGain, endGain,
+                pChannelGains);
+        setAudioMixSIMDEnabled(true);
+        TEST(maxDiff(simdDest, scalarDest) < 1e-6f);
+    }
+
+    void testGainRamp(int channels, int numFrames, float startGain, float endGain)
+    {
+        int numSamples = numFrames*channels;
+        vector<float> simdBuffer(numSamples);
+        for (int i = 0; i < numSamples; ++i) {
+            simdBuffer[i] = sin(i*0.01f);
+        }
+        vector<float> scalarBuffer = simdBuffer;
+        applyGainRamp(&simdBuffer[0], numFrames, channels, startGain, endGain);
+        setAudioMixSIMDEnabled(false);
+        applyGainRamp(&scalarBuffer[0], numFrames, channels, startGain, endGain);
+        setAudioMixSIMDEnabled(true);
+        TEST(maxDiff(simdBuffer, scalarBuffer) < 1e-6f);
+    }
+
+    void testConvert()
+    {
+        const int NUM_SAMPLES = 1003;
+        vector<float> src(NUM_SAMPLES);
+        for (int i = 0; i < NUM_SAMPLES; ++i) {
+            src[i] = 1.5f*sin(i*0.05f);
+        }
+        src[0] = 1.f;
+        src[1] = -1.f;
+        vector<short> simdDest(NUM_SAMPLES);
+        vector<short> scalarDest(NUM_SAMPLES);
+        floatToS16(&src[0], &simdDest[0], NUM_SAMPLES);
+        setAudioMixSIMDEnabled(false);
+        floatToS16(&src[0], &scalarDest[0], NUM_SAMPLES);
+        setAudioMixSIMDEnabled(true);
+        TEST(simdDest == scalarDest);
+        TEST(simdDest[0] == 32767);
+        TEST(simdDest[1] == -32768);
+    }
+
+    void testAddChannels()
+    {
+        const int CHANNELS = 3;
+        float src[] = {1, 2, 3, 4, 5, 6};
+        float dest[] = {1, 1, 1, 1, 1, 1};
+        int channelMap[] = {2, -1, 0};
+        addChannels(dest, src, 2, CHANNELS, channelMap);
+        TEST(dest[0] == 4 && dest[1] == 1 && dest[2] == 2);
+        TEST(dest[3] == 7 && dest[4] == 1 && dest[5] == 5);
+        addChannels(dest, src, 2, CHANNELS);
+        TEST(dest[0] == 5 && dest[1] == 3 && dest[5] == 11);
+    }
+
+    void testInterleave(int channels)
+    {
+        const int NUM_FRAMES = 1001;
+        vector<vector<short> > s16Planes(channels, vector<short>(NUM_FRAMES));
+        vector<vector<float> > floatPlanes(channels, vector<float>(NUM_FRAMES));
+        vector<const short*> pS16Planes;
+        vector<const float*> pFloatPlanes;
+        for (int c = 0; c < channels; ++c) {
+            for (int i = 0; i < NUM_FRAMES; ++i) {
+                s16Planes[c][i] = short(i*channels+c);
+                floatPlanes[c][i] = float(i*channels+c);
+            }
+            pS16Planes.push_back(&s16Planes[c][0]);
+            pFloatPlanes.push_back(&floatPlanes[c][0]);
+        }
+        vector<short> s16Dest(NUM_FRAMES*channels);
+        vector<float> floatDest(NUM_FRAMES*channels);
+        interleaveS16(&s16Dest[0], &pS16Planes[0], NUM_FRAMES, channels);
+        interleaveFloat(&floatDest[0], &pFloatPlanes[0], NUM_FRAMES, channels);
+        bool bOK = true;
+        for (int i = 0; i < NUM_FRAMES*channels; ++i) {
+            if (s16Dest[i] != short(i) || floatDest[i] != float(i)) {
+                bOK = false;
+            }
+        }
+        TEST(bOK);
+    }
+
+    float maxDiff(const vector<float>& v1, const vector<float>& v2)
+    {
+        float diff = 0;
+        for (unsigned i = 0; i < v1.size(); ++i) {
+            diff = max(diff, float(fabs(v1[i]-v2[i])));
+        }
+        return diff;
+    }
+};
+
+// Mixes into a NullAudioOutput. Each source plays the same buffer in a loop.
+class AudioEngineTestBase: public Test {
+public:
+    AudioEngineTestBase(const string& sName)
+        : Test(sName, 2)
+    {
+    }
+
+protected:
+    static const int NUM_FRAMES = 1024;
+
+    // Channel c of the source buffer is a sine with amplitude 1000*(c+1), or the
+    // constant 1000*(c+1) if bConstant is set.
+    void initEngine(AudioEngine& engine, int channels, bool bConstant=false)
+    {
+        AudioParams ap(44100, channels, NUM_FRAMES);
+        engine.init(ap, 1.f);
+        engine.play();
+        m_pBuffer = AudioBufferPtr(new AudioBuffer(NUM_FRAMES, ap));
+        short* pData = m_pBuffer->getData();
+        for (int i = 0; i < NUM_FRAMES; ++i) {
+            for (int j = 0; j < channels; ++j) {
+                float amplitude = 1000.f*(j+1);
+                if (bConstant) {
+                    pData[i*channels+j] = short(amplitude);
+                } else {
+                    pData[i*channels+j] = short(amplitude*sin(i*0.05f));
+                }
+            }
+        }
+    }
+
+    void feedSource(AudioMsgQueue& dataQ, int numBuffers)
+    {
+        AudioMsgPtr pMsg(new AudioMsg);
+        pMsg->setAudio(m_pBuffer, 0);
+        for (int i = 0; i < numBuffers; ++i) {
+            dataQ.push(pMsg);
+        }
+    }
+
+    AudioMsgPtr createAudioMsg()
+    {
+        AudioMsgPtr pMsg(new AudioMsg);
+        pMsg->setAudio(m_pBuffer, 0);
+        return pMsg;
+    }
+
+    int countStatusMsgs(AudioMsgQueue& statusQ, AudioMsg::MsgType type)
+    {
+        int numMsgs = 0;
+        AudioMsgPtr pMsg = statusQ.pop(false);
+        while (pMsg) {
+            if (pMsg->getType() == type) {
+                numMsgs++;
+            }
+            pMsg = statusQ.pop(false);
+        }
+        return numMsgs;
+    }
+
+private:
+    AudioBufferPtr m_pBuffer;
+};
+
+class AudioEngineTest: public AudioEngineTestBase {
+public:
+    AudioEngineTest()
+        : AudioEngineTestBase("AudioEngineTest")
+    {
+    }
+
+    void runTests()
+    {
+        NullAudioOutputPtr pOutput(new NullAudioOutput());
+        AudioEngine engine(pOutput);
+        initEngine(engine, 2);
+        const int NUM_SOURCES = 64;
+        const int NUM_CALLBACKS = 200;
+        vector<AudioMsgQueuePtr> pDataQs;
+        vector<AudioMsgQueuePtr> pStatusQs;
+        for (int i = 0; i < NUM_SOURCES; ++i) {
+            pDataQs.push_back(AudioMsgQueuePtr(new AudioMsgQueue()));
+            pStatusQs.push_back(AudioMsgQueuePtr(new AudioMsgQueue()));
+            feedSource(*pDataQs[i], NUM_CALLBACKS);
+            engine.addSource(*pDataQs[i], *pStatusQs[i]);
+        }
+        // Keep the sum below the limiter threshold.
+        engine.setVolume(0.4f);
+
+        const short* pDest = 0;
+        vector<long long> callbackTimes;
+        for (int i = 0; i < NUM_CALLBACKS; ++i) {
+            long long startTime = TimeSource::get()->getCurrentMicrosecs();
+            pDest = pOutput->render(NUM_FRAMES);
+            callbackTimes.push_back(TimeSource::get()->getCurrentMicrosecs()-startTime);
+        }
+        // The last buffer is still playing, the others have been passed back.
+        TEST(countStatusMsgs(*pStatusQs[0], AudioMsg::AUDIO) == NUM_CALLBACKS-1);
+        bool bSilent = true;
+        for (int i = 0; i < NUM_FRAMES*2; ++i) {
+            if (pDest[i] != 0) {
+                bSilent = false;
+            }
+        }
+        TEST(!bSilent);
+
+        sort(callbackTimes.begin(), callbackTimes.end());
+        cerr << string(m_IndentLevel+4, ' ') << NUM_SOURCES << " sources, "
+                << NUM_FRAMES << " frames: callback time (us) median: "
+                << callbackTimes[callbackTimes.size()/2] << ", max: "
+                << callbackTimes.back() << endl;
+        engine.teardown();
+    }
+};
+
+// The audio thread passes every message it takes from the data queue on to the status
+// queue, so it never frees them. If the status queue is full, the source waits instead,
+// and SEEK_DONE and END_OF_FILE still arrive in order.
+class AudioSourceStatusTest: public AudioEngineTestBase {
+public:
+    AudioSourceStatusTest()
+        : AudioEngineTestBase("AudioSourceStatusTest")
+    {
+    }
+
+    void runTests()
+    {
+        const int STATUS_QUEUE_LENGTH = 8;
+        NullAudioOutputPtr pOutput(new NullAudioOutput());
+        AudioEngine engine(pOutput);
+        initEngine(engine, 2);
+        AudioMsgQueue dataQ(100, QUEUE_MPMC);
+        AudioMsgQueue statusQ(STATUS_QUEUE_LENGTH, QUEUE_SPSC);
+        vector<boost::weak_ptr<AudioMsg> > pWeakMsgs;
+        for (int i = 0; i < 20; ++i) {
+            AudioMsgPtr pMsg = createAudioMsg();
+            pWeakMsgs.push_back(pMsg);
+            dataQ.push(pMsg);
+        }
+        int sourceID = engine.addSource(dataQ, statusQ);
+
+        // Nobody reads the status queue.
+        for (int i = 0; i < 20; ++i) {
+            pOutput->render(NUM_FRAMES);
+        }
+        TEST(statusQ.size() == STATUS_QUEUE_LENGTH);
+        TEST(!dataQ.empty());
+        bool bAllAlive = true;
+        for (unsigned i = 0; i < pWeakMsgs.size(); ++i) {
+            if (pWeakMsgs[i].expired()) {
+                bAllAlive = false;
+            }
+        }
+        TEST(bAllAlive);
+
+        // Reading the status queue lets the source continue. Time messages are reused.
+        int numAudioMsgs = 0;
+        int numTimeMsgs = 0;
+        set<AudioMsg*> pTimeMsgs;
+        for (int i = 0; i < 30; ++i) {
+            pOutput->render(NUM_FRAMES);
+            AudioMsgPtr pMsg = statusQ.pop(false);
+            while (pMsg) {
+                if (pMsg->getType() == AudioMsg::AUDIO) {
+                    numAudioMsgs++;
+                } else if (pMsg->getType() == AudioMsg::AUDIO_TIME) {
+                    numTimeMsgs++;
+                    pTimeMsgs.insert(pMsg.get());
+                }
+                pMsg = statusQ.pop(false);
+            }
+        }
+        TEST(dataQ.empty());
+        TEST(numAudioMsgs == 20);
+        TEST(int(pTimeMsgs.size()) < numTimeMsgs);
+        pWeakMsgs.clear();
+
+        // Seek and end of file while the status queue is full.
+        for (int i = 0; i < 20; ++i) {
+            dataQ.push(createAudioMsg());
+        }
+        for (int i = 0; i < 20; ++i) {
+            pOutput->render(NUM_FRAMES);
+        }
+        TEST(statusQ.size() == STATUS_QUEUE_LENGTH);
+        engine.notifySeek(sourceID);
+        AudioMsgPtr pMsg(new AudioMsg);
+        pMsg->setSeekDone(1, 2.f);
+        dataQ.push(pMsg);
+        pMsg = AudioMsgPtr(new AudioMsg);
+        pMsg->setEOF();
+        dataQ.push(pMsg);
+        pOutput->render(NUM_FRAMES);
+
+        vector<AudioMsg::MsgType> types;
+        for (int i = 0; i < 20; ++i) {
+            pMsg = statusQ.pop(false);
+            while (pMsg) {
+                if (pMsg->getType() != AudioMsg::AUDIO &&
+                        pMsg->getType() != AudioMsg::AUDIO_TIME)
+                {
+                    types.push_back(pMsg->getType());
+                }
+                pMsg = statusQ.pop(false);
+            }
+            pOutput->render(NUM_FRAMES);
+        }
+        TEST(types.size() == 2);
+        if (types.size() == 2) {
+            TEST(types[0] == AudioMsg::SEEK_DONE);
+            TEST(types[1] == AudioMsg::END_OF_FILE);
+        }
+        TEST(dataQ.empty());
+        engine.removeSource(sourceID);
+        engine.teardown();
+    }
+};
+
+// Adds and removes sources in the main thread while another thread mixes. Like the
+// decoders, the test deletes the queues of a source as soon as it has been removed.
+class AudioEngineStressTest: public AudioEngineTestBase {
+public:
+    AudioEngineStressTest()
+        : AudioEngineTestBase("AudioEngineStressTest")
+    {
+    }
+
+    void runTests()
+    {
+        NullAudioOutputPtr pOutput(new NullAudioOutput());
+        AudioEngine engine(pOutput);
+        initEngine(engine, 2);
+        const int NUM_SOURCES = 16;
+        for (int i = 0; i < NUM_SOURCES; ++i) {
+            addSource(engine);
+        }
+        m_bStop = false;
+        m_NumRenders = 0;
+        m_NumSilentRenders = 0;
+        boost::thread mixThread(boost::bind(&AudioEngineStressTest::mixLoop, this,
+                pOutput.get()));
+        for (int i = 0; i < 1000; ++i) {
+            engine.removeSource(m_IDs.front());
+            m_IDs.erase(m_IDs.begin());
+            m_pDataQs.erase(m_pDataQs.begin());
+            m_pStatusQs.erase(m_pStatusQs.begin());
+            addSource(engine);
+            engine.setSourceVolume(m_IDs.back(), float(i%10)/10+0.1f);
+            engine.setSourcePan(m_IDs.back(), float(i%10)/5-1);
+            if (i % 100 == 0) {
+                int busID = engine.addBus();
+                engine.setSourceBus(m_IDs.back(), busID);
+                engine.removeBus(busID);
+            }
+            for (unsigned j = 0; j < m_pStatusQs.size(); ++j) {
+                m_pStatusQs[j]->clear();
+            }
+        }
+        // Make sure the remaining sources are mixed a few times.
+        int numRenders = m_NumRenders;
+        while (m_NumRenders < numRenders+10) {
+            msleep(1);
+        }
+        m_bStop = true;
+        mixThread.join();
+        for (unsigned i = 0; i < m_IDs.size(); ++i) {
+            engine.removeSource(m_IDs[i]);
+        }
+        engine.teardown();
+        // There are always sources with audio left, so there is no silence.
+        TEST(m_NumRenders > 0);
+        TEST(m_NumSilentRenders == 0);
+    }
+
+private:
+    void addSource(AudioEngine& engine)
+    {
+        m_pDataQs.push_back(AudioMsgQueuePtr(new AudioMsgQueue()));
+        m_pStatusQs.push_back(AudioMsgQueuePtr(new AudioMsgQueue()));
+        feedSource(*m_pDataQs.back(), 1000);
+        m_IDs.push_back(engine.addSource(*m_pDataQs.back(), *m_pStatusQs.back()));
+    }
+
+    void mixLoop(NullAudioOutput* pOutput)
+    {
+        while (!m_bStop) {
+            const short* pSamples = pOutput->render(NUM_FRAMES);
+            bool bSilent = true;
+            for (int i = 0; i < NUM_FRAMES*2; ++i) {
+                if (pSamples[i] != 0) {
+                    bSilent = false;
+                    break;
+                }
+            }
+            if (bSilent) {
+                m_NumSilentRenders++;
+            }
+            m_NumRenders++;
+        }
+    }
+
+    vector<int> m_IDs;
+    vector<AudioMsgQueuePtr> m_pDataQs;
+    vector<AudioMsgQueuePtr> m_pStatusQs;
+    volatile bool m_bStop;
+    boost::atomic<int> m_NumRenders;
+    boost::atomic<int> m_NumSilentRenders;
+};
+
+// Checks routing through buses with constant signals. The master limiter is disabled
+// so the expected output is exact.
+class AudioBusTest: public AudioEngineTestBase {
+public:
+    AudioBusTest()
+        : AudioEngineTestBase("AudioBusTest")
+    {
+    }
+
+    void runTests()
+    {
+        NullAudioOutputPtr pOutput(new NullAudioOutput());
+        AudioEngine engine(pOutput);
+        initEngine(engine, CHANNELS, true);
+        engine.setBusLimiterEnabled(0, false);
+        AudioMsgQueue dataQ;
+        AudioMsgQueue statusQ;
+        feedSource(dataQ, 100);
+        int sourceID = engine.addSource(dataQ, statusQ);
+        checkOutput(pOutput, 1000, 2000, 3000, 4000);
+
+        int busID = engine.addBus();
+        engine.setSourceBus(sourceID, busID);
+        engine.setBusGain(busID, 0.5f);
+        int channelMap[] = {1, 0, -1, 2};
+        engine.setBusChannelMap(busID, vector<int>(channelMap, channelMap+CHANNELS));
+        checkOutput(pOutput, 1000, 500, 2000, 0);
+
+        int subBusID = engine.addBus(busID);
+        engine.setSourceBus(sourceID, subBusID);
+        engine.setBusGain(subBusID, 2.f);
+        checkOutput(pOutput, 2000, 1000, 4000, 0);
+
+        // The sub bus now goes straight to the master bus.
+        engine.removeBus(busID);
+        checkOutput(pOutput, 2000, 4000, 6000, 8000);
+
+        engine.setSourcePan(sourceID, -1);
+        checkOutput(pOutput, 2000, 0, 6000, 0);
+        engine.setSourcePan(sourceID, 0.5);
+        checkOutput(pOutput, 1000, 4000, 3000, 8000);
+
+        engine.setVolume(0.5);
+        checkOutput(pOutput, 500, 2000, 1500, 4000);
+
+        bool bExceptionThrown = false;
+        try {
+            engine.removeBus(0);
+        } catch (Exception&) {
+            bExceptionThrown = true;
+        }
+        TEST(bExceptionThrown);
+        bExceptionThrown = false;
+        try {
+            engine.setBusChannelMap(subBusID, vector<int>(2, 0));
+        } catch (Exception&) {
+            bExceptionThrown = true;
+        }
+        TEST(bExceptionThrown);
+
+        engine.removeSource(sourceID);
+        engine.teardown();
+    }
+
+private:
+    static const int CHANNELS = 4;
+
+    void checkOutput(NullAudioOutputPtr pOutput, int c0, int c1, int c2, int c3)
+    {
+        // Gain changes are ramped over one buffer.
+        pOutput->render(NUM_FRAMES);
+        const short* pDest = pOutput->render(NUM_FRAMES);
+        int expected[] = {c0, c1, c2, c3};
+        bool bOK = true;
+        for (int i = 0; i < NUM_FRAMES; ++i) {
+            for (int j = 0; j < CHANNELS; ++j) {
+                if (abs(pDest[i*CHANNELS+j]-expected[j]) > 1) {
+                    bOK = false;
+                }
+            }
+        }
+        TEST(bOK);
+    }
+};
+
+class AudioFileOutputTest: public AudioEngineTestBase {
+public:
+    AudioFileOutputTest()
+        : AudioEngineTestBase("AudioFileOutputTest")
+    {
+    }
+
+    void runTests()
+    {
+        const int CHANNELS = 6;
+        const int NUM_BUFFERS = 10;
+        {
+            NullAudioOutputPtr pOutput(new NullAudioOutput("testaudio.wav"));
+            AudioEngine engine(pOutput);
+            initEngine(engine, CHANNELS);
+            AudioMsgQueue dataQ;
+            AudioMsgQueue statusQ;
+            feedSource(dataQ, NUM_BUFFERS);
+            engine.addSource(dataQ, statusQ);
+            for (int i = 0; i < NUM_BUFFERS; ++i) {
+                pOutput->render(NUM_FRAMES);
+            }
+            TEST(pOutput->getNumFramesRendered() == NUM_BUFFERS*NUM_FRAMES);
+            engine.teardown();
+        }
+        FILE* pFile = fopen("testaudio.wav", "rb");
+        TEST(pFile);
+        unsigned char header[44];
+        TEST(fread(header, 1, 44, pFile) == 44);
+        fseek(pFile, 0, SEEK_END);
+        long fileSize = ftell(pFile);
+        fclose(pFile);
+        ::remove("testaudio.wav");
+        TEST(fileSize == 44 + NUM_BUFFERS*NUM_FRAMES*CHANNELS*2);
+        TEST(string((char*)header, 4) == "RIFF");
+        TEST(header[22] == CHANNELS);
+        unsigned dataSize = header[40] | (header[41] << 8) | (header[42] << 16) |
+                (header[43] << 24);
+        TEST(dataSize == unsigned(fileSize-44));
+    }
+};
+
+// Measures the cost of sources and buses in an 8 channel setup.
+class AudioBusBenchmark: public AudioEngineTestBase {
+public:
+    AudioBusBenchmark()
+        : AudioEngineTestBase("AudioBusBenchmark")
+    {
+    }
+
+    void runTests()
+    {
+        const int NUM_SOURCES = 64;
+        const int NUM_BUSES = 8;
+        const int NUM_CALLBACKS = 100;
+        NullAudioOutputPtr pOutput(new NullAudioOutput());
+        AudioEngine engine(pOutput);
+        initEngine(engine, CHANNELS);
+        engine.setVolume(0.1f);
+        vector<AudioMsgQueuePtr> pDataQs;
+        vector<AudioMsgQueuePtr> pStatusQs;
+        vector<int> sourceIDs;
+        for (int i = 0; i < NUM_SOURCES; ++i) {
+            pDataQs.push_back(AudioMsgQueuePtr(new AudioMsgQueue()));
+            pStatusQs.push_back(AudioMsgQueuePtr(new AudioMsgQueue()));
+            feedSource(*pDataQs[i], 2*NUM_CALLBACKS+1);
+            sourceIDs.push_back(engine.addSource(*pDataQs[i], *pStatusQs[i]));
+            engine.setSourcePan(sourceIDs[i], float(i%5)/2-1);
+        }
+        float sourcesTime = measure(pOutput, NUM_CALLBACKS);
+
+        for (int i = 0; i < NUM_BUSES; ++i) {
+            int busID = engine.addBus();
+            engine.setBusLimiterEnabled(busID, true);
+            for (int j = i; j < NUM_SOURCES; j += NUM_BUSES) {
+                engine.setSourceBus(sourceIDs[j], busID);
+            }
+        }
+        // Skip the buffer with the gain ramps.
+        pOutput->render(NUM_FRAMES);
+        float busesTime = measure(pOutput, NUM_CALLBACKS);
+        TEST(busesTime > 0);
+
+        cerr << string(m_IndentLevel+4, ' ') << CHANNELS << " channels, " << NUM_FRAMES
+                << " frames: " << sourcesTime/NUM_SOURCES << " us per source, "
+                << (busesTime-sourcesTime)/NUM_BUSES << " us per bus with limiter"
+                << endl;
+        engine.teardown();
+    }
+
+private:
+    static const int CHANNELS = 8;
+
+    // Returns the median time per callback in microseconds.
+    float measure(NullAudioOutputPtr pOutput, int numCallbacks)
+    {
+        vector<long long> callbackTimes;
+        for (int i = 0; i < numCallbacks; ++i) {
+            long long startTime = TimeSource::get()->getCurrentMicrosecs();
+            pOutput->render(NUM_FRAMES);
+            callbackTimes.push_back(TimeSource::get()->getCurrentMicrosecs()-startTime);
+        }
+        sort(callbackTimes.begin(), callbackTimes.end());
+        return float(callbackTimes[callbackTimes.size()/2]);
+    }
+};
+
+// Plays samples from memory: overlapping voices, voice stealing, stopping, panning and
+// buses. The master limiter is disabled so the expected output is exact.
+class AudioSampleTest: public AudioEngineTestBase {
+public:
+    AudioSampleTest()
+        : AudioEngineTestBase("AudioSampleTest")
+    {
+    }
+
+    void runTests()
+    {
+        NullAudioOutputPtr pOutput(new NullAudioOutput());
+        AudioEngine engine(pOutput);
+        initEngine(engine, 2);
+        engine.setBusLimiterEnabled(0, false);
+        AudioParams ap(44100, 2, NUM_FRAMES);
+        int shortID = engine.addSample(createSample(ap, 300));
+        AudioBufferPtr pLongSample = createSample(ap, 4*NUM_FRAMES);
+        boost::weak_ptr<AudioBuffer> pWeakLongSample = pLongSample;
+        int longID = engine.addSample(pLongSample);
+        pLongSample = AudioBufferPtr();
+
+        // The sample starts at the beginning of the next buffer.
+        engine.playSample(shortID);
+        const short* pDest = pOutput->render(NUM_FRAMES);
+        TEST(checkFrames(pDest, 0, 300, 1000, 2000));
+        TEST(checkFrames(pDest, 300, NUM_FRAMES, 0, 0));
+        TEST(engine.getNumVoices() == 0);
+
+        engine.playSample(shortID);
+        engine.playSample(shortID, 0.5f);
+        pDest = pOutput->render(NUM_FRAMES);
+        TEST(checkFrames(pDest, 0, 300, 1500, 3000));
+
+        // The oldest voice fades out over one buffer.
+        engine.setMaxVoices(2);
+        TEST(engine.getMaxVoices() == 2);
+        for (int i = 0; i < 3; ++i) {
+            engine.playSample(longID);
+        }
+        pDest = pOutput->render(NUM_FRAMES);
+        TEST(checkFrames(pDest, 0, 1, 3000, 6000));
+        TEST(checkFrames(pDest, NUM_FRAMES-1, NUM_FRAMES, 2000, 4000));
+        TEST(engine.getNumVoices() == 2);
+        pDest = pOutput->render(NUM_FRAMES);
+        TEST(checkFrames(pDest, 0, NUM_FRAMES, 2000, 4000));
+
+        engine.setMaxVoices(32);
+        int voiceID = engine.playSample(longID, 1.f, -1.f);
+        pDest = pOutput->render(NUM_FRAMES);
+        TEST(checkFrames(pDest, 0, NUM_FRAMES, 3000, 4000));
+        engine.stopVoice(voiceID);
+        pOutput->render(NUM_FRAMES);
+        TEST(engine.getNumVoices() == 0);
+
+        int busID = engine.addBus();
+        engine.setBusGain(busID, 0.5f);
+        // The first buffer ramps the bus gain.
+        engine.playSample(shortID, 1.f, 0.f, busID);
+        pOutput->render(NUM_FRAMES);
+        engine.playSample(shortID, 1.f, 0.f, busID);
+        pDest = pOutput->render(NUM_FRAMES);
+        TEST(checkFrames(pDest, 0, 300, 500, 1000));
+
+        // Removed samples keep playing until they end.
+        engine.playSample(longID);
+        engine.removeSample(longID);
+        pDest = pOutput->render(NUM_FRAMES);
+        TEST(checkFrames(pDest, 0, NUM_FRAMES, 1000, 2000));
+        TEST(engine.getNumVoices() == 1);
+        engine.deleteRetiredObjects();
+        TEST(!pWeakLongSample.expired());
+        // Without further playSample() calls, the sample is freed once it has ended.
+        for (int i = 0; i < 3; ++i) {
+            pOutput->render(NUM_FRAMES);
+        }
+        TEST(engine.getNumVoices() == 0);
+        engine.deleteRetiredObjects();
+        TEST(pWeakLongSample.expired());
+
+        TEST(throwsException(engine, longID, 0));
+        TEST(throwsException(engine, shortID, 100));
+        bool bExceptionThrown = false;
+        try {
+            engine.setMaxVoices(0);
+        } catch (Exception&) {
+            bExceptionThrown = true;
+        }
+        TEST(bExceptionThrown);
+
+        testThreaded(engine, pOutput, ap);
+        engine.teardown();
+    }
+
+private:
+    // Triggers and removes samples in the main thread while another thread mixes.
+    void testThreaded(AudioEngine& engine, NullAudioOutputPtr pOutput,
+            const AudioParams& ap)
+    {
+        m_bStop = false;
+        boost::thread mixThread(boost::bind(&AudioSampleTest::mixLoop, this,
+                pOutput.get()));
+        vector<int> sampleIDs;
+        for (int i = 0; i < 2000; ++i) {
+            if (i % 100 == 0) {
+                if (sampleIDs.size() == 4) {
+                    engine.removeSample(sampleIDs.front());
+                    sampleIDs.erase(sampleIDs.begin());
+                }
+                sampleIDs.push_back(engine.addSample(createSample(ap, (i%7+1)*500)));
+            }
+            int voiceID = engine.playSample(sampleIDs[i%sampleIDs.size()], 0.1f,
+                    float(i%10)/5-1);
+            if (i % 3 == 0) {
+                engine.stopVoice(voiceID);
+            }
+            if (i % 50 == 0) {
+                // Lets the mix thread keep up with the triggers.
+                msleep(1);
+            }
+        }
+        m_bStop = true;
+        mixThread.join();
+        TEST(engine.getNumVoices() <= engine.getMaxVoices());
+    }
+
+    void mixLoop(NullAudioOutput* pOutput)
+    {
+        while (!m_bStop) {
+            pOutput->render(NUM_FRAMES);
+        }
+    }
+
+    AudioBufferPtr createSample(const AudioParams& ap, int numFrames)
+    {
+        AudioBufferPtr pSample(new AudioBuffer(numFrames, ap));
+        short* pData = pSample->getData();
+        for (int i = 0; i < numFrames; ++i) {
+            pData[i*2] = 1000;
+            pData[i*2+1] = 2000;
+        }
+        return pSample;
+    }
+
+    bool checkFrames(const short* pDest, int start, int end, int c0, int c1)
+    {
+        for (int i = start; i < end; ++i) {
+            if (abs(pDest[i*2]-c0) > 2 || abs(pDest[i*2+1]-c1) > 2) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool throwsException(AudioEngine& engine, int sampleID, int busID)
+    {
+        try {
+            engine.playSample(sampleID, 1.f, 0.f, busID);
+        } catch (Exception&) {
+            return true;
+        }
+        return false;
+    }
+
+    volatile bool m_bStop;
+};
+
+// Measures how long it takes from playSample() until the sample is in the output, with
+// the audio callback running in its own thread at the speed of a real device.
+class AudioSampleLatencyTest: public AudioEngineTestBase {
+public:
+    AudioSampleLatencyTest()
+        : AudioEngineTestBase("AudioSampleLatencyTest")
+    {
+    }
+
+    void runTests()
+    {
+        const int NUM_TRIGGERS = 20;
+        const int BUFFER_FRAMES = 256;
+        NullAudioOutputPtr pOutput(new NullAudioOutput());
+        AudioEngine engine(pOutput);
+        AudioParams ap(44100, 2, BUFFER_FRAMES);
+        engine.init(ap, 1.f);
+        engine.play();
+        AudioBufferPtr pSample(new AudioBuffer(BUFFER_FRAMES, ap));
+        short* pData = pSample->getData();
+        for (int i = 0; i < BUFFER_FRAMES*2; ++i) {
+            pData[i] = 1000;
+        }
+        int sampleID = engine.addSample(pSample);
+
+        m_bStop = false;
+        m_SoundTime = 0;
+        boost::thread mixThread(boost::bind(&AudioSampleLatencyTest::mixLoop, this,
+                pOutput.get(), BUFFER_FRAMES));
+        vector<long long> latencies;
+        for (int i = 0; i < NUM_TRIGGERS; ++i) {
+            m_SoundTime = 0;
+            long long triggerTime = TimeSource::get()->getCurrentMicrosecs();
+            engine.playSample(sampleID);
+            while (m_SoundTime == 0 &&
+                    TimeSource::get()->getCurrentMicrosecs()-triggerTime < 1000000)
+            {
+                msleep(1);
+            }
+            if (m_SoundTime == 0) {
+                TEST_FAILED("Sample wasn't played within 1 s.");
+                break;
+            }
+            latencies.push_back(m_SoundTime-triggerTime);
+            // Wait for the sample to end.
+            msleep(20);
+        }
+        m_bStop = true;
+        mixThread.join();
+        engine.teardown();
+
+        if (latencies.empty()) {
+            return;
+        }
+        sort(latencies.begin(), latencies.end());
+        long long bufferTime = (long long)BUFFER_FRAMES*1000000/ap.m_SampleRate;
+        // Expected is at most one buffer, but wall clock timing depends on the machine
+        // load. The bound only catches samples that wait for something else to happen.
+        TEST(latencies[latencies.size()/2] < 100000);
+        cerr << string(m_IndentLevel+4, ' ') << BUFFER_FRAMES << " frame buffers ("
+                << bufferTime << " us): trigger-to-sound latency (us) median: "
+                << latencies[latencies.size()/2] << ", max: " << latencies.back()
+                << endl;
+    }
+
+private:
+    // Renders a buffer every numFrames/sampleRate seconds, like an audio device, and
+    // notes when the first non-silent frame would be heard.
+    void mixLoop(NullAudioOutput* pOutput, int numFrames)
+    {
+        long long bufferTime = (long long)numFrames*1000000/44100;
+        long long nextTime = TimeSource::get()->getCurrentMicrosecs();
+        while (!m_bStop) {
+            const short* pDest = pOutput->render(numFrames);
+            if (m_SoundTime == 0) {
+                for (int i = 0; i < numFrames; ++i) {
+                    if (pDest[i*2] != 0) {
+                        // The buffer starts playing now, frame i is heard i frames
+                        // later.
+                        m_SoundTime = TimeSource::get()->getCurrentMicrosecs() +
+                                (long long)i*1000000/44100;
+                        break;
+                    }
+                }
+            }
+            nextTime += bufferTime;
+            long long sleepTime = nextTime-TimeSource::get()->getCurrentMicrosecs();
+            if (sleepTime > 1000) {
+                msleep(int(sleepTime/1000));
+            }
+        }
+    }
+
+    volatile bool m_bStop;
+    boost::atomic<long long> m_SoundTime;
+};
+
+class AudioTestSuite: public TestSuite {
+public:
+    AudioTestSuite()
+        : TestSuite("AudioTestSuite")
+    {
+        addTest(TestPtr(new AudioMixTest));
+        addTest(TestPtr(new AudioEngineTest));
+        addTest(TestPtr(new AudioSourceStatusTest));
+        addTest(TestPtr(new AudioEngineStressTest));
+        addTest(TestPtr(new AudioBusTest));
+        addTest(TestPtr(new AudioFileOutputTest));
+        addTest(TestPtr(new AudioBusBenchmark));
+        addTest(TestPtr(new AudioSampleTest));
+        addTest(TestPtr(new AudioSampleLatencyTest));
+    }
+};
+
+int main(int nargs, char** args)
+{
+    AudioTestSuite suite;
+    suite.runTests();
+    bool bOK = suite.isOk();
+
+    if (bOK) {
+        return 0;
+    } else {
+        return 1;
+    }
+}
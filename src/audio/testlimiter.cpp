@@ -23,9 +23,11 @@
 
 #include "../base/TestSuite.h"
 #include "../base/MathHelper.h"
+#include "../base/TimeSource.h"
 
 #include <stdlib.h>
 #include <iostream>
+#include <vector>
 
 using namespace avg;
 using namespace std;
@@ -98,11 +100,286 @@ public:
     }
 };
 
+typedef Dynamics<float, 2> StereoLimiter;
+
+static StereoLimiter* createLimiter(float fs, float rmsTime, float attackTime)
+{
+    StereoLimiter* pLimiter = new StereoLimiter(fs);
+    pLimiter->setThreshold(0.f);
+    pLimiter->setAttackTime(attackTime);
+    pLimiter->setReleaseTime(0.05f);
+    pLimiter->setRmsTime(rmsTime);
+    pLimiter->setRatio(std::numeric_limits<float>::infinity());
+    pLimiter->setMakeupGain(0.f);
+    return pLimiter;
+}
+
+// The per-sample stereo limiter that Dynamics::process() implemented before block
+// processing was added. Threshold and makeup gain are 0 dB and the ratio is infinite,
+// as set up by createLimiter(). Block and per-frame results are compared against it.
+class ReferenceLimiter: public IProcessor<float> {
+public:
+    ReferenceLimiter(float fs, float rmsTime, float attackTime)
+        : rms1_(0.f),
+          lookaheadBufIdx_(0),
+          env1_(0.f),
+          avg1BufRIdx_(0),
+          avg1BufWIdx_(AVG1 - 1),
+          avg1Old_(0.f),
+          avg2BufRIdx_(0),
+          avg2BufWIdx_(AVG2 - 1),
+          avg2Old_(0.f),
+          delayBufIdx_(0)
+    {
+        for (int i = 0; i < LOOKAHEAD; i++) {
+            lookaheadBuf_[i] = 1.f;
+        }
+        memset(avg1Buf_, 0, sizeof(avg1Buf_));
+        memset(avg2Buf_, 0, sizeof(avg2Buf_));
+        memset(delayBuf_, 0, sizeof(delayBuf_));
+
+        rmsCoef_ = 0.f;
+        if (rmsTime > 0.f) {
+            rmsCoef_ = std::pow(0.001f, 1.f / (fs * rmsTime));
+        }
+        attCoef_ = 0.f;
+        if (attackTime > 0.f) {
+            attCoef_ = pow(0.001f, 1.f / (fs * attackTime));
+        }
+        relCoef_ = pow(0.001f, 1.f / (fs * 0.05f));
+    }
+
+    virtual void process(float* pSamples)
+    {
+        //---------------- Preprocessing
+        float x = 0.f;
+        for (int i = 0; i < 2; i++) {
+            float abs = std::fabs(pSamples[i]);
+            if (abs > x) {
+                x = abs;
+            }
+        }
+
+        //---------------- RMS
+        float rms = (1.f - rmsCoef_) * x * x + rmsCoef_ * rms1_;
+        rms1_ = rms;
+        rms   = sqrt(rms);
+
+        //---------------- Max filter
+        if (rms > 1.) {
+            int j = lookaheadBufIdx_;
+            for (int i = 0; i < LOOKAHEAD; i++) {
+                j = (j+1)&(LOOKAHEAD-1);
+                if (lookaheadBuf_[j] < rms) {
+                    lookaheadBuf_[j] = rms;
+                }
+            }
+        }
+
+        //---------------- Ratio
+        float dbMax  = std::log10(lookaheadBuf_[lookaheadBufIdx_]);
+        float dbComp = dbMax * 0.f;
+        float comp   = std::pow(10.f, dbComp);
+        float c      = comp / lookaheadBuf_[lookaheadBufIdx_];
+
+        lookaheadBuf_[lookaheadBufIdx_] = 1.;
+        lookaheadBufIdx_ = (lookaheadBufIdx_+1)%LOOKAHEAD;
+
+        //---------------- Attack/release envelope
+        if (env1_ <= c) {
+            c = c + (env1_ - c) * relCoef_;
+        } else {
+            c = c + (env1_ - c) * attCoef_;
+        }
+        env1_ = c;
+
+        //---------------- Smoothing
+        const float tmp1       = avg1Old_ + c - avg1Buf_[avg1BufRIdx_];
+        avg1Old_               = tmp1;
+        avg1Buf_[avg1BufWIdx_] = c;
+        c = tmp1;
+        avg1BufRIdx_ = (avg1BufRIdx_+1)%AVG1;
+        avg1BufWIdx_ = (avg1BufWIdx_+1)%AVG1;
+
+        const float tmp2       = avg2Old_ + c - avg2Buf_[avg2BufRIdx_];
+        avg2Old_               = tmp2;
+        avg2Buf_[avg2BufWIdx_] = c;
+        c = tmp2;
+        avg2BufRIdx_ = (avg2BufRIdx_+1)%AVG2;
+        avg2BufWIdx_ = (avg2BufWIdx_+1)%AVG2;
+
+        c = c / (float(AVG1) * float(AVG2));
+
+        //---------------- Postprocessing
+        for (int i = 0; i < 2; i++) {
+            const float in = delayBuf_[delayBufIdx_*2+i];
+            delayBuf_[delayBufIdx_*2+i] = pSamples[i];
+            pSamples[i] = in * c;
+        }
+        delayBufIdx_ = (delayBufIdx_+1)&(LOOKAHEAD-1);
+    }
+
+    virtual void processBlock(float* pSamples, int numFrames)
+    {
+        for (int i = 0; i < numFrames; ++i) {
+            process(pSamples+i*2);
+        }
+    }
+
+private:
+    float rmsCoef_;
+    float rms1_;
+    float lookaheadBuf_[LOOKAHEAD];
+    int lookaheadBufIdx_;
+    float attCoef_;
+    float relCoef_;
+    float env1_;
+    float avg1Buf_[AVG1];
+    int avg1BufRIdx_;
+    int avg1BufWIdx_;
+    float avg1Old_;
+    float avg2Buf_[AVG2];
+    int avg2BufRIdx_;
+    int avg2BufWIdx_;
+    float avg2Old_;
+    float delayBuf_[LOOKAHEAD*2];
+    int delayBufIdx_;
+};
+
+// Alternates between loud and quiet passages so the limiter both kicks in and
+// releases.
+static void generateSignal(vector<float>& samples, int numFrames)
+{
+    samples.resize(numFrames*2);
+    for (int j = 0; j < numFrames; j++) {
+        float amplitude = ((j/5000)%2 == 0) ? 2.f : 0.4f;
+        samples[j*2] = amplitude*sin(j*(440.f/44100)*float(M_PI));
+        samples[j*2+1] = amplitude*sin(j*(660.f/44100)*float(M_PI));
+    }
+}
+
+static float getMaxDiff(const vector<float>& samples1, const vector<float>& samples2)
+{
+    float maxDiff = 0;
+    for (unsigned i = 0; i < samples1.size(); ++i) {
+        maxDiff = max(maxDiff, float(fabs(samples1[i]-samples2[i])));
+    }
+    return maxDiff;
+}
+
+// Within one LSB of 16-bit output.
+static const float MAX_DIFF = 1.f/32768;
+
+class LimiterBlockTest: public Test {
+public:
+    LimiterBlockTest()
+        : Test("LimiterBlockTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        runTest(0.f, 0.f);
+        runTest(0.01f, 0.002f);
+    }
+
+private:
+    void runTest(float rmsTime, float attackTime)
+    {
+        const int NUM_FRAMES = 44100;
+        vector<float> refSamples;
+        generateSignal(refSamples, NUM_FRAMES);
+        vector<float> frameSamples = refSamples;
+        vector<float> blockSamples = refSamples;
+
+        ReferenceLimiter refLimiter(44100.f, rmsTime, attackTime);
+        for (int i = 0; i < NUM_FRAMES; ++i) {
+            refLimiter.process(&refSamples[i*2]);
+        }
+
+        StereoLimiter* pFrameLimiter = createLimiter(44100.f, rmsTime, attackTime);
+        for (int i = 0; i < NUM_FRAMES; ++i) {
+            pFrameLimiter->process(&frameSamples[i*2]);
+        }
+
+        // Irregular block sizes, including single frames, check that the state
+        // carries over correctly between blocks.
+        StereoLimiter* pBlockLimiter = createLimiter(44100.f, rmsTime, attackTime);
+        int blockSizes[] = {1, 37, 64, 100, 512, 1024};
+        int pos = 0;
+        for (int i = 0; pos < NUM_FRAMES; ++i) {
+            int numFrames = min(blockSizes[i%6], NUM_FRAMES-pos);
+            pBlockLimiter->processBlock(&blockSamples[pos*2], numFrames);
+            pos += numFrames;
+        }
+
+        TEST(getMaxDiff(refSamples, frameSamples) <= MAX_DIFF);
+        TEST(getMaxDiff(refSamples, blockSamples) <= MAX_DIFF);
+
+        delete pFrameLimiter;
+        delete pBlockLimiter;
+    }
+};
+
+class LimiterBenchmark: public Test {
+public:
+    LimiterBenchmark()
+        : Test("LimiterBenchmark", 2)
+    {
+    }
+
+    void runTests()
+    {
+        const int NUM_FRAMES = 44100*10;
+        const int BUFFER_FRAMES = 1024;
+        vector<float> samples;
+        generateSignal(samples, NUM_FRAMES);
+
+        // The old code, called per frame through the interface like AudioEngine did.
+        IProcessor<float>* pRefLimiter = new ReferenceLimiter(44100.f, 0.f, 0.f);
+        vector<float> refBuffer = samples;
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int i = 0; i < NUM_FRAMES; ++i) {
+            pRefLimiter->process(&refBuffer[i*2]);
+        }
+        long long refTime = TimeSource::get()->getCurrentMicrosecs()-startTime;
+        delete pRefLimiter;
+
+        IProcessor<float>* pLimiter = createLimiter(44100.f, 0.f, 0.f);
+        vector<float> buffer = samples;
+        startTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int i = 0; i < NUM_FRAMES; i += BUFFER_FRAMES) {
+            pLimiter->processBlock(&buffer[i*2], min(BUFFER_FRAMES, NUM_FRAMES-i));
+        }
+        long long blockTime = TimeSource::get()->getCurrentMicrosecs()-startTime;
+        delete pLimiter;
+        // The old code keeps its moving sums in single precision, so over 10 s it
+        // drifts by a bit more than one LSB.
+        TEST(getMaxDiff(refBuffer, buffer) <= 2*MAX_DIFF);
+
+        cerr << string(m_IndentLevel+4, ' ') << "10 s stereo, per frame: "
+                << refTime/1000. << " ms (" << float(NUM_FRAMES)/refTime
+                << " M frames/s), block: " << blockTime/1000. << " ms ("
+                << float(NUM_FRAMES)/blockTime << " M frames/s)" << endl;
+    }
+};
+
+class LimiterTestSuite: public TestSuite {
+public:
+    LimiterTestSuite()
+        : TestSuite("LimiterTestSuite")
+    {
+        addTest(TestPtr(new LimiterTest));
+        addTest(TestPtr(new LimiterBlockTest));
+        addTest(TestPtr(new LimiterBenchmark));
+    }
+};
+
 int main(int nargs, char** args)
 {
-    LimiterTest test;
-    test.runTests();
-    bool bOK = test.isOk();
+    LimiterTestSuite suite;
+    suite.runTests();
+    bool bOK = suite.isOk();
 
     if (bOK) {
         return 0;
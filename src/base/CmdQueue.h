@@ -33,15 +33,15 @@ template<class RECEIVER>
 class AVG_TEMPLATE_API CmdQueue: public Queue<Command<RECEIVER> >
 {
 public:
-    CmdQueue(int maxSize=-1);
+    CmdQueue(int maxSize=-1, QueueType type=QUEUE_LOCKING);
     typedef typename Queue<Command<RECEIVER> >::QElementPtr CmdPtr;
     void pushCmd(typename Command<RECEIVER>::CmdFunc func);
     
 };
 
 template<class RECEIVER>
-CmdQueue<RECEIVER>::CmdQueue(int maxSize)
-    : Queue<Command<RECEIVER> >(maxSize)
+CmdQueue<RECEIVER>::CmdQueue(int maxSize, QueueType type)
+    : Queue<Command<RECEIVER> >(maxSize, type)
 {
 }
 
@@ -79,11 +79,22 @@ ConfigMgr::ConfigMgr()
     addOption("scr", "gamma", "-1,-1,-1");
     addOption("scr", "vsyncmode", "auto");
     addOption("scr", "videoaccel", "true");
+    addOption("scr", "videoseekindex", "false");
+    addOption("scr", "videocodecthreads", "1");
+    addOption("scr", "videothreadtype", "slice");
+    addOption("scr", "maxvideocodecthreads", "0");
+    addOption("scr", "bitmappoolsize", "64");
+    addOption("scr", "cputhreads", "0");
+    addOption("scr", "texuploadbudget", "8");
     
     addSubsys("aud");
     addOption("aud", "channels", "2");
     addOption("aud", "samplerate", "44100");
     addOption("aud", "outputbuffersamples", "1024");
+    addOption("aud", "resamplequality", "medium");
+
+    addSubsys("cam");
+    addOption("cam", "v4lbuffers", "4");
 
     addSubsys("gesture");
     addOption("gesture", "maxtapdist", "15");
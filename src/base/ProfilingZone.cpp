@@ -22,6 +22,8 @@
 #include "ProfilingZone.h"
 #include "ObjectCounter.h"
 
+#include <sstream>
+
 using namespace std;
 
 namespace avg {
@@ -41,11 +43,49 @@ ProfilingZone::~ProfilingZone()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
+static const int NUM_LATENCY_BUCKETS = 8;
+
 void ProfilingZone::restart()
 {
     m_NumFrames = 0;
     m_AvgTime = 0;
     m_TimeSum = 0;
+    m_LatencyHistogram.clear();
+}
+
+void ProfilingZone::addLatencySample(long long usecs)
+{
+    m_TimeSum += usecs;
+    if (m_LatencyHistogram.empty()) {
+        m_LatencyHistogram.resize(NUM_LATENCY_BUCKETS, 0);
+    }
+    int bucket = 0;
+    long long bucketLimit = 1000;
+    while (usecs >= bucketLimit && bucket < NUM_LATENCY_BUCKETS-1) {
+        bucket++;
+        bucketLimit *= 2;
+    }
+    m_LatencyHistogram[bucket]++;
+}
+
+bool ProfilingZone::hasLatencySamples() const
+{
+    return !m_LatencyHistogram.empty();
+}
+
+string ProfilingZone::getLatencyHistogramString() const
+{
+    stringstream ss;
+    int bucketLimit = 1;
+    for (unsigned i = 0; i < m_LatencyHistogram.size(); ++i) {
+        if (i == m_LatencyHistogram.size()-1) {
+            ss << ">=" << bucketLimit/2 << "ms: " << m_LatencyHistogram[i];
+        } else {
+            ss << "<" << bucketLimit << "ms: " << m_LatencyHistogram[i] << ", ";
+        }
+        bucketLimit *= 2;
+    }
+    return ss.str();
 }
 
 void ProfilingZone::reset()
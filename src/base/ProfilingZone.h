@@ -26,6 +26,9 @@
 #include "ProfilingZoneID.h"
 #include "TimeSource.h"
 
+#include <string>
+#include <vector>
+
 namespace avg {
 
 class AVG_API ProfilingZone
@@ -43,6 +46,13 @@ public:
     {
         m_TimeSum += TimeSource::get()->getCurrentMicrosecs()-m_StartTime;
     };
+    void add(long long value)
+    {
+        m_TimeSum += value;
+    };
+    void addLatencySample(long long usecs);
+    bool hasLatencySamples() const;
+    std::string getLatencyHistogramString() const;
     void reset();
     long long getUSecs() const;
     long long getAvgUSecs() const;
@@ -58,6 +68,8 @@ private:
     int m_NumFrames;
     int m_Indent;
     const ProfilingZoneID& m_ZoneID;
+    // Number of latency samples below 1, 2, 4, ... ms. The last bucket collects the rest.
+    std::vector<int> m_LatencyHistogram;
 };
 
 }
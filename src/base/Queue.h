@@ -23,10 +23,13 @@
 #define _Queue_H_
 
 #include "../api.h"
+#include "RingBuffer.h"
 
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/atomic.hpp>
 
 #include <deque>
 
@@ -34,36 +37,62 @@ namespace avg {
 
 typedef boost::unique_lock<boost::mutex> unique_lock;
 
+// QUEUE_LOCKING is the default: an unbounded or bounded deque guarded by a mutex.
+// The other types store the elements in a lock-free RingBuffer and only fall back to
+// the mutex when a caller actually needs to block. They are only correct if the queue
+// is used with the number of producer and consumer threads given, and peek() needs a
+// single consumer. Unbounded queues (maxSize=-1) always use QUEUE_LOCKING.
+enum QueueType {QUEUE_LOCKING, QUEUE_SPSC, QUEUE_MPSC, QUEUE_MPMC};
+
 template<class QElement>
 class AVG_TEMPLATE_API Queue 
 {
 public:
     typedef boost::shared_ptr<QElement> QElementPtr;
 
-    Queue(int maxSize=-1);
+    Queue(int maxSize=-1, QueueType type=QUEUE_LOCKING);
     virtual ~Queue();
 
     bool empty() const;
     QElementPtr pop(bool bBlock = true);
     void clear();
     void push(const QElementPtr& pElem);
+    // Doesn't wait for room in a full queue, returns false instead.
+    bool tryPush(const QElementPtr& pElem);
     QElementPtr peek(bool bBlock = true) const;
     int size() const;
     int getMaxSize() const;
+    QueueType getType() const;
 
 private:
     QElementPtr getFrontElement(bool bBlock, unique_lock& Lock) const;
 
+    QElementPtr popLockFree(bool bBlock);
+    void pushLockFree(const QElementPtr& pElem);
+    QElementPtr peekLockFree(bool bBlock) const;
+    void wakeWaiters() const;
+
     std::deque<QElementPtr> m_pElements;
     mutable boost::mutex m_Mutex;
     mutable boost::condition m_Cond;
     int m_MaxSize;
+    QueueType m_Type;
+
+    typedef RingBuffer<QElementPtr> ElementRing;
+    boost::scoped_ptr<ElementRing> m_pRing;
+    mutable boost::atomic<int> m_NumWaiters;
 };
 
 template<class QElement>
-Queue<QElement>::Queue(int maxSize)
-    : m_MaxSize(maxSize)
+Queue<QElement>::Queue(int maxSize, QueueType type)
+    : m_MaxSize(maxSize),
+      m_Type(maxSize > 0 ? type : QUEUE_LOCKING),
+      m_NumWaiters(0)
 {
+    if (m_Type != QUEUE_LOCKING) {
+        m_pRing.reset(new ElementRing(maxSize, m_Type != QUEUE_SPSC, 
+                m_Type == QUEUE_MPMC));
+    }
 }
 
 template<class QElement>
@@ -74,6 +103,9 @@ Queue<QElement>::~Queue()
 template<class QElement>
 bool Queue<QElement>::empty() const
 {
+    if (m_pRing) {
+        return m_pRing->size() == 0;
+    }
     unique_lock Lock(m_Mutex);
     return m_pElements.empty();
 }
@@ -81,6 +113,9 @@ bool Queue<QElement>::empty() const
 template<class QElement>
 typename Queue<QElement>::QElementPtr Queue<QElement>::pop(bool bBlock)
 {
+    if (m_pRing) {
+        return popLockFree(bBlock);
+    }
     unique_lock lock(m_Mutex);
     QElementPtr pElem = getFrontElement(bBlock, lock); 
     if (pElem) {
@@ -102,6 +137,9 @@ void Queue<QElement>::clear()
 template<class QElement>
 typename Queue<QElement>::QElementPtr Queue<QElement>::peek(bool bBlock) const
 {
+    if (m_pRing) {
+        return peekLockFree(bBlock);
+    }
     unique_lock lock(m_Mutex);
     QElementPtr pElem = getFrontElement(bBlock, lock); 
     if (pElem) {
@@ -114,6 +152,10 @@ template<class QElement>
 void Queue<QElement>::push(const QElementPtr& pElem)
 {
     assert(pElem);
+    if (m_pRing) {
+        pushLockFree(pElem);
+        return;
+    }
     unique_lock lock(m_Mutex);
     if (m_pElements.size() == (unsigned)m_MaxSize) {
         while (m_pElements.size() == (unsigned)m_MaxSize) {
@@ -124,9 +166,32 @@ void Queue<QElement>::push(const QElementPtr& pElem)
     m_Cond.notify_one();
 }
 
+template<class QElement>
+bool Queue<QElement>::tryPush(const QElementPtr& pElem)
+{
+    assert(pElem);
+    if (m_pRing) {
+        if (!m_pRing->tryPush(pElem)) {
+            return false;
+        }
+        wakeWaiters();
+        return true;
+    }
+    unique_lock lock(m_Mutex);
+    if (m_pElements.size() == (unsigned)m_MaxSize) {
+        return false;
+    }
+    m_pElements.push_back(pElem);
+    m_Cond.notify_one();
+    return true;
+}
+
 template<class QElement>
 int Queue<QElement>::size() const
 {
+    if (m_pRing) {
+        return m_pRing->size();
+    }
     unique_lock lock(m_Mutex);
     return int(m_pElements.size());
 }
@@ -134,10 +199,15 @@ int Queue<QElement>::size() const
 template<class QElement>
 int Queue<QElement>::getMaxSize() const
 {
-    unique_lock lock(m_Mutex);
     return m_MaxSize;
 }
 
+template<class QElement>
+QueueType Queue<QElement>::getType() const
+{
+    return m_Type;
+}
+
 template<class QElement>
 typename Queue<QElement>::QElementPtr 
         Queue<QElement>::getFrontElement(bool bBlock, unique_lock& lock) const
@@ -154,5 +224,71 @@ typename Queue<QElement>::QElementPtr
     return m_pElements.front();
 }
 
+// Blocking in the lock-free modes: A waiting thread registers in m_NumWaiters and 
+// re-checks the ring while holding m_Mutex before it sleeps. The other side only 
+// takes the mutex if it sees a waiter after its own ring operation. The fences make 
+// sure that at least one of the two sides sees the other's change, so no wakeup gets 
+// lost.
+template<class QElement>
+typename Queue<QElement>::QElementPtr Queue<QElement>::popLockFree(bool bBlock)
+{
+    QElementPtr pElem;
+    if (!m_pRing->tryPop(pElem)) {
+        if (!bBlock) {
+            return pElem;
+        }
+        unique_lock lock(m_Mutex);
+        m_NumWaiters.fetch_add(1, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        while (!m_pRing->tryPop(pElem)) {
+            m_Cond.wait(lock);
+        }
+        m_NumWaiters.fetch_sub(1, boost::memory_order_relaxed);
+    }
+    wakeWaiters();
+    return pElem;
+}
+
+template<class QElement>
+void Queue<QElement>::pushLockFree(const QElementPtr& pElem)
+{
+    if (!m_pRing->tryPush(pElem)) {
+        unique_lock lock(m_Mutex);
+        m_NumWaiters.fetch_add(1, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        while (!m_pRing->tryPush(pElem)) {
+            m_Cond.wait(lock);
+        }
+        m_NumWaiters.fetch_sub(1, boost::memory_order_relaxed);
+    }
+    wakeWaiters();
+}
+
+template<class QElement>
+typename Queue<QElement>::QElementPtr Queue<QElement>::peekLockFree(bool bBlock) const
+{
+    QElementPtr pElem;
+    if (!m_pRing->front(pElem) && bBlock) {
+        unique_lock lock(m_Mutex);
+        m_NumWaiters.fetch_add(1, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        while (!m_pRing->front(pElem)) {
+            m_Cond.wait(lock);
+        }
+        m_NumWaiters.fetch_sub(1, boost::memory_order_relaxed);
+    }
+    return pElem;
+}
+
+template<class QElement>
+void Queue<QElement>::wakeWaiters() const
+{
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    if (m_NumWaiters.load(boost::memory_order_relaxed) > 0) {
+        unique_lock lock(m_Mutex);
+        m_Cond.notify_all();
+    }
+}
+
 }
 #endif
@@ -0,0 +1,198 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _RingBuffer_H_
+#define _RingBuffer_H_
+
+#include "../api.h"
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <assert.h>
+
+namespace avg {
+
+// Bounded, non-blocking ring buffer (Vyukov's sequenced cell algorithm). Every cell
+// carries a sequence number that tells producers and consumers whether it is free or
+// filled for the current lap, so no locks are needed. The capacity is exact, so it can
+// be used to implement Queue's maxSize semantics. If there is only one producer
+// (or consumer), the corresponding index is advanced with a plain store instead of a
+// compare-and-swap.
+// front() may only be called if there is a single consumer.
+template<class ELEMENT>
+class AVG_TEMPLATE_API RingBuffer: boost::noncopyable
+{
+public:
+    RingBuffer(int capacity, bool bMultiProducer, bool bMultiConsumer);
+    virtual ~RingBuffer();
+
+    bool tryPush(const ELEMENT& elem);
+    bool tryPop(ELEMENT& elem);
+    bool front(ELEMENT& elem) const;
+
+    int size() const;
+    int getCapacity() const;
+
+private:
+    struct Cell {
+        boost::atomic<size_t> m_Seq;
+        ELEMENT m_Elem;
+    };
+
+    enum {CACHE_LINE_SIZE = 64};
+
+    Cell* m_pCells;
+    size_t m_Capacity;
+    bool m_bMultiProducer;
+    bool m_bMultiConsumer;
+
+    // Producer and consumer indexes are kept on separate cache lines.
+    char m_Pad0[CACHE_LINE_SIZE];
+    boost::atomic<size_t> m_EnqueuePos;
+    char m_Pad1[CACHE_LINE_SIZE];
+    boost::atomic<size_t> m_DequeuePos;
+    char m_Pad2[CACHE_LINE_SIZE];
+};
+
+template<class ELEMENT>
+RingBuffer<ELEMENT>::RingBuffer(int capacity, bool bMultiProducer,
+        bool bMultiConsumer)
+    : m_Capacity(capacity),
+      m_bMultiProducer(bMultiProducer),
+      m_bMultiConsumer(bMultiConsumer),
+      m_EnqueuePos(0),
+      m_DequeuePos(0)
+{
+    assert(capacity > 0);
+    m_pCells = new Cell[m_Capacity];
+    for (size_t i = 0; i < m_Capacity; ++i) {
+        m_pCells[i].m_Seq.store(i, boost::memory_order_relaxed);
+    }
+}
+
+template<class ELEMENT>
+RingBuffer<ELEMENT>::~RingBuffer()
+{
+    delete[] m_pCells;
+}
+
+template<class ELEMENT>
+bool RingBuffer<ELEMENT>::tryPush(const ELEMENT& elem)
+{
+    Cell* pCell;
+    size_t pos = m_EnqueuePos.load(boost::memory_order_relaxed);
+    while (true) {
+        pCell = &m_pCells[pos % m_Capacity];
+        size_t seq = pCell->m_Seq.load(boost::memory_order_acquire);
+        ptrdiff_t dif = ptrdiff_t(seq) - ptrdiff_t(pos);
+        if (dif == 0) {
+            if (!m_bMultiProducer) {
+                m_EnqueuePos.store(pos+1, boost::memory_order_relaxed);
+                break;
+            }
+            if (m_EnqueuePos.compare_exchange_weak(pos, pos+1,
+                    boost::memory_order_relaxed))
+            {
+                break;
+            }
+        } else if (dif < 0) {
+            // Full.
+            return false;
+        } else {
+            pos = m_EnqueuePos.load(boost::memory_order_relaxed);
+        }
+    }
+    pCell->m_Elem = elem;
+    pCell->m_Seq.store(pos+1, boost::memory_order_release);
+    return true;
+}
+
+template<class ELEMENT>
+bool RingBuffer<ELEMENT>::tryPop(ELEMENT& elem)
+{
+    Cell* pCell;
+    size_t pos = m_DequeuePos.load(boost::memory_order_relaxed);
+    while (true) {
+        pCell = &m_pCells[pos % m_Capacity];
+        size_t seq = pCell->m_Seq.load(boost::memory_order_acquire);
+        ptrdiff_t dif = ptrdiff_t(seq) - ptrdiff_t(pos+1);
+        if (dif == 0) {
+            if (!m_bMultiConsumer) {
+                m_DequeuePos.store(pos+1, boost::memory_order_relaxed);
+                break;
+            }
+            if (m_DequeuePos.compare_exchange_weak(pos, pos+1,
+                    boost::memory_order_relaxed))
+            {
+                break;
+            }
+        } else if (dif < 0) {
+            // Empty.
+            return false;
+        } else {
+            pos = m_DequeuePos.load(boost::memory_order_relaxed);
+        }
+    }
+    elem = pCell->m_Elem;
+    // Reset the cell so it doesn't keep the element alive.
+    pCell->m_Elem = ELEMENT();
+    pCell->m_Seq.store(pos+m_Capacity, boost::memory_order_release);
+    return true;
+}
+
+template<class ELEMENT>
+bool RingBuffer<ELEMENT>::front(ELEMENT& elem) const
+{
+    assert(!m_bMultiConsumer);
+    size_t pos = m_DequeuePos.load(boost::memory_order_relaxed);
+    const Cell& cell = m_pCells[pos % m_Capacity];
+    if (cell.m_Seq.load(boost::memory_order_acquire) != pos+1) {
+        return false;
+    }
+    elem = cell.m_Elem;
+    return true;
+}
+
+template<class ELEMENT>
+int RingBuffer<ELEMENT>::size() const
+{
+    size_t dequeuePos = m_DequeuePos.load(boost::memory_order_acquire);
+    size_t enqueuePos = m_EnqueuePos.load(boost::memory_order_acquire);
+    ptrdiff_t size = ptrdiff_t(enqueuePos - dequeuePos);
+    if (size < 0) {
+        return 0;
+    }
+    if (size > ptrdiff_t(m_Capacity)) {
+        return int(m_Capacity);
+    }
+    return int(size);
+}
+
+template<class ELEMENT>
+int RingBuffer<ELEMENT>::getCapacity() const
+{
+    return int(m_Capacity);
+}
+
+}
+#endif
@@ -49,6 +49,24 @@ public:
 
     static void enableTimers(bool bEnable);
 
+    // Adds a per-frame quantity that isn't a time (e.g. a byte count) to a zone.
+    // It is averaged and dumped like the times.
+    static void addToZone(ProfilingZoneID& zoneID, long long value)
+    {
+        if (s_bTimersEnabled) {
+            zoneID.getProfiler()->addToZone(zoneID, value);
+        }
+    };
+
+    // Adds the latency of one frame (e.g. from capture to the end of a pipeline stage)
+    // to a zone. The average and a histogram of the latencies are dumped.
+    static void addLatencySample(ProfilingZoneID& zoneID, long long usecs)
+    {
+        if (s_bTimersEnabled) {
+            zoneID.getProfiler()->addLatencySample(zoneID, usecs);
+        }
+    };
+
 private:
     ProfilingZoneID* m_pZoneID;
 
@@ -0,0 +1,183 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ThreadPool.h"
+#include "ThreadHelper.h"
+#include "ConfigMgr.h"
+#include "Logger.h"
+
+#include <boost/bind.hpp>
+
+using namespace std;
+
+namespace avg {
+
+ThreadPool* ThreadPool::s_pThreadPool = 0;
+static boost::once_flag s_ThreadPoolOnceFlag = BOOST_ONCE_INIT;
+
+ThreadPool* ThreadPool::get()
+{
+    boost::call_once(s_ThreadPoolOnceFlag, &ThreadPool::createInstance);
+    return s_pThreadPool;
+}
+
+void ThreadPool::createInstance()
+{
+    // Like other singletons used from worker threads, the pool is never deleted.
+    s_pThreadPool = new ThreadPool();
+}
+
+ThreadPool::ThreadPool()
+    : m_NumThreads(1),
+      m_pJobs(0),
+      m_NextJob(0),
+      m_NumJobsDone(0),
+      m_bStop(false)
+{
+    int numThreads = ConfigMgr::get()->getIntOption("scr", "cputhreads", 0);
+    if (numThreads <= 0) {
+        numThreads = max(int(boost::thread::hardware_concurrency()), 1);
+    }
+    startWorkers(numThreads-1);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopWorkers();
+}
+
+void ThreadPool::runJobs(const vector<Job>& jobs)
+{
+    boost::unique_lock<boost::mutex> batchLock(m_BatchMutex, boost::try_to_lock);
+    if (!batchLock.owns_lock() || m_pWorkers.empty() || jobs.size() < 2) {
+        for (unsigned i = 0; i < jobs.size(); ++i) {
+            jobs[i]();
+        }
+        return;
+    }
+
+    boost::unique_lock<boost::mutex> lock(m_Mutex);
+    m_pJobs = &jobs;
+    m_NextJob = 0;
+    m_NumJobsDone = 0;
+    m_JobCondition.notify_all();
+    while (runNextJob(lock)) {
+    }
+    while (m_NumJobsDone < jobs.size()) {
+        m_DoneCondition.wait(lock);
+    }
+    m_pJobs = 0;
+    if (m_pException) {
+        Exception ex(*m_pException);
+        m_pException.reset();
+        throw ex;
+    }
+    if (m_pOtherException) {
+        boost::exception_ptr pEx = m_pOtherException;
+        m_pOtherException = boost::exception_ptr();
+        boost::rethrow_exception(pEx);
+    }
+}
+
+int ThreadPool::getNumThreads() const
+{
+    return m_NumThreads;
+}
+
+void ThreadPool::setNumThreads(int numThreads)
+{
+    AVG_ASSERT(numThreads >= 1);
+    lock_guard batchLock(m_BatchMutex);
+    stopWorkers();
+    startWorkers(numThreads-1);
+}
+
+void ThreadPool::startWorkers(int numWorkers)
+{
+    m_bStop = false;
+    for (int i = 0; i < numWorkers; ++i) {
+        m_pWorkers.push_back(new boost::thread(boost::bind(&ThreadPool::workerLoop,
+                this)));
+    }
+    m_NumThreads = numWorkers+1;
+}
+
+void ThreadPool::stopWorkers()
+{
+    {
+        lock_guard lock(m_Mutex);
+        m_bStop = true;
+        m_JobCondition.notify_all();
+    }
+    for (unsigned i = 0; i < m_pWorkers.size(); ++i) {
+        m_pWorkers[i]->join();
+        delete m_pWorkers[i];
+    }
+    m_pWorkers.clear();
+}
+
+void ThreadPool::workerLoop()
+{
+    setAffinityMask(false);
+    boost::unique_lock<boost::mutex> lock(m_Mutex);
+    while (!m_bStop) {
+        if (!runNextJob(lock)) {
+            m_JobCondition.wait(lock);
+        }
+    }
+}
+
+bool ThreadPool::runNextJob(boost::unique_lock<boost::mutex>& lock)
+{
+    // Called with m_Mutex locked. The job itself runs unlocked.
+    if (!m_pJobs || m_NextJob >= m_pJobs->size()) {
+        return false;
+    }
+    const Job& job = (*m_pJobs)[m_NextJob];
+    m_NextJob++;
+    lock.unlock();
+    // Nothing may escape: it would end a worker thread or leave runJobs() while the
+    // workers still use the jobs.
+    try {
+        job();
+    } catch (const Exception& ex) {
+        lock.lock();
+        if (!m_pException && !m_pOtherException) {
+            m_pException.reset(new Exception(ex));
+        }
+        lock.unlock();
+    } catch (...) {
+        boost::exception_ptr pEx = boost::current_exception();
+        lock.lock();
+        if (!m_pException && !m_pOtherException) {
+            m_pOtherException = pEx;
+        }
+        lock.unlock();
+    }
+    lock.lock();
+    m_NumJobsDone++;
+    if (m_NumJobsDone == m_pJobs->size()) {
+        m_DoneCondition.notify_all();
+    }
+    return true;
+}
+
+}
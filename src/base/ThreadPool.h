@@ -0,0 +1,91 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ThreadPool_H_
+#define _ThreadPool_H_
+
+#include "../api.h"
+#include "Exception.h"
+
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <vector>
+
+namespace avg {
+
+// Process-wide pool of worker threads for data-parallel work such as CPU filters.
+// runJobs() distributes a batch of independent jobs over the workers and the calling
+// thread and returns when all of them are done. Only one batch runs at a time; if the
+// pool is busy (e.g. when runJobs() is called from inside a job or from a second
+// thread), the jobs are executed sequentially in the calling thread instead.
+// If jobs throw, the first exception is rethrown by runJobs() once the whole batch is
+// done.
+class AVG_API ThreadPool: boost::noncopyable
+{
+public:
+    typedef boost::function<void ()> Job;
+
+    static ThreadPool* get();
+
+    void runJobs(const std::vector<Job>& jobs);
+
+    // Number of threads that work on a batch, including the calling thread.
+    int getNumThreads() const;
+    void setNumThreads(int numThreads);
+
+private:
+    ThreadPool();
+    virtual ~ThreadPool();
+    static void createInstance();
+
+    void startWorkers(int numWorkers);
+    void stopWorkers();
+    void workerLoop();
+    bool runNextJob(boost::unique_lock<boost::mutex>& lock);
+
+    std::vector<boost::thread*> m_pWorkers;
+    // getNumThreads() can be called from jobs while setNumThreads() changes m_pWorkers.
+    boost::atomic<int> m_NumThreads;
+
+    boost::mutex m_BatchMutex;
+    boost::mutex m_Mutex;
+    boost::condition_variable m_JobCondition;
+    boost::condition_variable m_DoneCondition;
+    const std::vector<Job>* m_pJobs;
+    unsigned m_NextJob;
+    unsigned m_NumJobsDone;
+    // The first exception thrown by a job. m_pException if it is an avg::Exception,
+    // m_pOtherException otherwise.
+    boost::scoped_ptr<Exception> m_pException;
+    boost::exception_ptr m_pOtherException;
+    bool m_bStop;
+
+    static ThreadPool* s_pThreadPool;
+};
+
+}
+
+#endif
@@ -108,6 +108,26 @@ void ThreadProfiler::stopZone(const ProfilingZoneID& zoneID)
     m_ActiveZones.pop_back();
 }
 
+void ThreadProfiler::addToZone(const ProfilingZoneID& zoneID, long long value)
+{
+    ZoneMap::iterator it = m_ZoneMap.find(&zoneID);
+    if (it == m_ZoneMap.end()) {
+        addZone(zoneID)->add(value);
+    } else {
+        it->second->add(value);
+    }
+}
+
+void ThreadProfiler::addLatencySample(const ProfilingZoneID& zoneID, long long usecs)
+{
+    ZoneMap::iterator it = m_ZoneMap.find(&zoneID);
+    if (it == m_ZoneMap.end()) {
+        addZone(zoneID)->addLatencySample(usecs);
+    } else {
+        it->second->addLatencySample(usecs);
+    }
+}
+
 void ThreadProfiler::dumpStatistics()
 {
     if (!m_Zones.empty()) {
@@ -125,6 +145,13 @@ void ThreadProfiler::dumpStatistics()
                     << std::setw(9) << std::right << (*it)->getAvgUSecs());
         }
         AVG_TRACE(m_LogCategory, Logger::severity::INFO, "");
+        for (it = m_Zones.begin(); it != m_Zones.end(); ++it) {
+            if ((*it)->hasLatencySamples()) {
+                AVG_TRACE(m_LogCategory, Logger::severity::INFO,
+                        "Latency histogram " << (*it)->getName() << ": " <<
+                        (*it)->getLatencyHistogramString());
+            }
+        }
     }
 }
 
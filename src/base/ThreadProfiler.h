@@ -57,6 +57,8 @@ public:
     void restart();
     void startZone(const ProfilingZoneID& zoneID);
     void stopZone(const ProfilingZoneID& zoneID);
+    void addToZone(const ProfilingZoneID& zoneID, long long value);
+    void addLatencySample(const ProfilingZoneID& zoneID, long long usecs);
     void dumpStatistics();
     void reset();
     int getNumZones();
@@ -23,7 +23,10 @@
 #include "Queue.h"
 #include "Command.h"
 #include "WorkerThread.h"
+#include "ThreadPool.h"
 #include "ObjectCounter.h"
+#include "ProfilingZone.h"
+#include "ProfilingZoneID.h"
 #include "triangulate/Triangulate.h"
 #include "GLMHelper.h"
 #include "GeomHelper.h"
@@ -49,6 +52,8 @@
 
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <new>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -162,16 +167,25 @@ public:
 
     void runTests() 
     {
-        runSingleThreadTests();
-        runMultiThreadTests();
+        QueueType types[] = {QUEUE_LOCKING, QUEUE_SPSC, QUEUE_MPSC, QUEUE_MPMC};
+        for (int i = 0; i < 4; ++i) {
+            cerr << string(m_IndentLevel+2, ' ') << "Queue type: " << types[i] << endl;
+            runSingleThreadTests(types[i]);
+            runMultiThreadTests(types[i]);
+        }
+        {
+            // Unbounded queues can't be lock-free.
+            Queue<int> q(-1, QUEUE_SPSC);
+            TEST(q.getType() == QUEUE_LOCKING);
+        }
     }
 
 private:
     typedef Queue<int>::QElementPtr ElemPtr;
     
-    void runSingleThreadTests()
+    void runSingleThreadTests(QueueType type)
     {
-        Queue<string> q;
+        Queue<string> q(10, type);
         typedef Queue<string>::QElementPtr ElemPtr;
         TEST(q.empty());
         q.push(ElemPtr(new string("1")));
@@ -184,35 +198,49 @@ private:
         TEST(*q.pop() == "2");
         q.push(ElemPtr(new string("4")));
         TEST(*q.pop() == "3");
-        TEST(*q.peek() == "4");
+        if (type != QUEUE_MPMC) {
+            TEST(*q.peek() == "4");
+        }
         TEST(*q.pop() == "4");
         TEST(q.empty());
         ElemPtr pElem = q.pop(false);
         TEST(!pElem);
+        for (int i = 0; i < 10; ++i) {
+            q.push(ElemPtr(new string("x")));
+        }
+        TEST(q.size() == 10);
+        TEST(!q.tryPush(ElemPtr(new string("y"))));
+        TEST(q.size() == 10);
+        q.clear();
+        TEST(q.empty());
+        TEST(q.tryPush(ElemPtr(new string("5"))));
+        TEST(*q.pop() == "5");
     }
 
-    void runMultiThreadTests()
+    void runMultiThreadTests(QueueType type)
     {
+        bool bPeek = (type != QUEUE_MPMC);
         {
-            Queue<int> q(10);
+            Queue<int> q(10, type);
             thread pusher(boost::bind(&pushThread, &q, 100));
-            thread popper(boost::bind(&popThread, &q, 100));
+            thread popper(boost::bind(&popThread, &q, 100, bPeek));
             pusher.join();
             popper.join();
             TEST(q.empty());
         }
-        {
-            Queue<int> q(10);
+        if (type != QUEUE_SPSC) {
+            Queue<int> q(10, type);
             thread pusher1(boost::bind(&pushThread, &q, 100));
             thread pusher2(boost::bind(&pushThread, &q, 100));
-            thread popper(boost::bind(&popThread, &q, 200));
+            thread popper(boost::bind(&popThread, &q, 200, bPeek));
             pusher1.join();
             pusher2.join();
             popper.join();
             TEST(q.empty());
         }
-        {
-            Queue<int> q(10);
+        if (type == QUEUE_LOCKING || type == QUEUE_MPMC) {
+            // The pushing thread also pops, so we need multiple consumers.
+            Queue<int> q(10, type);
             thread pusher(boost::bind(&pushClearThread, &q, 100));
             thread popper(boost::bind(&popClearThread, &q));
             pusher.join();
@@ -229,10 +257,12 @@ private:
         }
     }
 
-    static void popThread(Queue<int>* pq, int numPops)
+    static void popThread(Queue<int>* pq, int numPops, bool bPeek)
     {
         for (int i=0; i<numPops; ++i) {
-            pq->peek();
+            if (bPeek) {
+                pq->peek();
+            }
             pq->pop();
             msleep(3);
         }
@@ -260,6 +290,77 @@ private:
     }
 };
 
+
+// Compares throughput and latency of the different queue types. Every element carries
+// the time it was pushed, the consumer records the time it took to arrive.
+class QueueBenchmark: public Test
+{
+public:
+    QueueBenchmark()
+        : Test("QueueBenchmark", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        runBenchmark(QUEUE_LOCKING, 1);
+        runBenchmark(QUEUE_SPSC, 1);
+        runBenchmark(QUEUE_LOCKING, 2);
+        runBenchmark(QUEUE_MPSC, 2);
+    }
+
+private:
+    typedef Queue<long long> TimeQueue;
+    typedef TimeQueue::QElementPtr TimePtr;
+
+    void runBenchmark(QueueType type, int numProducers)
+    {
+        const int NUM_ELEMENTS = 100000;
+        TimeQueue q(64, type);
+        vector<long long> latencies;
+        latencies.reserve(NUM_ELEMENTS*numProducers);
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        thread popper(boost::bind(&popThread, &q, NUM_ELEMENTS*numProducers,
+                &latencies));
+        vector<thread*> pushers;
+        for (int i = 0; i < numProducers; ++i) {
+            pushers.push_back(new thread(boost::bind(&pushThread, &q, NUM_ELEMENTS)));
+        }
+        for (int i = 0; i < numProducers; ++i) {
+            pushers[i]->join();
+            delete pushers[i];
+        }
+        popper.join();
+        long long totalTime = TimeSource::get()->getCurrentMicrosecs() - startTime;
+        TEST(int(latencies.size()) == NUM_ELEMENTS*numProducers);
+        TEST(q.empty());
+
+        sort(latencies.begin(), latencies.end());
+        float throughput = float(latencies.size())/totalTime;
+        cerr << string(m_IndentLevel+4, ' ') << "type " << type << ", " 
+                << numProducers << " producer(s): " << throughput << " M elements/s, "
+                << "latency (us) median: " << latencies[latencies.size()/2] 
+                << ", 99%: " << latencies[latencies.size()*99/100]
+                << ", 99.9%: " << latencies[latencies.size()*999/1000]
+                << ", max: " << latencies.back() << endl;
+    }
+
+    static void pushThread(TimeQueue* pq, int numPushes)
+    {
+        for (int i=0; i<numPushes; ++i) {
+            pq->push(TimePtr(new long long(TimeSource::get()->getCurrentMicrosecs())));
+        }
+    }
+
+    static void popThread(TimeQueue* pq, int numPops, vector<long long>* pLatencies)
+    {
+        for (int i=0; i<numPops; ++i) {
+            TimePtr pTime = pq->pop();
+            pLatencies->push_back(TimeSource::get()->getCurrentMicrosecs() - *pTime);
+        }
+    }
+};
+
 class TestWorkerThread: public WorkerThread<TestWorkerThread>
 {
 public:
@@ -330,6 +431,119 @@ public:
     }
 };
 
+class ThreadPoolTest: public Test
+{
+public:
+    ThreadPoolTest()
+        : Test("ThreadPoolTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        ThreadPool* pPool = ThreadPool::get();
+        int oldNumThreads = pPool->getNumThreads();
+        pPool->setNumThreads(4);
+        TEST(pPool->getNumThreads() == 4);
+        for (int i = 0; i < 100; ++i) {
+            runBatch(pPool, 17);
+        }
+        // Nested batches are executed sequentially.
+        std::vector<int> results(4, 0);
+        std::vector<ThreadPool::Job> jobs;
+        for (int i = 0; i < 4; ++i) {
+            jobs.push_back(boost::bind(&ThreadPoolTest::runNestedBatch, this, pPool,
+                    &results[i]));
+        }
+        pPool->runJobs(jobs);
+        TEST(std::count(results.begin(), results.end(), 8) == 4);
+
+        // Exceptions are passed on to the caller.
+        jobs.clear();
+        jobs.push_back(boost::bind(&ThreadPoolTest::throwException));
+        jobs.push_back(boost::bind(&ThreadPoolTest::throwException));
+        bool bExceptionThrown = false;
+        try {
+            pPool->runJobs(jobs);
+        } catch (const Exception&) {
+            bExceptionThrown = true;
+        }
+        TEST(bExceptionThrown);
+        runBatch(pPool, 3);
+
+        // Other exceptions are passed on as well, after all jobs are done.
+        jobs.clear();
+        std::vector<int> values(16, 0);
+        for (int i = 0; i < 16; ++i) {
+            jobs.push_back(boost::bind(&ThreadPoolTest::setValueSlowly, &values[i], 1));
+        }
+        jobs[1] = boost::bind(&ThreadPoolTest::throwBadAlloc);
+        bExceptionThrown = false;
+        try {
+            pPool->runJobs(jobs);
+        } catch (const std::bad_alloc&) {
+            bExceptionThrown = true;
+        }
+        TEST(bExceptionThrown);
+        TEST(std::count(values.begin(), values.end(), 1) == 15);
+        runBatch(pPool, 3);
+
+        pPool->setNumThreads(1);
+        runBatch(pPool, 5);
+        pPool->setNumThreads(oldNumThreads);
+    }
+
+private:
+    void runBatch(ThreadPool* pPool, int numJobs)
+    {
+        std::vector<int> results(numJobs, 0);
+        std::vector<ThreadPool::Job> jobs;
+        for (int i = 0; i < numJobs; ++i) {
+            jobs.push_back(boost::bind(&ThreadPoolTest::setValue, &results[i], i));
+        }
+        pPool->runJobs(jobs);
+        bool bOK = true;
+        for (int i = 0; i < numJobs; ++i) {
+            if (results[i] != i) {
+                bOK = false;
+            }
+        }
+        QUIET_TEST(bOK);
+    }
+
+    void runNestedBatch(ThreadPool* pPool, int* pResult)
+    {
+        std::vector<int> results(8, 0);
+        std::vector<ThreadPool::Job> jobs;
+        for (int i = 0; i < 8; ++i) {
+            jobs.push_back(boost::bind(&ThreadPoolTest::setValue, &results[i], 1));
+        }
+        pPool->runJobs(jobs);
+        *pResult = int(std::count(results.begin(), results.end(), 1));
+    }
+
+    static void setValue(int* pValue, int value)
+    {
+        *pValue = value;
+    }
+
+    static void setValueSlowly(int* pValue, int value)
+    {
+        msleep(1);
+        *pValue = value;
+    }
+
+    static void throwException()
+    {
+        throw Exception(AVG_ERR_UNKNOWN, "ThreadPoolTest");
+    }
+
+    static void throwBadAlloc()
+    {
+        throw std::bad_alloc();
+    }
+};
+
 
 class DummyClass
 {
@@ -368,6 +582,34 @@ public:
 };
 
 
+class ProfilingZoneTest: public Test {
+public:
+    ProfilingZoneTest()
+        : Test("ProfilingZoneTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        ProfilingZoneID zoneID("Latency");
+        ProfilingZone zone(zoneID);
+        TEST(!zone.hasLatencySamples());
+        zone.addLatencySample(500);
+        zone.addLatencySample(1500);
+        zone.addLatencySample(3000);
+        zone.addLatencySample(1000000);
+        TEST(zone.hasLatencySamples());
+        TEST(zone.getUSecs() == 1005000);
+        TEST(zone.getLatencyHistogramString() == "<1ms: 1, <2ms: 1, <4ms: 1, "
+                "<8ms: 0, <16ms: 0, <32ms: 0, <64ms: 0, >=64ms: 1");
+        zone.reset();
+        TEST(zone.getAvgUSecs() == 1005000);
+        zone.restart();
+        TEST(!zone.hasLatencySamples());
+    }
+};
+
+
 // The following pragmas avoid a compiler warning (potential division by 0)
 #ifdef _MSC_VER
 #pragma optimize("", off)
@@ -990,8 +1232,11 @@ public:
     {
         addTest(TestPtr(new DAGTest));
         addTest(TestPtr(new QueueTest));
+        addTest(TestPtr(new QueueBenchmark));
         addTest(TestPtr(new WorkerThreadTest));
+        addTest(TestPtr(new ThreadPoolTest));
         addTest(TestPtr(new ObjectCounterTest));
+        addTest(TestPtr(new ProfilingZoneTest));
         addTest(TestPtr(new GeomTest));
         addTest(TestPtr(new TriangleTest));
         addTest(TestPtr(new FileTest));
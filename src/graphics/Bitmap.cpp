@@ -20,10 +20,12 @@
 //
 
 #include "Bitmap.h"
+#include "BitmapPool.h"
 #include "Pixel24.h"
 #include "Pixel16.h"
 #include "Pixel8.h"
 #include "Filter3x3.h"
+#include "SIMDConversion.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -51,6 +53,7 @@ Bitmap::Bitmap(glm::vec2 size, PixelFormat pf, const UTF8String& sName, int stri
     : m_Size(size),
       m_PF(pf),
       m_pBits(0),
+      m_AllocSize(0),
       m_bOwnsBits(true),
       m_sName(sName)
 {
@@ -62,6 +65,7 @@ Bitmap::Bitmap(IntPoint size, PixelFormat pf, const UTF8String& sName, int strid
     : m_Size(size),
       m_PF(pf),
       m_pBits(0),
+      m_AllocSize(0),
       m_bOwnsBits(true),
       m_sName(sName)
 {
@@ -74,6 +78,7 @@ Bitmap::Bitmap(IntPoint size, PixelFormat pf, unsigned char* pBits,
     : m_Size(size),
       m_PF(pf),
       m_pBits(0),
+      m_AllocSize(0),
       m_sName(sName)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -84,6 +89,7 @@ Bitmap::Bitmap(const Bitmap& origBmp)
     : m_Size(origBmp.getSize()),
       m_PF(origBmp.getPixelFormat()),
       m_pBits(0),
+      m_AllocSize(0),
       m_bOwnsBits(origBmp.m_bOwnsBits),
       m_sName(origBmp.getName()+" copy")
 {
@@ -96,6 +102,7 @@ Bitmap::Bitmap(const Bitmap& origBmp, bool bOwnsBits)
     : m_Size(origBmp.getSize()),
       m_PF(origBmp.getPixelFormat()),
       m_pBits(0),
+      m_AllocSize(0),
       m_bOwnsBits(bOwnsBits),
       m_sName(origBmp.getName()+" copy")
 {
@@ -110,6 +117,7 @@ Bitmap::Bitmap(Bitmap& origBmp, const IntRect& rect)
     : m_Size(rect.size()),
       m_PF(origBmp.getPixelFormat()),
       m_pBits(0),
+      m_AllocSize(0),
       m_bOwnsBits(false)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -131,8 +139,7 @@ Bitmap::~Bitmap()
 {
     ObjectCounter::get()->decRef(&typeid(*this));
     if (m_bOwnsBits) {
-        delete[] m_pBits;
-        m_pBits = 0;
+        freeBits();
     }
 }
 
@@ -140,8 +147,7 @@ Bitmap &Bitmap::operator =(const Bitmap& origBmp)
 {
     if (this != &origBmp) {
         if (m_bOwnsBits) {
-            delete[] m_pBits;
-            m_pBits = 0;
+            freeBits();
         }
         m_Size = origBmp.getSize();
         m_PF = origBmp.getPixelFormat();
@@ -183,6 +189,7 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
                     case I8:
                     case A8:
                         YCbCrtoI8(origBmp);
+                        break;
                     default: {
                             Bitmap TempBmp(getSize(), B8G8R8X8, "TempColorConversion");
                             TempBmp.YCbCrtoBGR(origBmp);
@@ -397,11 +404,13 @@ void Bitmap::copyYUVPixels(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap&
     ptrv = vBmp.getPixels();
 
     for (i = 0; i < height; i++) {
-        int j;
-        o = (__m64*)pDestLine;
+        // The SSE2 version handles 16 pixels at a time, mmx does the rest.
+        int j = YUV420toBGR32LineSIMD(ptry, ptru, ptrv, (unsigned char*)pDestLine,
+                width, bJPEG);
+        o = (__m64*)(pDestLine+j);
         pDestLine += destStride;
         if (bJPEG) {
-            for (j = 0; j < width; j += 8) {
+            for (; j < width; j += 8) {
                 // ylo and yhi contain 4 pixels each
                 y = *(__m64*)(&(ptry[j]));
                 ylo = _m_punpcklbw(y, zero);
@@ -438,7 +447,7 @@ void Bitmap::copyYUVPixels(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap&
 
             }
         } else {
-            for (j = 0; j < width; j += 8) {
+            for (; j < width; j += 8) {
 
                 // y' = (298*(y-16))
                 // ylo and yhi contain 4 pixels each
@@ -1135,25 +1144,41 @@ void Bitmap::allocBits(int stride)
         //XXX: We allocate more than nessesary here because ffmpeg seems to
         // overwrite memory after the bits - probably during yuv conversion.
         // Yuck.
-        m_pBits = new unsigned char[size_t(m_Stride+1)*(m_Size.y+1)];
+        m_AllocSize = size_t(m_Stride+1)*(m_Size.y+1);
     } else {
-        m_pBits = new unsigned char[size_t(m_Stride)*m_Size.y];
+        m_AllocSize = size_t(m_Stride)*m_Size.y;
     }
+    m_pBits = BitmapPool::get()->allocBits(m_AllocSize);
+}
+
+void Bitmap::freeBits()
+{
+    BitmapPool::get()->freeBits(m_pBits, m_AllocSize);
+    m_pBits = 0;
+    m_AllocSize = 0;
 }
 
 void YUYV422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int width)
 {
-    Pixel32 * pDestPixel = pDestLine;
+    // Convert as many pixel pairs as possible using SIMD code and continue here.
+    int startPair = YUV422toBGR32LineSIMD(pSrcLine, (unsigned char*)pDestLine, width,
+            false);
+    Pixel32 * pDestPixel = pDestLine+startPair*2;
+    const unsigned char * pSrcPixels = pSrcLine+startPair*4;
     
     // We need the previous and next values to interpolate between the
     // sampled u and v values.
-    int v = *(pSrcLine+3);
+    int v;
+    if (startPair == 0) {
+        v = *(pSrcLine+3);
+    } else {
+        v = *(pSrcPixels-1);
+    }
     int v0; // Previous v
     int u;
     int u1; // Next u;
-    const unsigned char * pSrcPixels = pSrcLine;
 
-    for (int x = 0; x < width/2-1; x++) {
+    for (int x = startPair; x < width/2-1; x++) {
         // Two pixels at a time.
         // Source format is YUYV.
         u = pSrcPixels[1];
@@ -1177,17 +1202,25 @@ void YUYV422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int w
  
 void UYVY422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int width)
 {
-    Pixel32 * pDestPixel = pDestLine;
+    // Convert as many pixel pairs as possible using SIMD code and continue here.
+    int startPair = YUV422toBGR32LineSIMD(pSrcLine, (unsigned char*)pDestLine, width,
+            true);
+    Pixel32 * pDestPixel = pDestLine+startPair*2;
+    const unsigned char * pSrcPixels = pSrcLine+startPair*4;
     
     // We need the previous and next values to interpolate between the
     // sampled u and v values.
-    int v = *(pSrcLine+2);
+    int v;
+    if (startPair == 0) {
+        v = *(pSrcLine+2);
+    } else {
+        v = *(pSrcPixels-2);
+    }
     int v0; // Previous v
     int u;
     int u1; // Next u;
-    const unsigned char * pSrcPixels = pSrcLine;
 
-    for (int x = 0; x < width/2-1; x++) {
+    for (int x = startPair; x < width/2-1; x++) {
         // Two pixels at a time.
         // Source format is UYVY.
         u = pSrcPixels[0];
@@ -1285,9 +1318,10 @@ void Bitmap::YCbCrtoBGR(const Bitmap& origBmp)
     
 void YUYV422toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine, int width)
 {
-    const unsigned char * pSrc = pSrcLine;
-    unsigned char * pDest = pDestLine;
-    for (int x = 0; x < width; x++) {
+    int startX = YUYV422toI8LineSIMD(pSrcLine, pDestLine, width);
+    const unsigned char * pSrc = pSrcLine+startX*2;
+    unsigned char * pDest = pDestLine+startX;
+    for (int x = startX; x < width; x++) {
         *pDest = *pSrc;
         pDest++;
         pSrc+=2;
@@ -1307,7 +1341,7 @@ void YUV411toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine, int
  
 void Bitmap::YCbCrtoI8(const Bitmap& origBmp)
 {
-    AVG_ASSERT(origBmp.getBytesPerPixel() == 1);
+    AVG_ASSERT(getBytesPerPixel() == 1);
     const unsigned char * pSrc = origBmp.getPixels();
     unsigned char * pDest = m_pBits;
     int height = min(origBmp.getSize().y, m_Size.y);
@@ -1393,9 +1427,10 @@ void Bitmap::I8toRGB(const Bitmap& origBmp)
         unsigned int * pDest = (unsigned int *)m_pBits;
         int destStrideInPixels = m_Stride/getBytesPerPixel();
         for (int y = 0; y < height; ++y) {
-            const unsigned char * pSrcPixel = pSrc;
-            unsigned int * pDestPixel = pDest;
-            for (int x = 0; x < width; ++x) {
+            int startX = I8toRGBLineSIMD(pSrc, (unsigned char*)pDest, width, 4);
+            const unsigned char * pSrcPixel = pSrc+startX;
+            unsigned int * pDestPixel = pDest+startX;
+            for (int x = startX; x < width; ++x) {
                 *pDestPixel = (((((255 << 8)+(*pSrcPixel)) << 8)+
                         *pSrcPixel) << 8) +(*pSrcPixel);
                 pDestPixel ++;
@@ -1407,9 +1442,10 @@ void Bitmap::I8toRGB(const Bitmap& origBmp)
     } else {
         unsigned char * pDest = m_pBits;
         for (int y = 0; y < height; ++y) {
-            const unsigned char * pSrcPixel = pSrc;
-            unsigned char * pDestPixel = pDest;
-            for (int x = 0; x < width; ++x) {
+            int startX = I8toRGBLineSIMD(pSrc, pDest, width, 3);
+            const unsigned char * pSrcPixel = pSrc+startX;
+            unsigned char * pDestPixel = pDest+startX*3;
+            for (int x = startX; x < width; ++x) {
                 *pDestPixel++ = *pSrcPixel;
                 *pDestPixel++ = *pSrcPixel;
                 *pDestPixel++ = *pSrcPixel;
@@ -1430,9 +1466,10 @@ void Bitmap::ByteRGBAtoFloatRGBA(const Bitmap& origBmp)
     int width = min(origBmp.getSize().x, m_Size.x);
     float * pDest = (float *)m_pBits;
     for (int y = 0; y < height; ++y) {
-        const unsigned char * pSrcPixel = pSrc;
-        float * pDestPixel = pDest;
-        for (int x = 0; x < width*4; ++x) {
+        int startX = ByteToFloatLineSIMD(pSrc, pDest, width*4);
+        const unsigned char * pSrcPixel = pSrc+startX;
+        float * pDestPixel = pDest+startX;
+        for (int x = startX; x < width*4; ++x) {
             *pDestPixel = float(*pSrcPixel)/255;
             pDestPixel ++;
             pSrcPixel++;
@@ -1612,6 +1649,12 @@ void Bitmap::BY8toRGBBilinear(const Bitmap& origBmp)
             ++pSrcPixel;
             pDestPixel += 4;
         }
+
+        int numPairs = int(pSrcEndBoundary-pSrcPixel)/2;
+        int numSIMDPairs = BayerBilinearLineSIMD(pSrcPixel, srcStride, pDestPixel-1,
+                numPairs, blue < 0);
+        pSrcPixel += numSIMDPairs*2;
+        pDestPixel += numSIMDPairs*8;
                 
         if (blue > 0) {
             while (pSrcPixel <= pSrcEndBoundary - 2) {
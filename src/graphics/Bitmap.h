@@ -107,6 +107,7 @@ public:
 private:
     void initWithData(unsigned char* pBits, int stride, bool bCopyBits);
     void allocBits(int stride=0);
+    void freeBits();
     void YCbCrtoBGR(const Bitmap& origBmp);
     void YCbCrtoI8(const Bitmap& origBmp);
     void I8toI16(const Bitmap& origBmp);
@@ -122,6 +123,7 @@ private:
     int m_Stride;
     PixelFormat m_PF;
     unsigned char* m_pBits;
+    size_t m_AllocSize;
     bool m_bOwnsBits;
     UTF8String m_sName;
 
@@ -0,0 +1,163 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "BitmapPool.h"
+
+#include "../base/ConfigMgr.h"
+#include "../base/Logger.h"
+#include "../base/ThreadHelper.h"
+
+using namespace std;
+
+namespace avg {
+
+BitmapPool* BitmapPool::s_pBitmapPool = 0;
+static boost::once_flag s_BitmapPoolOnceFlag = BOOST_ONCE_INIT;
+
+BitmapPool* BitmapPool::get()
+{
+    // Bitmaps are created in several threads, so the pool is created using call_once.
+    boost::call_once(s_BitmapPoolOnceFlag, &BitmapPool::createInstance);
+    return s_pBitmapPool;
+}
+
+void BitmapPool::createInstance()
+{
+    // The pool is never deleted: Bitmaps in static objects can return their buffers
+    // after exit handlers have run.
+    s_pBitmapPool = new BitmapPool();
+}
+
+BitmapPool::BitmapPool()
+    : m_ResidentBytes(0),
+      m_NumHits(0),
+      m_NumMisses(0)
+{
+    int maxMB = ConfigMgr::get()->getIntOption("scr", "bitmappoolsize", 64);
+    m_MaxResidentBytes = size_t(maxMB)*1024*1024;
+}
+
+BitmapPool::~BitmapPool()
+{
+    clear();
+}
+
+unsigned char* BitmapPool::allocBits(size_t numBytes)
+{
+    {
+        lock_guard lock(m_Mutex);
+        BufferMap::iterator it = m_FreeBuffers.find(numBytes);
+        if (it != m_FreeBuffers.end() && !it->second.empty()) {
+            unsigned char* pBits = it->second.back();
+            it->second.pop_back();
+            m_ResidentBytes -= numBytes;
+            m_NumHits++;
+            return pBits;
+        }
+        m_NumMisses++;
+    }
+    return new unsigned char[numBytes];
+}
+
+void BitmapPool::freeBits(unsigned char* pBits, size_t numBytes)
+{
+    {
+        lock_guard lock(m_Mutex);
+        if (m_ResidentBytes+numBytes <= m_MaxResidentBytes) {
+            m_FreeBuffers[numBytes].push_back(pBits);
+            m_ResidentBytes += numBytes;
+            return;
+        }
+    }
+    delete[] pBits;
+}
+
+void BitmapPool::setMaxResidentBytes(size_t maxBytes)
+{
+    lock_guard lock(m_Mutex);
+    m_MaxResidentBytes = maxBytes;
+    trimToSize(maxBytes);
+}
+
+size_t BitmapPool::getMaxResidentBytes() const
+{
+    lock_guard lock(m_Mutex);
+    return m_MaxResidentBytes;
+}
+
+void BitmapPool::clear()
+{
+    lock_guard lock(m_Mutex);
+    trimToSize(0);
+}
+
+size_t BitmapPool::getResidentBytes() const
+{
+    lock_guard lock(m_Mutex);
+    return m_ResidentBytes;
+}
+
+long long BitmapPool::getNumHits() const
+{
+    lock_guard lock(m_Mutex);
+    return m_NumHits;
+}
+
+long long BitmapPool::getNumMisses() const
+{
+    lock_guard lock(m_Mutex);
+    return m_NumMisses;
+}
+
+float BitmapPool::getHitRate() const
+{
+    lock_guard lock(m_Mutex);
+    long long numAllocs = m_NumHits+m_NumMisses;
+    if (numAllocs == 0) {
+        return 0;
+    }
+    return float(m_NumHits)/numAllocs;
+}
+
+void BitmapPool::dumpStatistics() const
+{
+    AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO, 
+            "Bitmap pool: " << getNumHits() << " hits, " << getNumMisses() 
+            << " misses (hit rate " << getHitRate()*100 << "%), "
+            << getResidentBytes()/1024 << " KB resident.");
+}
+
+void BitmapPool::trimToSize(size_t maxBytes)
+{
+    // Largest buffers are released first.
+    BufferMap::reverse_iterator it = m_FreeBuffers.rbegin();
+    while (m_ResidentBytes > maxBytes && it != m_FreeBuffers.rend()) {
+        BufferList& buffers = it->second;
+        while (m_ResidentBytes > maxBytes && !buffers.empty()) {
+            delete[] buffers.back();
+            buffers.pop_back();
+            m_ResidentBytes -= it->first;
+        }
+        ++it;
+    }
+}
+
+}
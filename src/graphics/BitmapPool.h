@@ -0,0 +1,79 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _BitmapPool_H_
+#define _BitmapPool_H_
+
+#include "../api.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+
+#include <map>
+#include <vector>
+
+namespace avg {
+
+// Keeps the pixel buffers of deleted bitmaps around so bitmaps of the same size and
+// pixel format can reuse them. This avoids allocating and page-faulting full-frame
+// buffers every frame in the video, camera and tracker code paths.
+// Buffers are keyed by their size in bytes. Unused buffers are only kept as long as
+// their total size stays below the high-water mark.
+class AVG_API BitmapPool {
+public:
+    static BitmapPool* get();
+    virtual ~BitmapPool();
+
+    unsigned char* allocBits(size_t numBytes);
+    void freeBits(unsigned char* pBits, size_t numBytes);
+
+    void setMaxResidentBytes(size_t maxBytes);
+    size_t getMaxResidentBytes() const;
+    void clear();
+
+    size_t getResidentBytes() const;
+    long long getNumHits() const;
+    long long getNumMisses() const;
+    float getHitRate() const;
+    void dumpStatistics() const;
+
+private:
+    BitmapPool();
+    static void createInstance();
+    void trimToSize(size_t maxBytes);
+
+    typedef std::vector<unsigned char*> BufferList;
+    typedef std::map<size_t, BufferList> BufferMap;
+    BufferMap m_FreeBuffers;
+
+    size_t m_ResidentBytes;
+    size_t m_MaxResidentBytes;
+    long long m_NumHits;
+    long long m_NumMisses;
+    mutable boost::mutex m_Mutex;
+
+    static BitmapPool* s_pBitmapPool;
+};
+
+}
+
+#endif
+
@@ -55,8 +55,14 @@ void BmpTextureMover::moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex)
     AVG_ASSERT(getSize() == pBmp->getSize());
     AVG_ASSERT(pBmp->getPixelFormat() == getPF());
     tex.activate();
-    unsigned char * pStartPos = pBmp->getPixels();
     IntPoint size = tex.getSize();
+    if (pBmp->getStride() != Bitmap::getPreferredStride(size.x, getPF())) {
+        // Bitmaps that point into foreign buffers (e.g. decoded video frames) can
+        // have padded lines.
+        m_pBmp->copyPixels(*pBmp);
+        pBmp = m_pBmp;
+    }
+    unsigned char * pStartPos = pBmp->getPixels();
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y,
             tex.getGLFormat(getPF()), tex.getGLType(getPF()), 
             pStartPos);
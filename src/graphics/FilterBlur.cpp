@@ -23,9 +23,12 @@
 #include "Filterfill.h"
 #include "Pixel8.h"
 #include "Bitmap.h"
+#include "ParallelRows.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <iostream>
 #include <math.h>
 
@@ -47,11 +50,20 @@ BitmapPtr FilterBlur::apply(BitmapPtr pBmpSrc)
     
     IntPoint Size(pBmpSrc->getSize().x-2, pBmpSrc->getSize().y-2);
     BitmapPtr pDestBmp = BitmapPtr(new Bitmap(Size, I8, pBmpSrc->getName()));
+    processRowBands(Size.y, Size.x, 1,
+            boost::bind(&FilterBlur::applyToRows, this, pBmpSrc, pDestBmp, _1, _2));
+    return pDestBmp;
+}
+
+void FilterBlur::applyToRows(BitmapPtr pBmpSrc, BitmapPtr pDestBmp, int startRow,
+        int endRow) const
+{
+    IntPoint Size = pDestBmp->getSize();
     int srcStride = pBmpSrc->getStride();
     int destStride = pDestBmp->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels()+srcStride+1;
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < Size.y; ++y) {
+    unsigned char * pSrcLine = pBmpSrc->getPixels()+(startRow+1)*srcStride+1;
+    unsigned char * pDestLine = pDestBmp->getPixels()+startRow*destStride;
+    for (int y = startRow; y < endRow; ++y) {
         unsigned char * pSrcPixel = pSrcLine;
         unsigned char * pDestPixel = pDestLine;
         for (int x = 0; x < Size.x; ++x) {
@@ -63,7 +75,6 @@ BitmapPtr FilterBlur::apply(BitmapPtr pBmpSrc)
         pSrcLine += srcStride;
         pDestLine += destStride;
     }
-    return pDestBmp;
 }
 
 }
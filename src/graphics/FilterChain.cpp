@@ -0,0 +1,188 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "FilterChain.h"
+#include "ParallelRows.h"
+
+#include "../base/Exception.h"
+
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+namespace {
+
+// Pulls the lines of one row band through the stages of a fused chain. Stage i reads
+// the output of stage i-1 (stage 0 reads the source bitmap) and writes into a ring
+// buffer that holds the 2*radius+1 lines stage i+1 needs. The last stage writes
+// straight into the destination bitmap.
+class FusedRowPass
+{
+public:
+    FusedRowPass(BitmapPtr pSrcBmp, BitmapPtr pDestBmp,
+            const vector<RowFilter*>& pFilters)
+        : m_pSrcBmp(pSrcBmp),
+          m_pDestBmp(pDestBmp),
+          m_pFilters(pFilters),
+          m_Size(pSrcBmp->getSize()),
+          m_NextRows(pFilters.size()),
+          m_pSrcLines(pFilters.size()),
+          m_RingBuffers(pFilters.size()-1),
+          m_RingSizes(pFilters.size()-1)
+    {
+        for (unsigned i = 0; i < m_pFilters.size(); ++i) {
+            m_pSrcLines[i].resize(2*m_pFilters[i]->getRowRadius()+1);
+        }
+        for (unsigned i = 0; i < m_RingBuffers.size(); ++i) {
+            m_RingSizes[i] = 2*m_pFilters[i+1]->getRowRadius()+1;
+            m_RingBuffers[i].resize(m_RingSizes[i]*m_Size.x);
+        }
+    }
+
+    void run(int startRow, int endRow)
+    {
+        // Stage i needs to start early enough to cover the radii of all later stages.
+        int haloRows = 0;
+        for (int i = int(m_pFilters.size())-1; i >= 0; --i) {
+            m_NextRows[i] = max(startRow-haloRows, 0);
+            haloRows += m_pFilters[i]->getRowRadius();
+        }
+        produceRows(int(m_pFilters.size())-1, endRow-1);
+    }
+
+private:
+    void produceRows(int stage, int lastRow)
+    {
+        RowFilter* pFilter = m_pFilters[stage];
+        int radius = pFilter->getRowRadius();
+        vector<const unsigned char *>& pSrcLines = m_pSrcLines[stage];
+        while (m_NextRows[stage] <= lastRow) {
+            int y = m_NextRows[stage];
+            if (stage > 0) {
+                produceRows(stage-1, min(y+radius, m_Size.y-1));
+            }
+            for (int i = 0; i < 2*radius+1; ++i) {
+                int srcRow = min(max(y-radius+i, 0), m_Size.y-1);
+                pSrcLines[i] = getLine(stage-1, srcRow);
+            }
+            pFilter->filterRow(&pSrcLines[0], getLine(stage, y), y, m_Size);
+            m_NextRows[stage]++;
+        }
+    }
+
+    unsigned char * getLine(int stage, int row)
+    {
+        if (stage < 0) {
+            return m_pSrcBmp->getPixels()+row*m_pSrcBmp->getStride();
+        } else if (stage == int(m_pFilters.size())-1) {
+            return m_pDestBmp->getPixels()+row*m_pDestBmp->getStride();
+        } else {
+            return &(m_RingBuffers[stage][(row%m_RingSizes[stage])*m_Size.x]);
+        }
+    }
+
+    BitmapPtr m_pSrcBmp;
+    BitmapPtr m_pDestBmp;
+    const vector<RowFilter*>& m_pFilters;
+    IntPoint m_Size;
+    vector<int> m_NextRows;
+    vector<vector<const unsigned char *> > m_pSrcLines;
+    vector<vector<unsigned char> > m_RingBuffers;
+    vector<int> m_RingSizes;
+};
+
+}
+
+FilterChain::FilterChain()
+{
+}
+
+FilterChain::~FilterChain()
+{
+}
+
+void FilterChain::addFilter(FilterPtr pFilter)
+{
+    m_pFilters.push_back(pFilter);
+}
+
+BitmapPtr FilterChain::apply(BitmapPtr pBmpSource)
+{
+    BitmapPtr pBmp = pBmpSource;
+    RowFilterVector pRowFilters;
+    for (unsigned i = 0; i < m_pFilters.size(); ++i) {
+        RowFilter* pRowFilter = dynamic_cast<RowFilter*>(m_pFilters[i].get());
+        if (pRowFilter && pBmp->getPixelFormat() == I8) {
+            pRowFilters.push_back(pRowFilter);
+        } else {
+            pBmp = applyFused(pBmp, pRowFilters);
+            pRowFilters.clear();
+            pBmp = m_pFilters[i]->apply(pBmp);
+        }
+    }
+    pBmp = applyFused(pBmp, pRowFilters);
+    if (pBmp == pBmpSource) {
+        // Empty chain.
+        pBmp = BitmapPtr(new Bitmap(*pBmpSource));
+    }
+    return pBmp;
+}
+
+BitmapPtr FilterChain::applyFused(BitmapPtr pSrcBmp, const RowFilterVector& pFilters)
+        const
+{
+    if (pFilters.empty()) {
+        return pSrcBmp;
+    }
+    IntPoint size = pSrcBmp->getSize();
+    BitmapPtr pDestBmp(new Bitmap(size, I8, pSrcBmp->getName()));
+    int haloRows = 0;
+    bool bHasState = false;
+    for (unsigned i = 0; i < pFilters.size(); ++i) {
+        pFilters[i]->startFrame(size);
+        haloRows += pFilters[i]->getRowRadius();
+        bHasState |= pFilters[i]->hasState();
+    }
+    if (bHasState) {
+        // Parallel bands recompute their halo lines, but stateful filters must see
+        // each line exactly once.
+        applyFusedToRows(pSrcBmp, pDestBmp, pFilters, 0, size.y);
+    } else {
+        processRowBands(size.y, size.x, haloRows,
+                boost::bind(&FilterChain::applyFusedToRows, this, pSrcBmp, pDestBmp,
+                        boost::cref(pFilters), _1, _2));
+    }
+    return pDestBmp;
+}
+
+void FilterChain::applyFusedToRows(BitmapPtr pSrcBmp, BitmapPtr pDestBmp,
+        const RowFilterVector& pFilters, int startRow, int endRow) const
+{
+    FusedRowPass pass(pSrcBmp, pDestBmp, pFilters);
+    pass.run(startRow, endRow);
+}
+
+}
@@ -0,0 +1,63 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _FilterChain_H_
+#define _FilterChain_H_
+
+#include "../api.h"
+#include "Filter.h"
+#include "RowFilter.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace avg {
+
+// Applies a sequence of filters. Consecutive filters that implement RowFilter are
+// fused into a single pass over row bands: each stage hands its output lines to the
+// next one through a small ring buffer instead of a full-size intermediate bitmap.
+// All other filters are applied one after another. The result is identical to calling
+// apply() on each filter in turn.
+class AVG_API FilterChain: public Filter
+{
+public:
+    FilterChain();
+    virtual ~FilterChain();
+
+    void addFilter(FilterPtr pFilter);
+    virtual BitmapPtr apply(BitmapPtr pBmpSource);
+
+private:
+    typedef std::vector<RowFilter*> RowFilterVector;
+
+    BitmapPtr applyFused(BitmapPtr pSrcBmp, const RowFilterVector& pFilters) const;
+    void applyFusedToRows(BitmapPtr pSrcBmp, BitmapPtr pDestBmp,
+            const RowFilterVector& pFilters, int startRow, int endRow) const;
+
+    std::vector<FilterPtr> m_pFilters;
+};
+
+typedef boost::shared_ptr<FilterChain> FilterChainPtr;
+
+}
+
+#endif
@@ -28,6 +28,9 @@
 #include "Pixel8.h"
 #include "Pixel24.h"
 #include "Pixel32.h"
+#include "ParallelRows.h"
+
+#include <boost/bind.hpp>
 
 #include <iostream>
 
@@ -43,6 +46,8 @@ public:
     virtual BitmapPtr apply(BitmapPtr pBmpSource);
 
 private:
+    void applyToRows(BitmapPtr pBmpSource, BitmapPtr pNewBmp, int startRow,
+            int endRow) const;
     void convolveLine(const unsigned char* pSrc, unsigned char* pDest, 
             int lineLen, int stride, int offset = 0) const;
     int m_N;
@@ -125,13 +130,21 @@ BitmapPtr FilterConvol<Pixel>::apply(BitmapPtr pBmpSource)
     IntPoint NewSize(pBmpSource->getSize().x-m_N+1, pBmpSource->getSize().y-m_M+1);
     BitmapPtr pNewBmp(new Bitmap(NewSize, pBmpSource->getPixelFormat(),
             pBmpSource->getName()+"_filtered"));
-            
-    for (int y = 0; y < NewSize.y; y++) {
+    processRowBands(NewSize.y, NewSize.x, m_M, boost::bind(
+            &FilterConvol<Pixel>::applyToRows, this, pBmpSource, pNewBmp, _1, _2));
+    return pNewBmp;
+}
+
+template <class Pixel>
+void FilterConvol<Pixel>::applyToRows(BitmapPtr pBmpSource, BitmapPtr pNewBmp,
+        int startRow, int endRow) const
+{
+    for (int y = startRow; y < endRow; y++) {
         const unsigned char * pSrc = pBmpSource->getPixels()+y*pBmpSource->getStride();
         unsigned char * pDest = pNewBmp->getPixels()+y*pNewBmp->getStride();
-        convolveLine(pSrc, pDest, NewSize.x, pBmpSource->getStride(), m_Offset);
+        convolveLine(pSrc, pDest, pNewBmp->getSize().x, pBmpSource->getStride(),
+                m_Offset);
     }
-    return pNewBmp;
 }
 
 
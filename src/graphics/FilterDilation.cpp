@@ -20,9 +20,12 @@
 //
 
 #include "FilterDilation.h"
+#include "ParallelRows.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <algorithm>
 
 using namespace std;
@@ -44,28 +47,30 @@ BitmapPtr FilterDilation::apply(BitmapPtr pSrcBmp)
     AVG_ASSERT(pSrcBmp->getPixelFormat() == I8);
     IntPoint size = pSrcBmp->getSize();
     BitmapPtr pDestBmp = BitmapPtr(new Bitmap(size, I8, pSrcBmp->getName()));
-    unsigned char * pSrcLine = pSrcBmp->getPixels();
-    unsigned char * pNextSrcLine;
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < size.y; y++) {
-        pDestLine = pDestBmp->getPixels()+y*pDestBmp->getStride();
-        unsigned char * pLastSrcLine = pSrcLine;
-        pSrcLine = pSrcBmp->getPixels()+y*pSrcBmp->getStride();
-        if (y < size.y-1) {
-            pNextSrcLine = pSrcBmp->getPixels()+(y+1)*pSrcBmp->getStride();
-        } else {
-            pNextSrcLine = pSrcBmp->getPixels()+y*pSrcBmp->getStride();
-        }
-        pDestLine[0] = max(pSrcLine[0], max(pSrcLine[1], 
-                max(pLastSrcLine[0], pNextSrcLine[0])));
-        for (int x = 1; x < size.x-1; x++) { 
-            pDestLine[x] = max(pSrcLine[x], max(pSrcLine[x-1], max(pSrcLine[x+1], 
-                    max(pLastSrcLine[x], pNextSrcLine[x]))));
-        }
-        pDestLine[size.x-1] = max(pSrcLine[size.x-2], max(pSrcLine[size.x-1], 
-                max(pLastSrcLine[size.x-1], pNextSrcLine[size.x-1])));
-    }
+    processRowBands(size.y, size.x, getRowRadius(),
+            boost::bind(&RowFilter::filterRows, this, pSrcBmp, pDestBmp, _1, _2));
     return pDestBmp;
 }
 
+int FilterDilation::getRowRadius() const
+{
+    return 1;
+}
+
+void FilterDilation::filterRow(const unsigned char * const * ppSrcLines,
+        unsigned char * pDestLine, int y, const IntPoint& size)
+{
+    const unsigned char * pLastSrcLine = ppSrcLines[0];
+    const unsigned char * pSrcLine = ppSrcLines[1];
+    const unsigned char * pNextSrcLine = ppSrcLines[2];
+    pDestLine[0] = max(pSrcLine[0], max(pSrcLine[1], 
+            max(pLastSrcLine[0], pNextSrcLine[0])));
+    for (int x = 1; x < size.x-1; x++) { 
+        pDestLine[x] = max(pSrcLine[x], max(pSrcLine[x-1], max(pSrcLine[x+1], 
+                max(pLastSrcLine[x], pNextSrcLine[x]))));
+    }
+    pDestLine[size.x-1] = max(pSrcLine[size.x-2], max(pSrcLine[size.x-1], 
+            max(pLastSrcLine[size.x-1], pNextSrcLine[size.x-1])));
+}
+
 } // namespace
@@ -24,19 +24,22 @@
 
 #include "../api.h"
 #include "Filter.h"
+#include "RowFilter.h"
 
 namespace avg {
 
 // Grayscale 4-neighborhood dilation. Replaces each pixel with the maximum of
 // its neighbors.
-class AVG_API FilterDilation : public Filter
+class AVG_API FilterDilation : public Filter, public RowFilter
 {
 public:
   FilterDilation();
   virtual ~FilterDilation();
   virtual BitmapPtr apply(BitmapPtr pBmp);
 
-private:
+  virtual int getRowRadius() const;
+  virtual void filterRow(const unsigned char * const * ppSrcLines,
+          unsigned char * pDestLine, int y, const IntPoint& size);
 };
 
 }
@@ -24,19 +24,22 @@
 
 #include "../api.h"
 #include "Filter.h"
+#include "RowFilter.h"
 
 namespace avg {
 
 // Grayscale 4-neighborhood erosion. Replaces each pixel with the minimum of
 // its neighbors.
-class AVG_API FilterErosion : public Filter
+class AVG_API FilterErosion : public Filter, public RowFilter
 {
 public:
   FilterErosion();
   virtual ~FilterErosion();
   virtual BitmapPtr apply(BitmapPtr pBmp);
 
-private:
+  virtual int getRowRadius() const;
+  virtual void filterRow(const unsigned char * const * ppSrcLines,
+          unsigned char * pDestLine, int y, const IntPoint& size);
 };
 
 }
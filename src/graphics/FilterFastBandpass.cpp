@@ -24,10 +24,13 @@
 #include "Filterfill.h"
 #include "Pixel8.h"
 #include "Bitmap.h"
+#include "ParallelRows.h"
 
 #include "../base/Exception.h"
 
 #include <cstring>
+#include <boost/bind.hpp>
+
 #include <iostream>
 #include <sstream>
 
@@ -48,45 +51,52 @@ BitmapPtr FilterFastBandpass::apply(BitmapPtr pBmpSrc)
     AVG_ASSERT(pBmpSrc->getPixelFormat() == I8);
     BitmapPtr pBmpDest = BitmapPtr(new Bitmap(pBmpSrc->getSize(), I8,
             pBmpSrc->getName()));
-    int srcStride = pBmpSrc->getStride();
-    int destStride = pBmpDest->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels()+3*srcStride;
-    unsigned char * pDestLine = pBmpDest->getPixels()+3*destStride;
     IntPoint size = pBmpDest->getSize();
-    for (int y = 3; y < size.y-3; ++y) {
-        unsigned char * pSrcPixel = pSrcLine+3;
-        unsigned char * pDstPixel = pDestLine;
-        *pDstPixel++ = 128;
-        *pDstPixel++ = 128;
-        *pDstPixel++ = 128;
-        for (int x = 3; x < size.x-3; ++x) {
-            // Convolution Matrix is
-            //  0  0  0  0  0  0  0 
-            //  0 -2  0  0  0 -2  0
-            //  0  0  1  0  1  0  0
-            //  0  0  0  4  0  0  0
-            //  0  0  1  0  1  0  0
-            //  0 -2  0  0  0 -2  0
-            //  0  0  0  0  0  0  0 
-            *pDstPixel = 128
-                - int(*(pSrcPixel-2*srcStride-2)*2 + *(pSrcPixel-2*srcStride+2)*2 - 
-                      *(pSrcPixel-srcStride-1) - *(pSrcPixel-1*srcStride+1) -
-                      *(pSrcPixel+srcStride-1) - *(pSrcPixel+1*srcStride+1) + 
-                      *(pSrcPixel+2*srcStride-2)*2 + *(pSrcPixel+2*srcStride+2)*2+2)/4
-                + *pSrcPixel;
-            ++pSrcPixel;
-            ++pDstPixel;
-        }
-        *pDstPixel++ = 128;
-        *pDstPixel++ = 128;
-        *pDstPixel++ = 128;
-        pSrcLine += srcStride;
-        pDestLine += destStride;
-    }
-    // Set top and bottom borders.
-    memset(pBmpDest->getPixels(), 128, destStride*3);
-    memset(pBmpDest->getPixels()+destStride*(size.y-3), 128, destStride*3);
+    processRowBands(size.y, size.x, getRowRadius(),
+            boost::bind(&RowFilter::filterRows, this, pBmpSrc, pBmpDest, _1, _2));
     return pBmpDest;
 }
 
+int FilterFastBandpass::getRowRadius() const
+{
+    return 2;
+}
+
+void FilterFastBandpass::filterRow(const unsigned char * const * ppSrcLines,
+        unsigned char * pDestLine, int y, const IntPoint& size)
+{
+    // Top and bottom borders.
+    if (y < 3 || y >= size.y-3) {
+        memset(pDestLine, 128, size.x);
+        return;
+    }
+    const unsigned char * pLine0 = ppSrcLines[0];
+    const unsigned char * pLine1 = ppSrcLines[1];
+    const unsigned char * pSrcLine = ppSrcLines[2];
+    const unsigned char * pLine3 = ppSrcLines[3];
+    const unsigned char * pLine4 = ppSrcLines[4];
+    unsigned char * pDstPixel = pDestLine;
+    *pDstPixel++ = 128;
+    *pDstPixel++ = 128;
+    *pDstPixel++ = 128;
+    for (int x = 3; x < size.x-3; ++x) {
+        // Convolution Matrix is
+        //  0  0  0  0  0  0  0 
+        //  0 -2  0  0  0 -2  0
+        //  0  0  1  0  1  0  0
+        //  0  0  0  4  0  0  0
+        //  0  0  1  0  1  0  0
+        //  0 -2  0  0  0 -2  0
+        //  0  0  0  0  0  0  0 
+        *pDstPixel = 128
+            - int(pLine0[x-2]*2 + pLine0[x+2]*2 - pLine1[x-1] - pLine1[x+1] -
+                  pLine3[x-1] - pLine3[x+1] + pLine4[x-2]*2 + pLine4[x+2]*2+2)/4
+            + pSrcLine[x];
+        ++pDstPixel;
+    }
+    *pDstPixel++ = 128;
+    *pDstPixel++ = 128;
+    *pDstPixel++ = 128;
+}
+
 }
@@ -24,6 +24,7 @@
 
 #include "../api.h"
 #include "Filter.h"
+#include "RowFilter.h"
 #include "Bitmap.h"
 
 #include <boost/shared_ptr.hpp>
@@ -31,14 +32,16 @@
 namespace avg {
 
 // This is a fast and sloppy bandpass filter that uses a 7x7 kernel. 
-class AVG_API FilterFastBandpass: public Filter{
+class AVG_API FilterFastBandpass: public Filter, public RowFilter {
     public:
         FilterFastBandpass();
         virtual ~FilterFastBandpass();
 
         virtual BitmapPtr apply(BitmapPtr pBmpSrc);
 
-    private:
+        virtual int getRowRadius() const;
+        virtual void filterRow(const unsigned char * const * ppSrcLines,
+                unsigned char * pDestLine, int y, const IntPoint& size);
 };
 
 typedef boost::shared_ptr<FilterFastBandpass> FilterFastBandpassPtr;
@@ -23,10 +23,13 @@
 #include "Filterfill.h"
 #include "Pixel8.h"
 #include "Bitmap.h"
+#include "ParallelRows.h"
 
 #include "../base/MathHelper.h"
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <iostream>
 #include <math.h>
 
@@ -48,13 +51,26 @@ BitmapPtr FilterGauss::apply(BitmapPtr pBmpSrc)
 {
     AVG_ASSERT(pBmpSrc->getPixelFormat() == I8);
     int intRadius = int(ceil(m_Radius));
+    IntPoint destSize(pBmpSrc->getSize().x-2*intRadius,
+            pBmpSrc->getSize().y-2*intRadius);
+    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(destSize, I8, pBmpSrc->getName()));
+    processRowBands(destSize.y, destSize.x, intRadius,
+            boost::bind(&FilterGauss::applyToRows, this, pBmpSrc, pDestBmp, _1, _2));
+    return pDestBmp;
+}
+
+void FilterGauss::applyToRows(BitmapPtr pBmpSrc, BitmapPtr pDestBmp, int startRow,
+        int endRow) const
+{
+    int intRadius = int(ceil(m_Radius));
     
-    // Convolve in x-direction
-    IntPoint tempSize(pBmpSrc->getSize().x-2*intRadius, pBmpSrc->getSize().y);
+    // Convolve in x-direction. Every band convolves the source rows it needs, including
+    // intRadius rows above and below the band.
+    IntPoint tempSize(pBmpSrc->getSize().x-2*intRadius, endRow-startRow+2*intRadius);
     BitmapPtr pTempBmp = BitmapPtr(new Bitmap(tempSize, I8, pBmpSrc->getName()));
     int srcStride = pBmpSrc->getStride();
     int tempStride = pTempBmp->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels();
+    unsigned char * pSrcLine = pBmpSrc->getPixels()+startRow*srcStride;
     unsigned char * pTempLine = pTempBmp->getPixels();
     for (int y = 0; y < tempSize.y; ++y) {
         unsigned char * pSrcPixel = pSrcLine+intRadius;
@@ -111,12 +127,11 @@ BitmapPtr FilterGauss::apply(BitmapPtr pBmpSrc)
     }
 
     // Convolve in y-direction
-    IntPoint destSize(tempSize.x, tempSize.y-2*intRadius);
-    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(destSize, I8, pBmpSrc->getName()));
+    IntPoint destSize = pDestBmp->getSize();
     int destStride = pDestBmp->getStride();
     pTempLine = pTempBmp->getPixels()+intRadius*tempStride;
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < destSize.y; ++y) {
+    unsigned char * pDestLine = pDestBmp->getPixels()+startRow*destStride;
+    for (int y = startRow; y < endRow; ++y) {
         unsigned char * pTempPixel = pTempLine;
         unsigned char * pDestPixel = pDestLine;
         switch (intRadius) {
@@ -169,7 +184,6 @@ BitmapPtr FilterGauss::apply(BitmapPtr pBmpSrc)
         pTempLine += tempStride;
         pDestLine += destStride;
     }
-    return pDestBmp;
 }
 
 void FilterGauss::dumpKernel()
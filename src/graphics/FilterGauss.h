@@ -40,6 +40,8 @@ class AVG_API FilterGauss: public Filter{
         void dumpKernel();
 
     private:
+        void applyToRows(BitmapPtr pBmpSrc, BitmapPtr pDestBmp, int startRow,
+                int endRow) const;
         void calcKernel();
 
         float m_Radius;
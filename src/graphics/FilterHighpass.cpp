@@ -23,10 +23,13 @@
 #include "Filterfill.h"
 #include "Pixel8.h"
 #include "Bitmap.h"
+#include "ParallelRows.h"
 
 #include "../base/Exception.h"
 
 #include <cstring>
+#include <boost/bind.hpp>
+
 #include <iostream>
 #include <sstream>
 
@@ -47,48 +50,54 @@ BitmapPtr FilterHighpass::apply(BitmapPtr pBmpSrc)
     AVG_ASSERT(pBmpSrc->getPixelFormat() == I8);
     BitmapPtr pBmpDest = BitmapPtr(new Bitmap(pBmpSrc->getSize(), I8,
             pBmpSrc->getName()));
-    int srcStride = pBmpSrc->getStride();
-    int destStride = pBmpDest->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels()+3*srcStride;
-    unsigned char * pDestLine = pBmpDest->getPixels()+3*destStride;
     IntPoint size = pBmpDest->getSize();
-    for (int y = 3; y < size.y-3; ++y) {
-        unsigned char * pSrcPixel = pSrcLine+3;
-        unsigned char * pDstPixel = pDestLine;
-        *pDstPixel++ = 128;
-        *pDstPixel++ = 128;
-        *pDstPixel++ = 128;
-        for (int x = 3; x < size.x-3; ++x) {
-            // Convolution Matrix is
-            // -1  0  0   0  -1
-            //  0 -1  0  -1   0
-            //  0  0  8   0   0
-            //  0 -1  0  -1   0
-            // -1  0  0   0  -1
-            // Actually, it's 7x7, but you get the idea.
-            *pDstPixel = 128 - int(*(pSrcPixel-3*srcStride-3) 
-                    + *(pSrcPixel-3*srcStride+3) + *(pSrcPixel+3*srcStride-3) 
-                    + *(pSrcPixel+3*srcStride+3))/16; 
-            *pDstPixel += 
-                - int(*(pSrcPixel-2*srcStride-2) + *(pSrcPixel-2*srcStride+2) + 
-                      *(pSrcPixel-srcStride-1) + *(pSrcPixel-1*srcStride+1) +
-                      *(pSrcPixel+srcStride-1) + *(pSrcPixel+1*srcStride+1) + 
-                      *(pSrcPixel+2*srcStride-2) + *(pSrcPixel+2*srcStride+2))/16
-                + *(pSrcPixel)*3/4;
+    processRowBands(size.y, size.x, getRowRadius(),
+            boost::bind(&RowFilter::filterRows, this, pBmpSrc, pBmpDest, _1, _2));
+    return pBmpDest;
+}
 
-            ++pSrcPixel;
-            ++pDstPixel;
-        }
-        *pDstPixel++ = 128;
-        *pDstPixel++ = 128;
-        *pDstPixel++ = 128;
-        pSrcLine += srcStride;
-        pDestLine += destStride;
+int FilterHighpass::getRowRadius() const
+{
+    return 3;
+}
+
+void FilterHighpass::filterRow(const unsigned char * const * ppSrcLines,
+        unsigned char * pDestLine, int y, const IntPoint& size)
+{
+    // Top and bottom borders.
+    if (y < 3 || y >= size.y-3) {
+        memset(pDestLine, 128, size.x);
+        return;
     }
-    // Set top and bottom borders.
-    memset(pBmpDest->getPixels(), 128, destStride*3);
-    memset(pBmpDest->getPixels()+destStride*(size.y-3), 128, destStride*3);
-    return pBmpDest;
+    const unsigned char * pLine0 = ppSrcLines[0];
+    const unsigned char * pLine1 = ppSrcLines[1];
+    const unsigned char * pLine2 = ppSrcLines[2];
+    const unsigned char * pSrcLine = ppSrcLines[3];
+    const unsigned char * pLine4 = ppSrcLines[4];
+    const unsigned char * pLine5 = ppSrcLines[5];
+    const unsigned char * pLine6 = ppSrcLines[6];
+    unsigned char * pDstPixel = pDestLine;
+    *pDstPixel++ = 128;
+    *pDstPixel++ = 128;
+    *pDstPixel++ = 128;
+    for (int x = 3; x < size.x-3; ++x) {
+        // Convolution Matrix is
+        // -1  0  0   0  -1
+        //  0 -1  0  -1   0
+        //  0  0  8   0   0
+        //  0 -1  0  -1   0
+        // -1  0  0   0  -1
+        // Actually, it's 7x7, but you get the idea.
+        *pDstPixel = 128 - int(pLine0[x-3] + pLine0[x+3] + pLine6[x-3] + pLine6[x+3])/16;
+        *pDstPixel += 
+            - int(pLine1[x-2] + pLine1[x+2] + pLine2[x-1] + pLine2[x+1] +
+                  pLine4[x-1] + pLine4[x+1] + pLine5[x-2] + pLine5[x+2])/16
+            + pSrcLine[x]*3/4;
+        ++pDstPixel;
+    }
+    *pDstPixel++ = 128;
+    *pDstPixel++ = 128;
+    *pDstPixel++ = 128;
 }
 
 }
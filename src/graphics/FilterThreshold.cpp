@@ -43,17 +43,24 @@ FilterThreshold::~FilterThreshold()
 
 void FilterThreshold::applyInPlace(BitmapPtr pBmp) 
 {
-    IntPoint size = pBmp->getSize();
     AVG_ASSERT(pBmp->getPixelFormat() == I8);
-    for (int y = 0; y < size.y; y++) {
-        unsigned char * pLine = pBmp->getPixels()+y*pBmp->getStride();
-        for (int x = 0; x < size.x; x++) { 
-            unsigned char * pPixel = pLine + x;
-            if (*pPixel >= m_Threshold) {
-                *pPixel = 255;
-            } else {
-                *pPixel = 0;
-            }
+    filterRows(pBmp, pBmp, 0, pBmp->getSize().y);
+}
+
+int FilterThreshold::getRowRadius() const
+{
+    return 0;
+}
+
+void FilterThreshold::filterRow(const unsigned char * const * ppSrcLines,
+        unsigned char * pDestLine, int y, const IntPoint& size)
+{
+    const unsigned char * pSrcLine = ppSrcLines[0];
+    for (int x = 0; x < size.x; x++) { 
+        if (pSrcLine[x] >= m_Threshold) {
+            pDestLine[x] = 255;
+        } else {
+            pDestLine[x] = 0;
         }
     }
 }
@@ -24,16 +24,21 @@
 
 #include "../api.h"
 #include "Filter.h"
+#include "RowFilter.h"
 
 namespace avg {
 
-class AVG_API FilterThreshold : public Filter
+class AVG_API FilterThreshold : public Filter, public RowFilter
 {
 public:
     FilterThreshold(int threshold);
     virtual ~FilterThreshold();
     virtual void applyInPlace(BitmapPtr pBmp) ;
 
+    virtual int getRowRadius() const;
+    virtual void filterRow(const unsigned char * const * ppSrcLines,
+            unsigned char * pDestLine, int y, const IntPoint& size);
+
 private:
     int m_Threshold;
 };
@@ -42,6 +42,7 @@ using namespace boost;
 thread_specific_ptr<GLContext*> GLContext::s_pCurrentContext;
 bool GLContext::s_bErrorCheckEnabled = false;
 bool GLContext::s_bErrorLogEnabled = true;
+bool GLContext::s_bDrawBatchingEnabled = true;
 
 
 GLContext::GLContext(const IntPoint& windowSize)
@@ -50,6 +51,11 @@ GLContext::GLContext(const IntPoint& windowSize)
       m_bCheckedMemoryMode(false),
       m_BlendColor(0.f, 0.f, 0.f, 0.f),
       m_BlendMode(BLEND_ADD),
+      m_bBatchingDraws(false),
+      m_PendingStartIndex(0),
+      m_NumPendingIndexes(0),
+      m_NumDrawCalls(0),
+      m_NumStateChanges(0),
       m_MajorGLVersion(-1)
 {
     if (s_pCurrentContext.get() == 0) {
@@ -129,6 +135,7 @@ void GLContext::init(const GLConfig& glConfig, bool bOwnsContext)
 
 void GLContext::deleteObjects()
 {
+    GLContextManager::get()->deleteContextObjects(this);
     m_pStandardShader = StandardShaderPtr();
     for (unsigned i=0; i<m_FBOIDs.size(); ++i) {
         glproc::DeleteFramebuffers(1, &(m_FBOIDs[i]));
@@ -203,6 +210,7 @@ void GLContext::returnFBOToCache(unsigned fboID)
 void GLContext::setBlendColor(const glm::vec4& color)
 {
     if (m_BlendColor != color) {
+        stateChanged();
         glproc::BlendColor(color[0], color[1], color[2], color[3]);
         m_BlendColor = color;
     }
@@ -218,6 +226,7 @@ void GLContext::setBlendMode(BlendMode mode, bool bPremultipliedAlpha)
         srcFunc = GL_SRC_ALPHA;
     }
     if (mode != m_BlendMode || m_bPremultipliedAlpha != bPremultipliedAlpha) {
+        stateChanged();
         switch (mode) {
             case BLEND_BLEND:
                 glproc::BlendEquation(GL_FUNC_ADD);
@@ -268,6 +277,7 @@ bool GLContext::isBlendModeSupported(BlendMode mode) const
 void GLContext::bindTexture(unsigned unit, unsigned texID)
 {
     if (m_BoundTextures[unit-GL_TEXTURE0] != texID) {
+        stateChanged();
         glproc::ActiveTexture(unit);
         checkError("GLContext::bindTexture ActiveTexture()");
         glBindTexture(GL_TEXTURE_2D, texID);
@@ -276,6 +286,80 @@ void GLContext::bindTexture(unsigned unit, unsigned texID)
     }
 }
 
+void GLContext::stateChanged()
+{
+    flushDraws();
+    m_NumStateChanges++;
+}
+
+void GLContext::enableDrawBatching(bool bEnable)
+{
+    s_bDrawBatchingEnabled = bEnable;
+}
+
+void GLContext::startDrawBatching()
+{
+    AVG_ASSERT(m_NumPendingIndexes == 0);
+    m_bBatchingDraws = s_bDrawBatchingEnabled;
+}
+
+void GLContext::endDrawBatching()
+{
+    flushDraws();
+    m_bBatchingDraws = false;
+}
+
+void GLContext::drawElements(unsigned startIndex, unsigned numIndexes)
+{
+    if (m_bBatchingDraws) {
+        if (m_NumPendingIndexes > 0 && 
+                startIndex != m_PendingStartIndex+m_NumPendingIndexes)
+        {
+            flushDraws();
+        }
+        if (m_NumPendingIndexes == 0) {
+            m_PendingStartIndex = startIndex;
+        }
+        m_NumPendingIndexes += numIndexes;
+    } else {
+        m_PendingStartIndex = startIndex;
+        m_NumPendingIndexes = numIndexes;
+        flushDraws();
+    }
+}
+
+void GLContext::flushDraws()
+{
+    if (m_NumPendingIndexes > 0) {
+#ifdef AVG_ENABLE_EGL        
+        glDrawElements(GL_TRIANGLES, m_NumPendingIndexes, GL_UNSIGNED_SHORT, 
+                (void *)(m_PendingStartIndex*sizeof(unsigned short)));
+#else
+        glDrawElements(GL_TRIANGLES, m_NumPendingIndexes, GL_UNSIGNED_INT, 
+                (void *)(m_PendingStartIndex*sizeof(unsigned int)));
+#endif
+        checkError("GLContext::flushDraws()");
+        m_NumPendingIndexes = 0;
+        m_NumDrawCalls++;
+    }
+}
+
+void GLContext::resetDrawStats()
+{
+    m_NumDrawCalls = 0;
+    m_NumStateChanges = 0;
+}
+
+int GLContext::getNumDrawCalls() const
+{
+    return m_NumDrawCalls;
+}
+
+int GLContext::getNumStateChanges() const
+{
+    return m_NumStateChanges;
+}
+
 const GLConfig& GLContext::getConfig()
 {
     return m_GLConfig;
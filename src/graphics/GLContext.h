@@ -65,6 +65,22 @@ public:
     void setBlendMode(BlendMode mode, bool bPremultipliedAlpha = false);
     bool isBlendModeSupported(BlendMode mode) const;
     void bindTexture(unsigned unit, unsigned texID);
+    // Must be called before any other change to GL state while draw batching is on.
+    void stateChanged();
+
+    // Draw call batching. Between startDrawBatching() and endDrawBatching(), a draw
+    // of the index range directly following the previous one is merged with it if
+    // no state has changed in between. The merged range is drawn when the state
+    // changes or batching ends.
+    static void enableDrawBatching(bool bEnable);
+    void startDrawBatching();
+    void endDrawBatching();
+    void drawElements(unsigned startIndex, unsigned numIndexes);
+    void flushDraws();
+
+    void resetDrawStats();
+    int getNumDrawCalls() const;
+    int getNumStateChanges() const;
 
     const GLConfig& getConfig();
     void logConfig();
@@ -130,11 +146,18 @@ private:
     bool m_bPremultipliedAlpha;
     unsigned m_BoundTextures[16];
 
+    bool m_bBatchingDraws;
+    unsigned m_PendingStartIndex;
+    unsigned m_NumPendingIndexes;
+    int m_NumDrawCalls;
+    int m_NumStateChanges;
+
     int m_MajorGLVersion;
     int m_MinorGLVersion;
 
     static bool s_bErrorCheckEnabled;
     static bool s_bErrorLogEnabled;
+    static bool s_bDrawBatchingEnabled;
 
     static boost::thread_specific_ptr<GLContext*> s_pCurrentContext;
 };
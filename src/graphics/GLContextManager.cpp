@@ -25,12 +25,15 @@
 #include "../base/Logger.h"
 #include "../base/Backtrace.h"
 #include "../base/ScopeTimer.h"
+#include "../base/ConfigMgr.h"
 
 #include "GLTexture.h"
 #include "MCTexture.h"
 #include "VertexArray.h"
 #include "MCFBO.h"
 #include "ShaderRegistry.h"
+#include "TextureAtlas.h"
+#include "TextureUploader.h"
 
 #ifdef __APPLE__
     #include "CGLContext.h"
@@ -50,6 +53,10 @@ namespace avg {
 using namespace std;
 
 GLContextManager* GLContextManager::s_pGLContextManager = 0;
+bool GLContextManager::s_bAsyncTexUploads = true;
+
+// Smaller bitmaps are uploaded synchronously so they show up in the current frame.
+static const int MIN_ASYNC_UPLOAD_BYTES = 1024*1024;
 
 GLContextManager* GLContextManager::get()
 {
@@ -63,16 +70,24 @@ bool GLContextManager::isActive()
 }
 
 GLContextManager::GLContextManager()
+    : m_pTextureAtlas(0),
+      m_pTexUploader(0)
 {
 //    AVG_ASSERT(!s_pGLContextManager);
     s_pGLContextManager = this;
+    m_TexUploadBudget =
+            ConfigMgr::get()->getIntOption("scr", "texuploadbudget", 8)*1024*1024;
 }
 
 GLContextManager::~GLContextManager()
 {
     m_pPendingTexCreates.clear();
     m_pPendingTexUploads.clear();
+    m_PendingTexSubUploads.clear();
     m_PendingTexDeletes.clear();
+    delete m_pTextureAtlas;
+    m_pPendingAsyncTexUploads.clear();
+    delete m_pTexUploader;
 
     m_pPendingFBOCreates.clear();
 
@@ -160,6 +175,16 @@ void GLContextManager::scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp)
     m_pPendingTexUploads[pTex] = pBmp;
 }
 
+void GLContextManager::scheduleTexSubUpload(MCTexturePtr pTex, BitmapPtr pBmp, 
+        const IntPoint& pos)
+{
+    TexSubUpload upload;
+    upload.m_pTex = pTex;
+    upload.m_pBmp = pBmp;
+    upload.m_Pos = pos;
+    m_PendingTexSubUploads.push_back(upload);
+}
+
 MCTexturePtr GLContextManager::createTextureFromBmp(BitmapPtr pBmp, bool bMipmap,
         unsigned wrapSMode, unsigned wrapTMode, bool bForcePOT, int potBorderColor)
 {
@@ -174,6 +199,65 @@ void GLContextManager::deleteTexture(unsigned texID)
     m_PendingTexDeletes.push_back(texID);
 }
 
+TextureAtlas* GLContextManager::getTextureAtlas()
+{
+    if (!m_pTextureAtlas) {
+        m_pTextureAtlas = new TextureAtlas();
+    }
+    return m_pTextureAtlas;
+}
+
+void GLContextManager::scheduleAsyncTexUpload(MCTexturePtr pTex, BitmapPtr pBmp)
+{
+    if (!s_bAsyncTexUploads || !areAsyncTexUploadsSupported() ||
+            pBmp->getMemNeeded() < MIN_ASYNC_UPLOAD_BYTES)
+    {
+        scheduleTexUpload(pTex, pBmp);
+    } else {
+        // Handed to the uploader once the texture exists.
+        pTex->setUploadPending(true);
+        m_pPendingAsyncTexUploads[pTex] = pBmp;
+    }
+}
+
+void GLContextManager::processAsyncTexUploads()
+{
+    if (m_pTexUploader) {
+        GLContext* pContext = m_pTexUploader->getContext();
+        if (GLContext::getCurrent() != pContext) {
+            pContext->activate();
+        }
+        m_pTexUploader->processUploads();
+    }
+}
+
+int GLContextManager::getNumPendingAsyncTexUploads() const
+{
+    int numUploads = int(m_pPendingAsyncTexUploads.size());
+    if (m_pTexUploader) {
+        numUploads += m_pTexUploader->getNumPendingUploads();
+    }
+    return numUploads;
+}
+
+bool GLContextManager::areAsyncTexUploadsSupported() const
+{
+    return m_pContexts.size() == 1 && m_pContexts[0]->getMemoryMode() == MM_PBO;
+}
+
+void GLContextManager::setTexUploadBudget(unsigned numBytes)
+{
+    m_TexUploadBudget = numBytes;
+    if (m_pTexUploader) {
+        m_pTexUploader->setFrameBudget(numBytes);
+    }
+}
+
+void GLContextManager::enableAsyncTexUploads(bool bEnable)
+{
+    s_bAsyncTexUploads = bEnable;
+}
+
 VertexArrayPtr GLContextManager::createVertexArray(int reserveVerts,
         int reserveIndexes)
 {
@@ -229,6 +313,23 @@ void GLContextManager::uploadDataForContext()
         pTex->moveBmpToTexture(pBmp);
     }
 
+    // In order, so later uploads to the same area win.
+    for (unsigned i=0; i<m_PendingTexSubUploads.size(); ++i) {
+        const TexSubUpload& upload = m_PendingTexSubUploads[i];
+        upload.m_pTex->moveBmpToSubTexture(upload.m_pBmp, upload.m_Pos);
+    }
+
+    if (!m_pPendingAsyncTexUploads.empty()) {
+        if (!m_pTexUploader) {
+            m_pTexUploader = new TextureUploader(m_TexUploadBudget);
+        }
+        for (it=m_pPendingAsyncTexUploads.begin(); it!=m_pPendingAsyncTexUploads.end();
+                ++it)
+        {
+            m_pTexUploader->scheduleUpload(it->first, it->second);
+        }
+    }
+
     for (unsigned i=0; i<m_pPendingFBOCreates.size(); ++i) {
         m_pPendingFBOCreates[i]->initForGLContext();
     }
@@ -243,7 +344,9 @@ void GLContextManager::reset()
 {
     m_pPendingTexCreates.clear();
     m_pPendingTexUploads.clear();
+    m_PendingTexSubUploads.clear();
     m_PendingTexDeletes.clear();
+    m_pPendingAsyncTexUploads.clear();
 
     m_pPendingFBOCreates.clear();
     m_pPendingShaderParamCreates.clear();
@@ -252,6 +355,27 @@ void GLContextManager::reset()
     m_PendingBufferDeletes.clear();
 }
 
+void GLContextManager::deleteContextObjects(GLContext* pContext)
+{
+    // Called while the context is still valid, so the uploader can release its
+    // buffers.
+    if (m_pTexUploader && m_pTexUploader->getContext() == pContext) {
+        delete m_pTexUploader;
+        m_pTexUploader = 0;
+    }
+    if (m_pContexts.size() == 1) {
+        // The atlas pages are textures in the last context. Delete them now instead
+        // of leaving their ids to a later context.
+        delete m_pTextureAtlas;
+        m_pTextureAtlas = 0;
+        for (unsigned i=0; i<m_PendingTexDeletes.size(); ++i) {
+            glDeleteTextures(1, &m_PendingTexDeletes[i]);
+            GLContext::checkError("GLContextManager: delete atlas textures");
+        }
+        m_PendingTexDeletes.clear();
+    }
+}
+
 bool GLContextManager::isGLESSupported()
 {
 #if defined linux
@@ -41,6 +41,8 @@ class VertexArray;
 typedef boost::shared_ptr<VertexArray> VertexArrayPtr;
 class MCFBO;
 typedef boost::shared_ptr<MCFBO> MCFBOPtr;
+class TextureAtlas;
+class TextureUploader;
 
 class AVG_API GLContextManager
 {
@@ -75,10 +77,23 @@ public:
     }
 
     void scheduleTexUpload(MCTexturePtr pTex, BitmapPtr pBmp);
+    void scheduleTexSubUpload(MCTexturePtr pTex, BitmapPtr pBmp, const IntPoint& pos);
     MCTexturePtr createTextureFromBmp(BitmapPtr pBmp, bool bMipmap=false, 
             unsigned wrapSMode=GL_CLAMP_TO_EDGE, unsigned wrapTMode=GL_CLAMP_TO_EDGE,
             bool bForcePOT=false, int potBorderColor=0);
     void deleteTexture(unsigned texID);
+    TextureAtlas* getTextureAtlas();
+
+    // Large bitmaps are copied into pixel buffers in a background thread and
+    // uploaded over several frames. The texture is marked as upload pending until
+    // the data has arrived. Small bitmaps, configurations with several contexts and
+    // systems without pixel buffer objects use scheduleTexUpload() instead.
+    void scheduleAsyncTexUpload(MCTexturePtr pTex, BitmapPtr pBmp);
+    void processAsyncTexUploads();
+    int getNumPendingAsyncTexUploads() const;
+    bool areAsyncTexUploadsSupported() const;
+    void setTexUploadBudget(unsigned numBytes);
+    static void enableAsyncTexUploads(bool bEnable);
 
     VertexArrayPtr createVertexArray(int reserveVerts = 0, int reserveIndexes = 0);
     typedef std::map<const GLContext*, unsigned> BufferIDMap;
@@ -87,6 +102,7 @@ public:
     void uploadData();
     void uploadDataForContext();
     void reset();
+    void deleteContextObjects(GLContext* pContext);
 
     static bool isGLESSupported();
 
@@ -96,7 +112,17 @@ private:
     std::vector<MCTexturePtr> m_pPendingTexCreates;
     typedef std::map<MCTexturePtr, BitmapPtr> TexUploadMap;
     TexUploadMap m_pPendingTexUploads;
+    struct TexSubUpload {
+        MCTexturePtr m_pTex;
+        BitmapPtr m_pBmp;
+        IntPoint m_Pos;
+    };
+    std::vector<TexSubUpload> m_PendingTexSubUploads;
     std::vector<unsigned> m_PendingTexDeletes;
+    TextureAtlas* m_pTextureAtlas;
+    TexUploadMap m_pPendingAsyncTexUploads;
+    TextureUploader* m_pTexUploader;
+    unsigned m_TexUploadBudget;
 
     std::vector<MCFBOPtr> m_pPendingFBOCreates;
     std::vector<MCShaderParamPtr> m_pPendingShaderParamCreates;
@@ -105,6 +131,7 @@ private:
     std::vector<BufferIDMap> m_PendingBufferDeletes;
 
     static GLContextManager* s_pGLContextManager;
+    static bool s_bAsyncTexUploads;
 };
 
 }
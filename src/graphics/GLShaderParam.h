@@ -65,6 +65,7 @@ public:
     void set(const VAL_TYPE& val)
     {
         if (!m_bValSet || m_Val != val) {
+            GLContext::getCurrent()->stateChanged();
             uniformSet(getLocation(), val);
             GLContext::checkError("OGLShaderParam::set");
             m_Val = val;
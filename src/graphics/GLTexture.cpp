@@ -128,6 +128,29 @@ void GLTexture::moveBmpToTexture(BitmapPtr pBmp)
     pMover->moveBmpToTexture(pBmp, *this);
 }
 
+void GLTexture::moveBmpToSubTexture(BitmapPtr pBmp, const IntPoint& pos)
+{
+    IntPoint size = pBmp->getSize();
+    AVG_ASSERT(pBmp->getPixelFormat() == getPF());
+    AVG_ASSERT(pBmp->getStride() == Bitmap::getPreferredStride(size.x, getPF()));
+    AVG_ASSERT(pos.x >= 0 && pos.y >= 0);
+    AVG_ASSERT(pos.x+size.x <= getSize().x && pos.y+size.y <= getSize().y);
+    activate();
+    // Other uploads can leave GL_UNPACK_ALIGNMENT at 1 (see PBO::moveToTexture()), so
+    // it's set to match the stride here. Unpadded rows are uploaded with alignment 1,
+    // which also avoids the Apple A8 driver bug.
+    if (pBmp->getStride() == size.x*getBytesPerPixel(getPF())) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    } else {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x, pos.y, size.x, size.y,
+            getGLFormat(getPF()), getGLType(getPF()), pBmp->getPixels());
+    GLContext::checkError("GLTexture::moveBmpToSubTexture: glTexSubImage2D()");
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    generateMipmaps();
+}
+
 BitmapPtr GLTexture::moveTextureToBmp(int mipmapLevel)
 {
     TextureMoverPtr pMover = TextureMover::create(getGLSize(), getPF(), GL_DYNAMIC_READ);
@@ -49,6 +49,7 @@ public:
     void generateMipmaps();
 
     void moveBmpToTexture(BitmapPtr pBmp);
+    void moveBmpToSubTexture(BitmapPtr pBmp, const IntPoint& pos);
     BitmapPtr moveTextureToBmp(int mipmapLevel=0);
 
     unsigned getID() const;
@@ -41,6 +41,7 @@ HistoryPreProcessor::HistoryPreProcessor(IntPoint dimensions,
         unsigned int updateInterval, bool bBrighter)
     : m_FrameCounter(0),
       m_UpdateInterval(updateInterval),
+      m_HistoryUpdate(NO_UPDATE),
       m_bBrighter(bBrighter)
 {
     m_pHistoryBmp = BitmapPtr(new Bitmap(dimensions, I16));
@@ -67,17 +68,35 @@ void HistoryPreProcessor::reset()
     m_State = NO_IMAGE;
 }
 
-void HistoryPreProcessor::updateHistory(BitmapPtr pNewBmp)
+void HistoryPreProcessor::applyInPlace(BitmapPtr pBmp)
+{
+    startFrame(pBmp->getSize());
+    filterRows(pBmp, pBmp, 0, pBmp->getSize().y);
+}
+
+int HistoryPreProcessor::getRowRadius() const
+{
+    return 0;
+}
+
+bool HistoryPreProcessor::hasState() const
 {
-    AVG_ASSERT(pNewBmp->getSize() == m_pHistoryBmp->getSize());
+    return true;
+}
+
+void HistoryPreProcessor::startFrame(const IntPoint& size)
+{
+    // Decides how the history is updated in this frame. The update itself happens
+    // line by line in filterRow().
+    AVG_ASSERT(size == m_pHistoryBmp->getSize());
     switch (m_State) {
         case NO_IMAGE:
-            m_pHistoryBmp->copyPixels(*pNewBmp);
+            m_HistoryUpdate = COPY_FRAME;
             m_State = INITIALIZING;
             m_NumInitImages = 0;
             break;
         case INITIALIZING:
-            calcAvg<FAST_HISTORY_SPEED>(pNewBmp);
+            m_HistoryUpdate = FAST_AVG;
             m_NumInitImages++;
             if (m_NumInitImages == FAST_HISTORY_SPEED*2) {
                 m_State = NORMAL;
@@ -86,50 +105,64 @@ void HistoryPreProcessor::updateHistory(BitmapPtr pNewBmp)
         case NORMAL:
             if (m_FrameCounter < m_UpdateInterval-1) {
                 m_FrameCounter++;
+                m_HistoryUpdate = NO_UPDATE;
             } else {
                 m_FrameCounter = 0;
-                calcAvg<256>(pNewBmp);
+                m_HistoryUpdate = SLOW_AVG;
             }
             break;
     }
 }
 
-void HistoryPreProcessor::applyInPlace(BitmapPtr pBmp)
+void HistoryPreProcessor::filterRow(const unsigned char * const * ppSrcLines,
+        unsigned char * pDestLine, int y, const IntPoint& size)
 {
-    updateHistory(pBmp);
-    unsigned short * pSrc = (unsigned short*)m_pHistoryBmp->getPixels();
-    int srcStride = m_pHistoryBmp->getStride()/m_pHistoryBmp->getBytesPerPixel();
-    int destStride = pBmp->getStride();
-    unsigned char * pDest = pBmp->getPixels();
-    IntPoint size = pBmp->getSize();
-    for (int y = 0; y < size.y; y++) {
-        const unsigned short * pSrcPixel = pSrc;
-        unsigned char * pDestPixel = pDest;
-        if (m_bBrighter) {
+    const unsigned char * pSrcLine = ppSrcLines[0];
+    unsigned short * pHistoryLine = (unsigned short*)(m_pHistoryBmp->getPixels()+
+            y*m_pHistoryBmp->getStride());
+    switch (m_HistoryUpdate) {
+        case COPY_FRAME:
             for (int x = 0; x < size.x; x++) {
-                unsigned char Src = *pSrcPixel/256;
-                if ((*pDestPixel) > Src) {
-                    *pDestPixel = *pDestPixel-Src;
-                } else {
-                    *pDestPixel = 0;
-                }
-                pDestPixel++;
-                pSrcPixel++;
+                pHistoryLine[x] = pSrcLine[x] << 8;
             }
-        } else {
-            for (int x = 0; x < size.x; x++) {
-                unsigned char Src = *pSrcPixel/256;
-                if ((*pDestPixel) < Src) {
-                    *pDestPixel = Src-*pDestPixel;
-                } else {
-                    *pDestPixel = 0;
-                }
-                pDestPixel++;
-                pSrcPixel++;
+            break;
+        case FAST_AVG:
+            calcAvg<FAST_HISTORY_SPEED>(pSrcLine, pHistoryLine, size.x);
+            break;
+        case SLOW_AVG:
+            calcAvg<256>(pSrcLine, pHistoryLine, size.x);
+            break;
+        case NO_UPDATE:
+            break;
+    }
+
+    const unsigned short * pHistoryPixel = pHistoryLine;
+    const unsigned char * pSrcPixel = pSrcLine;
+    unsigned char * pDestPixel = pDestLine;
+    if (m_bBrighter) {
+        for (int x = 0; x < size.x; x++) {
+            unsigned char Src = *pHistoryPixel/256;
+            if ((*pSrcPixel) > Src) {
+                *pDestPixel = *pSrcPixel-Src;
+            } else {
+                *pDestPixel = 0;
+            }
+            pDestPixel++;
+            pSrcPixel++;
+            pHistoryPixel++;
+        }
+    } else {
+        for (int x = 0; x < size.x; x++) {
+            unsigned char Src = *pHistoryPixel/256;
+            if ((*pSrcPixel) < Src) {
+                *pDestPixel = Src-*pSrcPixel;
+            } else {
+                *pDestPixel = 0;
             }
+            pDestPixel++;
+            pSrcPixel++;
+            pHistoryPixel++;
         }
-        pDest += destStride;
-        pSrc += srcStride;
     }
 }
 
@@ -26,13 +26,14 @@
 
 #include "../api.h"
 #include "Filter.h"
+#include "RowFilter.h"
 #include "Bitmap.h"
 
 #include <boost/shared_ptr.hpp>
 
 namespace avg {
 
-class AVG_API HistoryPreProcessor: public Filter
+class AVG_API HistoryPreProcessor: public Filter, public RowFilter
 {
     public:
         HistoryPreProcessor(IntPoint dimensions, unsigned int updateInterval, 
@@ -43,44 +44,44 @@ class AVG_API HistoryPreProcessor: public Filter
         unsigned int getInterval(); 
         void reset();
 
+        virtual int getRowRadius() const;
+        virtual bool hasState() const;
+        virtual void startFrame(const IntPoint& size);
+        virtual void filterRow(const unsigned char * const * ppSrcLines,
+                unsigned char * pDestLine, int y, const IntPoint& size);
+
     private:
         HistoryPreProcessor(const HistoryPreProcessor&) {};
-        void updateHistory(BitmapPtr pNewBmp);
         void normalizeHistogram(BitmapPtr pBmp, unsigned char Max);
-        template<int SPEED> void calcAvg(BitmapPtr pNewBmp); 
+        template<int SPEED> void calcAvg(const unsigned char * pSrc,
+                unsigned short * pDest, int width) const;
 
         BitmapPtr m_pHistoryBmp;
         unsigned int m_FrameCounter;
         unsigned int m_UpdateInterval;
         typedef enum {NO_IMAGE, INITIALIZING, NORMAL} State;
         State m_State;
+        typedef enum {NO_UPDATE, COPY_FRAME, FAST_AVG, SLOW_AVG} HistoryUpdate;
+        HistoryUpdate m_HistoryUpdate;
         int m_NumInitImages;
         bool m_bBrighter;
 };
 
 template<int SPEED>
-void HistoryPreProcessor::calcAvg(BitmapPtr pNewBmp)
+void HistoryPreProcessor::calcAvg(const unsigned char * pSrc, unsigned short * pDest,
+        int width) const
 {
     const int SRC_NUMERATOR = SPEED-1;
     const int SRC_DENOMINATOR = SPEED;
     const int DEST_FACTOR = 256/SPEED;
-    const unsigned char * pSrc = pNewBmp->getPixels();
-    unsigned short * pDest = (unsigned short*)(m_pHistoryBmp->getPixels());
-    int destStride = m_pHistoryBmp->getStride()/m_pHistoryBmp->getBytesPerPixel();
-    IntPoint size = m_pHistoryBmp->getSize();
-    for (int y = 0; y < size.y; y++) {
-        const unsigned char * pSrcPixel = pSrc;
-        unsigned short * pDestPixel = pDest;
-        for (int x = 0; x < size.x; x++) {
-            int t = SRC_NUMERATOR*int(*pDestPixel)/SRC_DENOMINATOR;
-            *pDestPixel = (t) + int(*pSrcPixel)*DEST_FACTOR;
-            pDestPixel++;
-            pSrcPixel++;
-        }
-        pDest += destStride;
-        pSrc += pNewBmp->getStride();
+    const unsigned char * pSrcPixel = pSrc;
+    unsigned short * pDestPixel = pDest;
+    for (int x = 0; x < width; x++) {
+        int t = SRC_NUMERATOR*int(*pDestPixel)/SRC_DENOMINATOR;
+        *pDestPixel = (t) + int(*pSrcPixel)*DEST_FACTOR;
+        pDestPixel++;
+        pSrcPixel++;
     }
-
 }
 
 typedef boost::shared_ptr<HistoryPreProcessor> HistoryPreProcessorPtr;
@@ -33,7 +33,8 @@ using namespace std;
 namespace avg {
 
 ImagingProjection::ImagingProjection(IntPoint size)
-    : m_Color(0, 0, 0, 0)
+    : m_Color(0, 0, 0, 0),
+      m_TexCoordRect(0, 0, 1, 1)
 {
     GLContextManager* pCM = GLContextManager::get();
     m_pVA = pCM->createVertexArray();
@@ -43,7 +44,8 @@ ImagingProjection::ImagingProjection(IntPoint size)
 }
 
 ImagingProjection::ImagingProjection(IntPoint srcSize, IntRect destRect)
-    : m_Color(0, 0, 0, 0)
+    : m_Color(0, 0, 0, 0),
+      m_TexCoordRect(0, 0, 1, 1)
 {
     GLContextManager* pCM = GLContextManager::get();
     m_pVA = pCM->createVertexArray();
@@ -64,6 +66,14 @@ void ImagingProjection::setColor(const Pixel32& color)
     }
 }
 
+void ImagingProjection::setTexCoordRect(const FRect& rect)
+{
+    if (rect != m_TexCoordRect) {
+        m_TexCoordRect = rect;
+        init(m_SrcSize, m_DestRect);
+    }
+}
+
 void ImagingProjection::draw(const OGLShaderPtr& pShader)
 {
     IntPoint destSize = m_DestRect.size();
@@ -81,11 +91,13 @@ void ImagingProjection::init(IntPoint srcSize, IntRect destRect)
     glm::vec2 p3(dest.br.x/srcSize.x, dest.br.y/srcSize.y);
     glm::vec2 p2(p1.x, p3.y);
     glm::vec2 p4(p3.x, p1.y);
+    glm::vec2 texTL = m_TexCoordRect.tl;
+    glm::vec2 texSize = m_TexCoordRect.size();
     m_pVA->reset();
-    m_pVA->appendPos(p1, p1, m_Color);
-    m_pVA->appendPos(p2, p2, m_Color);
-    m_pVA->appendPos(p3, p3, m_Color);
-    m_pVA->appendPos(p4, p4, m_Color);
+    m_pVA->appendPos(p1, texTL+p1*texSize, m_Color);
+    m_pVA->appendPos(p2, texTL+p2*texSize, m_Color);
+    m_pVA->appendPos(p3, texTL+p3*texSize, m_Color);
+    m_pVA->appendPos(p4, texTL+p4*texSize, m_Color);
     m_pVA->appendQuadIndexes(1,0,2,3);
     
     IntPoint destSize = m_DestRect.size();
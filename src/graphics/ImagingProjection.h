@@ -45,6 +45,8 @@ public:
     virtual ~ImagingProjection();
 
     void setColor(const Pixel32& color);
+    // Part of the source texture to use, in texture coordinates.
+    void setTexCoordRect(const FRect& rect);
     void draw(const OGLShaderPtr& pShader);
 
 private:
@@ -54,6 +56,7 @@ private:
     IntRect m_DestRect;
     IntPoint m_Offset;
     Pixel32 m_Color;
+    FRect m_TexCoordRect;
     VertexArrayPtr m_pVA;
     Mat4fGLShaderParamPtr m_pTransformParam;
     glm::mat4 m_ProjMat;
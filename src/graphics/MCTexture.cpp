@@ -43,7 +43,8 @@ MCTexture::MCTexture(const IntPoint& size, PixelFormat pf, bool bMipmap,
         unsigned wrapSMode, unsigned wrapTMode, bool bForcePOT, int potBorderColor)
     : TexInfo(size, pf, bMipmap, wrapSMode, wrapTMode, usePOT(bForcePOT, bMipmap),
             potBorderColor),
-      m_bIsDirty(true)
+      m_bIsDirty(true),
+      m_bUploadPending(false)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -77,6 +78,12 @@ void MCTexture::moveBmpToTexture(BitmapPtr pBmp)
     m_bIsDirty = true;
 }
 
+void MCTexture::moveBmpToSubTexture(BitmapPtr pBmp, const IntPoint& pos)
+{
+    getCurTex()->moveBmpToSubTexture(pBmp, pos);
+    m_bIsDirty = true;
+}
+
 BitmapPtr MCTexture::moveTextureToBmp(int mipmapLevel)
 {
     return getCurTex()->moveTextureToBmp(mipmapLevel);
@@ -102,6 +109,16 @@ void MCTexture::resetDirty()
     m_bIsDirty = false;
 }
 
+void MCTexture::setUploadPending(bool bPending)
+{
+    m_bUploadPending = bPending;
+}
+
+bool MCTexture::isUploadPending() const
+{
+    return m_bUploadPending;
+}
+
 GLTexturePtr MCTexture::getCurTex() const
 {
     TexMap::const_iterator it = m_pTextures.find(GLContext::getCurrent());
@@ -50,6 +50,7 @@ public:
     void generateMipmaps();
 
     void moveBmpToTexture(BitmapPtr pBmp);
+    void moveBmpToSubTexture(BitmapPtr pBmp, const IntPoint& pos);
     BitmapPtr moveTextureToBmp(int mipmapLevel=0);
 
     GLTexturePtr getCurTex() const;
@@ -59,11 +60,16 @@ public:
     bool isDirty() const;
     void resetDirty();
 
+    // True while a TextureUploader is still filling the texture.
+    void setUploadPending(bool bPending);
+    bool isUploadPending() const;
+
 private:
     typedef std::map<GLContext*, GLTexturePtr> TexMap;
     TexMap m_pTextures;
 
     bool m_bIsDirty;
+    bool m_bUploadPending;
 };
 
 typedef boost::shared_ptr<MCTexture> MCTexturePtr;
@@ -96,6 +96,7 @@ void OGLShader::activate()
     // caching (See bug #355).
     OGLShaderPtr pCurShader = m_pShaderRegistry->getCurShader();
     if (isMountainLion() || !pCurShader || &*pCurShader != this) {
+        GLContext::getCurrent()->stateChanged();
         glproc::UseProgram(m_hProgram);
         m_pShaderRegistry->setCurShader(m_sName);
         GLContext::checkError("OGLShader::activate: glUseProgram()");
@@ -121,6 +122,7 @@ void OGLShader::setTransform(const glm::mat4& transform)
         // No fixed-function vertex shader in gles
         AVG_ASSERT(false);
 #else
+        GLContext::getCurrent()->stateChanged();
         glLoadMatrixf(glm::value_ptr(transform));
 #endif
     }
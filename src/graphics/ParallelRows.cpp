@@ -0,0 +1,74 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ParallelRows.h"
+
+#include "../base/ThreadPool.h"
+
+#include <boost/bind.hpp>
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+// Below this, the thread handoff costs more than it saves.
+static const int MIN_PIXELS_PER_BAND = 16384;
+// Bands are at least this many times as tall as their halo.
+static const int MIN_BAND_TO_HALO_RATIO = 4;
+// More bands than threads keep all threads busy if some bands take longer.
+static const int BANDS_PER_THREAD = 2;
+
+void processRowBands(int numRows, int rowLen, int haloRows, const RowBandFunc& func)
+{
+    if (numRows <= 0) {
+        return;
+    }
+    int numBands = getNumRowBands(numRows, rowLen, haloRows);
+    if (numBands <= 1) {
+        func(0, numRows);
+        return;
+    }
+
+    vector<ThreadPool::Job> jobs;
+    jobs.reserve(numBands);
+    for (int i = 0; i < numBands; ++i) {
+        int startRow = (numRows*i)/numBands;
+        int endRow = (numRows*(i+1))/numBands;
+        jobs.push_back(boost::bind(func, startRow, endRow));
+    }
+    ThreadPool::get()->runJobs(jobs);
+}
+
+int getNumRowBands(int numRows, int rowLen, int haloRows)
+{
+    int numThreads = ThreadPool::get()->getNumThreads();
+    if (numThreads == 1 || numRows <= 0) {
+        return 1;
+    }
+    int minBandRows = max(MIN_BAND_TO_HALO_RATIO*haloRows, 1);
+    minBandRows = max(minBandRows, MIN_PIXELS_PER_BAND/max(rowLen, 1));
+    return max(min(numThreads*BANDS_PER_THREAD, numRows/minBandRows), 1);
+}
+
+}
@@ -0,0 +1,50 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ParallelRows_H_
+#define _ParallelRows_H_
+
+#include "../api.h"
+
+#include <boost/function.hpp>
+
+namespace avg {
+
+// Processes rows [startRow, endRow) of a destination bitmap.
+typedef boost::function<void (int startRow, int endRow)> RowBandFunc;
+
+// Splits rows [0, numRows) into horizontal bands and runs func on them in the
+// ThreadPool. Each band may only write its own destination rows. haloRows is the number
+// of rows a band reads above and below its own range (i.e. the kernel radius); bands are
+// kept tall enough that reading or recomputing the halo is cheap compared to the band
+// itself. Small bitmaps are processed in one band in the calling thread. Filters that
+// produce every destination pixel independently give identical results regardless of
+// the number of threads.
+void AVG_API processRowBands(int numRows, int rowLen, int haloRows,
+        const RowBandFunc& func);
+
+// Number of bands processRowBands() uses for the given parameters. Band i covers rows
+// [numRows*i/numBands, numRows*(i+1)/numBands).
+int AVG_API getNumRowBands(int numRows, int rowLen, int haloRows);
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "RowFilter.h"
+
+#include "../base/Exception.h"
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+RowFilter::~RowFilter()
+{
+}
+
+bool RowFilter::hasState() const
+{
+    return false;
+}
+
+void RowFilter::startFrame(const IntPoint& size)
+{
+}
+
+void RowFilter::filterRows(BitmapPtr pSrcBmp, BitmapPtr pDestBmp, int startRow,
+        int endRow)
+{
+    AVG_ASSERT(pSrcBmp->getPixelFormat() == I8);
+    AVG_ASSERT(pDestBmp->getPixelFormat() == I8);
+    IntPoint size = pSrcBmp->getSize();
+    int radius = getRowRadius();
+    vector<const unsigned char *> pSrcLines(2*radius+1);
+    for (int y = startRow; y < endRow; ++y) {
+        for (int i = 0; i < 2*radius+1; ++i) {
+            int srcRow = min(max(y-radius+i, 0), size.y-1);
+            pSrcLines[i] = pSrcBmp->getPixels()+srcRow*pSrcBmp->getStride();
+        }
+        filterRow(&pSrcLines[0], pDestBmp->getPixels()+y*pDestBmp->getStride(), y,
+                size);
+    }
+}
+
+}
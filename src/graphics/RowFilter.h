@@ -0,0 +1,62 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _RowFilter_H_
+#define _RowFilter_H_
+
+#include "../api.h"
+#include "Bitmap.h"
+
+namespace avg {
+
+// Interface for I8 filters that keep the bitmap size and compute each output line from
+// the source lines within getRowRadius() of it. FilterChain uses this to run several
+// such filters in one pass without allocating full-size intermediate bitmaps.
+class AVG_API RowFilter
+{
+public:
+    virtual ~RowFilter();
+
+    // Number of source lines above and below the current line that filterRow() reads.
+    virtual int getRowRadius() const = 0;
+
+    // Filters that update internal state per line (e.g. a background history) must
+    // see every line exactly once per frame.
+    virtual bool hasState() const;
+
+    // Called once per frame before the first call to filterRow().
+    virtual void startFrame(const IntPoint& size);
+
+    // ppSrcLines holds 2*getRowRadius()+1 lines centered on line y. Lines outside the
+    // bitmap are clamped to the first or last line. Not const since filters with state
+    // update it here. Unless hasState() is true, this is called from several threads
+    // at once for different lines.
+    virtual void filterRow(const unsigned char * const * ppSrcLines,
+            unsigned char * pDestLine, int y, const IntPoint& size) = 0;
+
+    // Runs filterRow() for lines startRow to endRow-1 of pSrcBmp.
+    void filterRows(BitmapPtr pSrcBmp, BitmapPtr pDestBmp, int startRow,
+            int endRow);
+};
+
+}
+
+#endif
@@ -0,0 +1,616 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "SIMDConversion.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AVG_SIMD_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define AVG_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// gcc needs to be told which functions may use instructions beyond the ones enabled on
+// the command line. msvc allows all intrinsics anyway.
+#if defined(__GNUC__) && defined(AVG_SIMD_X86)
+#define AVG_TARGET(sTarget) __attribute__((target(sTarget)))
+#else
+#define AVG_TARGET(sTarget)
+#endif
+
+using namespace std;
+
+namespace avg {
+
+static SIMDLevel detectSIMDLevel()
+{
+#if defined(AVG_SIMD_X86)
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int numIDs = info[0];
+    __cpuid(info, 1);
+    bool bSSSE3 = (info[2] & (1 << 9)) != 0;
+    bool bOSXSave = (info[2] & (1 << 27)) != 0;
+    bool bAVX2 = false;
+    // AVX registers are only usable if the os saves them on context switches.
+    if (numIDs >= 7 && bOSXSave && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        bAVX2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool bSSSE3 = __builtin_cpu_supports("ssse3");
+    bool bAVX2 = __builtin_cpu_supports("avx2");
+#endif
+    if (bAVX2) {
+        return SIMD_AVX2;
+    } else if (bSSSE3) {
+        return SIMD_SSSE3;
+    } else {
+        return SIMD_SSE2;
+    }
+#elif defined(AVG_SIMD_NEON)
+    return SIMD_NEON;
+#else
+    return SIMD_NONE;
+#endif
+}
+
+static SIMDLevel s_MaxLevel = detectSIMDLevel();
+static SIMDLevel s_Level = s_MaxLevel;
+
+SIMDLevel getMaxSIMDLevel()
+{
+    return s_MaxLevel;
+}
+
+SIMDLevel getSIMDLevel()
+{
+    return s_Level;
+}
+
+void setSIMDLevel(SIMDLevel level)
+{
+    if (level > s_MaxLevel) {
+        s_Level = s_MaxLevel;
+    } else {
+        s_Level = level;
+    }
+}
+
+string getSIMDLevelName(SIMDLevel level)
+{
+    switch (level) {
+        case SIMD_NONE:
+            return "scalar";
+        case SIMD_SSE2:
+            return "SSE2";
+        case SIMD_SSSE3:
+            return "SSSE3";
+        case SIMD_AVX2:
+            return "AVX2";
+        case SIMD_NEON:
+            return "NEON";
+        default:
+            return "unknown";
+    }
+}
+
+#ifdef AVG_SIMD_X86
+
+// Interleaves 16 b, g and r bytes into 16 B8G8R8X8 pixels.
+AVG_TARGET("sse2")
+static inline void storeBGRXSSE2(unsigned char* pDest, __m128i b, __m128i g, __m128i r)
+{
+    const __m128i alpha = _mm_set1_epi8(-1);
+    __m128i bg = _mm_unpacklo_epi8(b, g);
+    __m128i ra = _mm_unpacklo_epi8(r, alpha);
+    _mm_storeu_si128((__m128i*)pDest, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i*)(pDest+16), _mm_unpackhi_epi16(bg, ra));
+    bg = _mm_unpackhi_epi8(b, g);
+    ra = _mm_unpackhi_epi8(r, alpha);
+    _mm_storeu_si128((__m128i*)(pDest+32), _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i*)(pDest+48), _mm_unpackhi_epi16(bg, ra));
+}
+
+// Same fixed point math as YUVtoBGR32Pixel() for eight 16-bit samples. The results are
+// not clamped yet. The products don't fit into 16 bits, so they are calculated as
+// 32-bit sums using pmaddwd.
+AVG_TARGET("sse2")
+static inline void YUVtoBGRSSE2(__m128i y, __m128i u, __m128i v,
+        __m128i& b, __m128i& g, __m128i& r)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i yFactor = _mm_set1_epi32(298);
+    const __m128i bFactor = _mm_set1_epi32(516);
+    const __m128i gFactors = _mm_setr_epi16(-100, -208, -100, -208, -100, -208,
+            -100, -208);
+    const __m128i rFactor = _mm_set1_epi32(409);
+    y = _mm_sub_epi16(y, _mm_set1_epi16(16));
+    u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+    v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+    __m128i yLo = _mm_madd_epi16(_mm_unpacklo_epi16(y, zero), yFactor);
+    __m128i yHi = _mm_madd_epi16(_mm_unpackhi_epi16(y, zero), yFactor);
+    __m128i lo = _mm_add_epi32(yLo, _mm_madd_epi16(_mm_unpacklo_epi16(u, zero), bFactor));
+    __m128i hi = _mm_add_epi32(yHi, _mm_madd_epi16(_mm_unpackhi_epi16(u, zero), bFactor));
+    b = _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+    lo = _mm_add_epi32(yLo, _mm_madd_epi16(_mm_unpacklo_epi16(u, v), gFactors));
+    hi = _mm_add_epi32(yHi, _mm_madd_epi16(_mm_unpackhi_epi16(u, v), gFactors));
+    g = _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+    lo = _mm_add_epi32(yLo, _mm_madd_epi16(_mm_unpacklo_epi16(v, zero), rFactor));
+    hi = _mm_add_epi32(yHi, _mm_madd_epi16(_mm_unpackhi_epi16(v, zero), rFactor));
+    r = _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+}
+
+// The loops stop one pixel short of the line end so lines passed in with an offset of
+// one byte (UYVY) are never read beyond their end.
+AVG_TARGET("sse2")
+static int YUYV422toI8LineSSE2(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    const __m128i lumaMask = _mm_set1_epi16(0xFF);
+    int x = 0;
+    for (; x+16 < width; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(pSrc+x*2));
+        __m128i b = _mm_loadu_si128((const __m128i*)(pSrc+x*2+16));
+        a = _mm_and_si128(a, lumaMask);
+        b = _mm_and_si128(b, lumaMask);
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_packus_epi16(a, b));
+    }
+    return x;
+}
+
+AVG_TARGET("ssse3")
+static int YUYV422toI8LineSSSE3(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    const __m128i evenBytes = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+            -1, -1, -1, -1, -1, -1, -1, -1);
+    int x = 0;
+    for (; x+16 < width; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(pSrc+x*2));
+        __m128i b = _mm_loadu_si128((const __m128i*)(pSrc+x*2+16));
+        a = _mm_shuffle_epi8(a, evenBytes);
+        b = _mm_shuffle_epi8(b, evenBytes);
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_unpacklo_epi64(a, b));
+    }
+    return x;
+}
+
+AVG_TARGET("avx2")
+static int YUYV422toI8LineAVX2(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    const __m256i lumaMask = _mm256_set1_epi16(0xFF);
+    int x = 0;
+    for (; x+32 < width; x += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(pSrc+x*2));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(pSrc+x*2+32));
+        a = _mm256_and_si256(a, lumaMask);
+        b = _mm256_and_si256(b, lumaMask);
+        // packus works per 128-bit lane, so the quadwords need to be reordered.
+        __m256i result = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b),
+                _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i*)(pDest+x), result);
+    }
+    return x + YUYV422toI8LineSSSE3(pSrc+x*2, pDest+x, width-x);
+}
+
+AVG_TARGET("sse2")
+static int YUV422toBGR32LineSSE2(const unsigned char* pSrc, unsigned char* pDest,
+        int width, bool bUYVY)
+{
+    const __m128i lowWord = _mm_set1_epi32(0xFFFF);
+    const __m128i byteMask = _mm_set1_epi16(0xFF);
+    int uOfs = bUYVY ? 0 : 1;
+    int vOfs = uOfs+2;
+    int vPrev = pSrc[vOfs];
+    int numPairs = width/2-1;
+    int pair = 0;
+    // Eight pixel pairs per iteration. The chroma values are interpolated just like in
+    // the scalar code: Even pixels use the average of the previous and current v, odd
+    // pixels the average of the current and next u.
+    for (; pair+8 <= numPairs; pair += 8) {
+        const unsigned char* pSrcPair = pSrc+pair*4;
+        __m128i a = _mm_loadu_si128((const __m128i*)pSrcPair);
+        __m128i b = _mm_loadu_si128((const __m128i*)(pSrcPair+16));
+        __m128i lumaA, lumaB, chromaA, chromaB;
+        if (bUYVY) {
+            lumaA = _mm_srli_epi16(a, 8);
+            lumaB = _mm_srli_epi16(b, 8);
+            chromaA = _mm_and_si128(a, byteMask);
+            chromaB = _mm_and_si128(b, byteMask);
+        } else {
+            lumaA = _mm_and_si128(a, byteMask);
+            lumaB = _mm_and_si128(b, byteMask);
+            chromaA = _mm_srli_epi16(a, 8);
+            chromaB = _mm_srli_epi16(b, 8);
+        }
+        __m128i yEven = _mm_packs_epi32(_mm_and_si128(lumaA, lowWord),
+                _mm_and_si128(lumaB, lowWord));
+        __m128i yOdd = _mm_packs_epi32(_mm_srli_epi32(lumaA, 16),
+                _mm_srli_epi32(lumaB, 16));
+        __m128i u = _mm_packs_epi32(_mm_and_si128(chromaA, lowWord),
+                _mm_and_si128(chromaB, lowWord));
+        __m128i v = _mm_packs_epi32(_mm_srli_epi32(chromaA, 16),
+                _mm_srli_epi32(chromaB, 16));
+
+        __m128i uNext = _mm_insert_epi16(_mm_srli_si128(u, 2), pSrcPair[32+uOfs], 7);
+        __m128i vPrevs = _mm_insert_epi16(_mm_slli_si128(v, 2), vPrev, 0);
+        vPrev = pSrcPair[28+vOfs];
+        __m128i vEven = _mm_srli_epi16(_mm_add_epi16(vPrevs, v), 1);
+        __m128i uOdd = _mm_srli_epi16(_mm_add_epi16(u, uNext), 1);
+
+        __m128i bEven, gEven, rEven;
+        YUVtoBGRSSE2(yEven, u, vEven, bEven, gEven, rEven);
+        __m128i bOdd, gOdd, rOdd;
+        YUVtoBGRSSE2(yOdd, uOdd, v, bOdd, gOdd, rOdd);
+        __m128i b8 = _mm_packus_epi16(_mm_unpacklo_epi16(bEven, bOdd),
+                _mm_unpackhi_epi16(bEven, bOdd));
+        __m128i g8 = _mm_packus_epi16(_mm_unpacklo_epi16(gEven, gOdd),
+                _mm_unpackhi_epi16(gEven, gOdd));
+        __m128i r8 = _mm_packus_epi16(_mm_unpacklo_epi16(rEven, rOdd),
+                _mm_unpackhi_epi16(rEven, rOdd));
+        storeBGRXSSE2(pDest+pair*8, b8, g8, r8);
+    }
+    return pair;
+}
+
+AVG_TARGET("sse2")
+static int YUV420toBGR32LineSSE2(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int width, bool bJPEG)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i y = _mm_loadu_si128((const __m128i*)(pY+x));
+        __m128i yLo = _mm_unpacklo_epi8(y, zero);
+        __m128i yHi = _mm_unpackhi_epi8(y, zero);
+        __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pU+x/2)), zero);
+        __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pV+x/2)), zero);
+        u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+        v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+        __m128i r, g, b;
+        if (bJPEG) {
+            g = _mm_adds_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(-44)),
+                    _mm_mullo_epi16(v, _mm_set1_epi16(-91)));
+            b = _mm_mullo_epi16(u, _mm_set1_epi16(113));
+            r = _mm_mullo_epi16(v, _mm_set1_epi16(179));
+        } else {
+            // y' = (149*(y-16)) >> 7
+            const __m128i yOfs = _mm_set1_epi16(16);
+            const __m128i yFactor = _mm_set1_epi16(149);
+            yLo = _mm_srli_epi16(_mm_mullo_epi16(_mm_subs_epu16(yLo, yOfs), yFactor), 7);
+            yHi = _mm_srli_epi16(_mm_mullo_epi16(_mm_subs_epu16(yHi, yOfs), yFactor), 7);
+            g = _mm_adds_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(-50)),
+                    _mm_mullo_epi16(v, _mm_set1_epi16(-104)));
+            b = _mm_mullo_epi16(u, _mm_set1_epi16(129));
+            r = _mm_mullo_epi16(v, _mm_set1_epi16(204));
+        }
+        r = _mm_srai_epi16(r, 7);
+        g = _mm_srai_epi16(g, 7);
+        b = _mm_srai_epi16(b, 6);
+
+        // Every chroma value is used for two pixels.
+        __m128i r8 = _mm_packus_epi16(_mm_adds_epi16(_mm_unpacklo_epi16(r, r), yLo),
+                _mm_adds_epi16(_mm_unpackhi_epi16(r, r), yHi));
+        __m128i g8 = _mm_packus_epi16(_mm_adds_epi16(_mm_unpacklo_epi16(g, g), yLo),
+                _mm_adds_epi16(_mm_unpackhi_epi16(g, g), yHi));
+        __m128i b8 = _mm_packus_epi16(_mm_adds_epi16(_mm_unpacklo_epi16(b, b), yLo),
+                _mm_adds_epi16(_mm_unpackhi_epi16(b, b), yHi));
+        storeBGRXSSE2(pDest+x*4, b8, g8, r8);
+    }
+    return x;
+}
+
+AVG_TARGET("sse2")
+static int I8toRGBX32LineSSE2(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    const __m128i alpha = _mm_set1_epi8(-1);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i gray = _mm_loadu_si128((const __m128i*)(pSrc+x));
+        __m128i gg = _mm_unpacklo_epi8(gray, gray);
+        __m128i ga = _mm_unpacklo_epi8(gray, alpha);
+        _mm_storeu_si128((__m128i*)(pDest+x*4), _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128((__m128i*)(pDest+x*4+16), _mm_unpackhi_epi16(gg, ga));
+        gg = _mm_unpackhi_epi8(gray, gray);
+        ga = _mm_unpackhi_epi8(gray, alpha);
+        _mm_storeu_si128((__m128i*)(pDest+x*4+32), _mm_unpacklo_epi16(gg, ga));
+        _mm_storeu_si128((__m128i*)(pDest+x*4+48), _mm_unpackhi_epi16(gg, ga));
+    }
+    return x;
+}
+
+AVG_TARGET("avx2")
+static int I8toRGBX32LineAVX2(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    // The low lane expands pixels 0-3, the high lane pixels 4-7.
+    const __m256i spread = _mm256_setr_epi8(
+            0, 0, 0, -1, 1, 1, 1, -1, 2, 2, 2, -1, 3, 3, 3, -1,
+            4, 4, 4, -1, 5, 5, 5, -1, 6, 6, 6, -1, 7, 7, 7, -1);
+    const __m256i alpha = _mm256_set1_epi32(0xFF000000);
+    int x = 0;
+    for (; x+8 <= width; x += 8) {
+        __m256i gray = _mm256_broadcastsi128_si256(
+                _mm_loadl_epi64((const __m128i*)(pSrc+x)));
+        __m256i result = _mm256_or_si256(_mm256_shuffle_epi8(gray, spread), alpha);
+        _mm256_storeu_si256((__m256i*)(pDest+x*4), result);
+    }
+    return x;
+}
+
+AVG_TARGET("ssse3")
+static int I8toRGB24LineSSSE3(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    const __m128i spread0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    const __m128i spread1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9,
+            10, 10);
+    const __m128i spread2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14,
+            14, 14, 15, 15, 15);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i gray = _mm_loadu_si128((const __m128i*)(pSrc+x));
+        _mm_storeu_si128((__m128i*)(pDest+x*3), _mm_shuffle_epi8(gray, spread0));
+        _mm_storeu_si128((__m128i*)(pDest+x*3+16), _mm_shuffle_epi8(gray, spread1));
+        _mm_storeu_si128((__m128i*)(pDest+x*3+32), _mm_shuffle_epi8(gray, spread2));
+    }
+    return x;
+}
+
+AVG_TARGET("sse2")
+static int ByteToFloatLineSSE2(const unsigned char* pSrc, float* pDest, int numValues)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scale = _mm_set1_ps(255.f);
+    int i = 0;
+    for (; i+16 <= numValues; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(pSrc+i));
+        __m128i words = _mm_unpacklo_epi8(bytes, zero);
+        _mm_storeu_ps(pDest+i, _mm_div_ps(
+                _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)), scale));
+        _mm_storeu_ps(pDest+i+4, _mm_div_ps(
+                _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero)), scale));
+        words = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_ps(pDest+i+8, _mm_div_ps(
+                _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)), scale));
+        _mm_storeu_ps(pDest+i+12, _mm_div_ps(
+                _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero)), scale));
+    }
+    return i;
+}
+
+AVG_TARGET("avx2")
+static int ByteToFloatLineAVX2(const unsigned char* pSrc, float* pDest, int numValues)
+{
+    const __m256 scale = _mm256_set1_ps(255.f);
+    int i = 0;
+    for (; i+16 <= numValues; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(pSrc+i));
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+        _mm256_storeu_ps(pDest+i, _mm256_div_ps(lo, scale));
+        _mm256_storeu_ps(pDest+i+8, _mm256_div_ps(hi, scale));
+    }
+    return i;
+}
+
+// Eight pixel pairs per iteration, using 16-bit sums. The first pixel of each pair
+// averages four diagonal and four adjacent neighbours, the second one two horizontal
+// and two vertical neighbours (pavgw rounds like the scalar (a+b+1)>>1).
+AVG_TARGET("sse2")
+static int BayerBilinearLineSSE2(const unsigned char* pSrc, int srcStride,
+        unsigned char* pDest, int numPairs, bool bSwapRB)
+{
+    const __m128i byteMask = _mm_set1_epi16(0xFF);
+    const __m128i two = _mm_set1_epi16(2);
+    int pair = 0;
+    for (; pair+8 <= numPairs; pair += 8) {
+        const unsigned char* pSrc0 = pSrc+pair*2;
+        const unsigned char* pSrc1 = pSrc0+srcStride;
+        const unsigned char* pSrc2 = pSrc1+srcStride;
+        __m128i row0 = _mm_loadu_si128((const __m128i*)pSrc0);
+        __m128i row0Next = _mm_loadu_si128((const __m128i*)(pSrc0+2));
+        __m128i row1 = _mm_loadu_si128((const __m128i*)pSrc1);
+        __m128i row1Next = _mm_loadu_si128((const __m128i*)(pSrc1+2));
+        __m128i row2 = _mm_loadu_si128((const __m128i*)pSrc2);
+        __m128i row2Next = _mm_loadu_si128((const __m128i*)(pSrc2+2));
+
+        // x+0 and x+1 of each pair, and the same for the next pair (x+2, x+3).
+        __m128i s00 = _mm_and_si128(row0, byteMask);
+        __m128i s01 = _mm_srli_epi16(row0, 8);
+        __m128i s02 = _mm_and_si128(row0Next, byteMask);
+        __m128i s10 = _mm_and_si128(row1, byteMask);
+        __m128i s11 = _mm_srli_epi16(row1, 8);
+        __m128i s12 = _mm_and_si128(row1Next, byteMask);
+        __m128i s13 = _mm_srli_epi16(row1Next, 8);
+        __m128i s20 = _mm_and_si128(row2, byteMask);
+        __m128i s21 = _mm_srli_epi16(row2, 8);
+        __m128i s22 = _mm_and_si128(row2Next, byteMask);
+
+        __m128i diag = _mm_add_epi16(_mm_add_epi16(s00, s02), _mm_add_epi16(s20, s22));
+        diag = _mm_srli_epi16(_mm_add_epi16(diag, two), 2);
+        __m128i cross = _mm_add_epi16(_mm_add_epi16(s01, s10), _mm_add_epi16(s12, s21));
+        cross = _mm_srli_epi16(_mm_add_epi16(cross, two), 2);
+        __m128i vert = _mm_avg_epu16(s02, s22);
+        __m128i horiz = _mm_avg_epu16(s11, s13);
+
+        // Channel values of the first and second pixels, interleaved.
+        __m128i c0 = _mm_unpacklo_epi8(_mm_packus_epi16(diag, diag),
+                _mm_packus_epi16(vert, vert));
+        __m128i c1 = _mm_unpacklo_epi8(_mm_packus_epi16(cross, cross),
+                _mm_packus_epi16(s12, s12));
+        __m128i c2 = _mm_unpacklo_epi8(_mm_packus_epi16(s11, s11),
+                _mm_packus_epi16(horiz, horiz));
+        if (bSwapRB) {
+            storeBGRXSSE2(pDest+pair*8, c2, c1, c0);
+        } else {
+            storeBGRXSSE2(pDest+pair*8, c0, c1, c2);
+        }
+    }
+    return pair;
+}
+
+#endif
+
+#ifdef AVG_SIMD_NEON
+
+static int YUYV422toI8LineNEON(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    int x = 0;
+    for (; x+16 < width; x += 16) {
+        uint8x16x2_t yuyv = vld2q_u8(pSrc+x*2);
+        vst1q_u8(pDest+x, yuyv.val[0]);
+    }
+    return x;
+}
+
+static int I8toRGBLineNEON(const unsigned char* pSrc, unsigned char* pDest, int width,
+        int bpp)
+{
+    int x = 0;
+    if (bpp == 4) {
+        uint8x16x4_t rgbx;
+        rgbx.val[3] = vdupq_n_u8(255);
+        for (; x+16 <= width; x += 16) {
+            uint8x16_t gray = vld1q_u8(pSrc+x);
+            rgbx.val[0] = gray;
+            rgbx.val[1] = gray;
+            rgbx.val[2] = gray;
+            vst4q_u8(pDest+x*4, rgbx);
+        }
+    } else {
+        uint8x16x3_t rgb;
+        for (; x+16 <= width; x += 16) {
+            uint8x16_t gray = vld1q_u8(pSrc+x);
+            rgb.val[0] = gray;
+            rgb.val[1] = gray;
+            rgb.val[2] = gray;
+            vst3q_u8(pDest+x*3, rgb);
+        }
+    }
+    return x;
+}
+
+#endif
+
+int YUYV422toI8LineSIMD(const unsigned char* pSrc, unsigned char* pDest, int width)
+{
+    switch (s_Level) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            return YUYV422toI8LineAVX2(pSrc, pDest, width);
+        case SIMD_SSSE3:
+            return YUYV422toI8LineSSSE3(pSrc, pDest, width);
+        case SIMD_SSE2:
+            return YUYV422toI8LineSSE2(pSrc, pDest, width);
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            return YUYV422toI8LineNEON(pSrc, pDest, width);
+#endif
+        default:
+            return 0;
+    }
+}
+
+int YUV422toBGR32LineSIMD(const unsigned char* pSrc, unsigned char* pDest, int width,
+        bool bUYVY)
+{
+#ifdef AVG_SIMD_X86
+    if (s_Level >= SIMD_SSE2) {
+        return YUV422toBGR32LineSSE2(pSrc, pDest, width, bUYVY);
+    }
+#endif
+    return 0;
+}
+
+int YUV420toBGR32LineSIMD(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int width, bool bJPEG)
+{
+#ifdef AVG_SIMD_X86
+    if (s_Level >= SIMD_SSE2) {
+        return YUV420toBGR32LineSSE2(pY, pU, pV, pDest, width, bJPEG);
+    }
+#endif
+    return 0;
+}
+
+int I8toRGBLineSIMD(const unsigned char* pSrc, unsigned char* pDest, int width, int bpp)
+{
+#ifdef AVG_SIMD_X86
+    if (bpp == 4) {
+        if (s_Level >= SIMD_AVX2) {
+            return I8toRGBX32LineAVX2(pSrc, pDest, width);
+        } else if (s_Level >= SIMD_SSE2) {
+            return I8toRGBX32LineSSE2(pSrc, pDest, width);
+        }
+    } else {
+        if (s_Level >= SIMD_SSSE3) {
+            return I8toRGB24LineSSSE3(pSrc, pDest, width);
+        }
+    }
+#endif
+#ifdef AVG_SIMD_NEON
+    if (s_Level == SIMD_NEON) {
+        return I8toRGBLineNEON(pSrc, pDest, width, bpp);
+    }
+#endif
+    return 0;
+}
+
+int BayerBilinearLineSIMD(const unsigned char* pSrc, int srcStride,
+        unsigned char* pDest, int numPairs, bool bSwapRB)
+{
+#ifdef AVG_SIMD_X86
+    if (s_Level >= SIMD_SSE2) {
+        return BayerBilinearLineSSE2(pSrc, srcStride, pDest, numPairs, bSwapRB);
+    }
+#endif
+    return 0;
+}
+
+int ByteToFloatLineSIMD(const unsigned char* pSrc, float* pDest, int numValues)
+{
+#ifdef AVG_SIMD_X86
+    if (s_Level >= SIMD_AVX2) {
+        return ByteToFloatLineAVX2(pSrc, pDest, numValues);
+    } else if (s_Level >= SIMD_SSE2) {
+        return ByteToFloatLineSSE2(pSrc, pDest, numValues);
+    }
+#endif
+    return 0;
+}
+
+}
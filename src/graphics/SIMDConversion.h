@@ -0,0 +1,78 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _SIMDConversion_H_
+#define _SIMDConversion_H_
+
+#include "../api.h"
+
+#include <string>
+
+namespace avg {
+
+// Vectorized line kernels for the pixel format conversions in Bitmap. The instruction
+// set is chosen at runtime using cpuid. Every kernel converts as much of the line as it
+// can and returns the number of pixels (or pixel pairs, or values) it processed; the
+// caller converts the rest using the scalar code, which stays the reference
+// implementation. All kernels are bit-exact with the scalar code, except for
+// ByteToFloatLineSIMD, which can differ by one ulp because the scalar version may be
+// compiled to a multiplication by the reciprocal.
+
+enum SIMDLevel {SIMD_NONE, SIMD_SSE2, SIMD_SSSE3, SIMD_AVX2, SIMD_NEON};
+
+// Best level supported by cpu and compiler.
+AVG_API SIMDLevel getMaxSIMDLevel();
+AVG_API SIMDLevel getSIMDLevel();
+// Restricts the kernels used. Levels above getMaxSIMDLevel() are clamped. Used by tests
+// and benchmarks to compare against the scalar code.
+AVG_API void setSIMDLevel(SIMDLevel level);
+AVG_API std::string getSIMDLevelName(SIMDLevel level);
+
+// Extracts the luminance channel of a YUYV line. Pass pSrc+1 for UYVY lines.
+int YUYV422toI8LineSIMD(const unsigned char* pSrc, unsigned char* pDest, int width);
+
+// Converts complete YUYV (or UYVY if bUYVY is set) pixel pairs to B8G8R8X8. The last
+// pair of the line is never converted since it is interpolated differently.
+int YUV422toBGR32LineSIMD(const unsigned char* pSrc, unsigned char* pDest, int width,
+        bool bUYVY);
+
+// Converts a YUV420 line to B8G8R8X8 using the same fixed point math as the mmx code in
+// Bitmap::copyYUVPixels.
+int YUV420toBGR32LineSIMD(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int width, bool bJPEG);
+
+// Replicates grayscale values into three color channels (four with opaque alpha if
+// bpp == 4).
+int I8toRGBLineSIMD(const unsigned char* pSrc, unsigned char* pDest, int width, int bpp);
+
+// Bilinear Bayer demosaicing of the pixel pairs in the middle row of three source
+// rows, as in the inner loop of Bitmap::BY8toRGBBilinear(). pDest points to the first
+// byte of the first pixel. Without bSwapRB, the first pixel of each pair gets the
+// diagonal average in channel 0, the second one the vertical average.
+int BayerBilinearLineSIMD(const unsigned char* pSrc, int srcStride,
+        unsigned char* pDest, int numPairs, bool bSwapRB);
+
+// Converts bytes to floats in the range 0..1.
+int ByteToFloatLineSIMD(const unsigned char* pSrc, float* pDest, int numValues);
+
+}
+
+#endif
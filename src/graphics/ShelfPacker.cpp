@@ -0,0 +1,221 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ShelfPacker.h"
+
+#include "../base/Exception.h"
+
+#include <climits>
+
+using namespace std;
+
+namespace avg {
+
+ShelfPacker::Span::Span(int x, int width)
+    : m_X(x),
+      m_Width(width)
+{
+}
+
+ShelfPacker::Shelf::Shelf(int y, int height, int width)
+    : m_Y(y),
+      m_Height(height),
+      m_NumRects(0)
+{
+    m_FreeSpans.push_back(Span(0, width));
+}
+
+bool ShelfPacker::Shelf::findSpan(int width) const
+{
+    for (unsigned i=0; i<m_FreeSpans.size(); ++i) {
+        if (m_FreeSpans[i].m_Width >= width) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ShelfPacker::ShelfPacker(const IntPoint& size)
+    : m_Size(size),
+      m_NumRects(0),
+      m_UsedArea(0)
+{
+}
+
+ShelfPacker::~ShelfPacker()
+{
+}
+
+bool ShelfPacker::alloc(const IntPoint& size, IntPoint& pos)
+{
+    AVG_ASSERT(size.x > 0 && size.y > 0);
+    if (size.x > m_Size.x || size.y > m_Size.y) {
+        return false;
+    }
+    // Best height fit among the shelves that have room. Empty shelves are split to
+    // the height needed, so they don't waste anything.
+    int bestShelf = -1;
+    int bestWaste = INT_MAX;
+    for (unsigned i=0; i<m_Shelves.size(); ++i) {
+        const Shelf& shelf = m_Shelves[i];
+        if (shelf.m_Height >= size.y && shelf.findSpan(size.x)) {
+            int waste = 0;
+            if (shelf.m_NumRects > 0) {
+                waste = shelf.m_Height - size.y;
+            }
+            if (waste < bestWaste) {
+                bestShelf = i;
+                bestWaste = waste;
+            }
+        }
+    }
+    bool bRoomForNewShelf = getShelvesHeight()+size.y <= m_Size.y;
+    if (bestShelf != -1 && (bestWaste <= size.y/2 || !bRoomForNewShelf)) {
+        allocInShelf(bestShelf, size, pos);
+        return true;
+    }
+    if (bRoomForNewShelf) {
+        m_Shelves.push_back(Shelf(getShelvesHeight(), size.y, m_Size.x));
+        allocInShelf(m_Shelves.size()-1, size, pos);
+        return true;
+    }
+    if (bestShelf != -1) {
+        allocInShelf(bestShelf, size, pos);
+        return true;
+    }
+    return false;
+}
+
+void ShelfPacker::free(const IntRect& rect)
+{
+    unsigned i = 0;
+    while (i < m_Shelves.size() && m_Shelves[i].m_Y != rect.tl.y) {
+        ++i;
+    }
+    AVG_ASSERT(i < m_Shelves.size());
+    Shelf& shelf = m_Shelves[i];
+    AVG_ASSERT(shelf.m_NumRects > 0);
+
+    vector<Span>& spans = shelf.m_FreeSpans;
+    unsigned spanIndex = 0;
+    while (spanIndex < spans.size() && spans[spanIndex].m_X < rect.tl.x) {
+        ++spanIndex;
+    }
+    spans.insert(spans.begin()+spanIndex, Span(rect.tl.x, rect.width()));
+    if (spanIndex+1 < spans.size() && 
+            spans[spanIndex].m_X+spans[spanIndex].m_Width == spans[spanIndex+1].m_X)
+    {
+        spans[spanIndex].m_Width += spans[spanIndex+1].m_Width;
+        spans.erase(spans.begin()+spanIndex+1);
+    }
+    if (spanIndex > 0 && 
+            spans[spanIndex-1].m_X+spans[spanIndex-1].m_Width == spans[spanIndex].m_X)
+    {
+        spans[spanIndex-1].m_Width += spans[spanIndex].m_Width;
+        spans.erase(spans.begin()+spanIndex);
+    }
+
+    shelf.m_NumRects--;
+    m_NumRects--;
+    m_UsedArea -= rect.width()*rect.height();
+    if (shelf.m_NumRects == 0) {
+        AVG_ASSERT(spans.size() == 1 && spans[0].m_Width == m_Size.x);
+        mergeEmptyShelves(i);
+    }
+}
+
+const IntPoint& ShelfPacker::getSize() const
+{
+    return m_Size;
+}
+
+int ShelfPacker::getNumRects() const
+{
+    return m_NumRects;
+}
+
+int ShelfPacker::getUsedArea() const
+{
+    return m_UsedArea;
+}
+
+int ShelfPacker::getNumShelves() const
+{
+    return int(m_Shelves.size());
+}
+
+void ShelfPacker::allocInShelf(unsigned shelfIndex, const IntPoint& size, IntPoint& pos)
+{
+    Shelf& shelf = m_Shelves[shelfIndex];
+    if (shelf.m_NumRects == 0 && shelf.m_Height > size.y) {
+        // Split the empty shelf. Its neighbours aren't empty, so the remainder doesn't
+        // need to be merged with anything.
+        Shelf remainder(shelf.m_Y+size.y, shelf.m_Height-size.y, m_Size.x);
+        shelf.m_Height = size.y;
+        m_Shelves.insert(m_Shelves.begin()+shelfIndex+1, remainder);
+    }
+    Shelf& allocShelf = m_Shelves[shelfIndex];
+    vector<Span>& spans = allocShelf.m_FreeSpans;
+    for (unsigned i=0; i<spans.size(); ++i) {
+        if (spans[i].m_Width >= size.x) {
+            pos = IntPoint(spans[i].m_X, allocShelf.m_Y);
+            spans[i].m_X += size.x;
+            spans[i].m_Width -= size.x;
+            if (spans[i].m_Width == 0) {
+                spans.erase(spans.begin()+i);
+            }
+            allocShelf.m_NumRects++;
+            m_NumRects++;
+            m_UsedArea += size.x*size.y;
+            return;
+        }
+    }
+    AVG_ASSERT(false);
+}
+
+void ShelfPacker::mergeEmptyShelves(unsigned shelfIndex)
+{
+    // Keeps the invariant that no two empty shelves are adjacent and that the last
+    // shelf isn't empty.
+    if (shelfIndex+1 < m_Shelves.size() && m_Shelves[shelfIndex+1].m_NumRects == 0) {
+        m_Shelves[shelfIndex].m_Height += m_Shelves[shelfIndex+1].m_Height;
+        m_Shelves.erase(m_Shelves.begin()+shelfIndex+1);
+    }
+    if (shelfIndex > 0 && m_Shelves[shelfIndex-1].m_NumRects == 0) {
+        m_Shelves[shelfIndex-1].m_Height += m_Shelves[shelfIndex].m_Height;
+        m_Shelves.erase(m_Shelves.begin()+shelfIndex);
+        shelfIndex--;
+    }
+    if (shelfIndex == m_Shelves.size()-1) {
+        m_Shelves.pop_back();
+    }
+}
+
+int ShelfPacker::getShelvesHeight() const
+{
+    if (m_Shelves.empty()) {
+        return 0;
+    } else {
+        return m_Shelves.back().m_Y+m_Shelves.back().m_Height;
+    }
+}
+
+}
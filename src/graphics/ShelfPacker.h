@@ -0,0 +1,81 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ShelfPacker_H_
+#define _ShelfPacker_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <vector>
+
+namespace avg {
+
+// Allocates rectangles inside a fixed-size area. Rectangles are placed in shelves - 
+// horizontal strips that each hold a row of rectangles. Freed space is reused by later
+// allocations: free spans inside a shelf are coalesced, empty shelves are merged with
+// their empty neighbours and split again when a smaller rectangle needs them.
+// Allocated rectangles never move.
+class AVG_API ShelfPacker {
+public:
+    ShelfPacker(const IntPoint& size);
+    virtual ~ShelfPacker();
+
+    bool alloc(const IntPoint& size, IntPoint& pos);
+    void free(const IntRect& rect);
+
+    const IntPoint& getSize() const;
+    int getNumRects() const;
+    int getUsedArea() const;
+    int getNumShelves() const;
+
+private:
+    struct Span {
+        Span(int x, int width);
+        int m_X;
+        int m_Width;
+    };
+
+    struct Shelf {
+        Shelf(int y, int height, int width);
+        bool findSpan(int width) const;
+        int m_Y;
+        int m_Height;
+        int m_NumRects;
+        std::vector<Span> m_FreeSpans;
+    };
+
+    // Can insert a shelf, so references into m_Shelves don't survive the call.
+    void allocInShelf(unsigned shelfIndex, const IntPoint& size, IntPoint& pos);
+    void mergeEmptyShelves(unsigned shelfIndex);
+    int getShelvesHeight() const;
+
+    IntPoint m_Size;
+    std::vector<Shelf> m_Shelves;
+    int m_NumRects;
+    int m_UsedArea;
+};
+
+}
+
+#endif
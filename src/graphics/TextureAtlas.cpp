@@ -0,0 +1,243 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "TextureAtlas.h"
+
+#include "ShelfPacker.h"
+#include "Bitmap.h"
+#include "MCTexture.h"
+#include "GLContextManager.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+
+#include <string.h>
+
+using namespace std;
+
+namespace avg {
+
+static const int BORDER = 1;
+
+class AtlasPage: boost::noncopyable {
+public:
+    AtlasPage(const IntPoint& size, PixelFormat pf)
+        : m_Packer(size),
+          m_pf(pf)
+    {
+        m_pTex = GLContextManager::get()->createTexture(size, pf);
+    }
+
+    ShelfPacker m_Packer;
+    PixelFormat m_pf;
+    MCTexturePtr m_pTex;
+};
+
+AtlasRegion::AtlasRegion(AtlasPagePtr pPage, const IntRect& rect)
+    : m_pPage(pPage),
+      m_Rect(rect)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+AtlasRegion::~AtlasRegion()
+{
+    m_pPage->m_Packer.free(m_Rect);
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+void AtlasRegion::setBitmap(BitmapPtr pBmp)
+{
+    IntPoint size = getSize();
+    AVG_ASSERT(pBmp->getSize() == size);
+    AVG_ASSERT(pBmp->getPixelFormat() == getPF());
+
+    // Copy the bitmap into the center of a bitmap with a border that repeats the 
+    // edge pixels.
+    BitmapPtr pPaddedBmp(new Bitmap(m_Rect.size(), getPF()));
+    int bpp = pBmp->getBytesPerPixel();
+    int lineLen = pBmp->getLineLen();
+    int paddedStride = pPaddedBmp->getStride();
+    for (int y=0; y<size.y; ++y) {
+        const unsigned char* pSrc = pBmp->getPixels()+y*pBmp->getStride();
+        unsigned char* pDest = pPaddedBmp->getPixels()+(y+BORDER)*paddedStride;
+        memcpy(pDest+BORDER*bpp, pSrc, lineLen);
+        for (int i=0; i<BORDER; ++i) {
+            memcpy(pDest+i*bpp, pSrc, bpp);
+            memcpy(pDest+(BORDER+size.x+i)*bpp, pSrc+(size.x-1)*bpp, bpp);
+        }
+    }
+    unsigned char* pPixels = pPaddedBmp->getPixels();
+    for (int i=0; i<BORDER; ++i) {
+        memcpy(pPixels+i*paddedStride, pPixels+BORDER*paddedStride, paddedStride);
+        memcpy(pPixels+(BORDER+size.y+i)*paddedStride, 
+                pPixels+(BORDER+size.y-1)*paddedStride, paddedStride);
+    }
+    GLContextManager::get()->scheduleTexSubUpload(m_pPage->m_pTex, pPaddedBmp, 
+            m_Rect.tl);
+}
+
+MCTexturePtr AtlasRegion::getTex() const
+{
+    return m_pPage->m_pTex;
+}
+
+IntPoint AtlasRegion::getSize() const
+{
+    return m_Rect.size()-IntPoint(2*BORDER, 2*BORDER);
+}
+
+PixelFormat AtlasRegion::getPF() const
+{
+    return m_pPage->m_pf;
+}
+
+FRect AtlasRegion::getTexCoordRect() const
+{
+    glm::vec2 pageSize(m_pPage->m_Packer.getSize());
+    glm::vec2 tl = glm::vec2(m_Rect.tl+IntPoint(BORDER, BORDER));
+    glm::vec2 br = glm::vec2(m_Rect.br-IntPoint(BORDER, BORDER));
+    return FRect(tl.x/pageSize.x, tl.y/pageSize.y, br.x/pageSize.x, br.y/pageSize.y);
+}
+
+bool TextureAtlas::s_bEnabled = true;
+
+void TextureAtlas::enable(bool bEnable)
+{
+    s_bEnabled = bEnable;
+}
+
+bool TextureAtlas::isEnabled()
+{
+    return s_bEnabled;
+}
+
+TextureAtlas::TextureAtlas(const IntPoint& pageSize, int maxBmpSize, 
+        unsigned maxPagesPerPF)
+    : m_PageSize(pageSize),
+      m_MaxBmpSize(maxBmpSize),
+      m_MaxPagesPerPF(maxPagesPerPF)
+{
+    AVG_ASSERT(maxBmpSize+2*BORDER <= pageSize.x && maxBmpSize+2*BORDER <= pageSize.y);
+}
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+bool TextureAtlas::canHold(const IntPoint& size, PixelFormat pf) const
+{
+    if (!s_bEnabled) {
+        return false;
+    }
+    if (size.x <= 0 || size.y <= 0 || size.x > m_MaxBmpSize || size.y > m_MaxBmpSize) {
+        return false;
+    }
+    switch (pf) {
+        case B8G8R8A8:
+        case B8G8R8X8:
+        case R8G8B8A8:
+        case R8G8B8X8:
+        case A8:
+            return true;
+        default:
+            return false;
+    }
+}
+
+AtlasRegionPtr TextureAtlas::insert(BitmapPtr pBmp)
+{
+    IntPoint size = pBmp->getSize();
+    PixelFormat pf = pBmp->getPixelFormat();
+    if (!canHold(size, pf)) {
+        return AtlasRegionPtr();
+    }
+    removeEmptyPages();
+
+    IntPoint paddedSize = size+IntPoint(2*BORDER, 2*BORDER);
+    IntPoint pos;
+    AtlasPagePtr pPage;
+    unsigned numPages = 0;
+    for (unsigned i=0; i<m_pPages.size(); ++i) {
+        if (m_pPages[i]->m_pf == pf) {
+            numPages++;
+            if (m_pPages[i]->m_Packer.alloc(paddedSize, pos)) {
+                pPage = m_pPages[i];
+                break;
+            }
+        }
+    }
+    if (!pPage) {
+        if (numPages >= m_MaxPagesPerPF) {
+            // All pages are full. The caller falls back to a separate texture.
+            return AtlasRegionPtr();
+        }
+        pPage = AtlasPagePtr(new AtlasPage(m_PageSize, pf));
+        m_pPages.push_back(pPage);
+        bool bOK = pPage->m_Packer.alloc(paddedSize, pos);
+        AVG_ASSERT(bOK);
+    }
+    AtlasRegionPtr pRegion(new AtlasRegion(pPage, IntRect(pos, pos+paddedSize)));
+    pRegion->setBitmap(pBmp);
+    return pRegion;
+}
+
+int TextureAtlas::getNumRegions() const
+{
+    int numRegions = 0;
+    for (unsigned i=0; i<m_pPages.size(); ++i) {
+        numRegions += m_pPages[i]->m_Packer.getNumRects();
+    }
+    return numRegions;
+}
+
+int TextureAtlas::getNumPages() const
+{
+    return int(m_pPages.size());
+}
+
+float TextureAtlas::getOccupancy() const
+{
+    if (m_pPages.empty()) {
+        return 0;
+    }
+    float usedArea = 0;
+    for (unsigned i=0; i<m_pPages.size(); ++i) {
+        usedArea += m_pPages[i]->m_Packer.getUsedArea();
+    }
+    return usedArea/(float(m_PageSize.x)*m_PageSize.y*m_pPages.size());
+}
+
+void TextureAtlas::removeEmptyPages()
+{
+    // Regions keep their page alive, so this releases the textures of pages that
+    // aren't used any more.
+    vector<AtlasPagePtr>::iterator it = m_pPages.begin();
+    while (it != m_pPages.end()) {
+        if ((*it)->m_Packer.getNumRects() == 0) {
+            it = m_pPages.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _TextureAtlas_H_
+#define _TextureAtlas_H_
+
+#include "../api.h"
+
+#include "PixelFormat.h"
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+namespace avg {
+
+class MCTexture;
+typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+class AtlasPage;
+typedef boost::shared_ptr<AtlasPage> AtlasPagePtr;
+
+// A bitmap stored in a texture atlas page. The space in the page is returned to the 
+// atlas when the region is deleted.
+class AVG_API AtlasRegion: boost::noncopyable {
+public:
+    AtlasRegion(AtlasPagePtr pPage, const IntRect& rect);
+    virtual ~AtlasRegion();
+
+    void setBitmap(BitmapPtr pBmp);
+
+    MCTexturePtr getTex() const;
+    IntPoint getSize() const;
+    PixelFormat getPF() const;
+    // Texture coordinates of the bitmap inside the page texture.
+    FRect getTexCoordRect() const;
+
+private:
+    AtlasPagePtr m_pPage;
+    IntRect m_Rect;
+};
+
+typedef boost::shared_ptr<AtlasRegion> AtlasRegionPtr;
+
+// Packs small bitmaps into shared textures so scenes with lots of small images don't
+// need a texture (and a texture bind) per image. There are separate pages for every 
+// pixel format. Each bitmap gets a one-pixel border that repeats its edge pixels, so 
+// linear filtering doesn't bleed neighbouring bitmaps into it.
+class AVG_API TextureAtlas: boost::noncopyable {
+public:
+    static void enable(bool bEnable);
+    static bool isEnabled();
+
+    TextureAtlas(const IntPoint& pageSize=IntPoint(1024, 1024), int maxBmpSize=256,
+            unsigned maxPagesPerPF=8);
+    virtual ~TextureAtlas();
+
+    bool canHold(const IntPoint& size, PixelFormat pf) const;
+    // Returns an empty pointer if the bitmap can't be stored in the atlas. The bitmap
+    // is uploaded with the next GLContextManager::uploadData().
+    AtlasRegionPtr insert(BitmapPtr pBmp);
+
+    int getNumRegions() const;
+    int getNumPages() const;
+    // Fraction of the allocated page area that is in use.
+    float getOccupancy() const;
+
+private:
+    void removeEmptyPages();
+
+    IntPoint m_PageSize;
+    int m_MaxBmpSize;
+    unsigned m_MaxPagesPerPF;
+    std::vector<AtlasPagePtr> m_pPages;
+
+    static bool s_bEnabled;
+};
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "TextureUploadThread.h"
+#include "Bitmap.h"
+
+#include "../base/ScopeTimer.h"
+
+namespace avg {
+
+TextureUploadThread::TextureUploadThread(CQueue& cmdQ, TexUploadBandQueue& filledQueue)
+    : WorkerThread<TextureUploadThread>("TextureUpload", cmdQ),
+      m_FilledQueue(filledQueue)
+{
+}
+
+bool TextureUploadThread::work()
+{
+    waitForCommand();
+    return true;
+}
+
+static ProfilingZoneID FillBandProfilingZone("Fill upload buffer", true);
+
+void TextureUploadThread::fillBand(TexUploadBandPtr pBand)
+{
+    {
+        ScopeTimer timer(FillBandProfilingZone);
+        int width = pBand->m_pSrcBmp->getSize().x;
+        Bitmap srcBmp(*pBand->m_pSrcBmp, IntRect(0, pBand->m_StartRow, width,
+                pBand->m_StartRow+pBand->m_NumRows));
+        Bitmap destBmp(IntPoint(width, pBand->m_NumRows), pBand->m_DestPF,
+                pBand->m_pDestPixels, pBand->m_DestStride, false);
+        destBmp.copyPixels(srcBmp);
+    }
+    m_FilledQueue.push(pBand);
+    ThreadProfiler::get()->reset();
+}
+
+}
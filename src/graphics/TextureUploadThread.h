@@ -0,0 +1,77 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _TextureUploadThread_H_
+#define _TextureUploadThread_H_
+
+#include "../api.h"
+#include "PixelFormat.h"
+
+#include "../base/WorkerThread.h"
+#include "../base/Queue.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+class MCTexture;
+typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+
+// A band of rows of a bitmap on its way into a texture. The worker thread only
+// touches the source and destination fields; everything else belongs to the main
+// thread.
+struct TexUploadBand {
+    BitmapPtr m_pSrcBmp;
+    int m_StartRow;
+    int m_NumRows;
+    PixelFormat m_DestPF;
+    unsigned char* m_pDestPixels;
+    int m_DestStride;
+
+    MCTexturePtr m_pTex;
+    // 0 if the buffer couldn't be mapped. The band is then uploaded directly.
+    unsigned m_BufferID;
+    bool m_bLastBand;
+    bool m_bFilled;
+};
+
+typedef boost::shared_ptr<TexUploadBand> TexUploadBandPtr;
+typedef Queue<TexUploadBand> TexUploadBandQueue;
+typedef boost::shared_ptr<TexUploadBandQueue> TexUploadBandQueuePtr;
+
+class AVG_API TextureUploadThread: public WorkerThread<TextureUploadThread>
+{
+public:
+    TextureUploadThread(CQueue& cmdQ, TexUploadBandQueue& filledQueue);
+
+    void fillBand(TexUploadBandPtr pBand);
+
+private:
+    virtual bool work();
+
+    TexUploadBandQueue& m_FilledQueue;
+};
+
+}
+
+#endif
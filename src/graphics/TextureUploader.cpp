@@ -0,0 +1,298 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "TextureUploader.h"
+
+#include "GLContext.h"
+#include "GLTexture.h"
+#include "MCTexture.h"
+#include "Bitmap.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ScopeTimer.h"
+
+#include <boost/bind.hpp>
+
+#include <vector>
+
+using namespace std;
+
+namespace avg {
+
+TextureUploader::TextureUploader(unsigned frameBudget, unsigned numBuffers,
+        unsigned bandSize)
+    : m_FrameBudget(frameBudget),
+      m_BandSize(bandSize),
+      m_NumPendingUploads(0),
+      m_BytesTransferred(0)
+{
+    m_pContext = GLContext::getCurrent();
+    AVG_ASSERT(m_pContext->getMemoryMode() == MM_PBO);
+    m_BufferIDs.resize(numBuffers);
+    glproc::GenBuffers(numBuffers, &m_BufferIDs[0]);
+    GLContext::checkError("TextureUploader: GenBuffers()");
+    m_FreeBufferIDs = m_BufferIDs;
+
+    m_pCmdQueue = TextureUploadThread::CQueuePtr(new TextureUploadThread::CQueue);
+    m_pFilledQueue = TexUploadBandQueuePtr(new TexUploadBandQueue);
+    m_pThread = new boost::thread(TextureUploadThread(*m_pCmdQueue, *m_pFilledQueue));
+}
+
+TextureUploader::~TextureUploader()
+{
+    m_pCmdQueue->pushCmd(boost::bind(&TextureUploadThread::stop, _1));
+    m_pThread->join();
+    delete m_pThread;
+
+    // The buffers belong to the context. If it's already gone, so are they.
+    if (GLContext::getCurrent() == m_pContext) {
+#ifndef AVG_ENABLE_EGL
+        for (unsigned i=0; i<m_pBandsInFlight.size(); ++i) {
+            unsigned bufferID = m_pBandsInFlight[i]->m_BufferID;
+            if (bufferID != 0) {
+                glproc::BindBuffer(GL_PIXEL_UNPACK_BUFFER_EXT, bufferID);
+                glproc::UnmapBuffer(GL_PIXEL_UNPACK_BUFFER_EXT);
+            }
+        }
+        glproc::BindBuffer(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
+#endif
+        glproc::DeleteBuffers(m_BufferIDs.size(), &m_BufferIDs[0]);
+        GLContext::checkError("TextureUploader: DeleteBuffers()");
+    }
+}
+
+void TextureUploader::scheduleUpload(MCTexturePtr pTex, BitmapPtr pBmp)
+{
+    AVG_ASSERT(GLContext::getCurrent() == m_pContext);
+    AVG_ASSERT(pTex->getSize() == pBmp->getSize());
+    Upload upload;
+    upload.m_pTex = pTex;
+    upload.m_pBmp = pBmp;
+    upload.m_NextRow = 0;
+    m_Uploads.push_back(upload);
+    m_NumPendingUploads++;
+    pTex->setUploadPending(true);
+    // Start copying right away so the data is ready by the end of the frame.
+    dispatchBands();
+}
+
+static ProfilingZoneID TexUploadProfilingZone("Async texture upload");
+static ProfilingZoneID TexUploadBytesProfilingZone("Texture upload bytes");
+
+void TextureUploader::processUploads()
+{
+    ScopeTimer timer(TexUploadProfilingZone);
+    AVG_ASSERT(GLContext::getCurrent() == m_pContext);
+    receiveFilledBands(false);
+    m_BytesTransferred = transferBands(m_FrameBudget);
+    dispatchBands();
+    ScopeTimer::addToZone(TexUploadBytesProfilingZone, m_BytesTransferred);
+}
+
+static ProfilingZoneID TexUploadWaitProfilingZone("Wait for texture upload");
+
+void TextureUploader::finish()
+{
+    ScopeTimer timer(TexUploadWaitProfilingZone);
+    AVG_ASSERT(GLContext::getCurrent() == m_pContext);
+    while (!m_pBandsInFlight.empty()) {
+        if (!m_pBandsInFlight.front()->m_bFilled) {
+            receiveFilledBands(true);
+        }
+        transferBands(0);
+        dispatchBands();
+    }
+}
+
+GLContext* TextureUploader::getContext() const
+{
+    return m_pContext;
+}
+
+void TextureUploader::setFrameBudget(unsigned frameBudget)
+{
+    m_FrameBudget = frameBudget;
+}
+
+unsigned TextureUploader::getFrameBudget() const
+{
+    return m_FrameBudget;
+}
+
+int TextureUploader::getNumPendingUploads() const
+{
+    return m_NumPendingUploads;
+}
+
+unsigned TextureUploader::getBytesTransferred() const
+{
+    return m_BytesTransferred;
+}
+
+unsigned TextureUploader::transferBands(unsigned maxBytes)
+{
+    // Bands are transferred in the order they were dispatched, so later uploads to
+    // the same texture win. The first band always goes through, even if it's larger
+    // than the budget.
+    unsigned numBytes = 0;
+    while (!m_pBandsInFlight.empty() && m_pBandsInFlight.front()->m_bFilled) {
+        TexUploadBandPtr pBand = m_pBandsInFlight.front();
+        unsigned bandBytes = pBand->m_NumRows*pBand->m_DestStride;
+        if (maxBytes != 0 && numBytes > 0 && numBytes+bandBytes > maxBytes) {
+            break;
+        }
+        transferBand(pBand);
+        m_pBandsInFlight.pop_front();
+        numBytes += bandBytes;
+    }
+    return numBytes;
+}
+
+void TextureUploader::transferBand(TexUploadBandPtr pBand)
+{
+#ifndef AVG_ENABLE_EGL
+    MCTexturePtr pTex = pBand->m_pTex;
+    PixelFormat pf = pBand->m_DestPF;
+    vector<unsigned char> pixels;
+    if (pBand->m_BufferID == 0) {
+        // The buffer couldn't be mapped, so the band is copied and uploaded from
+        // client memory instead.
+        pixels.resize(pBand->m_DestStride*pBand->m_NumRows);
+        int width = pBand->m_pSrcBmp->getSize().x;
+        Bitmap srcBmp(*pBand->m_pSrcBmp, IntRect(0, pBand->m_StartRow, width,
+                pBand->m_StartRow+pBand->m_NumRows));
+        Bitmap destBmp(IntPoint(width, pBand->m_NumRows), pf, &pixels[0],
+                pBand->m_DestStride, false);
+        destBmp.copyPixels(srcBmp);
+    } else {
+        glproc::BindBuffer(GL_PIXEL_UNPACK_BUFFER_EXT, pBand->m_BufferID);
+        glproc::UnmapBuffer(GL_PIXEL_UNPACK_BUFFER_EXT);
+        GLContext::checkError("TextureUploader: UnmapBuffer()");
+    }
+    pTex->activate(GL_TEXTURE0);
+#ifdef __APPLE__
+    // See getStride()
+    if (pf == A8) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    } else {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+#endif
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, pBand->m_StartRow, pTex->getSize().x,
+            pBand->m_NumRows, GLTexture::getGLFormat(pf), GLTexture::getGLType(pf),
+            pixels.empty() ? 0 : &pixels[0]);
+    GLContext::checkError("TextureUploader: glTexSubImage2D()");
+    if (pBand->m_BufferID != 0) {
+        glproc::BindBuffer(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
+        m_FreeBufferIDs.push_back(pBand->m_BufferID);
+    }
+    if (pBand->m_bLastBand) {
+        pTex->generateMipmaps();
+        pTex->setUploadPending(false);
+        pTex->setDirty();
+        m_NumPendingUploads--;
+    }
+#else
+    AVG_ASSERT(false);
+#endif
+}
+
+void TextureUploader::dispatchBands()
+{
+#ifndef AVG_ENABLE_EGL
+    while (!m_Uploads.empty() && !m_FreeBufferIDs.empty()) {
+        Upload& upload = m_Uploads.front();
+        IntPoint size = upload.m_pBmp->getSize();
+        PixelFormat pf = upload.m_pTex->getPF();
+        int stride = getStride(size.x, pf);
+        unsigned maxBandBytes = m_BandSize;
+        if (m_FrameBudget != 0) {
+            maxBandBytes = min(maxBandBytes, m_FrameBudget);
+        }
+        int numRows = max(int(maxBandBytes/stride), 1);
+        numRows = min(numRows, size.y-upload.m_NextRow);
+
+        TexUploadBandPtr pBand(new TexUploadBand);
+        pBand->m_pSrcBmp = upload.m_pBmp;
+        pBand->m_StartRow = upload.m_NextRow;
+        pBand->m_NumRows = numRows;
+        pBand->m_DestPF = pf;
+        pBand->m_DestStride = stride;
+        pBand->m_pTex = upload.m_pTex;
+        pBand->m_BufferID = m_FreeBufferIDs.back();
+        pBand->m_bFilled = false;
+        m_FreeBufferIDs.pop_back();
+
+        // Respecifying the storage lets the driver hand out fresh memory instead of
+        // waiting until a previous transfer from the buffer has finished.
+        glproc::BindBuffer(GL_PIXEL_UNPACK_BUFFER_EXT, pBand->m_BufferID);
+        glproc::BufferData(GL_PIXEL_UNPACK_BUFFER_EXT, stride*numRows, 0,
+                GL_STREAM_DRAW);
+        GLContext::checkError("TextureUploader: BufferData()");
+        pBand->m_pDestPixels = (unsigned char *)glproc::MapBuffer(
+                GL_PIXEL_UNPACK_BUFFER_EXT, GL_WRITE_ONLY);
+        GLContext::checkError("TextureUploader: MapBuffer()");
+
+        upload.m_NextRow += numRows;
+        pBand->m_bLastBand = (upload.m_NextRow == size.y);
+        if (pBand->m_bLastBand) {
+            m_Uploads.pop_front();
+        }
+        m_pBandsInFlight.push_back(pBand);
+        if (pBand->m_pDestPixels) {
+            m_pCmdQueue->pushCmd(boost::bind(&TextureUploadThread::fillBand, _1,
+                    pBand));
+        } else {
+            // Can happen if the driver is out of memory. transferBand() then falls
+            // back to a synchronous upload.
+            AVG_LOG_WARNING("TextureUploader: MapBuffer() failed, uploading directly.");
+            m_FreeBufferIDs.push_back(pBand->m_BufferID);
+            pBand->m_BufferID = 0;
+            pBand->m_bFilled = true;
+        }
+    }
+    glproc::BindBuffer(GL_PIXEL_UNPACK_BUFFER_EXT, 0);
+#endif
+}
+
+void TextureUploader::receiveFilledBands(bool bBlock)
+{
+    TexUploadBandPtr pBand = m_pFilledQueue->pop(bBlock);
+    while (pBand) {
+        pBand->m_bFilled = true;
+        pBand = m_pFilledQueue->pop(false);
+    }
+}
+
+int TextureUploader::getStride(int width, PixelFormat pf) const
+{
+#ifdef __APPLE__
+    // Same workaround as in PBO::getStride(): Apple/NVidia drivers break A8 textures
+    // if GL_UNPACK_ALIGNMENT != 1.
+    if (pf == A8) {
+        return width;
+    }
+#endif
+    return Bitmap::getPreferredStride(width, pf);
+}
+
+}
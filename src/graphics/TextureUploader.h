@@ -0,0 +1,95 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _TextureUploader_H_
+#define _TextureUploader_H_
+
+#include "../api.h"
+#include "TextureUploadThread.h"
+
+#include <boost/thread.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace avg {
+
+class GLContext;
+
+// Streams bitmaps into textures without stalling the main thread. Uploads are split
+// into bands of rows. For each band, the main thread maps a pixel buffer object from
+// a small ring and a TextureUploadThread copies (and converts, if necessary) the
+// pixels into it. processUploads() unmaps filled buffers and transfers them to their
+// textures using glTexSubImage2D. It moves at most frameBudget bytes per call
+// (0 means no limit), so large bitmaps are spread over several frames. Textures are
+// marked as upload pending until their last band has arrived.
+//
+// Needs pixel buffer objects and a single GL context.
+class AVG_API TextureUploader: boost::noncopyable
+{
+public:
+    TextureUploader(unsigned frameBudget, unsigned numBuffers=4,
+            unsigned bandSize=1024*1024);
+    virtual ~TextureUploader();
+
+    void scheduleUpload(MCTexturePtr pTex, BitmapPtr pBmp);
+    void processUploads();
+    void finish();
+
+    GLContext* getContext() const;
+    void setFrameBudget(unsigned frameBudget);
+    unsigned getFrameBudget() const;
+    int getNumPendingUploads() const;
+    unsigned getBytesTransferred() const;
+
+private:
+    struct Upload {
+        MCTexturePtr m_pTex;
+        BitmapPtr m_pBmp;
+        int m_NextRow;
+    };
+
+    unsigned transferBands(unsigned maxBytes);
+    void transferBand(TexUploadBandPtr pBand);
+    void dispatchBands();
+    void receiveFilledBands(bool bBlock);
+    int getStride(int width, PixelFormat pf) const;
+
+    GLContext* m_pContext;
+    unsigned m_FrameBudget;
+    unsigned m_BandSize;
+    std::vector<unsigned> m_BufferIDs;
+    std::vector<unsigned> m_FreeBufferIDs;
+
+    std::deque<Upload> m_Uploads;
+    std::deque<TexUploadBandPtr> m_pBandsInFlight;
+    int m_NumPendingUploads;
+    unsigned m_BytesTransferred;
+
+    TextureUploadThread::CQueuePtr m_pCmdQueue;
+    TexUploadBandQueuePtr m_pFilledQueue;
+    boost::thread* m_pThread;
+};
+
+}
+
+#endif
@@ -5,9 +5,12 @@
 #define _TwoPassScale_h_
 
 #include "ContribDefs.h"
+#include "ParallelRows.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <math.h>
 #include <algorithm>
 #include <cstring>
@@ -129,7 +132,7 @@ private:
     LineContribType *CalcContributions (unsigned    uLineSize,
                                         unsigned    uSrcSize);
 
-    void ScaleRow(PixelClass *pSrc, int uSrcWidth, PixelClass *pDest, int uResWidth, 
+    void ScaleRow(PixelClass *pSrc, PixelClass *pDest, int uResWidth, 
             LineContribType *pContrib);
 
     void HorizScale(PixelClass * pSrcData, const IntPoint& srcSize, int srcStride, 
@@ -138,6 +141,14 @@ private:
     void VertScale(PixelClass *pSrcData, const IntPoint& srcSize, int srcStride,
             PixelClass *pDestData, const IntPoint& destSize, int destStride);
 
+    // Row bands of the two passes, run in parallel.
+    void HorizScaleRows(PixelClass * pSrcData, int srcStride, PixelClass *pDestData,
+            const IntPoint& destSize, int destStride, LineContribType * pContrib,
+            int startRow, int endRow);
+    void VertScaleRows(PixelClass * pSrcData, int srcStride, PixelClass *pDestData,
+            const IntPoint& destSize, int destStride, LineContribType * pContrib,
+            int startRow, int endRow);
+
     const ContribDef& m_ContribDef;
 };
 
@@ -242,8 +253,8 @@ TwoPassScale<DataClass>::CalcContributions(unsigned uLineSize, unsigned uSrcSize
 
 template <class DataClass>
 void
-TwoPassScale<DataClass>::ScaleRow(PixelClass *pSrc, int uSrcWidth,
-        PixelClass *pDest, int uResWidth, LineContribType *pContrib)
+TwoPassScale<DataClass>::ScaleRow(PixelClass *pSrc, PixelClass *pDest,
+        int uResWidth, LineContribType *pContrib)
 {
     PixelClass * pDestPixel = pDest;
     for (int x = 0; x < uResWidth; x++) {
@@ -276,15 +287,27 @@ void TwoPassScale<DataClass>::HorizScale(PixelClass * pSrcData, const IntPoint&
         }
     } else {
         LineContribType * pContrib = CalcContributions(destSize.x, srcSize.x);
-        for (int y = 0; y < destSize.y; y++) {
-            ScaleRow(pSrc, srcSize.x, pDest, destSize.x, pContrib);
-            pSrc = (PixelClass*)((char*)(pSrc)+srcStride);
-            pDest = (PixelClass*)((char*)(pDest)+destStride);
-        }
+        processRowBands(destSize.y, destSize.x, 0, 
+                boost::bind(&TwoPassScale<DataClass>::HorizScaleRows, this, pSrcData,
+                        srcStride, pDestData, destSize, destStride, pContrib, _1, _2));
         FreeContributions(pContrib);  // Free contributions structure
     }
 }
 
+template <class DataClass>
+void TwoPassScale<DataClass>::HorizScaleRows(PixelClass * pSrcData, int srcStride,
+        PixelClass *pDestData, const IntPoint& destSize, int destStride,
+        LineContribType * pContrib, int startRow, int endRow)
+{
+    PixelClass * pSrc = (PixelClass*)((char*)(pSrcData)+size_t(startRow)*srcStride);
+    PixelClass * pDest = (PixelClass*)((char*)(pDestData)+size_t(startRow)*destStride);
+    for (int y = startRow; y < endRow; y++) {
+        ScaleRow(pSrc, pDest, destSize.x, pContrib);
+        pSrc = (PixelClass*)((char*)(pSrc)+srcStride);
+        pDest = (PixelClass*)((char*)(pDest)+destStride);
+    }
+}
+
 
 template <class DataClass>
 void TwoPassScale<DataClass>::VertScale(PixelClass *pSrcData, const IntPoint& srcSize,
@@ -301,31 +324,43 @@ void TwoPassScale<DataClass>::VertScale(PixelClass *pSrcData, const IntPoint& sr
         }
     } else {
         LineContribType * pContrib = CalcContributions(destSize.y, srcSize.y);
-        for (int y = 0; y < destSize.y; y++) {
-            PixelClass * pDestPixel = pDest;
-            int * pWeights = pContrib->ContribRow[y].Weights;
-            int iLeft = pContrib->ContribRow[y].Left;
-            int iRight = pContrib->ContribRow[y].Right;
-            PixelClass* pSrcPixelBase = (PixelClass*)((char*)(pSrc)
-                    + size_t(iLeft)*srcStride);
-            for (int x = 0; x < destSize.x; x++) {
-                typename DataClass::_Accumulator a;
-                int * pWeight = pWeights;
-                PixelClass * pSrcPixel = pSrcPixelBase;
-                pSrcPixelBase++;
-                for (int i = iLeft; i <= iRight; i++) {
-                    // Scan between boundries
-                    // Accumulate weighted effect of each neighboring pixel
-                    a.Accumulate(*pWeight, *pSrcPixel);
-                    pWeight++;
-                    pSrcPixel = (PixelClass*)((char*)(pSrcPixel)+srcStride);
-                }
-                a.Store(pDestPixel);
-                pDestPixel++;
+        processRowBands(destSize.y, destSize.x, pContrib->WindowSize/2,
+                boost::bind(&TwoPassScale<DataClass>::VertScaleRows, this, pSrcData,
+                        srcStride, pDestData, destSize, destStride, pContrib, _1, _2));
+        FreeContributions(pContrib);     // Free contributions structure
+    }
+}
+
+template <class DataClass>
+void TwoPassScale<DataClass>::VertScaleRows(PixelClass * pSrcData, int srcStride,
+        PixelClass *pDestData, const IntPoint& destSize, int destStride,
+        LineContribType * pContrib, int startRow, int endRow)
+{
+    PixelClass * pSrc = pSrcData;
+    PixelClass * pDest = (PixelClass*)((char*)(pDestData)+size_t(startRow)*destStride);
+    for (int y = startRow; y < endRow; y++) {
+        PixelClass * pDestPixel = pDest;
+        int * pWeights = pContrib->ContribRow[y].Weights;
+        int iLeft = pContrib->ContribRow[y].Left;
+        int iRight = pContrib->ContribRow[y].Right;
+        PixelClass* pSrcPixelBase = (PixelClass*)((char*)(pSrc)
+                + size_t(iLeft)*srcStride);
+        for (int x = 0; x < destSize.x; x++) {
+            typename DataClass::_Accumulator a;
+            int * pWeight = pWeights;
+            PixelClass * pSrcPixel = pSrcPixelBase;
+            pSrcPixelBase++;
+            for (int i = iLeft; i <= iRight; i++) {
+                // Scan between boundries
+                // Accumulate weighted effect of each neighboring pixel
+                a.Accumulate(*pWeight, *pSrcPixel);
+                pWeight++;
+                pSrcPixel = (PixelClass*)((char*)(pSrcPixel)+srcStride);
             }
-            pDest = (PixelClass*)((char*)(pDest)+destStride);
+            a.Store(pDestPixel);
+            pDestPixel++;
         }
-        FreeContributions(pContrib);     // Free contributions structure
+        pDest = (PixelClass*)((char*)(pDest)+destStride);
     }
 }
 
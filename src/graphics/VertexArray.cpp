@@ -73,6 +73,7 @@ void VertexArray::update()
     AVG_ASSERT(!m_VertexBufferIDMap.empty());
     if (hasDataChanged()) {
         GLContext* pContext = GLContext::getCurrent();
+        pContext->stateChanged();
         unsigned vertexBufferID = m_VertexBufferIDMap[pContext];
         transferBuffer(GL_ARRAY_BUFFER, vertexBufferID, 
                 getReserveVerts()*sizeof(Vertex), 
@@ -95,6 +96,7 @@ void VertexArray::activate()
 {
     AVG_ASSERT(!m_VertexBufferIDMap.empty());
     GLContext* pContext = GLContext::getCurrent();
+    pContext->stateChanged();
     unsigned vertexBufferID = m_VertexBufferIDMap[pContext];
     unsigned indexBufferID = m_IndexBufferIDMap[pContext];
     glproc::BindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
@@ -115,24 +117,13 @@ void VertexArray::draw()
 {
     update();
     activate();
-#ifdef AVG_ENABLE_EGL        
-    glDrawElements(GL_TRIANGLES, getNumIndexes(), GL_UNSIGNED_SHORT, 0);
-#else
-    glDrawElements(GL_TRIANGLES, getNumIndexes(), GL_UNSIGNED_INT, 0);
-#endif
-    GLContext::checkError("VertexArray::draw()");
+    draw(0, getNumIndexes(), 0, getNumVerts());
 }
 
 void VertexArray::draw(unsigned startIndex, unsigned numIndexes, unsigned startVertex,
         unsigned numVertexes)
 {
-#ifdef AVG_ENABLE_EGL        
-    glDrawElements(GL_TRIANGLES, numIndexes, GL_UNSIGNED_SHORT, 
-            (void *)(startIndex*sizeof(unsigned short)));
-#else
-    glDrawElements(GL_TRIANGLES, numIndexes, GL_UNSIGNED_INT, 
-            (void *)(startIndex*sizeof(unsigned int)));
-#endif
+    GLContext::getCurrent()->drawElements(startIndex, numIndexes);
 //    XXX: Theoretically faster, but broken on Linux/Intel N10 graphics, Ubuntu 12/04
 //    glproc::DrawRangeElements(GL_TRIANGLES, startVertex, startVertex+numVertexes, 
 //            numIndexes, GL_UNSIGNED_SHORT, (void *)(startIndex*sizeof(unsigned short)));
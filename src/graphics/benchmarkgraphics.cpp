@@ -37,10 +37,20 @@
 #include "FilterGauss.h"
 #include "FilterBlur.h"
 #include "FilterBandpass.h"
+#include "SIMDConversion.h"
+#include "FilterResizeBilinear.h"
+#include "FilterFastBandpass.h"
+#include "FilterDilation.h"
+#include "FilterErosion.h"
+#include "FilterThreshold.h"
+#include "FilterChain.h"
 
 #include "../base/TimeSource.h"
+#include "../base/ThreadPool.h"
 
 #include <iostream>
+#include <sstream>
+#include <cstring>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -48,9 +58,8 @@ using namespace avg;
 using namespace std;
 
 template<class TEST>
-void runPerformanceTest(int numRuns=500)
+void runPerformanceTest(TEST& PerfTest, int numRuns=500)
 {
-    TEST PerfTest;
     long long StartTime = TimeSource::get()->getCurrentMicrosecs();
     for (int i = 0; i < numRuns; ++i) {
         PerfTest.run();
@@ -60,6 +69,13 @@ void runPerformanceTest(int numRuns=500)
     
 }
 
+template<class TEST>
+void runPerformanceTest(int numRuns=500)
+{
+    TEST PerfTest;
+    runPerformanceTest(PerfTest, numRuns);
+}
+
 class PerfTestBase {
 public:
     PerfTestBase(string sName) 
@@ -234,6 +250,179 @@ private:
         
 };
 
+class ConversionPerfTest: public PerfTestBase {
+public:
+    ConversionPerfTest(PixelFormat srcPF, PixelFormat destPF, const IntPoint& size,
+            SIMDLevel level)
+        : PerfTestBase(getTestName(getPixelFormatString(srcPF)+"->"+
+                getPixelFormatString(destPF), size, level)),
+          m_Level(level)
+    {
+        m_pSrcBmp = BitmapPtr(new Bitmap(size, srcPF));
+        m_pDestBmp = BitmapPtr(new Bitmap(size, destPF));
+        memset(m_pSrcBmp->getPixels(), 128, m_pSrcBmp->getMemNeeded());
+    }
+
+    void run()
+    {
+        setSIMDLevel(m_Level);
+        m_pDestBmp->copyPixels(*m_pSrcBmp);
+    }
+
+    static string getTestName(const string& sConversion, const IntPoint& size,
+            SIMDLevel level)
+    {
+        stringstream ss;
+        ss << "ConversionPerfTest (" << sConversion << ", " << size << ", " <<
+                getSIMDLevelName(level) << ")";
+        return ss.str();
+    }
+
+private:
+    BitmapPtr m_pSrcBmp;
+    BitmapPtr m_pDestBmp;
+    SIMDLevel m_Level;
+};
+
+class YUV420ConversionPerfTest: public PerfTestBase {
+public:
+    YUV420ConversionPerfTest(const IntPoint& size, SIMDLevel level)
+        : PerfTestBase(ConversionPerfTest::getTestName("YUV420->B8G8R8X8", size, level)),
+          m_Level(level)
+    {
+        m_pYBmp = BitmapPtr(new Bitmap(size, I8));
+        m_pUBmp = BitmapPtr(new Bitmap(size/2, I8));
+        m_pVBmp = BitmapPtr(new Bitmap(size/2, I8));
+        m_pDestBmp = BitmapPtr(new Bitmap(size, B8G8R8X8));
+    }
+
+    void run()
+    {
+        setSIMDLevel(m_Level);
+        m_pDestBmp->copyYUVPixels(*m_pYBmp, *m_pUBmp, *m_pVBmp, false);
+    }
+
+private:
+    BitmapPtr m_pYBmp;
+    BitmapPtr m_pUBmp;
+    BitmapPtr m_pVBmp;
+    BitmapPtr m_pDestBmp;
+    SIMDLevel m_Level;
+};
+
+void runConversionPerfTests(const IntPoint& size, SIMDLevel level)
+{
+    int numRuns = max(10, 200*640*480/(size.x*size.y));
+    PixelFormat conversions[][2] = {
+            {YCbCr422, B8G8R8X8},
+            {YUYV422, B8G8R8X8},
+            {YCbCr422, I8},
+            {YUYV422, I8},
+            {I8, B8G8R8X8},
+            {I8, B8G8R8},
+            {R8G8B8A8, R32G32B32A32F},
+            {BAYER8_GBRG, B8G8R8X8}
+        };
+    for (unsigned i = 0; i < sizeof(conversions)/sizeof(conversions[0]); ++i) {
+        ConversionPerfTest test(conversions[i][0], conversions[i][1], size, level);
+        runPerformanceTest(test, numRuns);
+    }
+    YUV420ConversionPerfTest test(size, level);
+    runPerformanceTest(test, numRuns);
+}
+
+class FilterPerfTest: public PerfTestBase {
+public:
+    FilterPerfTest(const string& sFilterName, FilterPtr pFilter, PixelFormat pf,
+            const IntPoint& size, int numThreads)
+        : PerfTestBase(getTestName(sFilterName, size, numThreads)),
+          m_pFilter(pFilter)
+    {
+        m_pSrcBmp = BitmapPtr(new Bitmap(size, pf));
+        memset(m_pSrcBmp->getPixels(), 128, m_pSrcBmp->getMemNeeded());
+    }
+
+    void run()
+    {
+        m_pFilter->apply(m_pSrcBmp);
+    }
+
+private:
+    static string getTestName(const string& sFilterName, const IntPoint& size,
+            int numThreads)
+    {
+        stringstream ss;
+        ss << "FilterPerfTest (" << sFilterName << ", " << size << ", " << numThreads
+                << " threads)";
+        return ss.str();
+    }
+
+    FilterPtr m_pFilter;
+    BitmapPtr m_pSrcBmp;
+};
+
+void runFilterPerfTests(const IntPoint& size, int numThreads)
+{
+    int numRuns = max(10, 100*640*480/(size.x*size.y));
+    ThreadPool::get()->setNumThreads(numThreads);
+    FilterPerfTest gaussTest("Gauss", FilterPtr(new FilterGauss(3)), I8, size,
+            numThreads);
+    runPerformanceTest(gaussTest, numRuns);
+    FilterPerfTest blurTest("Blur", FilterPtr(new FilterBlur()), I8, size, numThreads);
+    runPerformanceTest(blurTest, numRuns);
+    FilterPerfTest highpassTest("Highpass", FilterPtr(new FilterHighpass()), I8, size,
+            numThreads);
+    runPerformanceTest(highpassTest, numRuns);
+    FilterPerfTest resizeTest("ResizeBilinear",
+            FilterPtr(new FilterResizeBilinear(size/2)), R8G8B8A8, size, numThreads);
+    runPerformanceTest(resizeTest, numRuns);
+}
+
+class FilterChainPerfTest: public PerfTestBase {
+public:
+    FilterChainPerfTest(const IntPoint& size, bool bFused)
+        : PerfTestBase(getTestName(size, bFused)),
+          m_bFused(bFused)
+    {
+        m_pSrcBmp = BitmapPtr(new Bitmap(size, I8));
+        memset(m_pSrcBmp->getPixels(), 128, m_pSrcBmp->getMemNeeded());
+        m_pFilters.push_back(FilterPtr(new HistoryPreProcessor(size, 1, true)));
+        m_pFilters.push_back(FilterPtr(new FilterFastBandpass()));
+        m_pFilters.push_back(FilterPtr(new FilterDilation()));
+        m_pFilters.push_back(FilterPtr(new FilterErosion()));
+        m_pFilters.push_back(FilterPtr(new FilterThreshold(128)));
+        for (unsigned i = 0; i < m_pFilters.size(); ++i) {
+            m_Chain.addFilter(m_pFilters[i]);
+        }
+    }
+
+    void run()
+    {
+        if (m_bFused) {
+            m_Chain.apply(m_pSrcBmp);
+        } else {
+            BitmapPtr pBmp = m_pSrcBmp;
+            for (unsigned i = 0; i < m_pFilters.size(); ++i) {
+                pBmp = m_pFilters[i]->apply(pBmp);
+            }
+        }
+    }
+
+private:
+    static string getTestName(const IntPoint& size, bool bFused)
+    {
+        stringstream ss;
+        ss << "FilterChainPerfTest (" << size << ", " << 
+                (bFused ? "fused" : "separate") << ")";
+        return ss.str();
+    }
+
+    BitmapPtr m_pSrcBmp;
+    vector<FilterPtr> m_pFilters;
+    FilterChain m_Chain;
+    bool m_bFused;
+};
+
 void runPerformanceTests()
 {
     runPerformanceTest<LoadPNGPerfTest>();
@@ -245,6 +434,33 @@ void runPerformanceTests()
     runPerformanceTest<CopyRGBPerfTest>();
     runPerformanceTest<CopyRGBAPerfTest>();
     runPerformanceTest<YUV2RGBPerfTest>(200);
+
+    // Pixel format conversions, scalar vs. best SIMD version.
+    IntPoint sizes[] = {IntPoint(640, 480), IntPoint(1920, 1080), IntPoint(3840, 2160)};
+    for (int i = 0; i < 3; ++i) {
+        runConversionPerfTests(sizes[i], SIMD_NONE);
+        runConversionPerfTests(sizes[i], getMaxSIMDLevel());
+    }
+    setSIMDLevel(getMaxSIMDLevel());
+
+    // Row-parallel filters, scaling with the number of threads.
+    int oldNumThreads = ThreadPool::get()->getNumThreads();
+    for (int i = 0; i < 2; ++i) {
+        for (int numThreads = 1; numThreads <= 8; numThreads *= 2) {
+            runFilterPerfTests(sizes[i], numThreads);
+        }
+    }
+
+    // History -> bandpass -> dilation -> erosion -> threshold, separate vs. fused.
+    ThreadPool::get()->setNumThreads(1);
+    for (int i = 0; i < 3; ++i) {
+        int numRuns = max(10, 100*640*480/(sizes[i].x*sizes[i].y));
+        FilterChainPerfTest separateTest(sizes[i], false);
+        runPerformanceTest(separateTest, numRuns);
+        FilterChainPerfTest fusedTest(sizes[i], true);
+        runPerformanceTest(fusedTest, numRuns);
+    }
+    ThreadPool::get()->setNumThreads(oldNumThreads);
 }
 
 int main(int nargs, char** args)
@@ -34,12 +34,16 @@
 #include "GLContextManager.h"
 #include "ShaderRegistry.h"
 #include "BmpTextureMover.h"
+#include "TextureAtlas.h"
+#include "TextureUploader.h"
+#include "MCTexture.h"
 #include "PBO.h"
 
 #include "../base/TestSuite.h"
 #include "../base/Exception.h"
 #include "../base/Test.h"
 #include "../base/StringHelper.h"
+#include "../base/TimeSource.h"
 
 #include <math.h>
 #include <iostream>
@@ -429,12 +433,129 @@ private:
 };
 
 
+class TextureAtlasTest: public GraphicsTest {
+public:
+    TextureAtlasTest()
+        : GraphicsTest("TextureAtlasTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        TextureAtlas atlas(IntPoint(256, 256), 128, 1);
+        BitmapPtr pBmp1 = loadTestBmp("rgb24alpha-64x64");
+        BitmapPtr pBmp2 = loadTestBmp("rgb24-65x65", pBmp1->getPixelFormat());
+        TEST(!atlas.canHold(IntPoint(129, 10), pBmp1->getPixelFormat()));
+        TEST(!atlas.canHold(IntPoint(10, 10), I8));
+
+        AtlasRegionPtr pRegion1 = atlas.insert(pBmp1);
+        AtlasRegionPtr pRegion2 = atlas.insert(pBmp2);
+        TEST(pRegion1 && pRegion2);
+        TEST(pRegion1->getTex() == pRegion2->getTex());
+        TEST(atlas.getNumRegions() == 2);
+        TEST(atlas.getNumPages() == 1);
+        GLContextManager::get()->uploadData();
+        testRegion(pRegion1, pBmp1, "atlas1");
+        testRegion(pRegion2, pBmp2, "atlas2");
+
+        // The single page is full after a few more bitmaps.
+        vector<AtlasRegionPtr> pRegions;
+        AtlasRegionPtr pRegion;
+        do {
+            pRegion = atlas.insert(pBmp1);
+            if (pRegion) {
+                pRegions.push_back(pRegion);
+            }
+        } while (pRegion);
+        TEST(atlas.getOccupancy() > 0.5);
+        
+        // Freed space is reused and regions can be updated in place.
+        pRegions.clear();
+        pRegion1 = AtlasRegionPtr();
+        pRegion = atlas.insert(pBmp1);
+        TEST(pRegion);
+        pRegion2->setBitmap(pBmp2);
+        GLContextManager::get()->uploadData();
+        testRegion(pRegion, pBmp1, "atlas3");
+        testRegion(pRegion2, pBmp2, "atlas4");
+    }
+
+private:
+    void testRegion(AtlasRegionPtr pRegion, BitmapPtr pOrigBmp, const string& sName)
+    {
+        BitmapPtr pPageBmp = pRegion->getTex()->moveTextureToBmp();
+        FRect texRect = pRegion->getTexCoordRect();
+        glm::vec2 pageSize(pPageBmp->getSize());
+        IntRect rect(IntPoint(texRect.tl*pageSize+0.5f), 
+                IntPoint(texRect.br*pageSize+0.5f));
+        TEST(rect.size() == pOrigBmp->getSize());
+        Bitmap regionBmp(*pPageBmp, rect);
+        testEqual(regionBmp, *pOrigBmp, sName, 0.01, 0.1);
+    }
+};
+
+
+class TextureUploaderTest: public GraphicsTest {
+public:
+    TextureUploaderTest()
+        : GraphicsTest("TextureUploaderTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        BitmapPtr pOrigBmp = loadTestBmp("rgb24alpha-64x64");
+        int stride = pOrigBmp->getStride();
+        GLContextManager* pCM = GLContextManager::get();
+        // Bands of 16 lines, at most two bands per frame.
+        TextureUploader uploader(32*stride, 2, 16*stride);
+        {
+            MCTexturePtr pTex = pCM->createTexture(pOrigBmp->getSize(),
+                    pOrigBmp->getPixelFormat());
+            pCM->uploadData();
+            uploader.scheduleUpload(pTex, pOrigBmp);
+            TEST(pTex->isUploadPending());
+            TEST(uploader.getNumPendingUploads() == 1);
+            int numFrames = 0;
+            while (pTex->isUploadPending() && numFrames < 1000) {
+                msleep(1);
+                uploader.processUploads();
+                TEST(uploader.getBytesTransferred() <= unsigned(32*stride));
+                numFrames++;
+            }
+            TEST(numFrames >= 2);
+            TEST(uploader.getNumPendingUploads() == 0);
+            BitmapPtr pDestBmp = pTex->moveTextureToBmp();
+            testEqual(*pDestBmp, *pOrigBmp, "uploader-frames", 0.01, 0.1);
+        }
+        {
+            // Pixel format conversion in the worker thread and finish().
+            BitmapPtr pRGBBmp = loadTestBmp("rgb24-64x64");
+            PixelFormat destPF = pOrigBmp->getPixelFormat();
+            MCTexturePtr pTex = pCM->createTexture(pRGBBmp->getSize(), destPF);
+            pCM->uploadData();
+            uploader.scheduleUpload(pTex, pRGBBmp);
+            uploader.finish();
+            TEST(!pTex->isUploadPending());
+            BitmapPtr pBaselineBmp(new Bitmap(pRGBBmp->getSize(), destPF));
+            pBaselineBmp->copyPixels(*pRGBBmp);
+            BitmapPtr pDestBmp = pTex->moveTextureToBmp();
+            testEqual(*pDestBmp, *pBaselineBmp, "uploader-convert", 0.01, 0.1);
+        }
+    }
+};
+
+
 class GPUTestSuite: public TestSuite {
 public:
     GPUTestSuite(const string& sVariant) 
         : TestSuite("GPUTestSuite ("+sVariant+")")
     {
         addTest(TestPtr(new TextureMoverTest));
+        addTest(TestPtr(new TextureAtlasTest));
+        if (GLContext::getCurrent()->getMemoryMode() == MM_PBO) {
+            addTest(TestPtr(new TextureUploaderTest));
+        }
         addTest(TestPtr(new BrightnessFilterTest));
         addTest(TestPtr(new HueSatFilterTest));
         addTest(TestPtr(new InvertFilterTest));
@@ -21,6 +21,7 @@
 
 #include "GraphicsTest.h"
 #include "Bitmap.h"
+#include "BitmapPool.h"
 #include "BitmapLoader.h"
 #include "Pixel32.h"
 #include "Pixel24.h"
@@ -47,11 +48,16 @@
 #include "FilterErosion.h"
 #include "FilterGetAlpha.h"
 #include "FilterResizeBilinear.h"
+#include "FilterResizeGaussian.h"
 #include "FilterUnmultiplyAlpha.h"
+#include "FilterChain.h"
+#include "SIMDConversion.h"
+#include "ShelfPacker.h"
 
 #include "../base/TestSuite.h"
 #include "../base/Exception.h"
 #include "../base/MathHelper.h"
+#include "../base/ThreadPool.h"
 
 #ifdef _WIN32
 #pragma warning(push)
@@ -102,6 +108,18 @@ BitmapPtr initBmp(PixelFormat pf)
     return pBmp;
 }
 
+BitmapPtr createRandomBmp(const IntPoint& size, PixelFormat pf)
+{
+    BitmapPtr pBmp(new Bitmap(size, pf));
+    for (int y = 0; y < size.y; ++y) {
+        unsigned char * pLine = pBmp->getPixels()+y*pBmp->getStride();
+        for (int x = 0; x < pBmp->getLineLen(); ++x) {
+            pLine[x] = rand() % 256;
+        }
+    }
+    return pBmp;
+}
+
 // TODO: This is very incomplete!
 class PixelTest: public GraphicsTest {
 public:
@@ -402,6 +420,163 @@ private:
 
 };
 
+class BitmapPoolTest: public GraphicsTest {
+public:
+    BitmapPoolTest()
+      : GraphicsTest("BitmapPoolTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        BitmapPool* pPool = BitmapPool::get();
+        size_t oldMaxBytes = pPool->getMaxResidentBytes();
+        pPool->clear();
+        pPool->setMaxResidentBytes(64*64*4*2);
+        TEST(pPool->getResidentBytes() == 0);
+        long long numHits = pPool->getNumHits();
+        long long numMisses = pPool->getNumMisses();
+        {
+            Bitmap bmp(IntPoint(64, 64), R8G8B8X8);
+        }
+        TEST(pPool->getNumMisses() == numMisses+1);
+        TEST(pPool->getResidentBytes() == 64*64*4);
+        {
+            // Same size: Should reuse the buffer.
+            Bitmap bmp(IntPoint(64, 64), R8G8B8X8);
+            TEST(pPool->getNumHits() == numHits+1);
+            TEST(pPool->getResidentBytes() == 0);
+            FilterFill<Pixel32>(Pixel32(1,2,3,4)).applyInPlace(
+                    BitmapPtr(new Bitmap(bmp, false)));
+            Bitmap copyBmp(bmp);
+            TEST(copyBmp == bmp);
+        }
+        TEST(pPool->getResidentBytes() == 64*64*4*2);
+        {
+            // Over the high-water mark: Buffer isn't kept.
+            Bitmap bmp(IntPoint(32, 32), I8);
+        }
+        TEST(pPool->getResidentBytes() == 64*64*4*2);
+        pPool->setMaxResidentBytes(64*64*4);
+        TEST(pPool->getResidentBytes() == 64*64*4);
+        pPool->clear();
+        TEST(pPool->getResidentBytes() == 0);
+        pPool->setMaxResidentBytes(oldMaxBytes);
+    }
+};
+
+class SIMDConversionTest: public GraphicsTest {
+public:
+    SIMDConversionTest()
+      : GraphicsTest("SIMDConversionTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        SIMDLevel maxLevel = getMaxSIMDLevel();
+        cerr << "    Max. SIMD level: " << getSIMDLevelName(maxLevel) << endl;
+        // Line lengths that aren't multiples of the vector size make sure the scalar
+        // code takes over at the right place. YCbCr formats need even sizes.
+        IntPoint sizes[] = {IntPoint(2, 2), IntPoint(38, 4), IntPoint(70, 2),
+                IntPoint(642, 2)};
+        for (int i = SIMD_SSE2; i <= maxLevel; ++i) {
+            SIMDLevel level = SIMDLevel(i);
+            cerr << "    Testing " << getSIMDLevelName(level) << endl;
+            for (unsigned j = 0; j < sizeof(sizes)/sizeof(IntPoint); ++j) {
+                testConversion(level, sizes[j], YCbCr422, B8G8R8X8);
+                testConversion(level, sizes[j], YUYV422, B8G8R8X8);
+                testConversion(level, sizes[j], YCbCr422, I8);
+                testConversion(level, sizes[j], YUYV422, I8);
+                testConversion(level, sizes[j], I8, R8G8B8A8);
+                testConversion(level, sizes[j], I8, R8G8B8);
+                testFloatConversion(level, sizes[j]);
+                testYUV420Conversion(level, sizes[j], false);
+                testYUV420Conversion(level, sizes[j], true);
+            }
+            // Bayer demosaicing skips the outermost pixels and needs three lines.
+            IntPoint bayerSizes[] = {IntPoint(3, 3), IntPoint(38, 5), IntPoint(71, 4),
+                    IntPoint(642, 6)};
+            PixelFormat bayerPFs[] = {BAYER8_RGGB, BAYER8_GBRG, BAYER8_GRBG,
+                    BAYER8_BGGR};
+            for (unsigned j = 0; j < sizeof(bayerSizes)/sizeof(IntPoint); ++j) {
+                for (unsigned k = 0; k < sizeof(bayerPFs)/sizeof(PixelFormat); ++k) {
+                    testBayerConversion(level, bayerSizes[j], bayerPFs[k]);
+                }
+            }
+        }
+        setSIMDLevel(maxLevel);
+    }
+
+private:
+    void testConversion(SIMDLevel level, const IntPoint& size, PixelFormat srcPF,
+            PixelFormat destPF)
+    {
+        BitmapPtr pSrcBmp = createRandomBmp(size, srcPF);
+        Bitmap scalarBmp(size, destPF);
+        setSIMDLevel(SIMD_NONE);
+        scalarBmp.copyPixels(*pSrcBmp);
+        Bitmap simdBmp(size, destPF);
+        setSIMDLevel(level);
+        simdBmp.copyPixels(*pSrcBmp);
+        TEST(simdBmp == scalarBmp);
+    }
+
+    void testBayerConversion(SIMDLevel level, const IntPoint& size, PixelFormat srcPF)
+    {
+        BitmapPtr pSrcBmp = createRandomBmp(size, srcPF);
+        Bitmap scalarBmp(size, B8G8R8X8);
+        memset(scalarBmp.getPixels(), 0, scalarBmp.getMemNeeded());
+        setSIMDLevel(SIMD_NONE);
+        scalarBmp.copyPixels(*pSrcBmp);
+        Bitmap simdBmp(size, B8G8R8X8);
+        memset(simdBmp.getPixels(), 0, simdBmp.getMemNeeded());
+        setSIMDLevel(level);
+        simdBmp.copyPixels(*pSrcBmp);
+        TEST(simdBmp == scalarBmp);
+    }
+
+    void testFloatConversion(SIMDLevel level, const IntPoint& size)
+    {
+        BitmapPtr pSrcBmp = createRandomBmp(size, R8G8B8A8);
+        Bitmap scalarBmp(size, R32G32B32A32F);
+        setSIMDLevel(SIMD_NONE);
+        scalarBmp.copyPixels(*pSrcBmp);
+        Bitmap simdBmp(size, R32G32B32A32F);
+        setSIMDLevel(level);
+        simdBmp.copyPixels(*pSrcBmp);
+        bool bOK = true;
+        for (int y = 0; y < size.y; ++y) {
+            const float * pScalar = (const float*)(scalarBmp.getPixels()+
+                    y*scalarBmp.getStride());
+            const float * pSIMD = (const float*)(simdBmp.getPixels()+y*simdBmp.getStride());
+            for (int x = 0; x < size.x*4; ++x) {
+                if (fabs(pScalar[x]-pSIMD[x]) > 1e-6) {
+                    bOK = false;
+                }
+            }
+        }
+        TEST(bOK);
+    }
+
+    void testYUV420Conversion(SIMDLevel level, IntPoint size, bool bJPEG)
+    {
+        // The mmx code always writes multiples of eight pixels.
+        size.x = (size.x+7)/8*8;
+        IntPoint chromaSize((size.x+1)/2, (size.y+1)/2);
+        BitmapPtr pYBmp = createRandomBmp(size, I8);
+        BitmapPtr pUBmp = createRandomBmp(chromaSize, I8);
+        BitmapPtr pVBmp = createRandomBmp(chromaSize, I8);
+        Bitmap scalarBmp(size, B8G8R8X8);
+        setSIMDLevel(SIMD_NONE);
+        scalarBmp.copyYUVPixels(*pYBmp, *pUBmp, *pVBmp, bJPEG);
+        Bitmap simdBmp(size, B8G8R8X8);
+        setSIMDLevel(level);
+        simdBmp.copyYUVPixels(*pYBmp, *pUBmp, *pVBmp, bJPEG);
+        TEST(simdBmp == scalarBmp);
+    }
+};
+
 class FilterColorizeTest: public GraphicsTest {
 public:
     FilterColorizeTest()
@@ -1005,6 +1180,212 @@ private:
 
 };
 
+class FilterThreadingTest: public GraphicsTest {
+public:
+    FilterThreadingTest()
+        : GraphicsTest("FilterThreadingTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        // Multithreaded filters must produce the same result as single-threaded ones.
+        BitmapPtr pI8Bmp = createRandomBmp(IntPoint(640, 480), I8);
+        BitmapPtr pRGBABmp = createRandomBmp(IntPoint(640, 480), R8G8B8A8);
+        BitmapPtr pRGBBmp = createRandomBmp(IntPoint(640, 480), R8G8B8);
+        for (int radius = 1; radius <= 4; ++radius) {
+            runTest("Gauss", FilterPtr(new FilterGauss(float(radius))), pI8Bmp);
+        }
+        runTest("Blur", FilterPtr(new FilterBlur()), pI8Bmp);
+        float mat[9] = {1/9.f, 1/9.f, 1/9.f, 1/9.f, 1/9.f, 1/9.f, 1/9.f, 1/9.f, 1/9.f};
+        runTest("ConvolI8", FilterPtr(new FilterConvol<Pixel8>(mat, 3, 3)), pI8Bmp);
+        runTest("ConvolRGBA", FilterPtr(new FilterConvol<Pixel32>(mat, 3, 3)),
+                pRGBABmp);
+        runTest("Highpass", FilterPtr(new FilterHighpass()), pI8Bmp);
+        runTest("FastBandpass", FilterPtr(new FilterFastBandpass()), pI8Bmp);
+        runTest("Dilation", FilterPtr(new FilterDilation()), pI8Bmp);
+        runTest("Erosion", FilterPtr(new FilterErosion()), pI8Bmp);
+        runTest("ResizeBilinear", FilterPtr(new FilterResizeBilinear(
+                IntPoint(320, 240))), pRGBABmp);
+        runTest("ResizeBilinear", FilterPtr(new FilterResizeBilinear(
+                IntPoint(1000, 700))), pRGBBmp);
+        runTest("ResizeGaussian", FilterPtr(new FilterResizeGaussian(
+                IntPoint(213, 160), 1.5)), pI8Bmp);
+    }
+
+private:
+    void runTest(const string& sName, FilterPtr pFilter, BitmapPtr pSrcBmp)
+    {
+        cerr << "    Testing " << sName << endl;
+        ThreadPool* pPool = ThreadPool::get();
+        int oldNumThreads = pPool->getNumThreads();
+        pPool->setNumThreads(1);
+        BitmapPtr pBaselineBmp = pFilter->apply(pSrcBmp);
+        for (int numThreads = 2; numThreads <= 8; numThreads *= 2) {
+            pPool->setNumThreads(numThreads);
+            BitmapPtr pDestBmp = pFilter->apply(pSrcBmp);
+            TEST(*pDestBmp == *pBaselineBmp);
+        }
+        pPool->setNumThreads(oldNumThreads);
+    }
+};
+
+class FilterChainTest: public GraphicsTest {
+public:
+    FilterChainTest()
+        : GraphicsTest("FilterChainTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        // Fused filter chains must give the same results as applying the filters one
+        // after another.
+        IntPoint sizes[] = {IntPoint(640, 480), IntPoint(33, 9), IntPoint(8, 3)};
+        ThreadPool* pPool = ThreadPool::get();
+        int oldNumThreads = pPool->getNumThreads();
+        for (int numThreads = 1; numThreads <= 4; numThreads *= 4) {
+            pPool->setNumThreads(numThreads);
+            for (int i = 0; i < 3; ++i) {
+                BitmapPtr pSrcBmp = createRandomBmp(sizes[i], I8);
+                {
+                    FilterPtr filters[] = {FilterPtr(new FilterHighpass()),
+                            FilterPtr(new FilterThreshold(128))};
+                    runTest(filters, 2, pSrcBmp);
+                }
+                {
+                    FilterPtr filters[] = {FilterPtr(new FilterFastBandpass()),
+                            FilterPtr(new FilterDilation()), 
+                            FilterPtr(new FilterErosion()),
+                            FilterPtr(new FilterThreshold(100))};
+                    runTest(filters, 4, pSrcBmp);
+                }
+                {
+                    // FilterBlur can't be fused and splits the chain.
+                    FilterPtr filters[] = {FilterPtr(new FilterDilation()),
+                            FilterPtr(new FilterBlur()), 
+                            FilterPtr(new FilterErosion())};
+                    runTest(filters, 3, pSrcBmp);
+                }
+                {
+                    FilterPtr filters[] = {FilterPtr(new FilterHighpass())};
+                    runTest(filters, 1, pSrcBmp);
+                }
+                runTest(0, 0, pSrcBmp);
+                testHistory(sizes[i]);
+            }
+        }
+        pPool->setNumThreads(oldNumThreads);
+    }
+
+private:
+    void runTest(FilterPtr* pFilters, int numFilters, BitmapPtr pSrcBmp)
+    {
+        FilterChain chain;
+        BitmapPtr pBaselineBmp = pSrcBmp;
+        for (int i = 0; i < numFilters; ++i) {
+            chain.addFilter(pFilters[i]);
+            pBaselineBmp = pFilters[i]->apply(pBaselineBmp);
+        }
+        BitmapPtr pDestBmp = chain.apply(pSrcBmp);
+        TEST(*pDestBmp == *pBaselineBmp);
+    }
+
+    void testHistory(const IntPoint& size)
+    {
+        // HistoryPreProcessor has state, so each frame must update it exactly once.
+        HistoryPreProcessorPtr pHistory(new HistoryPreProcessor(size, 3, true));
+        HistoryPreProcessor baselineHistory(size, 3, true);
+        FilterChain chain;
+        chain.addFilter(pHistory);
+        chain.addFilter(FilterPtr(new FilterFastBandpass()));
+        for (int i = 0; i < 40; ++i) {
+            BitmapPtr pSrcBmp = createRandomBmp(size, I8);
+            BitmapPtr pBaselineBmp = baselineHistory.apply(pSrcBmp);
+            pBaselineBmp = FilterFastBandpass().apply(pBaselineBmp);
+            BitmapPtr pDestBmp = chain.apply(pSrcBmp);
+            if (!(*pDestBmp == *pBaselineBmp)) {
+                TEST_FAILED("History chain differs in frame " << i);
+            }
+        }
+    }
+};
+
+class ShelfPackerTest: public GraphicsTest {
+public:
+    ShelfPackerTest()
+        : GraphicsTest("ShelfPackerTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        {
+            ShelfPacker packer(IntPoint(64, 64));
+            IntPoint pos;
+            TEST(!packer.alloc(IntPoint(65, 1), pos));
+            TEST(packer.alloc(IntPoint(32, 16), pos) && pos == IntPoint(0, 0));
+            TEST(packer.alloc(IntPoint(32, 16), pos) && pos == IntPoint(32, 0));
+            TEST(packer.alloc(IntPoint(16, 12), pos) && pos == IntPoint(0, 16));
+            TEST(packer.getNumRects() == 3);
+            TEST(packer.getUsedArea() == 2*32*16+16*12);
+            packer.free(IntRect(IntPoint(0, 0), IntPoint(32, 16)));
+            // Freed space in the first shelf is reused.
+            TEST(packer.alloc(IntPoint(30, 15), pos) && pos == IntPoint(0, 0));
+        }
+        for (unsigned seed = 0; seed < 20; ++seed) {
+            testRandomAllocs(seed);
+        }
+    }
+
+private:
+    void testRandomAllocs(unsigned seed)
+    {
+        // Random allocations and frees. Allocated rects must stay inside the area
+        // and must never overlap.
+        ShelfPacker packer(IntPoint(256, 256));
+        vector<IntRect> rects;
+        srand(seed);
+        for (int i = 0; i < 5000; ++i) {
+            if (rects.empty() || rand()%3 != 0) {
+                IntPoint size(rand()%40+1, rand()%40+1);
+                IntPoint pos;
+                if (packer.alloc(size, pos)) {
+                    IntRect rect(pos, pos+size);
+                    if (rect.tl.x < 0 || rect.tl.y < 0 || 
+                            rect.br.x > 256 || rect.br.y > 256)
+                    {
+                        TEST_FAILED("Rect outside of area, seed " << seed << 
+                                ", iteration " << i);
+                        return;
+                    }
+                    for (unsigned j = 0; j < rects.size(); ++j) {
+                        if (rect.intersects(rects[j])) {
+                            TEST_FAILED("Overlapping rects, seed " << seed << 
+                                    ", iteration " << i);
+                            return;
+                        }
+                    }
+                    rects.push_back(rect);
+                }
+            } else {
+                unsigned j = rand()%rects.size();
+                packer.free(rects[j]);
+                rects.erase(rects.begin()+j);
+            }
+        }
+        TEST(packer.getNumRects() == int(rects.size()));
+        for (unsigned j = 0; j < rects.size(); ++j) {
+            packer.free(rects[j]);
+        }
+        // Everything is free again, so the whole area must be available.
+        TEST(packer.getNumRects() == 0 && packer.getUsedArea() == 0);
+        TEST(packer.getNumShelves() == 0);
+        IntPoint pos;
+        TEST(packer.alloc(IntPoint(256, 256), pos));
+    }
+};
+
 class GraphicsTestSuite: public TestSuite {
 public:
     GraphicsTestSuite() 
@@ -1012,6 +1393,8 @@ public:
     {
         addTest(TestPtr(new PixelTest));
         addTest(TestPtr(new BitmapTest));
+        addTest(TestPtr(new BitmapPoolTest));
+        addTest(TestPtr(new SIMDConversionTest));
         addTest(TestPtr(new Filter3x3Test));
         addTest(TestPtr(new FilterConvolTest));
         addTest(TestPtr(new FilterColorizeTest));
@@ -1036,6 +1419,9 @@ public:
         addTest(TestPtr(new FilterAlphaTest));
         addTest(TestPtr(new FilterResizeBilinearTest));
         addTest(TestPtr(new FilterUnmultiplyAlphaTest));
+        addTest(TestPtr(new FilterThreadingTest));
+        addTest(TestPtr(new FilterChainTest));
+        addTest(TestPtr(new ShelfPackerTest));
     }
 };
 
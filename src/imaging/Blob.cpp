@@ -22,6 +22,7 @@
 //
 
 #include "Blob.h"
+#include "ComponentLabeller.h"
 
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
@@ -40,12 +41,10 @@ using namespace std;
 
 namespace avg {
 
-Blob::Blob(const Run& run)
+Blob::Blob(int numRuns)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
-    m_Runs.reserve(50);
-    m_Runs.push_back(run);
-    m_pParent = BlobPtr();
+    m_Runs.reserve(numRuns);
 
     m_bStatsAvailable = false;
 }
@@ -62,19 +61,10 @@ RunArray *Blob::getRuns()
 
 void Blob::addRun(const Run& run)
 {
-    AVG_ASSERT((m_Runs.end()-1)->m_Row <= run.m_Row);
+    AVG_ASSERT(m_Runs.empty() || (m_Runs.end()-1)->m_Row <= run.m_Row);
     m_Runs.push_back(run);
 }
 
-
-void Blob::merge(const BlobPtr& pOtherBlob)
-{
-    AVG_ASSERT(pOtherBlob);
-    RunArray * pOtherRuns = pOtherBlob->getRuns();
-    m_Runs.insert(m_Runs.end(), pOtherRuns->begin(), pOtherRuns->end());
-    pOtherRuns->clear();
-}
-
 void Blob::render(BitmapPtr pSrcBmp, BitmapPtr pDestBmp, Pixel32 color, 
         int min, int max, bool bFinger, bool bMarkCenter, Pixel32 centerColor)
 {
@@ -152,12 +142,80 @@ bool Blob::contains(IntPoint pt)
     return false;
 }
 
+void BlobMoments::addRuns(const Run* pRuns, int numRuns)
+{
+    // Per run, with len = end-start:
+    //   sum of x   = (start+end-1)*len/2
+    //   sum of x^2 = (f(end-1)-f(start-1))/6, f(n) = n*(n+1)*(2n+1)
+    // The divisions are done once at the end so the terms stay integers. The runs are
+    // copied into separate arrays in batches first: the compiler doesn't vectorize the
+    // int to double conversions on the interleaved Run fields.
+    const int BATCH_SIZE = 64;
+    int starts[BATCH_SIZE];
+    int ends[BATCH_SIZE];
+    int rows[BATCH_SIZE];
+    double area = 0;
+    double sumX2 = 0;
+    double sumY = 0;
+    double sumXX6 = 0;
+    double sumXY2 = 0;
+    double sumYY = 0;
+    int minX = m_BoundingBox.tl.x;
+    int minY = m_BoundingBox.tl.y;
+    int maxX = m_BoundingBox.br.x;
+    int maxY = m_BoundingBox.br.y;
+    for (int batchStart = 0; batchStart < numRuns; batchStart += BATCH_SIZE) {
+        int batchSize = std::min(BATCH_SIZE, numRuns-batchStart);
+        const Run* pBatch = pRuns+batchStart;
+        for (int i = 0; i < batchSize; ++i) {
+            starts[i] = pBatch[i].m_StartCol;
+            ends[i] = pBatch[i].m_EndCol;
+            rows[i] = pBatch[i].m_Row;
+        }
+        for (int i = 0; i < batchSize; ++i) {
+            double start = starts[i];
+            double end = ends[i];
+            double y = rows[i];
+            double len = end-start;
+            double runSumX2 = (start+end-1)*len;
+            area += len;
+            sumX2 += runSumX2;
+            sumY += len*y;
+            sumXX6 += (end-1)*end*(2*end-1) - (start-1)*start*(2*start-1);
+            sumXY2 += runSumX2*y;
+            sumYY += len*y*y;
+            minX = std::min(minX, starts[i]);
+            minY = std::min(minY, rows[i]);
+            maxX = std::max(maxX, ends[i]);
+            maxY = std::max(maxY, rows[i]);
+        }
+    }
+    m_Area += area;
+    m_SumX += sumX2/2;
+    m_SumY += sumY;
+    m_SumXX += sumXX6/6;
+    m_SumXY += sumXY2/2;
+    m_SumYY += sumYY;
+    m_BoundingBox = IntRect(minX, minY, maxX, maxY);
+}
+
 void Blob::calcStats()
 {
-    m_Center = calcCenter();
+    BlobMoments moments;
+    if (!m_Runs.empty()) {
+        moments.addRuns(&m_Runs[0], int(m_Runs.size()));
+    }
+    calcStats(moments);
+}
+
+void Blob::calcStats(const BlobMoments& moments)
+{
+    double centerX = moments.m_SumX/moments.m_Area;
+    double centerY = moments.m_SumY/moments.m_Area;
+    m_Center = glm::vec2(centerX, centerY);
     m_EstimatedNextCenter = m_Center;
-    m_Area = float(calcArea());
-    m_BoundingBox = calcBBox();
+    m_Area = float(moments.m_Area);
+    m_BoundingBox = moments.m_BoundingBox;
     /*
        more useful numbers that can be calculated from c
        see e.g. 
@@ -167,31 +225,16 @@ void Blob::calcStats()
        Inertia = c_xx + c_yy
        Eccentricity = ...
        */
-    float c_xx = 0;  // Variance in x direction
-    float c_yy =0;   // Variance in y direction
-    float c_xy = 0;  // Covariance
-    float ll=0;
+    // Central moments, derived from the raw moments in double precision because of
+    // the cancellation.
+    float c_xx = float(moments.m_SumXX/moments.m_Area - centerX*centerX); // Var. in x
+    float c_yy = float(moments.m_SumYY/moments.m_Area - centerY*centerY); // Var. in y
+    float c_xy = float(moments.m_SumXY/moments.m_Area - centerX*centerY); // Covariance
     float l1;
     float l2;
     float tmp_x;
     float tmp_y;
     float mag;
-    for (RunArray::iterator r = m_Runs.begin(); r != m_Runs.end();++r) {
-        //This is the evaluated expression for the variance when using runs...
-        ll = float(r->length());
-        c_yy += ll* (r->m_Row- m_Center.y)*(r->m_Row- m_Center.y);
-        c_xx += ( (r->m_EndCol-1) * r->m_EndCol * (2*r->m_EndCol-1) 
-                - (r->m_StartCol-1) * r->m_StartCol * (2*r->m_StartCol -1))/6.f 
-            - m_Center.x * ((r->m_EndCol-1)*r->m_EndCol-(r->m_StartCol-1)*r->m_StartCol)
-            + ll* m_Center.x*m_Center.x;
-        c_xy += (r->m_Row-m_Center.y)*0.5f*( (r->m_EndCol-1)*r->m_EndCol
-                - (r->m_StartCol-1)*r->m_StartCol) 
-                + ll *(m_Center.x*m_Center.y - m_Center.x*r->m_Row);
-    }
-
-    c_xx /= m_Area;
-    c_yy /= m_Area;
-    c_xy /= m_Area;
 
     m_Inertia = c_xx + c_yy;
 
@@ -324,51 +367,17 @@ const BlobPtr Blob::getFirstRelated()
     }
 }
 
-glm::vec2 Blob::calcCenter()
-{
-    glm::vec2 center(0,0);
-    float c = 0;
-    for (RunArray::iterator r = m_Runs.begin(); r != m_Runs.end(); ++r) {
-        center += r->m_Center * float(r->length());
-        c += r->length();
-    }
-    center = center/c;
-    return center;
-}
-
-IntRect Blob::calcBBox()
-{
-    int x1 = INT_MAX;
-    int y1 = INT_MAX;
-    int x2 = 0;
-    int y2 = 0;
-    for (RunArray::iterator r = m_Runs.begin(); r!=m_Runs.end(); ++r) {
-        x1 = std::min(x1, r->m_StartCol);
-        y1 = std::min(y1, r->m_Row);
-        x2 = std::max(x2, r->m_EndCol);
-        y2 = std::max(y2, r->m_Row);
-    }
-    return IntRect(x1, y1, x2, y2);
-}
-
-int Blob::calcArea()
-{
-    int res = 0;
-    for (RunArray::iterator r = m_Runs.begin(); r != m_Runs.end(); ++r) {
-        res+= r->length();
-    }
-    return res;
-}
-
-void Blob::initRowPositions()
+void Blob::initRowStarts()
 {
-    int offset = m_BoundingBox.tl.y;
-    RunArray::iterator it = m_Runs.begin();
-    for (int i = 0; i < m_BoundingBox.height(); i++) {
-        while (it->m_Row-offset < i) {
-            it++;
+    int firstRow = m_BoundingBox.tl.y;
+    int numRows = m_BoundingBox.br.y-firstRow+1;
+    m_RowStarts.resize(numRows+1);
+    unsigned runIdx = 0;
+    for (int i = 0; i <= numRows; i++) {
+        while (runIdx < m_Runs.size() && m_Runs[runIdx].m_Row-firstRow < i) {
+            runIdx++;
         }
-        m_RowPositions.push_back(it);
+        m_RowStarts[i] = runIdx;
     }
 }
 
@@ -410,45 +419,128 @@ IntPoint getNeighbor(const IntPoint& pt, int dir)
     return neighborPt;
 }
 
-IntPoint Blob::findNeighborInside(const IntPoint& pt, int& dir)
+int Blob::findRun(int rowIdx, int col) const
 {
+    // Index of the first run in the row that ends after col. Runs in a row are sorted
+    // and don't overlap, so their ends are sorted as well.
+    int first = m_RowStarts[rowIdx];
+    int last = m_RowStarts[rowIdx+1];
+    while (first < last) {
+        int mid = (first+last)/2;
+        if (m_Runs[mid].m_EndCol <= col) {
+            first = mid+1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+int Blob::findNeighborRun(int rowIdx, int centerX, int x, int& firstRunIdx) const
+{
+    // Returns the run in row rowIdx that contains x or -1. x is next to centerX, and
+    // firstRunIdx caches the first run that can touch the pixels next to centerX.
+    if (rowIdx < 0 || rowIdx+1 >= int(m_RowStarts.size())) {
+        return -1;
+    }
+    if (firstRunIdx == -1) {
+        firstRunIdx = findRun(rowIdx, centerX-1);
+    }
+    // Within a row, runs are at least one pixel apart, so at most two runs touch the
+    // three pixels next to centerX.
+    int rowEnd = m_RowStarts[rowIdx+1];
+    for (int i = firstRunIdx; i < firstRunIdx+2 && i < rowEnd; ++i) {
+        if (x >= m_Runs[i].m_StartCol && x < m_Runs[i].m_EndCol) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool Blob::findNextBoundaryPt(IntPoint& pt, int& runIdx, int& dir) const
+{
+    // Moore neighbor search: The neighbors of pt are checked clockwise, starting after
+    // the one we came from. Horizontal neighbors can only be in the current run. The
+    // runs of the rows above and below are looked up when the search first gets there.
     if (dir & 1) {
         dir += 2;
     } else {
         dir++;
     }
-    if (dir > 7) {
-        dir -= 8;
+    dir &= 7;
+    const Run& run = m_Runs[runIdx];
+    int rowIdx = pt.y-m_BoundingBox.tl.y;
+    int firstAboveIdx = -1;
+    int firstBelowIdx = -1;
+    for (int i = 0; i < 8; i++) {
+        IntPoint neighborPt = getNeighbor(pt, dir);
+        int neighborIdx = -1;
+        if (neighborPt.y < pt.y) {
+            neighborIdx = findNeighborRun(rowIdx-1, pt.x, neighborPt.x, firstAboveIdx);
+        } else if (neighborPt.y > pt.y) {
+            neighborIdx = findNeighborRun(rowIdx+1, pt.x, neighborPt.x, firstBelowIdx);
+        } else if (neighborPt.x >= run.m_StartCol && neighborPt.x < run.m_EndCol) {
+            neighborIdx = runIdx;
+        }
+        if (neighborIdx != -1) {
+            pt = neighborPt;
+            runIdx = neighborIdx;
+            return true;
+        }
+        dir = (dir+7) & 7;
     }
+    // Single-pixel blob.
+    return false;
+}
 
-    for (int i = 0; i < 8; i++) {
-        IntPoint curPt = getNeighbor(pt, dir);
-        if (ptIsInBlob(curPt)) {
-            return curPt;
-        } else {
-            dir--;
-            if (dir < 0) {
-                dir += 8;
-            }
+int Blob::getNumStepsEast(const IntPoint& pt, int runIdx) const
+{
+    // Called after a step east, which means that the pixel above pt is outside. The
+    // tracer keeps going east until a run in the row above starts (NE neighbor) or the
+    // current run ends.
+    int rowIdx = pt.y-m_BoundingBox.tl.y;
+    int endCol = m_Runs[runIdx].m_EndCol;
+    if (rowIdx > 0) {
+        int aboveIdx = findRun(rowIdx-1, pt.x);
+        if (aboveIdx < m_RowStarts[rowIdx] && m_Runs[aboveIdx].m_StartCol <= pt.x) {
+            aboveIdx++;
+        }
+        if (aboveIdx < m_RowStarts[rowIdx]) {
+            endCol = std::min(endCol, m_Runs[aboveIdx].m_StartCol);
         }
     }
-    AVG_ASSERT(false);
-    return pt;
+    return std::max(endCol-1-pt.x, 0);
 }
 
-bool runIsLess(const Run& r1, const Run& r2)
+int Blob::getNumStepsWest(const IntPoint& pt, int runIdx) const
 {
-    return r1.m_Row < r2.m_Row;
+    // Called after a step west, which means that the pixel below pt is outside. The
+    // tracer keeps going west until a run in the row below ends (SW neighbor) or the
+    // current run ends.
+    int rowIdx = pt.y-m_BoundingBox.tl.y;
+    int startCol = m_Runs[runIdx].m_StartCol;
+    if (rowIdx+2 < int(m_RowStarts.size())) {
+        int belowIdx = findRun(rowIdx+1, pt.x)-1;
+        if (belowIdx >= m_RowStarts[rowIdx+1]) {
+            startCol = std::max(startCol, m_Runs[belowIdx].m_EndCol);
+        }
+    }
+    return std::max(pt.x-startCol, 0);
 }
 
 void Blob::calcContour(int precision)
 {
-    sort(m_Runs.begin(), m_Runs.end(), runIsLess);
-    initRowPositions();
+    AVG_ASSERT(m_bStatsAvailable);
+    initRowStarts();
+    m_Contour.clear();
     
-    // Moore Neighbor Tracing.
+    // Follows the border clockwise, keeping track of the run the current point is in.
+    // At each corner, the next point is the first inside neighbor in Moore order,
+    // found in the runs of the adjacent rows. Straight stretches along the top and
+    // bottom of runs are crossed in one step.
     IntPoint boundaryPt(m_Runs[0].m_StartCol, m_Runs[0].m_Row);
     IntPoint firstPt(boundaryPt);
+    int runIdx = 0;
     int i = precision;
     int dir = 1;
     do {
@@ -457,160 +549,41 @@ void Blob::calcContour(int precision)
             m_Contour.push_back(boundaryPt);
             i = 0;
         }
-        boundaryPt = findNeighborInside(boundaryPt, dir);
-    } while (firstPt != boundaryPt);
-}
-
-ContourSeq Blob::getContour()
-{
-    return m_Contour;
-}
-
-bool Blob::ptIsInBlob(const IntPoint& pt)
-{
-    if (m_BoundingBox.contains(pt)) {
-        RunArray::iterator it = m_RowPositions[pt.y-m_BoundingBox.tl.y];
-        while (it->m_Row == pt.y) {
-            if (pt.x >= it->m_StartCol && pt.x < it->m_EndCol) {
-                return true;
-            }
-            it++;
+        if (!findNextBoundaryPt(boundaryPt, runIdx, dir)) {
+            break;
         }
-    }
-    return false;
-}
-
-bool areConnected(const Run & run1, const Run & run2)
-{
-    if (run1.m_StartCol > run2.m_StartCol) {
-        return run2.m_EndCol > run1.m_StartCol;
-    } else {
-        return run1.m_EndCol > run2.m_StartCol;
-    }
-}
-
-void storeRuns(BlobVectorPtr pBlobs, RunArray* pUpperRuns, RunArray* pLowerRuns)
-{
-    for (RunArray::iterator run1_it = pUpperRuns->begin(); run1_it != pUpperRuns->end();
-            ++run1_it)
-    {
-        for (RunArray::iterator run2_it = pLowerRuns->begin(); 
-                run2_it != pLowerRuns->end(); ++run2_it)
-        {
-            if (run2_it->m_StartCol > run1_it->m_EndCol) {
-                break;
+        if (boundaryPt != firstPt && (dir == 0 || dir == 4)) {
+            int numSteps;
+            int step;
+            if (dir == 0) {
+                numSteps = getNumStepsEast(boundaryPt, runIdx);
+                step = 1;
+            } else {
+                numSteps = getNumStepsWest(boundaryPt, runIdx);
+                step = -1;
             }
-            if (areConnected(*run1_it, *run2_it)) {
-                BlobPtr pBlob = run1_it->m_pBlob.lock();
-                while (pBlob->m_pParent) {
-                    pBlob = pBlob->m_pParent;
-                }
-                if (!(run2_it->m_pBlob.expired())) {
-                    BlobPtr c_blob = run2_it->m_pBlob.lock();
-                    while (c_blob->m_pParent) {
-                        c_blob = c_blob->m_pParent;
-                    }
-                    if (c_blob != pBlob) {
-                        // When we merge, make sure the smaller blob is merged
-                        // into the bigger one to avoid a speed hit.
-                        if (pBlob->getRuns()->size() > c_blob->getRuns()->size()) {
-                            pBlob->merge(c_blob); //destroys c_blobs runs_list
-                            c_blob->m_pParent = pBlob;
-                        } else {
-                            c_blob->merge(pBlob); 
-                            pBlob->m_pParent = c_blob;
-                        }
-                    }
-                } else {
-                    run2_it->m_pBlob = pBlob;
-                    pBlob->addRun(*run2_it);
+            // Only the last point of the stretch can be the first point again.
+            for (int j = 0; j < numSteps; ++j) {
+                i++;
+                if (i >= precision) {
+                    m_Contour.push_back(boundaryPt);
+                    i = 0;
                 }
+                boundaryPt.x += step;
             }
         }
-    }
-    for (RunArray::iterator run2_it = pLowerRuns->begin(); run2_it != pLowerRuns->end();
-            ++run2_it)
-    {
-        if (run2_it->m_pBlob.expired()) {
-            BlobPtr pBlob = BlobPtr(new Blob(*run2_it));
-            pBlobs->push_back(pBlob);
-            run2_it->m_pBlob = pBlob;
-        }
-    }
+    } while (firstPt != boundaryPt);
 }
 
-void findRunsInLine(BitmapPtr pBmp, int y, RunArray* pRuns, unsigned char threshold)
+ContourSeq Blob::getContour()
 {
-    int runStart=0;
-    int runStop=0;
-    const unsigned char * pPixel = pBmp->getPixels()+y*pBmp->getStride();
-    bool bIsInRun = *pPixel > threshold;
-
-    int width = pBmp->getSize().x;
-    for (int x = 0; x < width; x++) {
-        bool bPixelInRun = *pPixel > threshold;
-        if (bIsInRun != bPixelInRun) {
-            if (bIsInRun) {
-                // Only if the run is longer than one pixel.
-                if (x-runStart > 1) {
-                    runStop = x;
-                    pRuns->push_back(Run(y, runStart, runStop));
-                    runStart = x;
-                }
-            } else {
-                runStop = x - 1;
-                if (runStop-runStart == 0 && !pRuns->empty()) {
-                    // Single dark pixel: ignore the pixel, revive the last run.
-                    runStart = pRuns->back().m_StartCol;
-                    pRuns->pop_back();
-                } else {
-                    runStart = x;
-                }
-            }
-            bIsInRun = bPixelInRun;
-        }
-        pPixel++;
-    }
-    if (bIsInRun) {
-        pRuns->push_back(Run(y, runStart, width));
-    }
+    return m_Contour;
 }
 
 BlobVectorPtr findConnectedComponents(BitmapPtr pBmp, unsigned char threshold)
 {
-    AVG_ASSERT(pBmp->getPixelFormat() == I8);
-    BlobVectorPtr pBlobs = BlobVectorPtr(new BlobVector);
-    IntPoint size = pBmp->getSize();
-    RunArray* pUpperRuns = new RunArray();
-    RunArray* pLowerRuns = new RunArray();
-
-    int y = 0;
-    findRunsInLine(pBmp, 0, pUpperRuns, threshold);
-    for (RunArray::iterator it = pUpperRuns->begin(); it!=pUpperRuns->end(); ++it) {
-        BlobPtr pBlob = BlobPtr(new Blob(*it));
-        pBlobs->push_back(pBlob);
-        it->m_pBlob = pBlob;
-    }
-    
-    for (y = 1; y < size.y; y++) {
-        findRunsInLine(pBmp, y, pLowerRuns, threshold);
-        storeRuns(pBlobs, pUpperRuns, pLowerRuns);
-        RunArray* pTmpRuns = pUpperRuns;
-        pUpperRuns = pLowerRuns;
-        pLowerRuns = pTmpRuns;
-        pLowerRuns->clear();
-    }
-    BlobVectorPtr pResultBlobs = BlobVectorPtr(new BlobVector);
-    for (BlobVector::iterator it = pBlobs->begin(); it != pBlobs->end(); ++it) {
-        if (!(*it)->m_pParent) {
-            pResultBlobs->push_back(*it);
-            (*it)->calcStats();
-        }
-    }
-    delete pUpperRuns;
-    delete pLowerRuns;
-    return pResultBlobs;
+    ComponentLabeller labeller;
+    return labeller.findComponents(pBmp, threshold);
 }
 
-
 }
@@ -33,6 +33,8 @@
 #include "../base/GLMHelper.h"
 
 #include <vector>
+#include <algorithm>
+#include <climits>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
@@ -47,14 +49,32 @@ typedef std::vector<BlobWeakPtr> BlobWeakPtrVector;
 typedef boost::shared_ptr<BlobVector> BlobVectorPtr;
 typedef std::vector<IntPoint> ContourSeq;
 
+// Raw moments of a set of runs. The sums for a run are evaluated in closed form instead
+// of pixel by pixel. All terms are integers that fit into a double's mantissa, so the
+// result is exact and does not depend on the order in which runs are added. This
+// lets the compiler vectorize the accumulation loop in addRuns().
+struct AVG_API BlobMoments
+{
+    BlobMoments();
+    void addRuns(const Run* pRuns, int numRuns);
+
+    double m_Area;
+    double m_SumX;
+    double m_SumY;
+    double m_SumXX;
+    double m_SumXY;
+    double m_SumYY;
+    IntRect m_BoundingBox;
+};
+
 class AVG_API Blob
 {
     public:
-        Blob(const Run& run);
+        // Reserves space for numRuns runs, which are then added using addRun().
+        explicit Blob(int numRuns);
         ~Blob();
 
         void addRun(const Run& run);
-        void merge(const BlobPtr& other);
         RunArray* getRuns();
         void render(BitmapPtr pSrcBmp, BitmapPtr pDestBmp, Pixel32 Color, 
                 int Min, int Max, bool bFinger, bool bMarkCenter, 
@@ -62,6 +82,8 @@ class AVG_API Blob
         bool contains(IntPoint pt);
 
         void calcStats();
+        // Traces the outer border on the runs. The result is the same as Moore
+        // neighbor tracing with every precision-th point kept.
         void calcContour(int Precision);
         ContourSeq getContour();
 
@@ -81,19 +103,18 @@ class AVG_API Blob
         void addRelated(BlobPtr pBlob);
         const BlobPtr getFirstRelated(); 
 
-        BlobPtr m_pParent;
-
     private:
         Blob(const Blob &);
-        glm::vec2 calcCenter();
-        IntRect calcBBox();
-        int calcArea();
-        void initRowPositions();
-        IntPoint findNeighborInside(const IntPoint& Pt, int& Dir);
-        bool ptIsInBlob(const IntPoint& Pt);
-
-        RunArray m_Runs; // This array is unsorted until contours are calculated.
-        std::vector<RunArray::iterator> m_RowPositions;
+        void calcStats(const BlobMoments& moments);
+        void initRowStarts();
+        int findRun(int rowIdx, int col) const;
+        int findNeighborRun(int rowIdx, int centerX, int x, int& firstRunIdx) const;
+        bool findNextBoundaryPt(IntPoint& pt, int& runIdx, int& dir) const;
+        int getNumStepsEast(const IntPoint& pt, int runIdx) const;
+        int getNumStepsWest(const IntPoint& pt, int runIdx) const;
+
+        RunArray m_Runs; // Sorted by row.
+        std::vector<int> m_RowStarts; // Index of the first run in each row.
         BlobWeakPtrVector m_RelatedBlobs; // For fingers, this contains the hand.
                                           // For hands, this contains the fingers.
 
@@ -112,9 +133,21 @@ class AVG_API Blob
         ContourSeq m_Contour;
 };
 
+// Convenience wrapper around ComponentLabeller for one-off use.
 BlobVectorPtr AVG_API findConnectedComponents(BitmapPtr pBmp, 
         unsigned char threshold);
 
+inline BlobMoments::BlobMoments()
+    : m_Area(0),
+      m_SumX(0),
+      m_SumY(0),
+      m_SumXX(0),
+      m_SumXY(0),
+      m_SumYY(0),
+      m_BoundingBox(INT_MAX, INT_MAX, 0, 0)
+{
+}
+
 }
 
 #endif
@@ -111,7 +111,7 @@ CMUCamera::~CMUCamera()
     delete m_pCamera;
 }
 
-BitmapPtr CMUCamera::getImage(bool bWait)
+BitmapPtr CMUCamera::captureImage(bool bWait)
 {
     if (bWait) {
         unsigned rc = WaitForSingleObject(m_pCamera->GetFrameEvent(), INFINITE);
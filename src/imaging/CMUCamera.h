@@ -39,7 +39,7 @@ public:
             PixelFormat destPF, float FrameRate);
     virtual ~CMUCamera();
 
-    virtual BitmapPtr getImage(bool bWait);
+    virtual BitmapPtr captureImage(bool bWait);
 
     virtual const std::string& getDevice() const; 
     virtual const std::string& getDriverName() const; 
@@ -24,6 +24,7 @@
 #include "../base/Logger.h"
 #include "../base/Exception.h"
 #include "../base/ScopeTimer.h"
+#include "../base/TimeSource.h"
 #include "../graphics/Filterfliprgb.h"
 
 #if defined(AVG_ENABLE_1394_2)
@@ -39,6 +40,7 @@
 #include "../imaging/DSCamera.h"
 #endif
 #include "../imaging/FakeCamera.h"
+#include "../imaging/ReplayCamera.h"
 
 #include <cstdlib>
 #include <string.h>
@@ -105,6 +107,39 @@ float Camera::getFrameRate() const
     return m_FrameRate;
 }
 
+BitmapPtr Camera::getImage(bool bWait)
+{
+    BitmapPtr pBmp = captureImage(bWait);
+    if (pBmp && m_pRecorder) {
+        bool bOK = m_pRecorder->addFrame(pBmp, TimeSource::get()->getCurrentMicrosecs());
+        if (!bOK) {
+            stopRecording();
+        }
+    }
+    return pBmp;
+}
+
+void Camera::startRecording(const string& sFilename)
+{
+    m_pRecorder = CameraRecorderPtr(new CameraRecorder(sFilename));
+    AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+            "Recording camera frames to " << sFilename << ".");
+}
+
+void Camera::stopRecording()
+{
+    if (m_pRecorder) {
+        AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+                "Recorded " << m_pRecorder->getNumFrames() << " camera frames.");
+        m_pRecorder = CameraRecorderPtr();
+    }
+}
+
+bool Camera::isRecording() const
+{
+    return bool(m_pRecorder);
+}
+
 PixelFormat Camera::fwBayerStringToPF(unsigned long reg)
 {
     string sBayerFormat((char*)&reg, 4);
@@ -231,6 +266,10 @@ CameraPtr createCamera(const string& sDriver, const string& sDevice, int unit,
             AVG_LOG_WARNING("DirectShow camera specified, but "
                     "DirectShow is only available under windows.");
 #endif
+        } else if (sDriver == "replay") {
+            pCamera = CameraPtr(new ReplayCamera(sDevice, destPF, false));
+        } else if (sDriver == "replay-realtime") {
+            pCamera = CameraPtr(new ReplayCamera(sDevice, destPF, true));
         } else {
             throw Exception(AVG_ERR_INVALID_ARGS,
                     "Unable to set up camera. Camera source '"+sDriver+"' unknown.");
@@ -27,6 +27,7 @@
 
 #include <boost/shared_ptr.hpp>
 #include "CameraInfo.h"
+#include "CameraRecorder.h"
 
 #include <string>
 #include <list>
@@ -75,7 +76,15 @@ public:
 
     IntPoint getImgSize();
     float getFrameRate() const;
-    virtual BitmapPtr getImage(bool bWait) = 0;
+    // Returns the next frame or an empty BitmapPtr if none is available. Frames are
+    // added to the current recording, if there is one.
+    BitmapPtr getImage(bool bWait);
+
+    // Records all frames returned by getImage() to a file that can be played back
+    // using ReplayCamera. Must be called from the thread that calls getImage().
+    void startRecording(const std::string& sFilename);
+    void stopRecording();
+    bool isRecording() const;
 
     virtual const std::string& getDevice() const = 0; 
     virtual const std::string& getDriverName() const = 0; 
@@ -89,6 +98,7 @@ public:
     virtual void setWhitebalance(int u, int v, bool bIgnoreOldValue=false) = 0;
 
 protected:
+    virtual BitmapPtr captureImage(bool bWait) = 0;
     PixelFormat fwBayerStringToPF(unsigned long reg);
     void setImgSize(const IntPoint& size);
 
@@ -99,6 +109,8 @@ private:
 
     IntPoint m_Size;
     float m_FrameRate;
+
+    CameraRecorderPtr m_pRecorder;
 };
 
 
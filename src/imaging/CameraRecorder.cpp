@@ -0,0 +1,95 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "CameraRecorder.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+
+#include <string.h>
+
+using namespace std;
+
+namespace avg {
+
+CameraRecorder::CameraRecorder(const string& sFilename)
+    : m_sFilename(sFilename),
+      m_File(sFilename.c_str(), ios::out | ios::binary | ios::trunc),
+      m_PF(NO_PIXELFORMAT),
+      m_NumFrames(0)
+{
+    if (!m_File) {
+        throw Exception(AVG_ERR_FILEIO, "Opening "+sFilename+" for writing failed.");
+    }
+}
+
+CameraRecorder::~CameraRecorder()
+{
+}
+
+bool CameraRecorder::addFrame(BitmapPtr pBmp, long long captureMicrosecs)
+{
+    if (!m_File.is_open()) {
+        return false;
+    }
+    if (m_NumFrames == 0) {
+        m_Size = pBmp->getSize();
+        m_PF = pBmp->getPixelFormat();
+        writeHeader(m_Size, m_PF);
+    } else if (pBmp->getSize() != m_Size || pBmp->getPixelFormat() != m_PF) {
+        AVG_LOG_WARNING("Camera frame format changed during recording to "
+                << m_sFilename << ". Frame not recorded.");
+        return true;
+    }
+    m_File.write((const char*)&captureMicrosecs, sizeof(captureMicrosecs));
+    int lineLen = pBmp->getLineLen();
+    for (int y = 0; y < m_Size.y; ++y) {
+        m_File.write((const char*)(pBmp->getPixels()+y*pBmp->getStride()), lineLen);
+    }
+    if (!m_File) {
+        // Called in the capture thread, so don't throw.
+        AVG_LOG_WARNING("Writing to " << m_sFilename << " failed. Recording stopped after "
+                << m_NumFrames << " frames.");
+        m_File.close();
+        return false;
+    }
+    m_NumFrames++;
+    return true;
+}
+
+int CameraRecorder::getNumFrames() const
+{
+    return m_NumFrames;
+}
+
+void CameraRecorder::writeHeader(const IntPoint& size, PixelFormat pf)
+{
+    char pfName[CAMREC_PF_NAME_LEN];
+    memset(pfName, 0, CAMREC_PF_NAME_LEN);
+    strncpy(pfName, getPixelFormatString(pf).c_str(), CAMREC_PF_NAME_LEN-1);
+    m_File.write(CAMREC_MAGIC, sizeof(CAMREC_MAGIC));
+    m_File.write((const char*)&CAMREC_VERSION, sizeof(int));
+    m_File.write((const char*)&size.x, sizeof(int));
+    m_File.write((const char*)&size.y, sizeof(int));
+    m_File.write(pfName, CAMREC_PF_NAME_LEN);
+}
+
+}
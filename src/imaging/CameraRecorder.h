@@ -0,0 +1,72 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _CameraRecorder_H_
+#define _CameraRecorder_H_
+
+#include "../api.h"
+
+#include "../graphics/Bitmap.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <fstream>
+#include <string>
+
+namespace avg {
+
+// Raw camera recordings as written by CameraRecorder and read by ReplayCamera:
+// A fixed-size header followed by frames of identical size, each consisting of the
+// capture time in microseconds and the tightly packed pixels. Frame i can be found at
+// CAMREC_HEADER_SIZE + i*(sizeof(long long) + frame size).
+static const char CAMREC_MAGIC[8] = {'A', 'V', 'G', 'C', 'A', 'M', 'R', 'C'};
+static const int CAMREC_VERSION = 1;
+static const int CAMREC_PF_NAME_LEN = 16;
+static const int CAMREC_HEADER_SIZE = 8+3*sizeof(int)+CAMREC_PF_NAME_LEN;
+
+class AVG_API CameraRecorder: boost::noncopyable
+{
+public:
+    CameraRecorder(const std::string& sFilename);
+    virtual ~CameraRecorder();
+
+    // The first frame determines size and pixel format of the recording. Frames that
+    // don't match are skipped. If writing fails, the file is closed and this and all
+    // further calls return false.
+    bool addFrame(BitmapPtr pBmp, long long captureMicrosecs);
+    int getNumFrames() const;
+
+private:
+    void writeHeader(const IntPoint& size, PixelFormat pf);
+
+    std::string m_sFilename;
+    std::ofstream m_File;
+    IntPoint m_Size;
+    PixelFormat m_PF;
+    int m_NumFrames;
+};
+
+typedef boost::shared_ptr<CameraRecorder> CameraRecorderPtr;
+
+}
+
+#endif
@@ -0,0 +1,265 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ComponentLabeller.h"
+
+#include "../base/Exception.h"
+#include "../base/ThreadPool.h"
+
+#include "../graphics/ParallelRows.h"
+
+#include <boost/bind.hpp>
+
+using namespace std;
+
+namespace avg {
+
+static void findRunsInLine(const unsigned char* pLine, int width, int y, RunArray* pRuns,
+        unsigned char threshold)
+{
+    int runStart=0;
+    int runStop=0;
+    const unsigned char * pPixel = pLine;
+    bool bIsInRun = *pPixel > threshold;
+
+    for (int x = 0; x < width; x++) {
+        bool bPixelInRun = *pPixel > threshold;
+        if (bIsInRun != bPixelInRun) {
+            if (bIsInRun) {
+                // Only if the run is longer than one pixel.
+                if (x-runStart > 1) {
+                    runStop = x;
+                    pRuns->push_back(Run(y, runStart, runStop));
+                    runStart = x;
+                }
+            } else {
+                runStop = x - 1;
+                if (runStop-runStart == 0 && !pRuns->empty() && pRuns->back().m_Row == y)
+                {
+                    // Single dark pixel: ignore the pixel, revive the last run.
+                    runStart = pRuns->back().m_StartCol;
+                    pRuns->pop_back();
+                } else {
+                    runStart = x;
+                }
+            }
+            bIsInRun = bPixelInRun;
+        }
+        pPixel++;
+    }
+    if (bIsInRun) {
+        pRuns->push_back(Run(y, runStart, width));
+    }
+}
+
+// Union-find over run indices. Roots are always the smallest index in their set, so
+// parents[i] <= i holds for all runs and a single ascending pass flattens the trees.
+static int findRoot(vector<int>& parents, int i)
+{
+    while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i = parents[i];
+    }
+    return i;
+}
+
+static void unite(vector<int>& parents, int i, int j)
+{
+    i = findRoot(parents, i);
+    j = findRoot(parents, j);
+    if (i < j) {
+        parents[j] = i;
+    } else if (j < i) {
+        parents[i] = j;
+    }
+}
+
+static void flatten(vector<int>& parents, int start)
+{
+    for (int i = start; i < int(parents.size()); ++i) {
+        parents[i] = parents[parents[i]];
+    }
+}
+
+// Unites overlapping runs of two adjacent rows. The runs of the upper row are
+// [upperStart, lowerStart), the runs of the lower row [lowerStart, lowerEnd).
+static void connectRows(const RunArray& runs, vector<int>& parents, int upperStart,
+        int lowerStart, int lowerEnd)
+{
+    int i = upperStart;
+    int j = lowerStart;
+    while (i < lowerStart && j < lowerEnd) {
+        const Run& upperRun = runs[i];
+        const Run& lowerRun = runs[j];
+        if (upperRun.m_StartCol < lowerRun.m_EndCol &&
+                lowerRun.m_StartCol < upperRun.m_EndCol)
+        {
+            unite(parents, i, j);
+        }
+        if (upperRun.m_EndCol < lowerRun.m_EndCol) {
+            i++;
+        } else if (upperRun.m_EndCol > lowerRun.m_EndCol) {
+            j++;
+        } else {
+            i++;
+            j++;
+        }
+    }
+}
+
+ComponentLabeller::ComponentLabeller()
+    : m_NumStripes(0)
+{
+}
+
+ComponentLabeller::~ComponentLabeller()
+{
+}
+
+void ComponentLabeller::setNumStripes(int numStripes)
+{
+    AVG_ASSERT(numStripes >= 0);
+    m_NumStripes = numStripes;
+}
+
+BlobVectorPtr ComponentLabeller::findComponents(BitmapPtr pBmp, unsigned char threshold)
+{
+    AVG_ASSERT(pBmp->getPixelFormat() == I8);
+    IntPoint size = pBmp->getSize();
+    int numStripes = m_NumStripes;
+    if (numStripes == 0) {
+        // Stripes need one row of context to be joined.
+        numStripes = getNumRowBands(size.y, size.x, 1);
+    }
+    numStripes = max(min(numStripes, size.y), 1);
+    m_Stripes.resize(numStripes);
+    for (int i = 0; i < numStripes; ++i) {
+        m_Stripes[i].m_StartRow = (size.y*i)/numStripes;
+        m_Stripes[i].m_EndRow = (size.y*(i+1))/numStripes;
+    }
+
+    if (numStripes == 1) {
+        labelStripe(&m_Stripes[0], pBmp, threshold);
+        // Keep both sets of buffers by swapping instead of copying.
+        m_Runs.swap(m_Stripes[0].m_Runs);
+        m_Parents.swap(m_Stripes[0].m_Parents);
+    } else {
+        vector<ThreadPool::Job> jobs;
+        jobs.reserve(numStripes);
+        for (int i = 0; i < numStripes; ++i) {
+            jobs.push_back(boost::bind(&ComponentLabeller::labelStripe, this,
+                    &m_Stripes[i], pBmp, threshold));
+        }
+        ThreadPool::get()->runJobs(jobs);
+
+        m_Runs.clear();
+        m_Parents.clear();
+        for (int i = 0; i < numStripes; ++i) {
+            const Stripe& stripe = m_Stripes[i];
+            int offset = int(m_Runs.size());
+            m_Runs.insert(m_Runs.end(), stripe.m_Runs.begin(), stripe.m_Runs.end());
+            for (unsigned j = 0; j < stripe.m_Parents.size(); ++j) {
+                m_Parents.push_back(stripe.m_Parents[j]+offset);
+            }
+            if (i > 0) {
+                joinStripes(m_Stripes[i-1], offset-int(m_Stripes[i-1].m_Runs.size()),
+                        offset);
+            }
+        }
+        flatten(m_Parents, 0);
+    }
+    return createBlobs();
+}
+
+void ComponentLabeller::labelStripe(Stripe* pStripe, BitmapPtr pBmp,
+        unsigned char threshold)
+{
+    RunArray& runs = pStripe->m_Runs;
+    vector<int>& parents = pStripe->m_Parents;
+    runs.clear();
+    parents.clear();
+    int width = pBmp->getSize().x;
+    int prevRowStart = 0;
+    for (int y = pStripe->m_StartRow; y < pStripe->m_EndRow; ++y) {
+        int rowStart = int(runs.size());
+        findRunsInLine(pBmp->getPixels()+y*pBmp->getStride(), width, y, &runs,
+                threshold);
+        for (int i = rowStart; i < int(runs.size()); ++i) {
+            parents.push_back(i);
+        }
+        if (y > pStripe->m_StartRow) {
+            connectRows(runs, parents, prevRowStart, rowStart, int(runs.size()));
+        }
+        prevRowStart = rowStart;
+    }
+    flatten(parents, 0);
+}
+
+void ComponentLabeller::joinStripes(const Stripe& upperStripe, int upperOffset,
+        int lowerOffset)
+{
+    // The runs of both stripes are already in m_Runs. Only the last row of the upper
+    // stripe and the first row of the lower stripe need to be connected.
+    int borderRow = upperStripe.m_EndRow;
+    int upperStart = lowerOffset;
+    while (upperStart > upperOffset && m_Runs[upperStart-1].m_Row == borderRow-1) {
+        upperStart--;
+    }
+    int lowerEnd = lowerOffset;
+    while (lowerEnd < int(m_Runs.size()) && m_Runs[lowerEnd].m_Row == borderRow) {
+        lowerEnd++;
+    }
+    connectRows(m_Runs, m_Parents, upperStart, lowerOffset, lowerEnd);
+}
+
+BlobVectorPtr ComponentLabeller::createBlobs()
+{
+    // Number the components in the order of their first run and count their runs.
+    int numRuns = int(m_Runs.size());
+    m_Labels.resize(numRuns);
+    m_NumRunsPerBlob.clear();
+    for (int i = 0; i < numRuns; ++i) {
+        if (m_Parents[i] == i) {
+            m_Labels[i] = int(m_NumRunsPerBlob.size());
+            m_NumRunsPerBlob.push_back(1);
+        } else {
+            m_Labels[i] = m_Labels[m_Parents[i]];
+            m_NumRunsPerBlob[m_Labels[i]]++;
+        }
+    }
+
+    BlobVectorPtr pBlobs = BlobVectorPtr(new BlobVector);
+    pBlobs->reserve(m_NumRunsPerBlob.size());
+    for (unsigned i = 0; i < m_NumRunsPerBlob.size(); ++i) {
+        pBlobs->push_back(BlobPtr(new Blob(m_NumRunsPerBlob[i])));
+    }
+    for (int i = 0; i < numRuns; ++i) {
+        (*pBlobs)[m_Labels[i]]->addRun(m_Runs[i]);
+    }
+    // Each blob's runs are now contiguous, so its moments are accumulated in a loop
+    // that vectorizes.
+    for (BlobVector::iterator it = pBlobs->begin(); it != pBlobs->end(); ++it) {
+        (*it)->calcStats();
+    }
+    return pBlobs;
+}
+
+}
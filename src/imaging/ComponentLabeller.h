@@ -0,0 +1,81 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ComponentLabeller_H_
+#define _ComponentLabeller_H_
+
+#include "../api.h"
+#include "Blob.h"
+#include "Run.h"
+
+#include "../graphics/Bitmap.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+namespace avg {
+
+// Finds the connected components (blobs) of all pixels brighter than a threshold.
+// The bitmap is split into horizontal stripes that are labelled in parallel using a
+// union-find structure over the runs of each stripe; the stripes are then joined at
+// their borders. All intermediate buffers are kept between calls, so a labeller that
+// is reused for every camera frame only allocates the blobs it returns.
+// Blobs are returned in the order of their topmost-leftmost run.
+class AVG_API ComponentLabeller: boost::noncopyable
+{
+public:
+    ComponentLabeller();
+    virtual ~ComponentLabeller();
+
+    BlobVectorPtr findComponents(BitmapPtr pBmp, unsigned char threshold);
+
+    // 0 (the default) chooses the number of stripes based on the bitmap size and the
+    // number of threads in the ThreadPool.
+    void setNumStripes(int numStripes);
+
+private:
+    struct Stripe {
+        int m_StartRow;
+        int m_EndRow;
+        RunArray m_Runs;
+        std::vector<int> m_Parents;
+    };
+
+    void labelStripe(Stripe* pStripe, BitmapPtr pBmp, unsigned char threshold);
+    void joinStripes(const Stripe& upperStripe, int upperOffset, int lowerOffset);
+    BlobVectorPtr createBlobs();
+
+    int m_NumStripes;
+    std::vector<Stripe> m_Stripes;
+
+    RunArray m_Runs;
+    std::vector<int> m_Parents;
+    std::vector<int> m_Labels;
+    std::vector<int> m_NumRunsPerBlob;
+};
+
+typedef boost::shared_ptr<ComponentLabeller> ComponentLabellerPtr;
+
+}
+
+#endif
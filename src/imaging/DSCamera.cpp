@@ -133,7 +133,7 @@ void DSCamera::close()
     m_pSampleGrabber->Release();
 }
 
-BitmapPtr DSCamera::getImage(bool bWait)
+BitmapPtr DSCamera::captureImage(bool bWait)
 {
     BitmapPtr pBmp;
     try {
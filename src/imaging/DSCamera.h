@@ -52,7 +52,7 @@ public:
     virtual ~DSCamera();
     virtual void startCapture();
 
-    virtual BitmapPtr getImage(bool bWait);
+    virtual BitmapPtr captureImage(bool bWait);
 
     virtual const std::string& getDevice() const; 
     virtual const std::string& getDriverName() const; 
@@ -213,7 +213,7 @@ void FWCamera::startCapture()
 #endif
 }
 
-BitmapPtr FWCamera::getImage(bool bWait)
+BitmapPtr FWCamera::captureImage(bool bWait)
 {
 #ifdef AVG_ENABLE_1394_2
     bool bGotFrame = false;
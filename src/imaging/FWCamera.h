@@ -51,7 +51,7 @@ public:
     virtual ~FWCamera();
     virtual void startCapture();
 
-    virtual BitmapPtr getImage(bool bWait);
+    virtual BitmapPtr captureImage(bool bWait);
 
     virtual const std::string& getDevice() const; 
     virtual const std::string& getDriverName() const; 
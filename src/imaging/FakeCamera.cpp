@@ -76,7 +76,7 @@ void FakeCamera::close()
 }
 
 
-BitmapPtr FakeCamera::getImage(bool bWait)
+BitmapPtr FakeCamera::captureImage(bool bWait)
 {
     if (bWait) {
         msleep(100);
@@ -43,7 +43,7 @@ public:
     virtual void open();
     virtual void close();
 
-    virtual BitmapPtr getImage(bool bWait);
+    virtual BitmapPtr captureImage(bool bWait);
     virtual bool isCameraAvailable();
 
     virtual const std::string& getDevice() const; 
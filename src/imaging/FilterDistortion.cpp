@@ -23,22 +23,74 @@
 
 #include "FilterDistortion.h"
 
-#include <iostream>
-#include <math.h>
+#include "../graphics/ParallelRows.h"
+
+#include "../base/Exception.h"
+#include "../base/FileHelper.h"
+#include "../base/Logger.h"
+
+#include <boost/bind.hpp>
+
+#include <fstream>
+#include <string.h>
 
 using namespace std;
 
 namespace avg {
 
+static const char CACHE_MAGIC[] = "AVGDISTORTIONMAP";
+static const int CACHE_VERSION = 1;
+static const int NUM_FINGERPRINT_STEPS = 8;
+
 FilterDistortion::FilterDistortion(const IntPoint& srcSize,
-        CoordTransformerPtr pTransformer)
+        CoordTransformerPtr pTransformer, const std::string& sCacheFilename)
     : m_SrcSize(srcSize),
-      m_pTransformer(pTransformer) 
+      m_pTransformer(pTransformer),
+      m_SrcStride(srcSize.x)
+{
+    calcFingerprint();
+    if (sCacheFilename == "" || !loadMap(sCacheFilename)) {
+        calcMap();
+        if (sCacheFilename != "") {
+            saveMap(sCacheFilename);
+        }
+    }
+}
+
+FilterDistortion::~FilterDistortion()
+{
+}
+
+BitmapPtr FilterDistortion::apply(BitmapPtr pBmpSource)
+{
+    AVG_ASSERT(pBmpSource->getBytesPerPixel() == 1);
+    setSrcStride(pBmpSource->getStride());
+    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(m_SrcSize, I8));
+    processRowBands(m_SrcSize.y, m_SrcSize.x, 0, boost::bind(
+            &FilterDistortion::applyToRows, this, pBmpSource->getPixels(), pDestBmp,
+            _1, _2));
+    return pDestBmp;
+}
+
+void FilterDistortion::calcFingerprint()
+{
+    m_Fingerprint.clear();
+    for (int y = 0; y <= NUM_FINGERPRINT_STEPS; ++y) {
+        for (int x = 0; x <= NUM_FINGERPRINT_STEPS; ++x) {
+            glm::dvec2 pt(double(m_SrcSize.x*x)/NUM_FINGERPRINT_STEPS,
+                    double(m_SrcSize.y*y)/NUM_FINGERPRINT_STEPS);
+            m_Fingerprint.push_back(m_pTransformer->inverse_transform_point(pt));
+        }
+    }
+}
+
+void FilterDistortion::calcMap()
 {
     // We use the same dimensions for both of src and dest and just crop.
-    // for each pixel at (x,y) in the dest, m_pMap[x][y] contains an IntPoint that gives 
-    // the coords in the src Bitmap. 
-    m_pMap = new IntPoint[m_SrcSize.y*m_SrcSize.x];
+    // For each pixel at (x,y) in the dest, m_Map[y*width+x] contains the offset of the
+    // corresponding src pixel. Pixels that map to points outside the src bitmap get
+    // the top left src pixel.
+    m_Map.resize(m_SrcSize.x*m_SrcSize.y);
     for (int y = 0; y < m_SrcSize.y; ++y) {
         for (int x = 0; x < m_SrcSize.x; ++x) {
             glm::dvec2 tmp = m_pTransformer->inverse_transform_point(glm::dvec2(x,y));
@@ -46,38 +98,106 @@ FilterDistortion::FilterDistortion(const IntPoint& srcSize,
             if (tmp2.x < m_SrcSize.x && tmp2.y < m_SrcSize.y &&
                     tmp2.x >= 0 && tmp2.y >= 0)
             {
-                m_pMap[y*m_SrcSize.x+x] = tmp2;
+                m_Map[y*m_SrcSize.x+x] = tmp2.y*m_SrcSize.x+tmp2.x;
             } else {
-                m_pMap[y*m_SrcSize.x+x] = IntPoint(0,0);
+                m_Map[y*m_SrcSize.x+x] = 0;
             }
         }
     }
 }
 
-FilterDistortion::~FilterDistortion()
+bool FilterDistortion::loadMap(const string& sFilename)
 {
-    delete[] m_pMap;
+    ifstream file(sFilename.c_str(), ios::in | ios::binary);
+    if (!file) {
+        return false;
+    }
+    char magic[sizeof(CACHE_MAGIC)];
+    int version;
+    IntPoint size;
+    int numFingerprintPoints;
+    file.read(magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&size, sizeof(size));
+    file.read((char*)&numFingerprintPoints, sizeof(numFingerprintPoints));
+    if (!file || memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 ||
+            version != CACHE_VERSION || size != m_SrcSize ||
+            numFingerprintPoints != int(m_Fingerprint.size()))
+    {
+        return false;
+    }
+    vector<glm::dvec2> fingerprint(numFingerprintPoints);
+    file.read((char*)&fingerprint[0], numFingerprintPoints*sizeof(glm::dvec2));
+    if (!file || fingerprint != m_Fingerprint) {
+        return false;
+    }
+    vector<int> map(m_SrcSize.x*m_SrcSize.y);
+    file.read((char*)&map[0], map.size()*sizeof(int));
+    if (!file) {
+        return false;
+    }
+    int maxOffset = m_SrcSize.x*m_SrcSize.y;
+    for (unsigned i = 0; i < map.size(); ++i) {
+        if (map[i] < 0 || map[i] >= maxOffset) {
+            return false;
+        }
+    }
+    m_Map.swap(map);
+    AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+            "Loaded distortion map from " << sFilename << ".");
+    return true;
 }
 
-BitmapPtr FilterDistortion::apply(BitmapPtr pBmpSource)
+void FilterDistortion::saveMap(const string& sFilename) const
 {
-    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(m_SrcSize, I8));
-    unsigned char* pDestLine = pDestBmp->getPixels();
-    unsigned char* pSrcPixels = pBmpSource->getPixels();
-    unsigned char* pDestPixel = pDestLine;
+    ofstream file(sFilename.c_str(), ios::out | ios::binary | ios::trunc);
+    int version = CACHE_VERSION;
+    int numFingerprintPoints = int(m_Fingerprint.size());
+    file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    file.write((const char*)&version, sizeof(version));
+    file.write((const char*)&m_SrcSize, sizeof(m_SrcSize));
+    file.write((const char*)&numFingerprintPoints, sizeof(numFingerprintPoints));
+    file.write((const char*)&m_Fingerprint[0],
+            numFingerprintPoints*sizeof(glm::dvec2));
+    file.write((const char*)&m_Map[0], m_Map.size()*sizeof(int));
+    if (!file) {
+        AVG_LOG_WARNING("Could not write distortion map to " << sFilename << ".");
+    }
+}
+
+void FilterDistortion::setSrcStride(int srcStride)
+{
+    if (srcStride == m_SrcStride) {
+        return;
+    }
+    m_SrcStride = srcStride;
+    if (srcStride == m_SrcSize.x) {
+        m_StridedMap.clear();
+    } else {
+        m_StridedMap.resize(m_Map.size());
+        for (unsigned i = 0; i < m_Map.size(); ++i) {
+            m_StridedMap[i] = (m_Map[i]/m_SrcSize.x)*srcStride + m_Map[i]%m_SrcSize.x;
+        }
+    }
+}
+
+void FilterDistortion::applyToRows(const unsigned char* pSrcPixels, BitmapPtr pDestBmp,
+        int startRow, int endRow) const
+{
+    const int* pMap;
+    if (m_StridedMap.empty()) {
+        pMap = &m_Map[0];
+    } else {
+        pMap = &m_StridedMap[0];
+    }
     int destStride = pDestBmp->getStride();
-    int srcStride = pBmpSource->getStride();
-    IntPoint * pMapPos = m_pMap;
-    for (int y = 0; y < m_SrcSize.y; ++y) {
-        for(int x = 0; x < m_SrcSize.x; ++x) {
-            *pDestPixel = pSrcPixels[pMapPos->x + srcStride*pMapPos->y];
-            pDestPixel++;
-            pMapPos++;
+    for (int y = startRow; y < endRow; ++y) {
+        unsigned char* pDestPixel = pDestBmp->getPixels()+y*destStride;
+        const int* pMapPos = pMap+y*m_SrcSize.x;
+        for (int x = 0; x < m_SrcSize.x; ++x) {
+            pDestPixel[x] = pSrcPixels[pMapPos[x]];
         }
-        pDestLine+=destStride;
-        pDestPixel = pDestLine;
     }
-    return pDestBmp;
 }
 
 }
@@ -34,19 +34,43 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <string>
+#include <vector>
+
 namespace avg {
 
-// TODO: This class doesn't have a unit test.
+// Undistorts I8 camera images using nearest-neighbour sampling. The per-pixel source
+// positions are computed once and stored as a table of source offsets. If
+// sCacheFilename is given, the table is read from that file when it was created for the
+// same transformation and written to it otherwise.
 class AVG_API FilterDistortion: public Filter 
 {
     public:
-        FilterDistortion(const IntPoint& srcSize, CoordTransformerPtr pTransformer);
+        FilterDistortion(const IntPoint& srcSize, CoordTransformerPtr pTransformer,
+                const std::string& sCacheFilename="");
         virtual ~FilterDistortion();
         BitmapPtr apply(BitmapPtr pBmpSource);
+
     private:
+        void calcFingerprint();
+        void calcMap();
+        bool loadMap(const std::string& sFilename);
+        void saveMap(const std::string& sFilename) const;
+        void setSrcStride(int srcStride);
+        void applyToRows(const unsigned char* pSrcPixels, BitmapPtr pDestBmp,
+                int startRow, int endRow) const;
+
         IntPoint m_SrcSize;
         CoordTransformerPtr m_pTransformer;
-        IntPoint* m_pMap;
+
+        // Transformed positions of a few sample points. Used to validate the cache file.
+        std::vector<glm::dvec2> m_Fingerprint;
+        // Source offset for each destination pixel, assuming a source stride of
+        // m_SrcSize.x.
+        std::vector<int> m_Map;
+        // m_Map adjusted for the stride of the last source bitmap.
+        std::vector<int> m_StridedMap;
+        int m_SrcStride;
 };
 
 typedef boost::shared_ptr<FilterDistortion> FilterDistortionPtr;
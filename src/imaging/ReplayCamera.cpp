@@ -0,0 +1,200 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ReplayCamera.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/TimeSource.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <string.h>
+
+using namespace std;
+using namespace boost::interprocess;
+
+namespace avg {
+
+ReplayCamera::ReplayCamera(const string& sFilename, PixelFormat destPF, bool bRealtime)
+    : Camera(I8, destPF, IntPoint(0, 0), 0),
+      m_sFilename(sFilename),
+      m_bRealtime(bRealtime),
+      m_CurFrame(0),
+      m_StartTime(-1)
+{
+    try {
+        m_pFile = boost::shared_ptr<file_mapping>(
+                new file_mapping(sFilename.c_str(), read_only));
+        m_pRegion = boost::shared_ptr<mapped_region>(
+                new mapped_region(*m_pFile, read_only));
+    } catch (interprocess_exception& ex) {
+        throw Exception(AVG_ERR_FILEIO, "Opening camera recording "+sFilename+
+                " failed: "+ex.what());
+    }
+    const char* pHeader = (const char*)m_pRegion->get_address();
+    size_t fileSize = m_pRegion->get_size();
+    int version = 0;
+    IntPoint size;
+    char pfName[CAMREC_PF_NAME_LEN+1];
+    if (fileSize >= size_t(CAMREC_HEADER_SIZE)) {
+        const char* pCur = pHeader+sizeof(CAMREC_MAGIC);
+        memcpy(&version, pCur, sizeof(int));
+        memcpy(&size.x, pCur+sizeof(int), sizeof(int));
+        memcpy(&size.y, pCur+2*sizeof(int), sizeof(int));
+        memcpy(pfName, pCur+3*sizeof(int), CAMREC_PF_NAME_LEN);
+        pfName[CAMREC_PF_NAME_LEN] = 0;
+    }
+    if (fileSize < size_t(CAMREC_HEADER_SIZE) ||
+            memcmp(pHeader, CAMREC_MAGIC, sizeof(CAMREC_MAGIC)) != 0 ||
+            version != CAMREC_VERSION)
+    {
+        throw Exception(AVG_ERR_FILEIO, sFilename+" is not a camera recording.");
+    }
+    PixelFormat pf = stringToPixelFormat(pfName);
+    if (pf == NO_PIXELFORMAT || size.x <= 0 || size.y <= 0) {
+        throw Exception(AVG_ERR_FILEIO, sFilename+": Invalid camera recording header.");
+    }
+    setCamPF(pf);
+    setImgSize(size);
+    m_FrameSize = sizeof(long long) + size.x*size.y*getBytesPerPixel(pf);
+    // Truncated frames at the end (e.g. after a crash while recording) are ignored.
+    m_NumFrames = int((fileSize-CAMREC_HEADER_SIZE)/m_FrameSize);
+    AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+            "Replaying " << m_NumFrames << " camera frames from " << sFilename << ".");
+}
+
+ReplayCamera::~ReplayCamera()
+{
+}
+
+BitmapPtr ReplayCamera::captureImage(bool bWait)
+{
+    if (isAtEnd()) {
+        if (bWait) {
+            msleep(100);
+        }
+        return BitmapPtr();
+    }
+    if (m_bRealtime) {
+        long long now = TimeSource::get()->getCurrentMicrosecs();
+        if (m_StartTime == -1) {
+            m_StartTime = now;
+        }
+        long long dueTime = m_StartTime + getFrameTime(m_CurFrame) - getFrameTime(0);
+        if (now < dueTime) {
+            if (!bWait) {
+                return BitmapPtr();
+            }
+            msleep(int((dueTime-now)/1000));
+        }
+    } else {
+        if (!bWait) {
+            return BitmapPtr();
+        }
+    }
+    BitmapPtr pBmp = readFrame(m_CurFrame);
+    m_CurFrame++;
+    return pBmp;
+}
+
+const string& ReplayCamera::getDevice() const
+{
+    return m_sFilename;
+}
+
+const std::string& ReplayCamera::getDriverName() const
+{
+    static string sDriverName = "replay";
+    static string sRealtimeDriverName = "replay-realtime";
+    if (m_bRealtime) {
+        return sRealtimeDriverName;
+    } else {
+        return sDriverName;
+    }
+}
+
+int ReplayCamera::getFeature(CameraFeature feature) const
+{
+    return 0;
+}
+
+void ReplayCamera::setFeature(CameraFeature feature, int value, bool bIgnoreOldValue)
+{
+}
+
+void ReplayCamera::setFeatureOneShot(CameraFeature feature)
+{
+}
+
+int ReplayCamera::getWhitebalanceU() const
+{
+    return 0;
+}
+
+int ReplayCamera::getWhitebalanceV() const
+{
+    return 0;
+}
+
+void ReplayCamera::setWhitebalance(int u, int v, bool bIgnoreOldValue)
+{
+}
+
+int ReplayCamera::getNumFrames() const
+{
+    return m_NumFrames;
+}
+
+bool ReplayCamera::isAtEnd() const
+{
+    return m_CurFrame >= m_NumFrames;
+}
+
+const unsigned char* ReplayCamera::getFrameData(int i) const
+{
+    return (const unsigned char*)m_pRegion->get_address() + CAMREC_HEADER_SIZE +
+            (size_t)i*m_FrameSize;
+}
+
+long long ReplayCamera::getFrameTime(int i) const
+{
+    long long time;
+    memcpy(&time, getFrameData(i), sizeof(time));
+    return time;
+}
+
+BitmapPtr ReplayCamera::readFrame(int i)
+{
+    // The tracker modifies camera frames in place, so we can't hand out bitmaps that
+    // point into the read-only mapping.
+    IntPoint size = getImgSize();
+    unsigned char* pPixels = (unsigned char*)(getFrameData(i)+sizeof(long long));
+    BitmapPtr pBmp(new Bitmap(size, getCamPF(), pPixels,
+            size.x*getBytesPerPixel(getCamPF()), true));
+    if (getCamPF() != getDestPF()) {
+        pBmp = convertCamFrameToDestPF(pBmp);
+    }
+    return pBmp;
+}
+
+}
@@ -0,0 +1,88 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ReplayCamera_H_
+#define _ReplayCamera_H_
+
+#include "../api.h"
+#include "Camera.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+
+namespace boost {
+namespace interprocess {
+    class file_mapping;
+    class mapped_region;
+}
+}
+
+namespace avg {
+
+// Plays back a recording made with Camera::startRecording(). The file is memory-mapped.
+// In realtime mode, frames are delivered with the timing they were recorded with, so
+// frames are dropped if the consumer is too slow - just like with a real camera.
+// Otherwise, each getImage(true) call returns the next frame immediately and no frames
+// are ever dropped, which makes runs reproducible.
+class AVG_API ReplayCamera: public Camera
+{
+public:
+    ReplayCamera(const std::string& sFilename, PixelFormat destPF, bool bRealtime);
+    virtual ~ReplayCamera();
+
+    virtual const std::string& getDevice() const;
+    virtual const std::string& getDriverName() const;
+
+    virtual int getFeature(CameraFeature feature) const;
+    virtual void setFeature(CameraFeature feature, int Value, bool bIgnoreOldValue=false);
+    virtual void setFeatureOneShot(CameraFeature feature);
+    virtual int getWhitebalanceU() const;
+    virtual int getWhitebalanceV() const;
+    virtual void setWhitebalance(int u, int v, bool bIgnoreOldValue=false);
+
+    int getNumFrames() const;
+    // True if all frames have been delivered.
+    bool isAtEnd() const;
+
+protected:
+    virtual BitmapPtr captureImage(bool bWait);
+
+private:
+    const unsigned char* getFrameData(int i) const;
+    long long getFrameTime(int i) const;
+    BitmapPtr readFrame(int i);
+
+    std::string m_sFilename;
+    bool m_bRealtime;
+    boost::shared_ptr<boost::interprocess::file_mapping> m_pFile;
+    boost::shared_ptr<boost::interprocess::mapped_region> m_pRegion;
+    int m_NumFrames;
+    int m_FrameSize;
+    int m_CurFrame;
+    long long m_StartTime;
+};
+
+typedef boost::shared_ptr<ReplayCamera> ReplayCameraPtr;
+
+}
+
+#endif
@@ -0,0 +1,286 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "TrackerBlobThread.h"
+#include "TrackerThread.h"
+
+#include "../base/ProfilingZoneID.h"
+#include "../base/TimeSource.h"
+#include "../base/ScopeTimer.h"
+#include "../base/Exception.h"
+
+#include "../graphics/Filterfill.h"
+#include "../graphics/Pixel32.h"
+
+#include <boost/bind.hpp>
+
+using namespace std;
+
+namespace avg {
+
+static ProfilingZoneID ProfilingZoneComps("ConnectedComps");
+static ProfilingZoneID ProfilingZoneUpdate("Update");
+static ProfilingZoneID ProfilingZoneDraw("Draw");
+static ProfilingZoneID ProfilingZoneSegmentLatency("Segment latency");
+static ProfilingZoneID ProfilingZoneTrackLatency("Track latency");
+
+TrackerFrame::TrackerFrame()
+    : m_Time(0),
+      m_CaptureMicrosecs(0),
+      m_TrackThreshold(0),
+      m_TouchThreshold(0)
+{
+}
+
+TrackerFrame::TrackerFrame(BitmapPtr pSrcBmp, const IntRect& roi)
+    : m_pSrcBmp(pSrcBmp),
+      m_pTrackBmp(new Bitmap(*pSrcBmp, roi)),
+      m_Time(0),
+      m_CaptureMicrosecs(0),
+      m_TrackThreshold(0),
+      m_TouchThreshold(0)
+{
+}
+
+TrackerBlobThread::TrackerBlobThread(CQueue& cmdQ, TrackerFrameQueuePtr pFrameQ,
+        IBlobTarget* pTarget, MutexPtr pMutex)
+    : WorkerThread<TrackerBlobThread>("TrackerBlobs", cmdQ),
+      m_pFrameQ(pFrameQ),
+      m_pTarget(pTarget),
+      m_pMutex(pMutex),
+      m_pTrackLabeller(new ComponentLabeller()),
+      m_pTouchLabeller(new ComponentLabeller())
+{
+}
+
+TrackerBlobThread::~TrackerBlobThread()
+{
+}
+
+void TrackerBlobThread::requestStop(CQueue& cmdQ, TrackerFrameQueuePtr pFrameQ)
+{
+    cmdQ.pushCmd(boost::bind(&TrackerBlobThread::stop, _1));
+    // The thread may stop without taking any more frames, so a blocking push into a
+    // full queue could wait forever. The caller is the only producer, so once the
+    // pending frames are dropped there is room for the frame that wakes the thread up.
+    pFrameQ->clear();
+    pFrameQ->push(TrackerFramePtr(new TrackerFrame));
+}
+
+bool TrackerBlobThread::work()
+{
+    if (getNumCmdsInQueue() > 0) {
+        // Handle a pending stop before waiting for the next frame.
+        return true;
+    }
+    TrackerFramePtr pFrame = m_pFrameQ->pop(true);
+    if (pFrame->m_pConfig) {
+        calcBlobs(pFrame);
+        ThreadProfiler::get()->reset();
+    }
+    return true;
+}
+
+inline bool isInbetween(float x, float min, float max)
+{
+    return x >= min && x <= max;
+}
+
+bool TrackerBlobThread::isRelevant(BlobPtr pBlob, int minArea, int maxArea,
+        float minEccentricity, float maxEccentricity)
+{
+    bool res;
+    res = isInbetween(pBlob->getArea(), float(minArea), float(maxArea)) && 
+            isInbetween(pBlob->getEccentricity(), minEccentricity, maxEccentricity);
+    return res;
+}
+
+BlobVectorPtr TrackerBlobThread::findRelevantBlobs(const TrackerConfig& config,
+        BlobVectorPtr pBlobs, bool bTouch) 
+{
+    string sConfigPrefix;
+    if (bTouch) {
+        sConfigPrefix = "/tracker/touch/";
+    } else {
+        sConfigPrefix = "/tracker/track/";
+    }
+    int minArea = config.getIntParam(sConfigPrefix+"areabounds/@min");
+    int maxArea = config.getIntParam(sConfigPrefix+"areabounds/@max");
+    float minEccentricity = config.getFloatParam(sConfigPrefix+
+            "eccentricitybounds/@min");
+    float maxEccentricity = config.getFloatParam(sConfigPrefix+
+            "eccentricitybounds/@max");
+    
+    BlobVectorPtr pRelevantBlobs(new BlobVector());
+    for(BlobVector::iterator it = pBlobs->begin(); it != pBlobs->end(); ++it) {
+        if (isRelevant(*it, minArea, maxArea, minEccentricity, maxEccentricity)) {
+            pRelevantBlobs->push_back(*it);
+        }
+        if (pRelevantBlobs->size() > 50) {
+            break;
+        }
+    }
+    return pRelevantBlobs;
+}
+
+void TrackerBlobThread::drawBlobs(const TrackerConfig& config, BlobVectorPtr pBlobs,
+        BitmapPtr pSrcBmp, BitmapPtr pDestBmp, int Offset, bool bTouch)
+{
+    if (!pDestBmp) {
+        return;
+    }
+    ScopeTimer timer(ProfilingZoneDraw);
+    string sConfigPrefix;
+    if (bTouch) {
+        sConfigPrefix = "/tracker/touch/";
+    } else {
+        sConfigPrefix = "/tracker/track/";
+    }
+    int minArea = config.getIntParam(sConfigPrefix+"areabounds/@min");
+    int maxArea = config.getIntParam(sConfigPrefix+"areabounds/@max");
+    float minEccentricity = config.getFloatParam(
+            sConfigPrefix+"eccentricitybounds/@min");
+    float maxEccentricity = config.getFloatParam(
+            sConfigPrefix+"eccentricitybounds/@max");
+    
+    // Get max. pixel value in Bitmap
+    int max = 0;
+    HistogramPtr pHist = pSrcBmp->getHistogram(4);
+    int i;
+    for (i = 255; i >= 0; i--) {
+        if ((*pHist)[i] != 0) {
+            max = i;
+            i = 0;
+        }
+    }
+    
+    for (BlobVector::iterator it2 = pBlobs->begin(); it2 != pBlobs->end(); ++it2) {
+        if (isRelevant(*it2, minArea, maxArea, minEccentricity, maxEccentricity)) {
+            if (bTouch) {
+                (*it2)->render(pSrcBmp, pDestBmp, 
+                        Pixel32(0xFF, 0xFF, 0xFF, 0xFF), Offset, max, bTouch, true,  
+                        Pixel32(0x00, 0x00, 0xFF, 0xFF));
+            } else {
+                (*it2)->render(pSrcBmp, pDestBmp, 
+                        Pixel32(0xFF, 0xFF, 0x00, 0x80), Offset, max, bTouch, true, 
+                        Pixel32(0x00, 0x00, 0xFF, 0xFF));
+            }
+        } else {
+            if (bTouch) {
+                (*it2)->render(pSrcBmp, pDestBmp, 
+                        Pixel32(0xFF, 0x00, 0x00, 0xFF), Offset, max, bTouch, false);
+            } else {
+                (*it2)->render(pSrcBmp, pDestBmp, 
+                        Pixel32(0x80, 0x80, 0x00, 0x80), Offset, max, bTouch, false);
+            }
+        }
+    }
+}
+
+void TrackerBlobThread::calcContours(const TrackerConfig& config, BlobVectorPtr pBlobs)
+{
+    ScopeTimer timer(ProfilingZoneDraw);
+    string sConfigPrefix;
+    sConfigPrefix = "/tracker/track/";
+    int minArea = config.getIntParam(sConfigPrefix+"areabounds/@min");
+    int maxArea = config.getIntParam(sConfigPrefix+"areabounds/@max");
+    float minEccentricity = config.getFloatParam(
+            sConfigPrefix+"eccentricitybounds/@min");
+    float maxEccentricity = config.getFloatParam(
+            sConfigPrefix+"eccentricitybounds/@max");
+    
+    int ContourPrecision = config.getIntParam("/tracker/contourprecision/@value");
+    if (ContourPrecision != 0) {
+        for (BlobVector::iterator it = pBlobs->begin(); it != pBlobs->end(); ++it) {
+            if (isRelevant(*it, minArea, maxArea, minEccentricity, maxEccentricity)) {
+                (*it)->calcContour(ContourPrecision);
+            }
+        }
+    }
+}
+
+void TrackerBlobThread::correlateHands(BlobVectorPtr pTrackBlobs, BlobVectorPtr pTouchBlobs)
+{
+   if (!pTrackBlobs || !pTouchBlobs) {
+       return;
+   }
+    for (BlobVector::iterator it1 = pTouchBlobs->begin(); it1 != pTouchBlobs->end();
+            ++it1) 
+    {
+        BlobPtr pTouchBlob = *it1;
+        IntPoint touchCenter = (IntPoint)(pTouchBlob->getCenter());
+        for (BlobVector::iterator it2 = pTrackBlobs->begin(); it2 != pTrackBlobs->end(); 
+                ++it2) 
+        {
+            BlobPtr pTrackBlob = *it2;
+            if (pTrackBlob->contains(touchCenter)) {
+                pTouchBlob->addRelated(pTrackBlob);
+                pTrackBlob->addRelated(pTouchBlob);
+                break;
+            }
+        }
+    }
+}
+
+void TrackerBlobThread::calcBlobs(TrackerFramePtr pFrame)
+{
+    const TrackerConfig& config = *(pFrame->m_pConfig);
+    BlobVectorPtr pTrackComps;
+    BlobVectorPtr pTouchComps;
+    {
+        ScopeTimer timer(ProfilingZoneComps);
+        lock_guard lock(*m_pMutex);
+        BitmapPtr pDestBmp = pFrame->m_pFingerBmp;
+        if (pDestBmp) {
+            Pixel32 Black(0x00, 0x00, 0x00, 0x00);
+            FilterFill<Pixel32>(Black).applyInPlace(pDestBmp);
+        }
+        {
+            if (pFrame->m_TrackThreshold != 0) {
+                pTrackComps = m_pTrackLabeller->findComponents(pFrame->m_pTrackBmp,
+                        pFrame->m_TrackThreshold);
+                calcContours(config, pTrackComps);
+                drawBlobs(config, pTrackComps, pFrame->m_pTrackBmp, pDestBmp,
+                        pFrame->m_TrackThreshold, false);
+                pTrackComps = findRelevantBlobs(config, pTrackComps, false);
+            }
+            if (pFrame->m_TouchThreshold != 0) {
+                pTouchComps = m_pTouchLabeller->findComponents(pFrame->m_pTouchBmp,
+                        pFrame->m_TouchThreshold);
+                pTouchComps = findRelevantBlobs(config, pTouchComps, true);
+                correlateHands(pTrackComps, pTouchComps);
+                drawBlobs(config, pTouchComps, pFrame->m_pTouchBmp, pDestBmp,
+                        pFrame->m_TouchThreshold, true);
+            }
+        }
+        ScopeTimer::addLatencySample(ProfilingZoneSegmentLatency,
+                TimeSource::get()->getCurrentMicrosecs()-pFrame->m_CaptureMicrosecs);
+        // Send the blobs to the BlobTarget.
+        {
+            ScopeTimer timer(ProfilingZoneUpdate);
+            m_pTarget->update(pTrackComps, pTouchComps, pFrame->m_Time);
+        }
+    }
+    ScopeTimer::addLatencySample(ProfilingZoneTrackLatency,
+            TimeSource::get()->getCurrentMicrosecs()-pFrame->m_CaptureMicrosecs);
+}
+
+}
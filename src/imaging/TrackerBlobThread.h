@@ -0,0 +1,112 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _TrackerBlobThread_H_
+#define _TrackerBlobThread_H_
+
+#include "../api.h"
+#include "TrackerConfig.h"
+#include "Blob.h"
+#include "ComponentLabeller.h"
+
+#include "../base/WorkerThread.h"
+#include "../base/Command.h"
+#include "../base/Queue.h"
+
+#include "../graphics/Bitmap.h"
+
+#include <boost/thread.hpp>
+
+namespace avg {
+
+typedef boost::shared_ptr<boost::mutex> MutexPtr;
+
+class AVG_API IBlobTarget {
+    public:
+        virtual ~IBlobTarget() {};
+        // Note that this function is called by TrackerBlobThread in it's own thread!
+        virtual void update(BlobVectorPtr pTrackBlobs, BlobVectorPtr pTouchBlobs,
+                long long time) = 0;
+};
+
+// A preprocessed camera frame on its way from TrackerThread to TrackerBlobThread. It
+// carries the settings it was processed with, so config changes take effect in frame
+// order.
+struct TrackerFrame
+{
+    TrackerFrame();
+    // m_pTrackBmp becomes the roi of pSrcBmp. It shares the pixels of pSrcBmp, so the
+    // frame keeps pSrcBmp alive until the blob thread is done with it.
+    TrackerFrame(BitmapPtr pSrcBmp, const IntRect& roi);
+
+    BitmapPtr m_pSrcBmp;
+    BitmapPtr m_pTrackBmp;
+    BitmapPtr m_pTouchBmp;
+    BitmapPtr m_pFingerBmp; // Debug image, 0 if disabled.
+    long long m_Time; // Capture time in milliseconds, passed on to the IBlobTarget.
+    long long m_CaptureMicrosecs; // Used for the latency statistics.
+    int m_TrackThreshold;
+    int m_TouchThreshold;
+    TrackerConfigPtr m_pConfig; // 0 for the frame that wakes the thread up to stop.
+};
+
+typedef boost::shared_ptr<TrackerFrame> TrackerFramePtr;
+typedef Queue<TrackerFrame> TrackerFrameQueue;
+typedef boost::shared_ptr<TrackerFrameQueue> TrackerFrameQueuePtr;
+
+// Second stage of the tracker pipeline: finds the blobs in preprocessed frames,
+// filters and correlates them and sends them to the IBlobTarget. Runs in parallel to
+// TrackerThread, which captures and preprocesses the next frame in the meantime. Frames
+// are processed in the order they were captured.
+class AVG_API TrackerBlobThread: public WorkerThread<TrackerBlobThread>
+{
+    public:
+        TrackerBlobThread(CQueue& cmdQ, TrackerFrameQueuePtr pFrameQ,
+                IBlobTarget* pTarget, MutexPtr pMutex);
+        virtual ~TrackerBlobThread();
+
+        // Makes the thread stop after the frame it is currently working on. Pending
+        // frames are dropped. Must be called from the thread that pushes the frames.
+        static void requestStop(CQueue& cmdQ, TrackerFrameQueuePtr pFrameQ);
+
+        bool work();
+
+    private:
+        void calcBlobs(TrackerFramePtr pFrame);
+        bool isRelevant(BlobPtr pBlob, int minArea, int maxArea,
+                float minEccentricity, float maxEccentricity);
+        BlobVectorPtr findRelevantBlobs(const TrackerConfig& config,
+                BlobVectorPtr pBlobs, bool bTouch);
+        void drawBlobs(const TrackerConfig& config, BlobVectorPtr pBlobs,
+                BitmapPtr pSrcBmp, BitmapPtr pDestBmp, int Offset, bool bTouch);
+        void calcContours(const TrackerConfig& config, BlobVectorPtr pBlobs);
+        void correlateHands(BlobVectorPtr pTrackBlobs, BlobVectorPtr pTouchBlobs);
+
+        TrackerFrameQueuePtr m_pFrameQ;
+        IBlobTarget* m_pTarget;
+        MutexPtr m_pMutex;
+        ComponentLabellerPtr m_pTrackLabeller;
+        ComponentLabellerPtr m_pTouchLabeller;
+};
+
+}
+
+#endif
@@ -236,6 +236,11 @@ void TrackerConfig::setTransform(DeDistortPtr pDeDistort)
     pDeDistort->save(*this);
 }
 
+const string& TrackerConfig::getFilename() const
+{
+    return m_sFilename;
+}
+
 void TrackerConfig::dump() const
 {
     string s;
@@ -57,6 +57,10 @@ public:
 
     DeDistortPtr getTransform() const;
     void setTransform(DeDistortPtr pDeDistort);
+
+    // Name of the config file that was loaded. Data derived from the config (such as
+    // the distortion map cache) is stored next to it.
+    const std::string& getFilename() const;
     
     void dump() const;
 
@@ -43,6 +43,8 @@
 #include "../graphics/GPUBlurFilter.h"
 #include "../graphics/BitmapLoader.h"
 
+#include <boost/bind.hpp>
+
 #include <iostream>
 #include <stdlib.h>
 
@@ -58,9 +60,20 @@ static ProfilingZoneID ProfilingZoneDistort("Distort");
 static ProfilingZoneID ProfilingZoneHistogram("Histogram");
 static ProfilingZoneID ProfilingZoneDownscale("Downscale");
 static ProfilingZoneID ProfilingZoneBandpass("Bandpass");
-static ProfilingZoneID ProfilingZoneComps("ConnectedComps");
-static ProfilingZoneID ProfilingZoneUpdate("Update");
-static ProfilingZoneID ProfilingZoneDraw("Draw");
+static ProfilingZoneID ProfilingZonePreprocessLatency("Preprocess latency");
+
+// Frames that are preprocessed but not yet picked up by the blob thread. Keeps memory
+// and latency bounded if blob finding is slower than the camera.
+static const int MAX_QUEUED_FRAMES = 2;
+
+static string getDistortionCacheFilename(const TrackerConfig& config)
+{
+    if (config.getFilename() == "") {
+        return "";
+    } else {
+        return config.getFilename()+".distortionmap";
+    }
+}
 
 TrackerThread::TrackerThread(IntRect roi, CameraPtr pCamera,
         BitmapPtr ppBitmaps[NUM_TRACKER_IMAGES], MutexPtr pMutex, CQueue& cmdQ,
@@ -78,7 +91,8 @@ TrackerThread::TrackerThread(IntRect roi, CameraPtr pCamera,
       m_bCreateFingerImage(false),
       m_NumFrames(0),
       m_NumCamFramesDiscarded(0),
-      m_pImagingContext(0)
+      m_pImagingContext(0),
+      m_pBlobThread(0)
 {
     m_bTrackBrighter = config.getBoolParam("/tracker/brighterregions/@value");
     if (bSubtractHistory) {
@@ -91,9 +105,11 @@ TrackerThread::TrackerThread(IntRect roi, CameraPtr pCamera,
 
     DeDistortPtr pDeDistort = config.getTransform();
     m_pDistorter = FilterDistortionPtr(new FilterDistortion(
-                m_pBitmaps[TRACKER_IMG_CAMERA]->getSize()/m_Prescale, pDeDistort));
+                m_pBitmaps[TRACKER_IMG_CAMERA]->getSize()/m_Prescale, pDeDistort,
+                getDistortionCacheFilename(config)));
 
     m_pConfig = TrackerConfigPtr(new TrackerConfig(config));
+    m_pBlobConfig = TrackerConfigPtr(new TrackerConfig(config));
     m_pCamera->startCapture();
 }
 
@@ -125,6 +141,11 @@ bool TrackerThread::init()
     
     // Done in TrackerInputDevice::ctor to work around Leopard/libdc1394 threading issue.
     //    m_pCamera->open();
+
+    m_pBlobCmdQ = TrackerBlobThread::CQueuePtr(new TrackerBlobThread::CQueue);
+    m_pFrameQ = TrackerFrameQueuePtr(new TrackerFrameQueue(MAX_QUEUED_FRAMES));
+    m_pBlobThread = new boost::thread(TrackerBlobThread(*m_pBlobCmdQ, m_pFrameQ,
+            m_pTarget, m_pMutex));
     return true;
 }
 
@@ -149,6 +170,7 @@ bool TrackerThread::work()
         }
     }
     long long time = TimeSource::get()->getCurrentMillisecs(); 
+    long long captureMicrosecs = TimeSource::get()->getCurrentMicrosecs();
     if (pCamBmp) {
         m_NumFrames++;
         ScopeTimer timer(ProfilingZoneTracker);
@@ -173,7 +195,8 @@ bool TrackerThread::work()
             ScopeTimer timer(ProfilingZoneDistort);
             pDistortedBmp = m_pDistorter->apply(pCamBmp);
         }
-        BitmapPtr pCroppedBmp(new Bitmap(*pDistortedBmp, m_ROI));
+        TrackerFramePtr pFrame(new TrackerFrame(pDistortedBmp, m_ROI));
+        BitmapPtr pCroppedBmp = pFrame->m_pTrackBmp;
         if (m_bCreateDebugImages) {
             lock_guard lock(*m_pMutex);
             m_pBitmaps[TRACKER_IMG_DISTORTED]->copyPixels(*pCroppedBmp);
@@ -187,20 +210,31 @@ bool TrackerThread::work()
             m_pBitmaps[TRACKER_IMG_NOHISTORY]->copyPixels(*pCroppedBmp);
             FilterNormalize(2).applyInPlace(m_pBitmaps[TRACKER_IMG_NOHISTORY]);
         }
-        {
-            BitmapPtr pBmpBandpass;
-            if (m_TouchThreshold != 0) {
-                {
-                    ScopeTimer timer(ProfilingZoneBandpass);
-                    pBmpBandpass = m_pBandpassFilter->apply(pCroppedBmp);
-                }
-                if (m_bCreateDebugImages) {
-                    lock_guard lock(*m_pMutex);
-                    *(m_pBitmaps[TRACKER_IMG_HIGHPASS]) = *pBmpBandpass;
-                }
+        BitmapPtr pBmpBandpass;
+        if (m_TouchThreshold != 0) {
+            {
+                ScopeTimer timer(ProfilingZoneBandpass);
+                pBmpBandpass = m_pBandpassFilter->apply(pCroppedBmp);
+            }
+            if (m_bCreateDebugImages) {
+                lock_guard lock(*m_pMutex);
+                *(m_pBitmaps[TRACKER_IMG_HIGHPASS]) = *pBmpBandpass;
             }
-            calcBlobs(pCroppedBmp, pBmpBandpass, time);
         }
+
+        pFrame->m_pTouchBmp = pBmpBandpass;
+        if (m_bCreateFingerImage) {
+            pFrame->m_pFingerBmp = m_pBitmaps[TRACKER_IMG_FINGERS];
+        }
+        pFrame->m_Time = time;
+        pFrame->m_CaptureMicrosecs = captureMicrosecs;
+        pFrame->m_TrackThreshold = m_TrackThreshold;
+        pFrame->m_TouchThreshold = m_TouchThreshold;
+        pFrame->m_pConfig = m_pBlobConfig;
+        ScopeTimer::addLatencySample(ProfilingZonePreprocessLatency,
+                TimeSource::get()->getCurrentMicrosecs()-captureMicrosecs);
+        // Blocks if the blob thread is more than MAX_QUEUED_FRAMES behind.
+        m_pFrameQ->push(pFrame);
         ThreadProfiler::get()->reset();
     }
     return true;
@@ -208,6 +242,12 @@ bool TrackerThread::work()
 
 void TrackerThread::deinit()
 {
+    if (m_pBlobThread) {
+        TrackerBlobThread::requestStop(*m_pBlobCmdQ, m_pFrameQ);
+        m_pBlobThread->join();
+        delete m_pBlobThread;
+        m_pBlobThread = 0;
+    }
     m_pCamera = CameraPtr();
     AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
             "Total camera frames: " << m_NumFrames);
@@ -244,7 +284,8 @@ void TrackerThread::setConfig(TrackerConfig config, IntRect roi,
     DeDistortPtr pDeDistort = config.getTransform();
     if (!(*m_pTrafo == *pDeDistort)) {
         m_pDistorter = FilterDistortionPtr(new FilterDistortion(
-                m_pBitmaps[TRACKER_IMG_CAMERA]->getSize()/m_Prescale, pDeDistort));
+                m_pBitmaps[TRACKER_IMG_CAMERA]->getSize()/m_Prescale, pDeDistort,
+                getDistortionCacheFilename(config)));
         *m_pTrafo = *pDeDistort;
     }
     int brightness = config.getIntParam("/camera/brightness/@value");
@@ -282,6 +323,7 @@ void TrackerThread::setConfig(TrackerConfig config, IntRect roi,
         }
     }
     m_pConfig = TrackerConfigPtr(new TrackerConfig(config));
+    m_pBlobConfig = TrackerConfigPtr(new TrackerConfig(config));
         
     setBitmaps(roi, ppBitmaps);
     createBandpassFilter();
@@ -329,6 +371,20 @@ void TrackerThread::resetHistory()
         m_pHistoryPreProcessor->reset();
     }
 }
+
+void TrackerThread::startCameraRecording(const string& sFilename)
+{
+    try {
+        m_pCamera->startRecording(sFilename);
+    } catch (Exception& ex) {
+        AVG_LOG_ERROR(ex.getStr());
+    }
+}
+
+void TrackerThread::stopCameraRecording()
+{
+    m_pCamera->stopRecording();
+}
         
 void TrackerThread::drawHistogram(BitmapPtr pDestBmp, BitmapPtr pSrcBmp)
 {
@@ -369,181 +425,4 @@ void TrackerThread::drawHistogram(BitmapPtr pDestBmp, BitmapPtr pSrcBmp)
     }
 }
 
-inline bool isInbetween(float x, float min, float max)
-{
-    return x >= min && x <= max;
-}
-
-bool TrackerThread::isRelevant(BlobPtr pBlob, int minArea, int maxArea,
-        float minEccentricity, float maxEccentricity)
-{
-    bool res;
-    res = isInbetween(pBlob->getArea(), float(minArea), float(maxArea)) && 
-            isInbetween(pBlob->getEccentricity(), minEccentricity, maxEccentricity);
-    return res;
-}
-
-BlobVectorPtr TrackerThread::findRelevantBlobs(BlobVectorPtr pBlobs, bool bTouch) 
-{
-    string sConfigPrefix;
-    if (bTouch) {
-        sConfigPrefix = "/tracker/touch/";
-    } else {
-        sConfigPrefix = "/tracker/track/";
-    }
-    int minArea = m_pConfig->getIntParam(sConfigPrefix+"areabounds/@min");
-    int maxArea = m_pConfig->getIntParam(sConfigPrefix+"areabounds/@max");
-    float minEccentricity = m_pConfig->getFloatParam(sConfigPrefix+
-            "eccentricitybounds/@min");
-    float maxEccentricity = m_pConfig->getFloatParam(sConfigPrefix+
-            "eccentricitybounds/@max");
-    
-    BlobVectorPtr pRelevantBlobs(new BlobVector());
-    for(BlobVector::iterator it = pBlobs->begin(); it != pBlobs->end(); ++it) {
-        if (isRelevant(*it, minArea, maxArea, minEccentricity, maxEccentricity)) {
-            pRelevantBlobs->push_back(*it);
-        }
-        if (pRelevantBlobs->size() > 50) {
-            break;
-        }
-    }
-    return pRelevantBlobs;
-}
-
-void TrackerThread::drawBlobs(BlobVectorPtr pBlobs, BitmapPtr pSrcBmp, 
-        BitmapPtr pDestBmp, int Offset, bool bTouch)
-{
-    if (!pDestBmp) {
-        return;
-    }
-    ScopeTimer timer(ProfilingZoneDraw);
-    string sConfigPrefix;
-    if (bTouch) {
-        sConfigPrefix = "/tracker/touch/";
-    } else {
-        sConfigPrefix = "/tracker/track/";
-    }
-    int minArea = m_pConfig->getIntParam(sConfigPrefix+"areabounds/@min");
-    int maxArea = m_pConfig->getIntParam(sConfigPrefix+"areabounds/@max");
-    float minEccentricity = m_pConfig->getFloatParam(
-            sConfigPrefix+"eccentricitybounds/@min");
-    float maxEccentricity = m_pConfig->getFloatParam(
-            sConfigPrefix+"eccentricitybounds/@max");
-    
-    // Get max. pixel value in Bitmap
-    int max = 0;
-    HistogramPtr pHist = pSrcBmp->getHistogram(4);
-    int i;
-    for (i = 255; i >= 0; i--) {
-        if ((*pHist)[i] != 0) {
-            max = i;
-            i = 0;
-        }
-    }
-    
-    for (BlobVector::iterator it2 = pBlobs->begin(); it2 != pBlobs->end(); ++it2) {
-        if (isRelevant(*it2, minArea, maxArea, minEccentricity, maxEccentricity)) {
-            if (bTouch) {
-                (*it2)->render(pSrcBmp, pDestBmp, 
-                        Pixel32(0xFF, 0xFF, 0xFF, 0xFF), Offset, max, bTouch, true,  
-                        Pixel32(0x00, 0x00, 0xFF, 0xFF));
-            } else {
-                (*it2)->render(pSrcBmp, pDestBmp, 
-                        Pixel32(0xFF, 0xFF, 0x00, 0x80), Offset, max, bTouch, true, 
-                        Pixel32(0x00, 0x00, 0xFF, 0xFF));
-            }
-        } else {
-            if (bTouch) {
-                (*it2)->render(pSrcBmp, pDestBmp, 
-                        Pixel32(0xFF, 0x00, 0x00, 0xFF), Offset, max, bTouch, false);
-            } else {
-                (*it2)->render(pSrcBmp, pDestBmp, 
-                        Pixel32(0x80, 0x80, 0x00, 0x80), Offset, max, bTouch, false);
-            }
-        }
-    }
-}
-
-void TrackerThread::calcContours(BlobVectorPtr pBlobs)
-{
-    ScopeTimer timer(ProfilingZoneDraw);
-    string sConfigPrefix;
-    sConfigPrefix = "/tracker/track/";
-    int minArea = m_pConfig->getIntParam(sConfigPrefix+"areabounds/@min");
-    int maxArea = m_pConfig->getIntParam(sConfigPrefix+"areabounds/@max");
-    float minEccentricity = m_pConfig->getFloatParam(
-            sConfigPrefix+"eccentricitybounds/@min");
-    float maxEccentricity = m_pConfig->getFloatParam(
-            sConfigPrefix+"eccentricitybounds/@max");
-    
-    int ContourPrecision = m_pConfig->getIntParam("/tracker/contourprecision/@value");
-    if (ContourPrecision != 0) {
-        for (BlobVector::iterator it = pBlobs->begin(); it != pBlobs->end(); ++it) {
-            if (isRelevant(*it, minArea, maxArea, minEccentricity, maxEccentricity)) {
-                (*it)->calcContour(ContourPrecision);
-            }
-        }
-    }
-}
-
-void TrackerThread::correlateHands(BlobVectorPtr pTrackBlobs, BlobVectorPtr pTouchBlobs)
-{
-   if (!pTrackBlobs || !pTouchBlobs) {
-       return;
-   }
-    for (BlobVector::iterator it1 = pTouchBlobs->begin(); it1 != pTouchBlobs->end();
-            ++it1) 
-    {
-        BlobPtr pTouchBlob = *it1;
-        IntPoint touchCenter = (IntPoint)(pTouchBlob->getCenter());
-        for (BlobVector::iterator it2 = pTrackBlobs->begin(); it2 != pTrackBlobs->end(); 
-                ++it2) 
-        {
-            BlobPtr pTrackBlob = *it2;
-            if (pTrackBlob->contains(touchCenter)) {
-                pTouchBlob->addRelated(pTrackBlob);
-                pTrackBlob->addRelated(pTouchBlob);
-                break;
-            }
-        }
-    }
-}
-
-void TrackerThread::calcBlobs(BitmapPtr pTrackBmp, BitmapPtr pTouchBmp, long long time) 
-{
-    BlobVectorPtr pTrackComps;
-    BlobVectorPtr pTouchComps;
-    {
-        ScopeTimer timer(ProfilingZoneComps);
-        lock_guard lock(*m_pMutex);
-        BitmapPtr pDestBmp;
-        if (m_bCreateFingerImage) {
-            Pixel32 Black(0x00, 0x00, 0x00, 0x00);
-            FilterFill<Pixel32>(Black).applyInPlace(
-                    m_pBitmaps[TRACKER_IMG_FINGERS]);
-            pDestBmp = m_pBitmaps[TRACKER_IMG_FINGERS];
-        }
-        {
-            if (m_TrackThreshold != 0) {
-                pTrackComps = findConnectedComponents(pTrackBmp, m_TrackThreshold);
-                calcContours(pTrackComps);
-                drawBlobs(pTrackComps, pTrackBmp, pDestBmp, m_TrackThreshold, false);
-                pTrackComps = findRelevantBlobs(pTrackComps, false);
-            }
-            if (m_TouchThreshold != 0) {
-                pTouchComps = findConnectedComponents(pTouchBmp, m_TouchThreshold);
-                pTouchComps = findRelevantBlobs(pTouchComps, true);
-                correlateHands(pTrackComps, pTouchComps);
-                drawBlobs(pTouchComps, pTouchBmp, pDestBmp, m_TouchThreshold, true);
-            }
-        }
-        // Send the blobs to the BlobTarget.
-        {
-            ScopeTimer timer(ProfilingZoneUpdate);
-            m_pTarget->update(pTrackComps, pTouchComps, time);
-        }
-    }
-    
-}
-        
 }
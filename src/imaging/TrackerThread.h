@@ -25,6 +25,7 @@
 #include "TrackerConfig.h"
 #include "Camera.h"
 #include "Blob.h"
+#include "TrackerBlobThread.h"
 #include "FilterDistortion.h"
 #include "DeDistort.h"
 
@@ -53,18 +54,8 @@ typedef enum {
         NUM_TRACKER_IMAGES
 } TrackerImageID;
 
-typedef boost::shared_ptr<boost::mutex> MutexPtr;
 class GLContext;
 
-class AVG_API IBlobTarget {
-    public:
-        virtual ~IBlobTarget() {};
-        // Note that this function is called by TrackerThread in it's own thread!
-        virtual void update(BlobVectorPtr pTrackBlobs, BlobVectorPtr pTouchBlobs,
-                long long time) = 0;
-};
-
-
 class AVG_API TrackerThread: public WorkerThread<TrackerThread>
 {
     public:
@@ -81,6 +72,8 @@ class AVG_API TrackerThread: public WorkerThread<TrackerThread>
                 BitmapPtr ppBitmaps[NUM_TRACKER_IMAGES]);
         void setDebugImages(bool bImg, bool bFinger);
         void resetHistory();
+        void startCameraRecording(const std::string& sFilename);
+        void stopCameraRecording();
     
     private:
         void setBitmaps(IntRect roi, BitmapPtr ppBitmaps[NUM_TRACKER_IMAGES]);
@@ -88,19 +81,13 @@ class AVG_API TrackerThread: public WorkerThread<TrackerThread>
         void checkMessages();
         void calcHistory();
         void drawHistogram(BitmapPtr pDestBmp, BitmapPtr pSrcBmp);
-        void calcBlobs(BitmapPtr pTrackBmp, BitmapPtr pTouchBmp, long long time);
-        bool isRelevant(BlobPtr pBlob, int minArea, int maxArea,
-                float minEccentricity, float maxEccentricity);
-        BlobVectorPtr findRelevantBlobs(BlobVectorPtr pBlobs, bool bTouch);
-        void drawBlobs(BlobVectorPtr pBlobs, BitmapPtr pSrcBmp, BitmapPtr pDestBmp,
-                int Offset, bool bTouch);
-        void calcContours(BlobVectorPtr pBlobs);
-        void correlateHands(BlobVectorPtr pTrackBlobs, BlobVectorPtr pTouchBlobs);
 
         std::string m_sDevice;
         std::string m_sMode;
 
         TrackerConfigPtr m_pConfig;
+        // Separate copy for the blob thread, since TrackerConfig isn't thread-safe.
+        TrackerConfigPtr m_pBlobConfig;
         BitmapPtr m_pCameraMaskBmp;
 
         int m_TouchThreshold; // 0 => no touch events.
@@ -127,6 +114,11 @@ class AVG_API TrackerThread: public WorkerThread<TrackerThread>
         
         GLContext* m_pImagingContext;
         FilterPtr m_pBandpassFilter;
+
+        // Blob finding and tracking runs in a second thread.
+        TrackerBlobThread::CQueuePtr m_pBlobCmdQ;
+        TrackerFrameQueuePtr m_pFrameQ;
+        boost::thread* m_pBlobThread;
 };
 
 }
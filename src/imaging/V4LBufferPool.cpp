@@ -0,0 +1,140 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "V4LBufferPool.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ThreadHelper.h"
+
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <errno.h>
+
+#include <linux/videodev2.h>
+
+#include <cstring>
+
+using namespace std;
+
+namespace avg {
+
+V4LBufferPool::V4LBufferPool(int fd)
+    : m_Fd(fd),
+      m_bStreaming(true),
+      m_NumLent(0)
+{
+}
+
+V4LBufferPool::~V4LBufferPool()
+{
+    for (unsigned i = 0; i < m_Buffers.size(); ++i) {
+        int err = munmap(m_Buffers[i].m_pStart, m_Buffers[i].m_Length);
+        AVG_ASSERT(err != -1);
+    }
+}
+
+void V4LBufferPool::addBuffer(void* pStart, size_t length)
+{
+    Buffer buffer;
+    buffer.m_pStart = pStart;
+    buffer.m_Length = length;
+    m_Buffers.push_back(buffer);
+}
+
+int V4LBufferPool::getNumBuffers() const
+{
+    return int(m_Buffers.size());
+}
+
+unsigned char* V4LBufferPool::getBufferStart(int i) const
+{
+    return (unsigned char*)m_Buffers[i].m_pStart;
+}
+
+bool V4LBufferPool::lend()
+{
+    lock_guard lock(m_Mutex);
+    if (m_NumLent >= getNumBuffers()-MIN_DRIVER_BUFFERS) {
+        return false;
+    }
+    m_NumLent++;
+    return true;
+}
+
+void V4LBufferPool::release(int i)
+{
+    lock_guard lock(m_Mutex);
+    AVG_ASSERT(m_NumLent > 0);
+    m_NumLent--;
+    requeueLocked(i);
+}
+
+void V4LBufferPool::requeue(int i)
+{
+    lock_guard lock(m_Mutex);
+    requeueLocked(i);
+}
+
+int V4LBufferPool::getNumLent()
+{
+    lock_guard lock(m_Mutex);
+    return m_NumLent;
+}
+
+void V4LBufferPool::stopStreaming()
+{
+    lock_guard lock(m_Mutex);
+    m_bStreaming = false;
+}
+
+void V4LBufferPool::requeueLocked(int i)
+{
+    if (m_bStreaming) {
+        struct v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        int rc;
+        do {
+            rc = ioctl(m_Fd, VIDIOC_QBUF, &buf);
+        } while (rc == -1 && errno == EINTR);
+        if (rc == -1) {
+            AVG_LOG_ERROR("V4L Camera: failed to enqueue image buffer.");
+        }
+    }
+}
+
+V4LBufferReleaser::V4LBufferReleaser(V4LBufferPoolPtr pPool, int index)
+    : m_pPool(pPool),
+      m_Index(index)
+{
+}
+
+void V4LBufferReleaser::operator()(Bitmap* pBmp)
+{
+    delete pBmp;
+    m_pPool->release(m_Index);
+}
+
+}
@@ -0,0 +1,97 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _V4LBufferPool_H_
+#define _V4LBufferPool_H_
+
+#include "../api.h"
+
+#include "../graphics/Bitmap.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <vector>
+
+namespace avg {
+
+// Owns the mmapped driver buffers of a V4LCamera. Bitmaps that point into a buffer keep
+// a reference to the pool, so the buffers stay mapped until the last of them is gone,
+// even if the camera has been closed in the meantime. Buffers can be released from any
+// thread.
+class AVG_API V4LBufferPool
+{
+public:
+    // Buffers that are always left to the driver so it can continue capturing.
+    static const int MIN_DRIVER_BUFFERS = 2;
+
+    V4LBufferPool(int fd);
+    ~V4LBufferPool();
+
+    void addBuffer(void* pStart, size_t length);
+    int getNumBuffers() const;
+    unsigned char* getBufferStart(int i) const;
+
+    // Returns false if too many buffers are in use outside the driver already.
+    bool lend();
+    // Gives back a buffer that was lent and queues it to the driver.
+    void release(int i);
+    // Queues a buffer that wasn't lent to the driver.
+    void requeue(int i);
+    int getNumLent();
+
+    // After this, buffers are no longer queued to the driver.
+    void stopStreaming();
+
+private:
+    struct Buffer {
+        void* m_pStart;
+        size_t m_Length;
+    };
+
+    void requeueLocked(int i);
+
+    boost::mutex m_Mutex;
+    int m_Fd;
+    std::vector<Buffer> m_Buffers;
+    bool m_bStreaming;
+    int m_NumLent;
+};
+
+typedef boost::shared_ptr<V4LBufferPool> V4LBufferPoolPtr;
+
+// Deleter for bitmaps that point into a driver buffer.
+class AVG_API V4LBufferReleaser
+{
+public:
+    V4LBufferReleaser(V4LBufferPoolPtr pPool, int index);
+
+    void operator()(Bitmap* pBmp);
+
+private:
+    V4LBufferPoolPtr m_pPool;
+    int m_Index;
+};
+
+}
+
+#endif
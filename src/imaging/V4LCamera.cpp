@@ -28,6 +28,7 @@
 #include "../base/Exception.h"
 #include "../base/StringHelper.h"
 #include "../base/GLMHelper.h"
+#include "../base/ConfigMgr.h"
 
 #include <sys/stat.h>
 #include <sys/ioctl.h>
@@ -117,17 +118,16 @@ V4LCamera::~V4LCamera()
 
 void V4LCamera::close()
 {
+    if (m_pBufferPool) {
+        m_pBufferPool->stopStreaming();
+    }
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     int rc = xioctl(m_Fd, VIDIOC_STREAMOFF, &type);
     if (rc == -1) {
         AVG_LOG_ERROR("VIDIOC_STREAMOFF");
     }
-    vector<Buffer>::iterator it;
-    for (it = m_vBuffers.begin(); it != m_vBuffers.end(); ++it) {
-        int err = munmap(it->start, it->length);
-        AVG_ASSERT (err != -1);
-    }
-    m_vBuffers.clear();
+    // The buffers are unmapped when the last frame that uses them is released.
+    m_pBufferPool = V4LBufferPoolPtr();
 
     ::close(m_Fd);
     AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO, "V4L2 Camera closed");
@@ -163,7 +163,7 @@ int V4LCamera::getV4LPF(PixelFormat pf)
     }
 }
 
-BitmapPtr V4LCamera::getImage(bool bWait)
+BitmapPtr V4LCamera::captureImage(bool bWait)
 {
     struct v4l2_buffer buf;
     CLEAR(buf);
@@ -208,7 +208,7 @@ BitmapPtr V4LCamera::getImage(bool bWait)
         }
     }
 
-    unsigned char * pCaptureBuffer = (unsigned char*)m_vBuffers[buf.index].start;
+    unsigned char * pCaptureBuffer = m_pBufferPool->getBufferStart(buf.index);
 
     float lineLen;
     switch (getCamPF()) {
@@ -221,6 +221,12 @@ BitmapPtr V4LCamera::getImage(bool bWait)
         default:
             lineLen = getImgSize().x*getBytesPerPixel(getCamPF());
     }
+    if (getCamPF() == getDestPF() && m_pBufferPool->lend()) {
+        // Zero-copy: The buffer goes back to the driver when the bitmap is deleted.
+        return BitmapPtr(new Bitmap(getImgSize(), getCamPF(), pCaptureBuffer, lineLen,
+                false, "CameraBmp"), V4LBufferReleaser(m_pBufferPool, buf.index));
+    }
+
     BitmapPtr pCamBmp(new Bitmap(getImgSize(), getCamPF(), pCaptureBuffer, lineLen,
             false, "TempCameraBmp"));
 
@@ -229,9 +235,7 @@ BitmapPtr V4LCamera::getImage(bool bWait)
 //            << pDestBmp->getPixelFormat() << endl;
 
     // enqueues free buffer for mmap
-    if (-1 == xioctl (m_Fd, VIDIOC_QBUF, &buf)) {
-        AVG_ASSERT_MSG(false, "V4L Camera: failed to enqueue image buffer.");
-    }
+    m_pBufferPool->requeue(buf.index);
 
     return pDestBmp;
 }
@@ -530,7 +534,7 @@ void V4LCamera::startCapture()
     unsigned int i;
     enum v4l2_buf_type type;
 
-    for (i = 0; i < m_vBuffers.size(); ++i) {
+    for (i = 0; i < unsigned(m_pBufferPool->getNumBuffers()); ++i) {
         struct v4l2_buffer buf;
 
         CLEAR(buf);
@@ -665,7 +669,16 @@ void V4LCamera::initMMap()
     struct v4l2_requestbuffers req;
     CLEAR(req);
 
-    req.count = 4;
+    int numBuffers = ConfigMgr::get()->getIntOption("cam", "v4lbuffers", 4);
+    if (numBuffers <= V4LBufferPool::MIN_DRIVER_BUFFERS) {
+        AVG_LOG_WARNING("cam/v4lbuffers is " << numBuffers << ". With "
+                << V4LBufferPool::MIN_DRIVER_BUFFERS
+                << " or fewer buffers, all camera frames are copied.");
+        if (numBuffers < V4LBufferPool::MIN_DRIVER_BUFFERS) {
+            numBuffers = V4LBufferPool::MIN_DRIVER_BUFFERS;
+        }
+    }
+    req.count = numBuffers;
     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     req.memory = V4L2_MEMORY_MMAP;
 
@@ -684,11 +697,16 @@ void V4LCamera::initMMap()
         cerr << "Insufficient buffer memory on " << m_sDevice;
         AVG_ASSERT(false);
     }
+    if (int(req.count) <= V4LBufferPool::MIN_DRIVER_BUFFERS &&
+            numBuffers > V4LBufferPool::MIN_DRIVER_BUFFERS)
+    {
+        AVG_LOG_WARNING("V4L2: " << m_sDevice << " only provides " << req.count
+                << " capture buffers. All camera frames are copied.");
+    }
 
-    m_vBuffers.clear();
+    m_pBufferPool = V4LBufferPoolPtr(new V4LBufferPool(m_Fd));
 
     for (int i = 0; i < int(req.count); ++i) {
-        Buffer tmp;
         struct v4l2_buffer buf;
 
         CLEAR (buf);
@@ -701,19 +719,17 @@ void V4LCamera::initMMap()
             AVG_ASSERT(false);
         }
 
-        tmp.length = buf.length;
-
-        tmp.start = mmap (NULL /* start anywhere */,
+        void* pStart = mmap (NULL /* start anywhere */,
             buf.length,
             PROT_READ | PROT_WRITE /* required */,
             MAP_SHARED /* recommended */,
             m_Fd, buf.m.offset);
 
-        if (MAP_FAILED == tmp.start) {
+        if (MAP_FAILED == pStart) {
             AVG_ASSERT(false);
         }
 
-        m_vBuffers.push_back(tmp);
+        m_pBufferPool->addBuffer(pStart, buf.length);
     }
 }
 }
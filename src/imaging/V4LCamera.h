@@ -26,6 +26,10 @@
 #include "../avgconfigwrapper.h"
 
 #include "Camera.h"
+#include "V4LBufferPool.h"
+
+#include <boost/shared_ptr.hpp>
+
 #include <string>
 #include <vector>
 
@@ -33,19 +37,20 @@ namespace avg {
 
 typedef unsigned int V4LCID_t;
 
-class AVG_API V4LCamera: public Camera {
 
-    struct Buffer {
-        void * start;
-        size_t length;
-    };
+// If no pixel format conversion is needed, frames are returned without copying: The
+// bitmap points directly into the mmapped driver buffer, and the buffer is given back to
+// the driver when the last reference to the bitmap is released. Only a limited number of
+// buffers are handed out this way, so the driver always has buffers to capture into;
+// the number of driver buffers is set by the cam/v4lbuffers config option.
+class AVG_API V4LCamera: public Camera {
 
 public:
     V4LCamera(std::string sDevice, int channel, IntPoint size, PixelFormat camPF,
             PixelFormat destPF, float frameRate);
     virtual ~V4LCamera();
 
-    virtual BitmapPtr getImage(bool bWait);
+    virtual BitmapPtr captureImage(bool bWait);
     virtual bool isCameraAvailable();
 
     virtual const std::string& getDevice() const;
@@ -91,7 +96,7 @@ private:
     std::string m_sDevice;
     std::string m_sDriverName;
     std::string m_sModelName;
-    std::vector<Buffer> m_vBuffers;
+    V4LBufferPoolPtr m_pBufferPool;
     bool m_bCameraAvailable;
     int m_v4lPF;
 };
@@ -0,0 +1,355 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ComponentLabeller.h"
+#include "FilterDistortion.h"
+#include "DeDistort.h"
+#include "CameraRecorder.h"
+#include "ReplayCamera.h"
+#include "TrackerThread.h"
+#include "TrackerConfig.h"
+
+#include "../graphics/Bitmap.h"
+#include "../graphics/BitmapLoader.h"
+#include "../graphics/Filterfill.h"
+#include "../graphics/Pixel8.h"
+#include "../graphics/Pixel32.h"
+
+#include "../base/TimeSource.h"
+#include "../base/ThreadPool.h"
+#include "../base/Exception.h"
+#include "../base/FileHelper.h"
+#include "../base/Logger.h"
+#include "../base/ScopeTimer.h"
+#include "../base/StringHelper.h"
+
+#include <boost/bind.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+
+using namespace avg;
+using namespace std;
+
+template<class TEST>
+void runPerformanceTest(TEST& PerfTest, int numRuns=500)
+{
+    long long StartTime = TimeSource::get()->getCurrentMicrosecs();
+    for (int i = 0; i < numRuns; ++i) {
+        PerfTest.run();
+    }
+    float ActiveTime = (TimeSource::get()->getCurrentMicrosecs()-StartTime)/1000.;
+    cerr << PerfTest.getName() << ": " << ActiveTime/numRuns << " ms" << endl;
+}
+
+class PerfTestBase {
+public:
+    PerfTestBase(string sName)
+        : m_sName(sName)
+    {
+    }
+
+    std::string getName()
+    {
+        return m_sName;
+    }
+
+private:
+    std::string m_sName;
+};
+
+class LabellerPerfTest: public PerfTestBase {
+public:
+    LabellerPerfTest(const string& sBmpName, BitmapPtr pBmp, int numThreads)
+        : PerfTestBase(getTestName(sBmpName, pBmp->getSize(), numThreads)),
+          m_pBmp(pBmp)
+    {
+    }
+
+    void run()
+    {
+        m_Labeller.findComponents(m_pBmp, 128);
+    }
+
+private:
+    static string getTestName(const string& sBmpName, const IntPoint& size,
+            int numThreads)
+    {
+        stringstream ss;
+        ss << "LabellerPerfTest (" << sBmpName << ", " << size << ", " << numThreads
+                << " threads)";
+        return ss.str();
+    }
+
+    BitmapPtr m_pBmp;
+    ComponentLabeller m_Labeller;
+};
+
+class BlobPerfTest: public PerfTestBase {
+public:
+    BlobPerfTest(const string& sBmpName, BitmapPtr pBmp)
+        : PerfTestBase("BlobPerfTest ("+sBmpName+")")
+    {
+        m_pBlobs = findConnectedComponents(pBmp, 128);
+    }
+
+    void run()
+    {
+        for (BlobVector::iterator it = m_pBlobs->begin(); it != m_pBlobs->end(); ++it) {
+            (*it)->calcStats();
+            (*it)->calcContour(3);
+        }
+    }
+
+private:
+    BlobVectorPtr m_pBlobs;
+};
+
+class DistortionPerfTest: public PerfTestBase {
+public:
+    DistortionPerfTest(BitmapPtr pBmp, DeDistortPtr pDeDistort, int numThreads)
+        : PerfTestBase(getTestName(pBmp->getSize(), numThreads)),
+          m_pBmp(pBmp),
+          m_Filter(pBmp->getSize(), pDeDistort)
+    {
+    }
+
+    void run()
+    {
+        m_Filter.apply(m_pBmp);
+    }
+
+private:
+    static string getTestName(const IntPoint& size, int numThreads)
+    {
+        stringstream ss;
+        ss << "DistortionPerfTest (" << size << ", " << numThreads << " threads)";
+        return ss.str();
+    }
+
+    BitmapPtr m_pBmp;
+    FilterDistortion m_Filter;
+};
+
+// Camera image with numBlobs bright ellipses (fingers, hands) and some sensor noise.
+BitmapPtr createSyntheticFrame(const IntPoint& size, int numBlobs, int seed=1)
+{
+    BitmapPtr pBmp(new Bitmap(size, I8));
+    FilterFill<Pixel8>(Pixel8(0)).applyInPlace(pBmp);
+    srand(seed);
+    unsigned char* pPixels = pBmp->getPixels();
+    int stride = pBmp->getStride();
+    for (int i = 0; i < numBlobs; ++i) {
+        int radiusX = rand()%40+5;
+        int radiusY = rand()%40+5;
+        int centerX = rand()%size.x;
+        int centerY = rand()%size.y;
+        for (int y = max(centerY-radiusY, 0); y < min(centerY+radiusY, size.y); ++y) {
+            for (int x = max(centerX-radiusX, 0); x < min(centerX+radiusX, size.x); ++x)
+            {
+                float dx = float(x-centerX)/radiusX;
+                float dy = float(y-centerY)/radiusY;
+                if (dx*dx+dy*dy < 1) {
+                    pPixels[y*stride+x] = 255;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < size.x*size.y/100; ++i) {
+        pPixels[(rand()%size.y)*stride+rand()%size.x] = 255;
+    }
+    return pBmp;
+}
+
+void runLabellerPerfTests(const string& sBmpName, BitmapPtr pBmp)
+{
+    int numRuns = max(10, 200*640*480/(pBmp->getSize().x*pBmp->getSize().y));
+    int oldNumThreads = ThreadPool::get()->getNumThreads();
+    for (int numThreads = 1; numThreads <= 8; numThreads *= 2) {
+        ThreadPool::get()->setNumThreads(numThreads);
+        LabellerPerfTest test(sBmpName, pBmp, numThreads);
+        runPerformanceTest(test, numRuns);
+    }
+    ThreadPool::get()->setNumThreads(oldNumThreads);
+
+    BlobPerfTest blobTest(sBmpName, pBmp);
+    runPerformanceTest(blobTest, numRuns);
+}
+
+void runDistortionPerfTests(BitmapPtr pBmp)
+{
+    vector<double> params;
+    params.push_back(0.01);
+    params.push_back(0.05);
+    glm::vec2 size(pBmp->getSize());
+    DeDistortPtr pDeDistort(new DeDistort(size, params, 0.05, 0.02,
+            glm::dvec2(10,-5), glm::dvec2(1.02,0.98)));
+
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    FilterDistortion filter(pBmp->getSize(), pDeDistort);
+    cerr << "DistortionPerfTest setup (" << pBmp->getSize() << "): "
+            << (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000. << " ms"
+            << endl;
+
+    int oldNumThreads = ThreadPool::get()->getNumThreads();
+    for (int numThreads = 1; numThreads <= 8; numThreads *= 2) {
+        ThreadPool::get()->setNumThreads(numThreads);
+        DistortionPerfTest test(pBmp, pDeDistort, numThreads);
+        runPerformanceTest(test, 200);
+    }
+    ThreadPool::get()->setNumThreads(oldNumThreads);
+}
+
+class FrameCounter: public IBlobTarget {
+public:
+    FrameCounter()
+        : m_NumFrames(0)
+    {
+    }
+
+    virtual void update(BlobVectorPtr pTrackBlobs, BlobVectorPtr pTouchBlobs,
+            long long time)
+    {
+        lock_guard lock(m_Mutex);
+        m_NumFrames++;
+    }
+
+    int getNumFrames()
+    {
+        lock_guard lock(m_Mutex);
+        return m_NumFrames;
+    }
+
+private:
+    boost::mutex m_Mutex;
+    int m_NumFrames;
+};
+
+// Runs a camera recording through the complete tracker at maximum speed. The per-stage
+// timings are dumped by the tracker threads when they end. Uses ./avgtrackerrc if it
+// exists and avgtrackerrc.minimal otherwise.
+void runTrackerReplayTest(const string& sRecording)
+{
+    ScopeTimer::enableTimers(true);
+    Logger::get()->configureCategory(Logger::category::PROFILE, Logger::severity::INFO);
+
+    ReplayCamera* pReplayCamera = new ReplayCamera(sRecording, I8, false);
+    CameraPtr pCamera(pReplayCamera);
+    IntPoint size = pCamera->getImgSize();
+    TrackerConfig config;
+    if (fileExists("avgtrackerrc")) {
+        config.load();
+    } else {
+        copyFile("avgtrackerrc.minimal", "avgtrackerrc");
+        config.load();
+        unlink("avgtrackerrc");
+    }
+    config.setParam("/camera/size/@x", toString(size.x));
+    config.setParam("/camera/size/@y", toString(size.y));
+
+    IntRect roi(IntPoint(0, 0), size);
+    BitmapPtr ppBitmaps[NUM_TRACKER_IMAGES];
+    for (int i = 0; i < NUM_TRACKER_IMAGES; ++i) {
+        switch (i) {
+            case TRACKER_IMG_CAMERA:
+                ppBitmaps[i] = BitmapPtr(new Bitmap(size, I8));
+                break;
+            case TRACKER_IMG_HISTOGRAM:
+                ppBitmaps[i] = BitmapPtr(new Bitmap(IntPoint(256, 256), I8));
+                FilterFill<Pixel8>(Pixel8(0)).applyInPlace(ppBitmaps[i]);
+                break;
+            case TRACKER_IMG_FINGERS:
+                ppBitmaps[i] = BitmapPtr(new Bitmap(roi.size(), B8G8R8A8));
+                FilterFill<Pixel32>(Pixel32(0,0,0,0)).applyInPlace(ppBitmaps[i]);
+                break;
+            default:
+                ppBitmaps[i] = BitmapPtr(new Bitmap(roi.size(), I8));
+                FilterFill<Pixel8>(Pixel8(0)).applyInPlace(ppBitmaps[i]);
+        }
+    }
+
+    MutexPtr pMutex(new boost::mutex);
+    TrackerThread::CQueue cmdQ;
+    FrameCounter counter;
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    boost::thread trackerThread(TrackerThread(roi, pCamera, ppBitmaps, pMutex, cmdQ,
+            &counter, true, config));
+    int numFrames = pReplayCamera->getNumFrames();
+    while (counter.getNumFrames() < numFrames) {
+        msleep(1);
+    }
+    float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+    cmdQ.pushCmd(boost::bind(&TrackerThread::stop, _1));
+    trackerThread.join();
+    cerr << "TrackerReplayTest (" << sRecording << ", " << size << "): "
+            << numFrames << " frames, " << activeTime/numFrames << " ms per frame"
+            << endl;
+}
+
+void runTrackerReplayTests()
+{
+    // 10 seconds of synthetic 60 Hz camera frames.
+    string sRecording = "benchmarkimaging.rec";
+    {
+        CameraRecorder recorder(sRecording);
+        for (int i = 0; i < 600; ++i) {
+            recorder.addFrame(createSyntheticFrame(IntPoint(640, 480), 10, i),
+                    i*1000000/60);
+        }
+    }
+    runTrackerReplayTest(sRecording);
+    unlink(sRecording.c_str());
+}
+
+void runPerformanceTests()
+{
+    runDistortionPerfTests(createSyntheticFrame(IntPoint(1600, 1250), 20));
+
+    // 2 megapixel camera frames with few and with many blobs.
+    runLabellerPerfTests("synthetic, 20 blobs",
+            createSyntheticFrame(IntPoint(1600, 1250), 20));
+    runLabellerPerfTests("synthetic, 500 blobs",
+            createSyntheticFrame(IntPoint(1600, 1250), 500));
+
+    const char* ppFNames[] = {"FilterWipeBorderResult1", "FilterClearBorderResult1"};
+    for (unsigned i = 0; i < sizeof(ppFNames)/sizeof(ppFNames[0]); ++i) {
+        string sFName = string("baseline/")+ppFNames[i]+".png";
+        try {
+            runLabellerPerfTests(ppFNames[i], loadBitmap(sFName, I8));
+        } catch (Exception& ex) {
+            cerr << "Skipping " << sFName << ": " << ex.getStr() << endl;
+        }
+    }
+}
+
+// Usage: benchmarkimaging [recording]. If a camera recording is given, only the tracker
+// replay benchmark is run on it.
+int main(int nargs, char** args)
+{
+    BitmapLoader::init(true);
+    if (nargs > 1) {
+        runTrackerReplayTest(args[1]);
+    } else {
+        runPerformanceTests();
+        runTrackerReplayTests();
+    }
+}
@@ -21,30 +21,47 @@
 
 #include "FakeCamera.h"
 #include "TrackerThread.h"
+#include "TrackerBlobThread.h"
 #include "TrackerConfig.h"
 #include "DeDistort.h"
 #include "FilterWipeBorder.h"
 #include "FilterClearBorder.h"
+#include "ComponentLabeller.h"
+#include "FilterDistortion.h"
+#include "CameraRecorder.h"
+#include "ReplayCamera.h"
+#ifdef AVG_ENABLE_V4L2
+#include "V4LBufferPool.h"
+#endif
 
 #include "../graphics/GraphicsTest.h"
 #include "../graphics/Filtergrayscale.h"
 #include "../graphics/BitmapLoader.h"
+#include "../graphics/Filterfill.h"
+#include "../graphics/Pixel8.h"
 
 #include "../base/TestSuite.h"
 #include "../base/Exception.h"
 #include "../base/FileHelper.h"
 #include "../base/MathHelper.h"
+#include "../base/TimeSource.h"
 
 #include <boost/thread/thread.hpp>
 #include <boost/bind.hpp>
+#include <boost/weak_ptr.hpp>
 
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sstream>
 
 #include <glib-object.h>
 
+#ifdef AVG_ENABLE_V4L2
+#include <sys/mman.h>
+#endif
+
 using namespace avg;
 using namespace std;
 
@@ -170,6 +187,620 @@ public:
     }
 };
 
+class FilterDistortionTest: public Test
+{
+public:
+    FilterDistortionTest()
+      : Test("FilterDistortionTest", 2)
+    {}
+
+    void runTests()
+    {
+        vector<double> params;
+        params.push_back(0.01);
+        params.push_back(0.05);
+        DeDistortPtr pDeDistort(new DeDistort(glm::vec2(16,16), params, 0.1, 0.05,
+                glm::dvec2(3,-2), glm::dvec2(1.05,0.95)));
+
+        const char* ppFNames[] = {"FilterWipeBorderResult1", "FilterClearBorderResult1"};
+        for (unsigned i = 0; i < sizeof(ppFNames)/sizeof(ppFNames[0]); ++i) {
+            BitmapPtr pSrcBmp = loadBitmap(string("baseline/")+ppFNames[i]+".png", I8);
+            FilterDistortion filter(pSrcBmp->getSize(), pDeDistort);
+            BitmapPtr pDestBmp = filter.apply(pSrcBmp);
+            TEST(*pDestBmp == *distortReference(pSrcBmp, pDeDistort));
+
+            // Source with a stride that is larger than the width.
+            IntRect srcRect(IntPoint(1,1), pSrcBmp->getSize()-IntPoint(1,1));
+            BitmapPtr pSubBmp(new Bitmap(*pSrcBmp, srcRect));
+            FilterDistortion subFilter(pSubBmp->getSize(), pDeDistort);
+            BitmapPtr pSubDestBmp = subFilter.apply(pSubBmp);
+            TEST(*pSubDestBmp == *distortReference(pSubBmp, pDeDistort));
+            TEST(*(filter.apply(pSrcBmp)) == *pDestBmp);
+        }
+
+        BitmapPtr pSrcBmp = loadBitmap("baseline/FilterWipeBorderResult1.png", I8);
+        BitmapPtr pRefBmp = distortReference(pSrcBmp, pDeDistort);
+        string sCacheFName = "testdistortion.map";
+        unlink(sCacheFName.c_str());
+        {
+            FilterDistortion filter(pSrcBmp->getSize(), pDeDistort, sCacheFName);
+            TEST(fileExists(sCacheFName));
+            TEST(*(filter.apply(pSrcBmp)) == *pRefBmp);
+        }
+        {
+            FilterDistortion filter(pSrcBmp->getSize(), pDeDistort, sCacheFName);
+            TEST(*(filter.apply(pSrcBmp)) == *pRefBmp);
+        }
+        {
+            // Cache file created for a different transformation.
+            vector<double> otherParams;
+            otherParams.push_back(0);
+            otherParams.push_back(0.1);
+            DeDistortPtr pOtherDeDistort(new DeDistort(glm::vec2(16,16), otherParams,
+                    0.0, 0.0, glm::dvec2(0,0), glm::dvec2(1,1)));
+            FilterDistortion filter(pSrcBmp->getSize(), pOtherDeDistort, sCacheFName);
+            TEST(*(filter.apply(pSrcBmp)) ==
+                    *distortReference(pSrcBmp, pOtherDeDistort));
+        }
+        {
+            // Corrupt cache file.
+            writeWholeFile(sCacheFName, "garbage");
+            FilterDistortion filter(pSrcBmp->getSize(), pDeDistort, sCacheFName);
+            TEST(*(filter.apply(pSrcBmp)) == *pRefBmp);
+        }
+        unlink(sCacheFName.c_str());
+    }
+
+private:
+    // Straightforward per-pixel nearest-neighbour lookup.
+    BitmapPtr distortReference(BitmapPtr pSrcBmp, CoordTransformerPtr pTransformer)
+    {
+        IntPoint size = pSrcBmp->getSize();
+        BitmapPtr pDestBmp(new Bitmap(size, I8));
+        for (int y = 0; y < size.y; ++y) {
+            for (int x = 0; x < size.x; ++x) {
+                glm::dvec2 pt = pTransformer->inverse_transform_point(glm::dvec2(x,y));
+                IntPoint srcPt(int(pt.x+0.5), int(pt.y+0.5));
+                if (srcPt.x < 0 || srcPt.y < 0 || srcPt.x >= size.x || srcPt.y >= size.y)
+                {
+                    srcPt = IntPoint(0,0);
+                }
+                pDestBmp->getPixels()[y*pDestBmp->getStride()+x] =
+                        pSrcBmp->getPixels()[srcPt.y*pSrcBmp->getStride()+srcPt.x];
+            }
+        }
+        return pDestBmp;
+    }
+};
+
+
+class ReplayCameraTest: public Test
+{
+public:
+    ReplayCameraTest()
+      : Test("ReplayCameraTest", 2)
+    {}
+
+    void runTests()
+    {
+        string sFName = "testcamera.rec";
+        vector<BitmapPtr> pBmps;
+        {
+            CameraRecorder recorder(sFName);
+            for (int i = 0; i < 3; ++i) {
+                BitmapPtr pBmp(new Bitmap(IntPoint(16, 12), I8));
+                FilterFill<Pixel8>(Pixel8(i*50)).applyInPlace(pBmp);
+                pBmp->setPixel(IntPoint(i, i), Pixel8(255));
+                recorder.addFrame(pBmp, 1000000+i*30000);
+                pBmps.push_back(pBmp);
+            }
+            // Frames with a different format are skipped.
+            recorder.addFrame(BitmapPtr(new Bitmap(IntPoint(8, 8), I8)), 1090000);
+            TEST(recorder.getNumFrames() == 3);
+        }
+        {
+            ReplayCamera camera(sFName, I8, false);
+            TEST(camera.getNumFrames() == 3);
+            TEST(camera.getImgSize() == IntPoint(16, 12));
+            TEST(!camera.getImage(false));
+            for (int i = 0; i < 3; ++i) {
+                BitmapPtr pBmp = camera.getImage(true);
+                TEST(pBmp && *pBmp == *pBmps[i]);
+            }
+            TEST(camera.isAtEnd());
+            TEST(!camera.getImage(false));
+        }
+        {
+            ReplayCamera camera(sFName, I8, true);
+            TEST(camera.getImage(true));
+            TEST(!camera.getImage(false));
+            long long startTime = TimeSource::get()->getCurrentMillisecs();
+            BitmapPtr pBmp = camera.getImage(true);
+            TEST(*pBmp == *pBmps[1]);
+            TEST(TimeSource::get()->getCurrentMillisecs()-startTime >= 20);
+            msleep(40);
+            pBmp = camera.getImage(false);
+            TEST(pBmp && *pBmp == *pBmps[2]);
+        }
+        {
+            // The camera factory selects the replay mode by driver name.
+            CameraPtr pCamera = createCamera("replay", sFName, -1, false,
+                    IntPoint(16, 12), I8, I8, 30);
+            TEST(pCamera->getDriverName() == "replay");
+            TEST(pCamera->getDevice() == sFName);
+            pCamera = createCamera("replay-realtime", sFName, -1, false,
+                    IntPoint(16, 12), I8, I8, 30);
+            TEST(pCamera->getDriverName() == "replay-realtime");
+        }
+        {
+            // Recording and playback through the Camera interface.
+            vector<string> sPictures;
+            sPictures.push_back(getSrcDirName()+"baseline/FilterWipeBorderResult1.png");
+            sPictures.push_back(getSrcDirName()+"baseline/FilterClearBorderResult1.png");
+            FakeCamera fakeCamera(sPictures);
+            fakeCamera.open();
+            fakeCamera.startRecording(sFName);
+            TEST(fakeCamera.isRecording());
+            BitmapPtr pBmp1 = fakeCamera.getImage(true);
+            BitmapPtr pBmp2 = fakeCamera.getImage(true);
+            fakeCamera.stopRecording();
+            TEST(!fakeCamera.isRecording());
+
+            ReplayCamera camera(sFName, I8, false);
+            TEST(camera.getNumFrames() == 2);
+            TEST(*camera.getImage(true) == *pBmp1);
+            TEST(*camera.getImage(true) == *pBmp2);
+        }
+        {
+            // A truncated last frame is ignored.
+            string sContents;
+            readWholeFile(sFName, sContents);
+            writeWholeFile(sFName, sContents.substr(0, sContents.size()-10));
+            ReplayCamera camera(sFName, I8, false);
+            TEST(camera.getNumFrames() == 1);
+        }
+        writeWholeFile(sFName, "garbage");
+        bool bExceptionThrown = false;
+        try {
+            ReplayCamera camera(sFName, I8, false);
+        } catch (const Exception&) {
+            bExceptionThrown = true;
+        }
+        TEST(bExceptionThrown);
+        unlink(sFName.c_str());
+#ifdef __linux__
+        {
+            // Write errors stop the recording instead of throwing.
+            CameraRecorder recorder("/dev/full");
+            BitmapPtr pBmp(new Bitmap(IntPoint(256, 256), I8));
+            FilterFill<Pixel8>(Pixel8(0)).applyInPlace(pBmp);
+            TEST(!recorder.addFrame(pBmp, 1000000));
+            TEST(!recorder.addFrame(pBmp, 1030000));
+            TEST(recorder.getNumFrames() == 0);
+        }
+#endif
+    }
+};
+
+
+class ComponentLabellerTest: public Test
+{
+public:
+    ComponentLabellerTest()
+        : Test("ComponentLabellerTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        // Two arms that only join in the last row.
+        const char* uShape[] = {
+                "..........",
+                ".##....##.",
+                ".##....##.",
+                ".##....##.",
+                ".##....##.",
+                ".##....##.",
+                ".#######..",
+                ".........."};
+        BitmapPtr pBmp = createBmp(uShape, 8);
+        for (int numStripes = 1; numStripes <= 8; ++numStripes) {
+            BlobVectorPtr pBlobs = findComponents(pBmp, numStripes);
+            TEST(pBlobs->size() == 1);
+            TEST((*pBlobs)[0]->getArea() == 27);
+            TEST((*pBlobs)[0]->getBoundingBox() == IntRect(1, 1, 9, 6));
+        }
+
+        // Single dark pixels are bridged, single bright pixels are ignored and runs
+        // need to overlap to be connected.
+        const char* noise[] = {
+                "##.###....#.",
+                "..........#.",
+                "...#........",
+                "......##....",
+                "........##..",
+                "............"};
+        pBmp = createBmp(noise, 6);
+        BlobVectorPtr pBlobs = findComponents(pBmp, 1);
+        TEST(pBlobs->size() == 3);
+        TEST((*pBlobs)[0]->getArea() == 6);
+        TEST((*pBlobs)[1]->getBoundingBox() == IntRect(6, 3, 8, 3));
+        TEST((*pBlobs)[2]->getBoundingBox() == IntRect(8, 4, 10, 4));
+
+        // Many overlapping rectangles: the result may not depend on the number of
+        // stripes.
+        pBmp = BitmapPtr(new Bitmap(IntPoint(320, 240), I8));
+        FilterFill<Pixel8>(Pixel8(0)).applyInPlace(pBmp);
+        srand(42);
+        for (int i = 0; i < 60; ++i) {
+            IntPoint pos(rand()%300, rand()%220);
+            IntPoint size(rand()%30+2, rand()%30+2);
+            IntRect rect(pos, glm::min(pos+size, pBmp->getSize()));
+            FilterFill<Pixel8>(Pixel8(255)).applyInPlace(
+                    BitmapPtr(new Bitmap(*pBmp, rect)));
+        }
+        BlobVectorPtr pRefBlobs = findComponents(pBmp, 1);
+        TEST(pRefBlobs->size() > 1);
+        int stripeCounts[] = {2, 3, 7, 240, 0};
+        for (int i = 0; i < 5; ++i) {
+            pBlobs = findComponents(pBmp, stripeCounts[i]);
+            TEST(pBlobs->size() == pRefBlobs->size());
+            for (unsigned j = 0; j < pBlobs->size() && j < pRefBlobs->size(); ++j) {
+                BlobPtr pBlob = (*pBlobs)[j];
+                BlobPtr pRefBlob = (*pRefBlobs)[j];
+                QUIET_TEST(pBlob->getArea() == pRefBlob->getArea());
+                QUIET_TEST(pBlob->getBoundingBox() == pRefBlob->getBoundingBox());
+                QUIET_TEST(almostEqual(pBlob->getCenter(), pRefBlob->getCenter()));
+            }
+        }
+    }
+
+private:
+    BitmapPtr createBmp(const char* ppRows[], int numRows)
+    {
+        int width = int(strlen(ppRows[0]));
+        BitmapPtr pBmp(new Bitmap(IntPoint(width, numRows), I8));
+        for (int y = 0; y < numRows; ++y) {
+            unsigned char* pLine = pBmp->getPixels()+y*pBmp->getStride();
+            for (int x = 0; x < width; ++x) {
+                pLine[x] = (ppRows[y][x] == '#') ? 255 : 0;
+            }
+        }
+        return pBmp;
+    }
+
+    BlobVectorPtr findComponents(BitmapPtr pBmp, int numStripes)
+    {
+        ComponentLabeller labeller;
+        labeller.setNumStripes(numStripes);
+        return labeller.findComponents(pBmp, 128);
+    }
+};
+
+class BlobTest: public Test
+{
+public:
+    BlobTest()
+        : Test("BlobTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        // Random overlapping ellipses produce blobs with holes, concavities and
+        // one-pixel-wide parts.
+        BitmapPtr pBmp(new Bitmap(IntPoint(200, 150), I8));
+        FilterFill<Pixel8>(Pixel8(0)).applyInPlace(pBmp);
+        srand(7);
+        for (int i = 0; i < 40; ++i) {
+            glm::vec2 center(rand()%200, rand()%150);
+            glm::vec2 radius(rand()%20+1, rand()%20+1);
+            for (int y = 0; y < 150; ++y) {
+                unsigned char* pLine = pBmp->getPixels()+y*pBmp->getStride();
+                for (int x = 0; x < 200; ++x) {
+                    glm::vec2 d = (glm::vec2(x, y)-center)/radius;
+                    if (glm::dot(d, d) < 1) {
+                        pLine[x] = 255;
+                    }
+                }
+            }
+        }
+        BlobVectorPtr pBlobs = findConnectedComponents(pBmp, 128);
+        TEST(pBlobs->size() > 10);
+        bool bStatsOK = true;
+        bool bContoursOK = true;
+        unsigned maxRuns = 0;
+        for (unsigned i = 0; i < pBlobs->size(); ++i) {
+            BlobPtr pBlob = (*pBlobs)[i];
+            maxRuns = max(maxRuns, unsigned(pBlob->getRuns()->size()));
+            bStatsOK &= checkStats(pBlob);
+            for (int precision = 1; precision < 5; precision += 3) {
+                ContourSeq refContour = traceContour(pBlob, precision);
+                pBlob->calcContour(precision);
+                bContoursOK &= (pBlob->getContour() == refContour);
+            }
+        }
+        // Moments are accumulated in batches of 64 runs.
+        TEST(maxRuns > 64);
+        TEST(bStatsOK);
+        TEST(bContoursOK);
+    }
+
+private:
+    bool checkStats(BlobPtr pBlob)
+    {
+        // Pixel by pixel.
+        double area = 0;
+        glm::dvec2 sum(0, 0);
+        double sumXX = 0;
+        double sumYY = 0;
+        double sumXY = 0;
+        RunArray* pRuns = pBlob->getRuns();
+        for (RunArray::iterator it = pRuns->begin(); it != pRuns->end(); ++it) {
+            for (int x = it->m_StartCol; x < it->m_EndCol; ++x) {
+                double y = it->m_Row;
+                area++;
+                sum += glm::dvec2(x, y);
+                sumXX += x*x;
+                sumYY += y*y;
+                sumXY += x*y;
+            }
+        }
+        glm::dvec2 center = sum/area;
+        double c_xx = sumXX/area-center.x*center.x;
+        double c_yy = sumYY/area-center.y*center.y;
+        double c_xy = sumXY/area-center.x*center.y;
+        float orientation = float(0.5*atan2(2*c_xy, c_xx-c_yy));
+        return pBlob->getArea() == area &&
+                almostEqual(pBlob->getCenter(), glm::vec2(center)) &&
+                almostEqual(pBlob->getInertia(), float(c_xx+c_yy), 0.001f) &&
+                (c_xy == 0 || almostEqual(pBlob->getOrientation(), orientation, 0.001f));
+    }
+
+    ContourSeq traceContour(BlobPtr pBlob, int precision)
+    {
+        // Moore neighbor tracing, looking at every pixel.
+        static const IntPoint neighbors[] = {IntPoint(1, 0), IntPoint(1, -1),
+                IntPoint(0, -1), IntPoint(-1, -1), IntPoint(-1, 0), IntPoint(-1, 1),
+                IntPoint(0, 1), IntPoint(1, 1)};
+        ContourSeq contour;
+        RunArray* pRuns = pBlob->getRuns();
+        IntPoint firstPt((*pRuns)[0].m_StartCol, (*pRuns)[0].m_Row);
+        IntPoint pt = firstPt;
+        int i = precision;
+        int dir = 1;
+        do {
+            i++;
+            if (i >= precision) {
+                contour.push_back(pt);
+                i = 0;
+            }
+            dir = (dir & 1) ? (dir+2)%8 : (dir+1)%8;
+            for (int j = 0; j < 8; ++j) {
+                if (pBlob->contains(pt+neighbors[dir])) {
+                    pt += neighbors[dir];
+                    break;
+                }
+                dir = (dir+7)%8;
+            }
+        } while (pt != firstPt);
+        return contour;
+    }
+};
+
+#ifdef AVG_ENABLE_V4L2
+class V4LBufferPoolTest: public Test
+{
+public:
+    V4LBufferPoolTest()
+        : Test("V4LBufferPoolTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        // Anonymous memory stands in for the driver buffers. Streaming is stopped, so
+        // nothing is queued to a device.
+        V4LBufferPoolPtr pPool(new V4LBufferPool(-1));
+        for (int i = 0; i < 4; ++i) {
+            void* pStart = mmap(0, 4096, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            TEST(pStart != MAP_FAILED);
+            pPool->addBuffer(pStart, 4096);
+        }
+        pPool->stopStreaming();
+
+        // Two buffers always stay with the driver.
+        TEST(pPool->lend());
+        TEST(pPool->lend());
+        TEST(!pPool->lend());
+        TEST(pPool->getNumLent() == 2);
+        pPool->release(0);
+        TEST(pPool->getNumLent() == 1);
+        TEST(pPool->lend());
+        pPool->requeue(3);
+        TEST(pPool->getNumLent() == 2);
+        pPool->release(0);
+        pPool->release(1);
+        TEST(pPool->getNumLent() == 0);
+
+        // Bitmaps that point into a buffer give it back when they are deleted and keep
+        // the pool alive until then.
+        TEST(pPool->lend());
+        BitmapPtr pBmp(new Bitmap(IntPoint(64, 64), I8, pPool->getBufferStart(2), 64,
+                false), V4LBufferReleaser(pPool, 2));
+        BitmapPtr pBmpCopy = pBmp;
+        TEST(pPool->getNumLent() == 1);
+        boost::weak_ptr<V4LBufferPool> pWeakPool = pPool;
+        pPool = V4LBufferPoolPtr();
+        TEST(!pWeakPool.expired());
+        pBmp = BitmapPtr();
+        TEST(pWeakPool.lock()->getNumLent() == 1);
+        pBmpCopy = BitmapPtr();
+        TEST(pWeakPool.expired());
+    }
+};
+#endif
+
+// Blob target that blocks in update() until it is released, so the blob thread falls
+// behind the frames that are queued for it.
+class BlockingBlobTarget: public IBlobTarget
+{
+public:
+    BlockingBlobTarget()
+        : m_NumUpdates(0),
+          m_bReleased(false)
+    {
+    }
+
+    virtual void update(BlobVectorPtr pTrackBlobs, BlobVectorPtr pTouchBlobs,
+            long long time)
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        m_NumUpdates++;
+        m_pTrackBlobs = pTrackBlobs;
+        m_Cond.notify_all();
+        while (!m_bReleased) {
+            m_Cond.wait(lock);
+        }
+    }
+
+    void waitForUpdate()
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        while (m_NumUpdates == 0) {
+            m_Cond.wait(lock);
+        }
+    }
+
+    void release()
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        m_bReleased = true;
+        m_Cond.notify_all();
+    }
+
+    int getNumUpdates()
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        return m_NumUpdates;
+    }
+
+    BlobVectorPtr getTrackBlobs()
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        return m_pTrackBlobs;
+    }
+
+private:
+    int m_NumUpdates;
+    BlobVectorPtr m_pTrackBlobs;
+    bool m_bReleased;
+    boost::mutex m_Mutex;
+    boost::condition m_Cond;
+};
+
+static void stopBlobThread(TrackerBlobThread::CQueue* pCmdQ,
+        TrackerFrameQueuePtr pFrameQ, boost::thread* pThread)
+{
+    TrackerBlobThread::requestStop(*pCmdQ, pFrameQ);
+    pThread->join();
+}
+
+class TrackerBlobThreadTest: public Test
+{
+public:
+    TrackerBlobThreadTest()
+        : Test("TrackerBlobThreadTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        testStop();
+        testFrameOwnership();
+    }
+
+private:
+    void testStop()
+    {
+        // Shut down while the blob thread is busy and the frame queue is full.
+        TrackerBlobThread::CQueue cmdQ;
+        TrackerFrameQueuePtr pFrameQ(new TrackerFrameQueue(2));
+        BlockingBlobTarget target;
+        MutexPtr pMutex(new boost::mutex);
+        boost::thread blobThread(TrackerBlobThread(cmdQ, pFrameQ, &target, pMutex));
+
+        TrackerConfigPtr pConfig(new TrackerConfig());
+        for (int i = 0; i < 3; ++i) {
+            TrackerFramePtr pFrame(new TrackerFrame);
+            pFrame->m_pConfig = pConfig;
+            pFrameQ->push(pFrame);
+        }
+        target.waitForUpdate();
+        TEST(pFrameQ->size() == 2);
+
+        boost::thread stopThread(boost::bind(&stopBlobThread, &cmdQ, pFrameQ,
+                &blobThread));
+        // Give the stop request time to arrive before the current frame is done. If
+        // waking up the thread blocks, the queue stays full.
+        long long startTime = TimeSource::get()->getCurrentMillisecs();
+        while (pFrameQ->size() != 1 &&
+                TimeSource::get()->getCurrentMillisecs()-startTime < 1000)
+        {
+            msleep(1);
+        }
+        target.release();
+        bool bStopped = stopThread.timed_join(boost::posix_time::seconds(10));
+        TEST(bStopped);
+        TEST(target.getNumUpdates() == 1);
+        if (!bStopped) {
+            // Don't destroy objects the hanging threads still use.
+            exit(1);
+        }
+    }
+
+    void testFrameOwnership()
+    {
+        // The track bitmap is a region of the distorted camera image, which the
+        // tracker thread drops as soon as the frame is queued.
+        copyFile(getSrcDirName()+"avgtrackerrc.minimal", "avgtrackerrc");
+        TrackerConfigPtr pConfig(new TrackerConfig());
+        pConfig->load();
+        unlink("avgtrackerrc");
+
+        BitmapPtr pSrcBmp(new Bitmap(IntPoint(160, 120), I8));
+        FilterFill<Pixel8>(Pixel8(0)).applyInPlace(pSrcBmp);
+        FilterFill<Pixel8>(Pixel8(255)).applyInPlace(
+                BitmapPtr(new Bitmap(*pSrcBmp, IntRect(60, 40, 100, 80))));
+        TrackerFramePtr pFrame(new TrackerFrame(pSrcBmp, IntRect(20, 20, 140, 100)));
+        pFrame->m_TrackThreshold = 128;
+        pFrame->m_pConfig = pConfig;
+        boost::weak_ptr<Bitmap> pWeakSrcBmp = pSrcBmp;
+        pSrcBmp = BitmapPtr();
+        TEST(!pWeakSrcBmp.expired());
+
+        TrackerBlobThread::CQueue cmdQ;
+        TrackerFrameQueuePtr pFrameQ(new TrackerFrameQueue(2));
+        BlockingBlobTarget target;
+        target.release();
+        MutexPtr pMutex(new boost::mutex);
+        boost::thread blobThread(TrackerBlobThread(cmdQ, pFrameQ, &target, pMutex));
+        pFrameQ->push(pFrame);
+        pFrame = TrackerFramePtr();
+        target.waitForUpdate();
+        stopBlobThread(&cmdQ, pFrameQ, &blobThread);
+
+        BlobVectorPtr pBlobs = target.getTrackBlobs();
+        TEST(pBlobs && pBlobs->size() == 1);
+        if (pBlobs && pBlobs->size() == 1) {
+            TEST(almostEqual((*pBlobs)[0]->getCenter(), glm::vec2(59.5f, 39.5f)));
+            TEST((*pBlobs)[0]->getArea() == 1600);
+        }
+        TEST(pWeakSrcBmp.expired());
+    }
+};
+
 #ifdef _WIN32
 #pragma warning(disable: 4996)
 #endif
@@ -218,6 +849,14 @@ public:
         addTest(TestPtr(new FilterWipeBorderTest));
         addTest(TestPtr(new FilterClearBorderTest));
         addTest(TestPtr(new DeDistortTest));
+        addTest(TestPtr(new FilterDistortionTest));
+        addTest(TestPtr(new ReplayCameraTest));
+        addTest(TestPtr(new ComponentLabellerTest));
+        addTest(TestPtr(new BlobTest));
+        addTest(TestPtr(new TrackerBlobThreadTest));
+#ifdef AVG_ENABLE_V4L2
+        addTest(TestPtr(new V4LBufferPoolTest));
+#endif
         addTest(TestPtr(new SerializeTest));
     }
 };
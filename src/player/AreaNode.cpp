@@ -69,6 +69,7 @@ void AreaNode::registerType()
 AreaNode::AreaNode()
     : m_RelViewport(0,0,0,0),
       m_Transform(glm::mat4(0)),
+      m_ParentTransform(glm::mat4(0)),
       m_bTransformChanged(true)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -107,6 +108,7 @@ void AreaNode::connectDisplay()
         notifySubscribers("SIZE_CHANGED", m_RelViewport.size());
     }
     m_bTransformChanged = true;
+    hitBoundsChanged();
     Node::connectDisplay();
 }
 
@@ -182,6 +184,7 @@ void AreaNode::setAngle(float angle)
 {
     m_Angle = fmod(angle, 2*(float)M_PI);
     m_bTransformChanged = true;
+    hitBoundsChanged();
 }
 
 glm::vec2 AreaNode::getPivot() const
@@ -199,6 +202,7 @@ void AreaNode::setPivot(const glm::vec2& pt)
     m_Pivot.y = pt.y;
     m_bHasCustomPivot = true;
     m_bTransformChanged = true;
+    hitBoundsChanged();
 }
 
 const std::string& AreaNode::getElementOutlineColor() const
@@ -237,12 +241,31 @@ void AreaNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements
     }
 }
 
+FRect AreaNode::calcHitBounds() const
+{
+    glm::vec2 size = getSize();
+    glm::vec2 corners[4] = {toGlobal(glm::vec2(0,0)), toGlobal(glm::vec2(size.x,0)),
+            toGlobal(glm::vec2(0,size.y)), toGlobal(size)};
+    FRect bounds(corners[0], corners[0]);
+    for (int i = 1; i < 4; ++i) {
+        bounds.tl = glm::min(bounds.tl, corners[i]);
+        bounds.br = glm::max(bounds.br, corners[i]);
+    }
+    // Leave some room for rounding errors in toLocal().
+    return FRect(bounds.tl-glm::vec2(1,1), bounds.br+glm::vec2(1,1));
+}
+
 void AreaNode::maybeRender(const glm::mat4& parentTransform)
 {
     AVG_ASSERT(getState() == NS_CANRENDER);
     if (isVisible()) {
-        calcTransform();
-        m_Transform = parentTransform*m_LocalTransform;
+        // The absolute transform only changes if this node or one of its ancestors
+        // moved, so it's cached across frames.
+        if (m_bTransformChanged || parentTransform != m_ParentTransform) {
+            calcTransform();
+            m_ParentTransform = parentTransform;
+            m_Transform = parentTransform*m_LocalTransform;
+        }
         render();
     }
 }
@@ -295,6 +318,7 @@ void AreaNode::setViewport(float x, float y, float width, float height)
         notifySubscribers("SIZE_CHANGED", m_RelViewport.size());
     }
     m_bTransformChanged = true;
+    hitBoundsChanged();
 }
 
 const FRect& AreaNode::getRelViewport() const
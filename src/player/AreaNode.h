@@ -103,6 +103,7 @@ class AVG_API AreaNode: public Node
     protected:
         AreaNode();
         glm::vec2 getUserSize() const;
+        FRect calcHitBounds() const;
         Pixel32 getEffectiveOutlineColor(Pixel32 parentColor) const;
 
     private:
@@ -117,6 +118,7 @@ class AVG_API AreaNode: public Node
         
         glm::vec2 m_UserSize;
         glm::mat4 m_Transform;
+        glm::mat4 m_ParentTransform;
         glm::mat4 m_LocalTransform;
         bool m_bTransformChanged;
 };
@@ -43,7 +43,7 @@ BitmapManager::BitmapManager()
     }
     
     m_pCmdQueue = BitmapManagerThread::CQueuePtr(new BitmapManagerThread::CQueue);
-    m_pMsgQueue = BitmapManagerMsgQueuePtr(new BitmapManagerMsgQueue(8));
+    m_pMsgQueue = BitmapManagerMsgQueuePtr(new BitmapManagerMsgQueue(8, QUEUE_MPSC));
 
     startThreads(1);
 
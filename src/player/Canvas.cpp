@@ -49,7 +49,14 @@ Canvas::Canvas(Player * pPlayer)
       m_PlaybackEndSignal(&IPlaybackEndListener::onPlaybackEnd),
       m_FrameEndSignal(&IFrameEndListener::onFrameEnd),
       m_PreRenderSignal(&IPreRenderListener::onPreRender),
-      m_ClipLevel(0)
+      m_ClipLevel(0),
+      m_NumPreRenderedNodes(0),
+      m_NumSkippedPreRenderNodes(0),
+      m_NumDrawCalls(0),
+      m_NumStateChanges(0),
+      m_NumRenderedFrames(0),
+      m_TotalDrawCalls(0),
+      m_TotalStateChanges(0)
 {
 }
 
@@ -77,6 +84,16 @@ void Canvas::initPlayback(int multiSampleSamples)
 void Canvas::stopPlayback(bool bIsAbort)
 {
     if (m_bIsPlaying) {
+        if (m_NumRenderedFrames > 0) {
+            AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                    "Render statistics: ");
+            AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                    "  Draw calls per frame: " 
+                    << float(m_TotalDrawCalls)/m_NumRenderedFrames);
+            AVG_TRACE(Logger::category::PROFILE, Logger::severity::INFO,
+                    "  State changes per frame: " 
+                    << float(m_TotalStateChanges)/m_NumRenderedFrames);
+        }
         if (!bIsAbort) {
             m_PlaybackEndSignal.emit();
         }
@@ -240,7 +257,33 @@ void Canvas::preRender()
     ScopeTimer Timer(PreRenderProfilingZone);
     m_pVertexArray->reset();
     createStdSubVA();
-    m_pRootNode->preRender(m_pVertexArray, true, 1.0f);
+    Node::resetPreRenderStats();
+    m_pRootNode->maybePreRender(m_pVertexArray, true, 1.0f, true);
+    m_NumPreRenderedNodes = Node::getNumPreRenderedNodes();
+    m_NumSkippedPreRenderNodes = Node::getNumSkippedPreRenderNodes();
+    m_NumDrawCalls = 0;
+    m_NumStateChanges = 0;
+    m_NumRenderedFrames++;
+}
+
+int Canvas::getNumPreRenderedNodes() const
+{
+    return m_NumPreRenderedNodes;
+}
+
+int Canvas::getNumSkippedPreRenderNodes() const
+{
+    return m_NumSkippedPreRenderNodes;
+}
+
+int Canvas::getNumDrawCalls() const
+{
+    return m_NumDrawCalls;
+}
+
+int Canvas::getNumStateChanges() const
+{
+    return m_NumStateChanges;
 }
 
 static ProfilingZoneID RootRenderProfilingZone("RootNode: render");
@@ -273,7 +316,15 @@ void Canvas::renderWindow(WindowPtr pWindow, MCFBOPtr pFBO, const IntRect& viewp
     m_pVertexArray->activate();
     {
         ScopeTimer timer(RootRenderProfilingZone);
+        GLContext* pContext = pWindow->getGLContext();
+        pContext->resetDrawStats();
+        pContext->startDrawBatching();
         m_pRootNode->maybeRender(projMat);
+        pContext->endDrawBatching();
+        m_NumDrawCalls += pContext->getNumDrawCalls();
+        m_NumStateChanges += pContext->getNumStateChanges();
+        m_TotalDrawCalls += pContext->getNumDrawCalls();
+        m_TotalStateChanges += pContext->getNumStateChanges();
     }
     renderOutlines(projMat);
 }
@@ -336,6 +387,8 @@ void Canvas::resetFXSchedule()
 
 void Canvas::clip(const glm::mat4& transform, SubVertexArray& va, GLenum stencilOp)
 {
+    GLContext* pContext = GLContext::getCurrent();
+    pContext->stateChanged();
     // Disable drawing to color buffer
     glColorMask(0, 0, 0, 0);
 
@@ -351,6 +404,7 @@ void Canvas::clip(const glm::mat4& transform, SubVertexArray& va, GLenum stencil
     pShader->setTransform(transform);
     pShader->activate();
     va.draw();
+    pContext->stateChanged();
 
     // Set stencil test
     glStencilFunc(GL_LEQUAL, m_ClipLevel, ~0);
@@ -105,6 +105,13 @@ class AVG_API Canvas: public ExportedObject
         void scheduleFXRender(const RasterNodePtr& pNode);
         SubVertexArray& getStdSubVA();
 
+        // Node counts of the last preRender() pass.
+        int getNumPreRenderedNodes() const;
+        int getNumSkippedPreRenderNodes() const;
+        // Counts for the last rendered frame.
+        int getNumDrawCalls() const;
+        int getNumStateChanges() const;
+
     protected:
         Player * getPlayer() const;
         void preRender();
@@ -134,6 +141,14 @@ class AVG_API Canvas: public ExportedObject
 
         int m_MultiSampleSamples;
         int m_ClipLevel;
+        int m_NumPreRenderedNodes;
+        int m_NumSkippedPreRenderNodes;
+        int m_NumDrawCalls;
+        int m_NumStateChanges;
+
+        int m_NumRenderedFrames;
+        long long m_TotalDrawCalls;
+        long long m_TotalStateChanges;
 
         std::vector<RasterNodePtr> m_pScheduledFXNodes;
 };
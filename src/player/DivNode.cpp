@@ -32,6 +32,8 @@
 #include "../base/MathHelper.h"
 #include "../base/ObjectCounter.h"
 
+#include "../graphics/GLContext.h"
+
 #include <iostream>
 #include <sstream>
 #include <limits>
@@ -41,6 +43,8 @@ using namespace boost;
 
 namespace avg {
 
+// Below this, checking all children is cheaper than maintaining the grid.
+static const unsigned MIN_CHILDREN_FOR_HIT_TEST_GRID = 32;
 
 void DivNode::registerType()
 {
@@ -58,6 +62,9 @@ void DivNode::registerType()
 }
 
 DivNode::DivNode(const ArgList& args)
+    : m_bLastChildActive(false),
+      m_LastChildOpacity(-1),
+      m_bChildrenStatic(false)
 {
     args.setMembers(this);
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -167,6 +174,7 @@ void DivNode::insertChild(NodePtr pChild, unsigned i)
     }
     std::vector<NodePtr>::iterator pos = m_Children.begin()+i;
     m_Children.insert(pos, pChild);
+    m_HitTestGrid.invalidate();
     try {
         pChild->setParent(this, getState(), getCanvas());
     } catch (Exception&) {
@@ -188,6 +196,8 @@ void DivNode::reorderChild(NodePtr pChild, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    setPreRenderDirty();
+    m_HitTestGrid.invalidate();
 }
 
 void DivNode::reorderChild(unsigned i, unsigned j)
@@ -200,6 +210,8 @@ void DivNode::reorderChild(unsigned i, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    setPreRenderDirty();
+    m_HitTestGrid.invalidate();
 }
 
 unsigned DivNode::indexOf(NodePtr pChild)
@@ -240,6 +252,8 @@ void DivNode::removeChild(NodePtr pChild, bool bKill)
                 getID()+"::removeChild: index "+toString(i)+" out of bounds."));
     }
     m_Children.erase(m_Children.begin()+i);
+    setPreRenderDirty();
+    m_HitTestGrid.invalidate();
 }
 
 void DivNode::removeChild(unsigned i, bool bKill)
@@ -256,6 +270,7 @@ bool DivNode::getCrop() const
 void DivNode::setCrop(bool bCrop)
 {
     m_bCrop = bCrop;
+    setPreRenderDirty();
 }
 
 const UTF8String& DivNode::getMediaDir() const
@@ -276,13 +291,23 @@ void DivNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements)
             ((getSize() == glm::vec2(0,0) ||
              (pos.x >= 0 && pos.y >= 0 && pos.x < getSize().x && pos.y < getSize().y))))
     {
-        for (int i = getNumChildren()-1; i >= 0; i--) {
-            NodePtr pCurChild = getChild(i);
-            glm::vec2 relPos = pCurChild->toLocal(pos);
-            pCurChild->getElementsByPos(relPos, pElements);
-            if (!pElements.empty()) {
-                pElements.push_back(getSharedThis());
-                return;
+        if (getNumChildren() >= MIN_CHILDREN_FOR_HIT_TEST_GRID) {
+            // Same order as below, but only for the children that can contain pos.
+            if (!m_HitTestGrid.isValid()) {
+                m_HitTestGrid.rebuild(m_Children);
+            }
+            vector<unsigned> candidates;
+            m_HitTestGrid.getCandidates(pos, candidates);
+            for (int i = int(candidates.size())-1; i >= 0; i--) {
+                if (getChildElementsByPos(candidates[i], pos, pElements)) {
+                    return;
+                }
+            }
+        } else {
+            for (int i = getNumChildren()-1; i >= 0; i--) {
+                if (getChildElementsByPos(i, pos, pElements)) {
+                    return;
+                }
             }
         }
         // pos isn't in any of the children.
@@ -293,6 +318,36 @@ void DivNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElements)
     }
 }
 
+bool DivNode::getHitBounds(FRect& bounds) const
+{
+    if (getSize() == glm::vec2(0,0)) {
+        // Children can be anywhere.
+        return false;
+    } else {
+        bounds = calcHitBounds();
+        return true;
+    }
+}
+
+void DivNode::childHitBoundsChanged(const Node* pChild)
+{
+    m_HitTestGrid.nodeMoved(pChild);
+}
+
+bool DivNode::getChildElementsByPos(unsigned i, const glm::vec2& pos,
+        vector<NodePtr>& pElements)
+{
+    const NodePtr& pChild = getChild(i);
+    glm::vec2 relPos = pChild->toLocal(pos);
+    pChild->getElementsByPos(relPos, pElements);
+    if (pElements.empty()) {
+        return false;
+    } else {
+        pElements.push_back(getSharedThis());
+        return true;
+    }
+}
+
 void DivNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
         float parentEffectiveOpacity)
 {
@@ -306,11 +361,28 @@ void DivNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         m_ClipVA.appendPos(viewport, glm::vec2(0,0), Pixel32(0,0,0,0));
         m_ClipVA.appendQuadIndexes(0, 1, 2, 3);
     }
+    bool bChildInputChanged = (bIsParentActive != m_bLastChildActive ||
+            getEffectiveOpacity() != m_LastChildOpacity);
+    m_bLastChildActive = bIsParentActive;
+    m_LastChildOpacity = getEffectiveOpacity();
+    m_bChildrenStatic = true;
     for (unsigned i = 0; i < getNumChildren(); i++) {
-        getChild(i)->preRender(pVA, bIsParentActive, getEffectiveOpacity());
+        const NodePtr& pChild = getChild(i);
+        pChild->maybePreRender(pVA, bIsParentActive, getEffectiveOpacity(),
+                bChildInputChanged);
+        if (pChild->needsPreRender()) {
+            m_bChildrenStatic = false;
+        }
     }
 }
 
+bool DivNode::isPreRenderStatic() const
+{
+    // The clip vertices are part of the frame's vertex array and need to be re-added
+    // every frame.
+    return m_bChildrenStatic && !(m_bCrop && getSize() != glm::vec2(0,0));
+}
+
 void DivNode::render()
 {
     const glm::mat4& transform = getTransform();
@@ -318,7 +390,18 @@ void DivNode::render()
         getCanvas()->pushClipRect(transform, m_ClipVA);
     }
     for (unsigned i = 0; i < getNumChildren(); i++) {
-        getChild(i)->maybeRender(transform);
+        const NodePtr& pChild = getChild(i);
+        const TypeDefinition* pDef = pChild->getDefinition();
+        if (pDef && pDef->isPlugin()) {
+            // Plugins may change GL state directly, so pending draws can't be merged
+            // across them.
+            GLContext* pContext = GLContext::getCurrent();
+            pContext->stateChanged();
+            pChild->maybeRender(transform);
+            pContext->stateChanged();
+        } else {
+            pChild->maybeRender(transform);
+        }
     }
     if (getCrop() && getSize() != glm::vec2(0,0)) {
         getCanvas()->popClipRect(transform, m_ClipVA);
@@ -24,6 +24,7 @@
 
 #include "../api.h"
 #include "AreaNode.h"
+#include "HitTestGrid.h"
 
 #include "../graphics/SubVertexArray.h"
 
@@ -67,6 +68,8 @@ class AVG_API DivNode : public AreaNode
         void setMediaDir(const UTF8String& mediaDir);
 
         void getElementsByPos(const glm::vec2& pos, std::vector<NodePtr>& pElements);
+        virtual bool getHitBounds(FRect& bounds) const;
+        void childHitBoundsChanged(const Node* pChild);
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
         virtual void render();
@@ -78,8 +81,13 @@ class AVG_API DivNode : public AreaNode
         virtual std::string dump(int indent = 0);
         IntPoint getMediaSize();
    
+    protected:
+        virtual bool isPreRenderStatic() const;
+
     private:
         bool isChildTypeAllowed(const std::string& sType);
+        bool getChildElementsByPos(unsigned i, const glm::vec2& pos,
+                std::vector<NodePtr>& pElements);
 
         UTF8String m_sMediaDir;
         bool m_bCrop;
@@ -87,6 +95,12 @@ class AVG_API DivNode : public AreaNode
         SubVertexArray m_ClipVA;
 
         std::vector<NodePtr> m_Children;
+        HitTestGrid m_HitTestGrid;
+
+        // Values passed to the children in the last preRender().
+        bool m_bLastChildActive;
+        float m_LastChildOpacity;
+        bool m_bChildrenStatic;
 };
 
 }
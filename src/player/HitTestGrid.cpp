@@ -0,0 +1,240 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "HitTestGrid.h"
+
+#include "Node.h"
+
+#include "../base/Exception.h"
+
+#include <algorithm>
+#include <iterator>
+#include <math.h>
+
+using namespace std;
+
+namespace avg {
+
+static const int MAX_GRID_SIZE = 256;
+static const int MAX_CELLS_PER_NODE = 16;
+
+namespace {
+
+bool isValidRect(const FRect& rect)
+{
+    // Also false for NaN coordinates.
+    return rect.tl.x <= rect.br.x && rect.tl.y <= rect.br.y;
+}
+
+void insertSorted(vector<unsigned>& v, unsigned i)
+{
+    v.insert(lower_bound(v.begin(), v.end(), i), i);
+}
+
+void eraseSorted(vector<unsigned>& v, unsigned i)
+{
+    vector<unsigned>::iterator it = lower_bound(v.begin(), v.end(), i);
+    AVG_ASSERT(it != v.end() && *it == i);
+    v.erase(it);
+}
+
+}
+
+HitTestGrid::Entry::Entry()
+    : m_bInGrid(false)
+{
+}
+
+HitTestGrid::HitTestGrid()
+    : m_bValid(false),
+      m_Size(0, 0)
+{
+}
+
+HitTestGrid::~HitTestGrid()
+{
+}
+
+void HitTestGrid::rebuild(const vector<NodePtr>& pNodes)
+{
+    m_pNodes.clear();
+    m_NodeIndexes.clear();
+    m_pMovedNodes.clear();
+    m_AlwaysChecked.clear();
+
+    FRect extent;
+    glm::vec2 sizeSum(0, 0);
+    int numBounded = 0;
+    for (unsigned i = 0; i < pNodes.size(); ++i) {
+        const Node* pNode = pNodes[i].get();
+        m_pNodes.push_back(pNode);
+        m_NodeIndexes[pNode] = i;
+        FRect bounds;
+        if (pNode->getHitBounds(bounds) && isValidRect(bounds)) {
+            if (numBounded == 0) {
+                extent = bounds;
+            } else {
+                extent.tl = glm::min(extent.tl, bounds.tl);
+                extent.br = glm::max(extent.br, bounds.br);
+            }
+            sizeSum += bounds.size();
+            numBounded++;
+        }
+    }
+
+    // Cells are about as large as the average node, but there are no more cells than
+    // nodes.
+    glm::vec2 extentSize(1, 1);
+    if (numBounded > 0) {
+        extentSize = glm::max(extent.size(), glm::vec2(1, 1));
+        m_Origin = extent.tl;
+    } else {
+        m_Origin = glm::vec2(0, 0);
+    }
+    float cellSize = sqrtf(extentSize.x*extentSize.y/max(numBounded, 1));
+    if (numBounded > 0) {
+        glm::vec2 avgSize = sizeSum/float(numBounded);
+        cellSize = max(cellSize, max(avgSize.x, avgSize.y));
+    }
+    m_Size = IntPoint(int(ceilf(extentSize.x/cellSize)), int(ceilf(extentSize.y/cellSize)));
+    m_Size = glm::clamp(m_Size, IntPoint(1, 1), IntPoint(MAX_GRID_SIZE, MAX_GRID_SIZE));
+    m_CellSize = extentSize/glm::vec2(m_Size);
+
+    m_Cells.assign(m_Size.x*m_Size.y, vector<unsigned>());
+    m_Entries.assign(m_pNodes.size(), Entry());
+    for (unsigned i = 0; i < m_pNodes.size(); ++i) {
+        addEntry(i);
+    }
+    m_bValid = true;
+}
+
+void HitTestGrid::invalidate()
+{
+    m_bValid = false;
+    m_pNodes.clear();
+    m_NodeIndexes.clear();
+    m_pMovedNodes.clear();
+    m_Cells.clear();
+    m_Entries.clear();
+    m_AlwaysChecked.clear();
+}
+
+bool HitTestGrid::isValid() const
+{
+    return m_bValid;
+}
+
+void HitTestGrid::nodeMoved(const Node* pNode)
+{
+    if (m_bValid) {
+        m_pMovedNodes.push_back(pNode);
+        if (m_pMovedNodes.size() > m_pNodes.size()) {
+            // Rebuilding is cheaper than updating at this point.
+            invalidate();
+        }
+    }
+}
+
+void HitTestGrid::getCandidates(const glm::vec2& pos, vector<unsigned>& candidates)
+{
+    AVG_ASSERT(m_bValid);
+    updateMovedNodes();
+    IntPoint cell = posToCell(pos);
+    const vector<unsigned>& cellNodes = getCell(cell.x, cell.y);
+    candidates.clear();
+    candidates.reserve(cellNodes.size()+m_AlwaysChecked.size());
+    merge(cellNodes.begin(), cellNodes.end(), 
+            m_AlwaysChecked.begin(), m_AlwaysChecked.end(), 
+            back_inserter(candidates));
+}
+
+void HitTestGrid::updateMovedNodes()
+{
+    for (unsigned i = 0; i < m_pMovedNodes.size(); ++i) {
+        map<const Node*, unsigned>::iterator it = m_NodeIndexes.find(m_pMovedNodes[i]);
+        AVG_ASSERT(it != m_NodeIndexes.end());
+        removeEntry(it->second);
+        addEntry(it->second);
+    }
+    m_pMovedNodes.clear();
+}
+
+void HitTestGrid::addEntry(unsigned i)
+{
+    Entry& entry = m_Entries[i];
+    entry.m_bInGrid = false;
+    FRect bounds;
+    if (m_pNodes[i]->getHitBounds(bounds) && isValidRect(bounds)) {
+        IntRect cells(posToCell(bounds.tl), posToCell(bounds.br)+IntPoint(1, 1));
+        if (cells.width()*cells.height() <= MAX_CELLS_PER_NODE) {
+            entry.m_bInGrid = true;
+            entry.m_Cells = cells;
+            for (int y = cells.tl.y; y < cells.br.y; ++y) {
+                for (int x = cells.tl.x; x < cells.br.x; ++x) {
+                    insertSorted(getCell(x, y), i);
+                }
+            }
+        }
+    }
+    if (!entry.m_bInGrid) {
+        insertSorted(m_AlwaysChecked, i);
+    }
+}
+
+void HitTestGrid::removeEntry(unsigned i)
+{
+    const Entry& entry = m_Entries[i];
+    if (entry.m_bInGrid) {
+        for (int y = entry.m_Cells.tl.y; y < entry.m_Cells.br.y; ++y) {
+            for (int x = entry.m_Cells.tl.x; x < entry.m_Cells.br.x; ++x) {
+                eraseSorted(getCell(x, y), i);
+            }
+        }
+    } else {
+        eraseSorted(m_AlwaysChecked, i);
+    }
+}
+
+IntPoint HitTestGrid::posToCell(const glm::vec2& pos) const
+{
+    // Positions outside the grid map to the border cells. This keeps the mapping
+    // monotonic, so a point inside a node's bounds always maps to one of its cells.
+    glm::vec2 cellPos = (pos-m_Origin)/m_CellSize;
+    IntPoint cell(0, 0);
+    if (cellPos.x >= m_Size.x) {
+        cell.x = m_Size.x-1;
+    } else if (cellPos.x > 0) {
+        cell.x = int(cellPos.x);
+    }
+    if (cellPos.y >= m_Size.y) {
+        cell.y = m_Size.y-1;
+    } else if (cellPos.y > 0) {
+        cell.y = int(cellPos.y);
+    }
+    return cell;
+}
+
+vector<unsigned>& HitTestGrid::getCell(int x, int y)
+{
+    return m_Cells[y*m_Size.x+x];
+}
+
+}
@@ -0,0 +1,88 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _HitTestGrid_H_
+#define _HitTestGrid_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+#include <map>
+
+namespace avg {
+
+class Node;
+typedef boost::shared_ptr<Node> NodePtr;
+
+// Uniform grid over the children of a DivNode. Used to find the children that can
+// contain a point without asking each one. Children without hit bounds and children
+// that cover many cells are always returned as candidates.
+class AVG_API HitTestGrid
+{
+public:
+    HitTestGrid();
+    virtual ~HitTestGrid();
+
+    void rebuild(const std::vector<NodePtr>& pNodes);
+    void invalidate();
+    bool isValid() const;
+
+    // The grid is updated for all moved nodes before the next query.
+    void nodeMoved(const Node* pNode);
+
+    // Returns the indexes of the nodes that might contain pos in ascending order.
+    void getCandidates(const glm::vec2& pos, std::vector<unsigned>& candidates);
+
+private:
+    struct Entry {
+        Entry();
+
+        bool m_bInGrid;
+        IntRect m_Cells;
+    };
+
+    void updateMovedNodes();
+    void addEntry(unsigned i);
+    void removeEntry(unsigned i);
+    IntPoint posToCell(const glm::vec2& pos) const;
+    std::vector<unsigned>& getCell(int x, int y);
+
+    bool m_bValid;
+    std::vector<const Node*> m_pNodes;
+    std::map<const Node*, unsigned> m_NodeIndexes;
+    std::vector<const Node*> m_pMovedNodes;
+
+    glm::vec2 m_Origin;
+    glm::vec2 m_CellSize;
+    IntPoint m_Size;
+    std::vector<std::vector<unsigned> > m_Cells;
+    std::vector<Entry> m_Entries;
+    std::vector<unsigned> m_AlwaysChecked;
+};
+
+}
+
+#endif
@@ -29,6 +29,8 @@
 #include "../graphics/BitmapLoader.h"
 #include "../graphics/Bitmap.h"
 #include "../graphics/GLContextManager.h"
+#include "../graphics/TextureAtlas.h"
+#include "../graphics/MCTexture.h"
 
 #include "OGLSurface.h"
 #include "OffscreenCanvas.h"
@@ -173,16 +175,15 @@ void Image::setBitmap(BitmapPtr pBmp, TextureCompression comp)
     m_pBmp = BitmapPtr(new Bitmap(pBmp->getSize(), pf, ""));
     m_pBmp->copyPixels(*pBmp);
     if (m_State == GPU) {
-        MCTexturePtr pTex = m_pSurface->getTex();
         if (bSourceChanged || m_pSurface->getSize() != m_pBmp->getSize() ||
-                m_pSurface->getPixelFormat() != pf)
+                m_pSurface->getPixelFormat() != pf || isUploadPending())
         {
-            pTex = GLContextManager::get()->createTexture(m_pBmp->getSize(), pf, 
-                    m_Material.getUseMipmaps(), m_Material.getWrapSMode(), 
-                    m_Material.getWrapTMode());
-            m_pSurface->create(pf, pTex);
+            setupSurface();
+        } else if (m_pSurface->getAtlasRegion()) {
+            m_pSurface->getAtlasRegion()->setBitmap(m_pBmp);
+        } else {
+            GLContextManager::get()->scheduleTexUpload(m_pSurface->getTex(), m_pBmp);
         }
-        GLContextManager::get()->scheduleTexUpload(pTex, m_pBmp);
     }
     assertValid();
 }
@@ -281,6 +282,13 @@ Image::Source Image::getSource()
     return m_Source;
 }
 
+bool Image::isUploadPending()
+{
+    // Atlased images use the page texture, which is never pending.
+    return m_State == GPU && (m_Source == FILE || m_Source == BITMAP) &&
+            m_pSurface->getTex()->isUploadPending();
+}
+
 Image::TextureCompression Image::string2compression(const string& s)
 {
     if (s == "none") {
@@ -310,11 +318,22 @@ void Image::setupSurface()
 {
     PixelFormat pf = m_pBmp->getPixelFormat();
 //    cerr << "setupSurface: " << pf << endl;
-    MCTexturePtr pTex = GLContextManager::get()->createTexture(m_pBmp->getSize(), pf, 
+    GLContextManager* pCM = GLContextManager::get();
+    if (!m_Material.getUseMipmaps() && m_Material.getWrapSMode() == GL_CLAMP_TO_EDGE &&
+            m_Material.getWrapTMode() == GL_CLAMP_TO_EDGE)
+    {
+        // Small images go into the texture atlas if there's room.
+        AtlasRegionPtr pRegion = pCM->getTextureAtlas()->insert(m_pBmp);
+        if (pRegion) {
+            m_pSurface->create(pf, pRegion);
+            return;
+        }
+    }
+    MCTexturePtr pTex = pCM->createTexture(m_pBmp->getSize(), pf, 
             m_Material.getUseMipmaps(), 
             m_Material.getWrapSMode(), m_Material.getWrapTMode());
     m_pSurface->create(pf, pTex);
-    GLContextManager::get()->scheduleTexUpload(pTex, m_pBmp);
+    pCM->scheduleAsyncTexUpload(pTex, m_pBmp);
 }
 
 bool Image::changeSource(Source newSource)
@@ -73,6 +73,7 @@ class AVG_API Image
         OGLSurface* getSurface();
         State getState();
         Source getSource();
+        bool isUploadPending();
 
         static TextureCompression string2compression(const std::string& s);
         static std::string compression2String(TextureCompression compression);
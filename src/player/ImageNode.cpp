@@ -168,12 +168,20 @@ void ImageNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
     calcVertexArray(pVA);
 }
 
+bool ImageNode::isPreRenderStatic() const
+{
+    if (!isVisible()) {
+        return true;
+    }
+    return !hasPerFrameVertexData() && !m_pImage->getCanvas();
+}
+
 static ProfilingZoneID RenderProfilingZone("ImageNode::render");
 
 void ImageNode::render()
 {
     ScopeTimer Timer(RenderProfilingZone);
-    if (m_pImage->getSource() != Image::NONE) {
+    if (m_pImage->getSource() != Image::NONE && !m_pImage->isUploadPending()) {
         blt32();
     }
 }
@@ -223,6 +231,16 @@ void ImageNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElement
     }
 }
 
+bool ImageNode::getHitBounds(FRect& bounds) const
+{
+    if (m_pImage->getCanvas()) {
+        // Events are forwarded to the canvas.
+        return false;
+    } else {
+        return RasterNode::getHitBounds(bounds);
+    }
+}
+
 BitmapPtr ImageNode::getBitmap()
 {
     return m_pImage->getBitmap();
@@ -57,10 +57,14 @@ class AVG_API ImageNode : public RasterNode
         virtual void render();
         
         void getElementsByPos(const glm::vec2& pos, std::vector<NodePtr>& pElements);
+        virtual bool getHitBounds(FRect& bounds) const;
 
         virtual BitmapPtr getBitmap();
         virtual IntPoint getMediaSize();
 
+    protected:
+        virtual bool isPreRenderStatic() const;
+
     private:
         bool isCanvasURL(const std::string& sURL);
         void checkCanvasValid(const CanvasPtr& pCanvas);
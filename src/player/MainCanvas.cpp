@@ -95,6 +95,7 @@ void MainCanvas::renderTree()
         IntRect viewport = pWindow->getViewport();
         renderWindow(pWindow, MCFBOPtr(), viewport);
     }
+    GLContextManager::get()->processAsyncTexUploads();
     GLContextManager::get()->reset();
 }
 
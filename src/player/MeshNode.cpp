@@ -28,6 +28,7 @@
 #include "../base/Logger.h"
 #include "../base/Exception.h"
 #include "../graphics/VertexData.h"
+#include "../graphics/GLContext.h"
 
 #include <cstdlib>
 #include <string>
@@ -152,13 +153,16 @@ void MeshNode::calcVertexes(const VertexDataPtr& pVertexData, Pixel32 color)
 
 void MeshNode::render()
 {
+    GLContext* pContext = GLContext::getCurrent();
     if (m_bBackfaceCull) {
+        pContext->stateChanged();
         glEnable(GL_CULL_FACE);
     }
     
     VectorNode::render();
     
     if (m_bBackfaceCull) {
+        pContext->stateChanged();
         glDisable(GL_CULL_FACE);
     }
 }
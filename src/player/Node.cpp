@@ -43,6 +43,9 @@ using namespace boost;
 
 namespace avg {
 
+int Node::s_NumPreRenderedNodes = 0;
+int Node::s_NumSkippedPreRenderNodes = 0;
+
 void Node::registerType()
 {
     PublisherDefinitionPtr pPubDef = PublisherDefinition::create("Node");
@@ -82,7 +85,10 @@ Node::Node(const std::string& sPublisherName)
     : Publisher(sPublisherName),
       m_pParent(0),
       m_pCanvas(),
-      m_State(NS_UNCONNECTED)
+      m_State(NS_UNCONNECTED),
+      m_bPreRenderDirty(true),
+      m_bPreRenderStatic(false),
+      m_NumSubtreeNodes(1)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -207,6 +213,7 @@ void Node::setOpacity(float opacity)
     } else if (m_Opacity > 1.0) {
         m_Opacity = 1.0;
     }
+    setPreRenderDirty();
 }
 
 bool Node::getActive() const 
@@ -218,6 +225,7 @@ void Node::setActive(bool bActive)
 {
     if (bActive != m_bActive) {
         m_bActive = bActive;
+        setPreRenderDirty();
     }
 }
 
@@ -354,6 +362,11 @@ glm::vec2 Node::toGlobal(const glm::vec2& localPos) const
     return localPos;
 }
 
+bool Node::getHitBounds(FRect& bounds) const
+{
+    return false;
+}
+
 NodePtr Node::getElementByPos(const glm::vec2& pos)
 {
     vector<NodePtr> elements;
@@ -376,6 +389,44 @@ void Node::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
     m_bEffectiveActive = bIsParentActive && m_bActive;
 }
 
+void Node::maybePreRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
+        float parentEffectiveOpacity, bool bParentChanged)
+{
+    if (bParentChanged || needsPreRender()) {
+        int numNodesBefore = s_NumPreRenderedNodes+s_NumSkippedPreRenderNodes;
+        s_NumPreRenderedNodes++;
+        // Cleared first so changes made during preRender() are seen next frame.
+        m_bPreRenderDirty = false;
+        preRender(pVA, bIsParentActive, parentEffectiveOpacity);
+        m_bPreRenderStatic = isPreRenderStatic();
+        m_NumSubtreeNodes = s_NumPreRenderedNodes+s_NumSkippedPreRenderNodes
+                -numNodesBefore;
+    } else {
+        s_NumSkippedPreRenderNodes += m_NumSubtreeNodes;
+    }
+}
+
+bool Node::needsPreRender() const
+{
+    return m_bPreRenderDirty || !m_bPreRenderStatic;
+}
+
+void Node::resetPreRenderStats()
+{
+    s_NumPreRenderedNodes = 0;
+    s_NumSkippedPreRenderNodes = 0;
+}
+
+int Node::getNumPreRenderedNodes()
+{
+    return s_NumPreRenderedNodes;
+}
+
+int Node::getNumSkippedPreRenderNodes()
+{
+    return s_NumSkippedPreRenderNodes;
+}
+
 Node::NodeState Node::getState() const
 {
     return m_State;
@@ -446,6 +497,7 @@ void Node::setState(Node::NodeState state)
     }
 
     m_State = state;
+    setPreRenderDirty();
 }
         
 void Node::initFilename(string& sFilename)
@@ -502,6 +554,29 @@ bool Node::getEffectiveActive() const
     return m_bEffectiveActive;
 }
 
+void Node::setPreRenderDirty()
+{
+    // A dirty node always has dirty ancestors, so the walk can stop at the first one.
+    m_bPreRenderDirty = true;
+    Node* pNode = m_pParent;
+    while (pNode && !pNode->m_bPreRenderDirty) {
+        pNode->m_bPreRenderDirty = true;
+        pNode = pNode->m_pParent;
+    }
+}
+
+bool Node::isPreRenderStatic() const
+{
+    return false;
+}
+
+void Node::hitBoundsChanged()
+{
+    if (m_pParent) {
+        m_pParent->childHitBoundsChanged(this);
+    }
+}
+
 NodePtr Node::getSharedThis()
 {
     return dynamic_pointer_cast<Node>(ExportedObject::getSharedThis());
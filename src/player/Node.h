@@ -29,6 +29,7 @@
 #include "Image.h"
 
 #include "../graphics/Pixel32.h"
+#include "../base/Rect.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
@@ -110,16 +111,33 @@ class AVG_API Node: public Publisher
         NodePtr getElementByPos(const glm::vec2& pos);
         virtual void getElementsByPos(const glm::vec2& pos, 
                 std::vector<NodePtr>& pElements);
+        // Returns false if the node doesn't know where it can be hit. Otherwise,
+        // bounds is set to a rectangle in parent coordinates that contains all
+        // positions getElementsByPos() can return elements for.
+        virtual bool getHitBounds(FRect& bounds) const;
 
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
+        // Calls preRender() unless neither the node nor its subtree has changed since
+        // the last frame, the inputs from the parent are the same and the subtree
+        // needs no per-frame work.
+        void maybePreRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
+                float parentEffectiveOpacity, bool bParentChanged);
+        bool needsPreRender() const;
         virtual void maybeRender(const glm::mat4& parentTransform) {};
+        // Draws are merged across nodes, so render() implementations in the core that
+        // change GL state without going through GLContext must call
+        // GLContext::stateChanged() first. DivNode does this for plugin nodes.
         virtual void render() {};
         virtual void renderOutlines(const VertexArrayPtr& pVA, Pixel32 color) {};
 
         float getEffectiveOpacity() const;
         virtual std::string dump(int indent = 0);
         
+        static void resetPreRenderStats();
+        static int getNumPreRenderedNodes();
+        static int getNumSkippedPreRenderNodes();
+
         NodeState getState() const;
         CanvasPtr getCanvas() const;
 
@@ -138,6 +156,11 @@ class AVG_API Node: public Publisher
                 Image::TextureCompression comp = Image::TEXTURECOMPRESSION_NONE);
         virtual bool isVisible() const;
         bool getEffectiveActive() const;
+        void setPreRenderDirty();
+        void hitBoundsChanged();
+        // True if preRender() has nothing to do as long as the node and its
+        // ancestors don't change.
+        virtual bool isPreRenderStatic() const;
         NodePtr getSharedThis();
 
         void logFileNotFoundWarning(const std::string& sWarn) const;
@@ -185,6 +208,12 @@ class AVG_API Node: public Publisher
         bool m_bSensitive;
         float m_EffectiveOpacity;
         bool m_bEffectiveActive;
+
+        bool m_bPreRenderDirty;
+        bool m_bPreRenderStatic;
+        int m_NumSubtreeNodes;
+        static int s_NumPreRenderedNodes;
+        static int s_NumSkippedPreRenderNodes;
 };
 
 }
@@ -29,6 +29,7 @@
 
 #include "../graphics/GLContext.h"
 #include "../graphics/MCTexture.h"
+#include "../graphics/TextureAtlas.h"
 #include "../graphics/StandardShader.h"
 
 #include <iostream>
@@ -71,6 +72,7 @@ void OGLSurface::create(PixelFormat pf, MCTexturePtr pTex0, MCTexturePtr pTex1,
     m_pTextures[1] = pTex1;
     m_pTextures[2] = pTex2;
     m_pTextures[3] = pTex3;
+    m_pAtlasRegion = AtlasRegionPtr();
     m_bIsDirty = true;
     m_bPremultipliedAlpha = bPremultipliedAlpha;
 
@@ -87,6 +89,20 @@ void OGLSurface::create(PixelFormat pf, MCTexturePtr pTex0, MCTexturePtr pTex1,
     }
 }
 
+void OGLSurface::create(PixelFormat pf, AtlasRegionPtr pRegion)
+{
+    AVG_ASSERT(!pixelFormatIsPlanar(pf));
+    m_pf = pf;
+    m_Size = pRegion->getSize();
+    m_pTextures[0] = pRegion->getTex();
+    m_pTextures[1] = MCTexturePtr();
+    m_pTextures[2] = MCTexturePtr();
+    m_pTextures[3] = MCTexturePtr();
+    m_pAtlasRegion = pRegion;
+    m_bIsDirty = true;
+    m_bPremultipliedAlpha = false;
+}
+
 void OGLSurface::setMask(MCTexturePtr pTex)
 {
     m_pMaskTexture = pTex;
@@ -99,6 +115,7 @@ void OGLSurface::destroy()
     m_pTextures[1] = MCTexturePtr();
     m_pTextures[2] = MCTexturePtr();
     m_pTextures[3] = MCTexturePtr();
+    m_pAtlasRegion = AtlasRegionPtr();
 }
 
 void OGLSurface::activate(const IntPoint& logicalSize) const
@@ -149,8 +166,11 @@ void OGLSurface::activate(const IntPoint& logicalSize) const
         //   The tex coords in the vertex array are scaled to fit the image texture. We 
         //   need to undo this and fit to the mask texture. In the npot case, everything
         //   evaluates to (1,1);
-        glm::vec2 texSize = glm::vec2(m_pTextures[0]->getGLSize());
-        glm::vec2 imgSize = glm::vec2(m_pTextures[0]->getSize());
+        glm::vec2 imgSize = glm::vec2(m_Size);
+        glm::vec2 texSize = imgSize;
+        if (!m_pAtlasRegion) {
+            texSize = glm::vec2(m_pTextures[0]->getGLSize());
+        }
         glm::vec2 maskTexSize = glm::vec2(m_pMaskTexture->getGLSize());
         glm::vec2 maskImgSize = glm::vec2(m_pMaskTexture->getSize());
         glm::vec2 maskScale = glm::vec2(maskTexSize.x/maskImgSize.x, 
@@ -174,7 +194,15 @@ void OGLSurface::activate(const IntPoint& logicalSize) const
             maskScale *= glm::vec2((float)logicalSize.x/m_Size.x, 
                     (float)logicalSize.y/m_Size.y);
         }
-        pShader->setMask(true, maskPos, m_MaskSize*maskScale/imgScale);
+        glm::vec2 maskSize = m_MaskSize*maskScale/imgScale;
+        if (m_pAtlasRegion) {
+            // The tex coords cover just the region in the atlas page. Map them to the
+            // mask the same way as for a texture of its own.
+            FRect texRect = m_pAtlasRegion->getTexCoordRect();
+            maskPos += texRect.tl/(texRect.size()*maskSize);
+            maskSize *= texRect.size();
+        }
+        pShader->setMask(true, maskPos, maskSize);
     } else {
         pShader->setMask(false);
     }
@@ -209,6 +237,22 @@ IntPoint OGLSurface::getTextureSize()
     return m_pTextures[0]->getGLSize();
 }
 
+FRect OGLSurface::getTexCoordRect() const
+{
+    if (m_pAtlasRegion) {
+        return m_pAtlasRegion->getTexCoordRect();
+    } else {
+        glm::vec2 textureSize = glm::vec2(m_pTextures[0]->getGLSize());
+        glm::vec2 imageSize = glm::vec2(m_Size);
+        return FRect(0, 0, imageSize.x/textureSize.x, imageSize.y/textureSize.y);
+    }
+}
+
+AtlasRegionPtr OGLSurface::getAtlasRegion() const
+{
+    return m_pAtlasRegion;
+}
+
 bool OGLSurface::isCreated() const
 {
     return m_pTextures[0];
@@ -25,6 +25,7 @@
 #include "../api.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 #include "../graphics/PixelFormat.h"
 
 #include <boost/shared_ptr.hpp>
@@ -33,6 +34,8 @@ namespace avg {
 
 class MCTexture;
 typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+class AtlasRegion;
+typedef boost::shared_ptr<AtlasRegion> AtlasRegionPtr;
 
 class AVG_API OGLSurface {
 public:
@@ -42,6 +45,7 @@ public:
     virtual void create(PixelFormat pf, MCTexturePtr pTex0, 
             MCTexturePtr pTex1 = MCTexturePtr(), MCTexturePtr pTex2 = MCTexturePtr(), 
             MCTexturePtr pTex3 = MCTexturePtr(), bool bPremultipliedAlpha = false);
+    void create(PixelFormat pf, AtlasRegionPtr pRegion);
     void setMask(MCTexturePtr pTex);
     virtual void destroy();
     void activate(const IntPoint& logicalSize = IntPoint(1,1)) const;
@@ -52,6 +56,9 @@ public:
     PixelFormat getPixelFormat();
     IntPoint getSize();
     IntPoint getTextureSize();
+    // Part of the texture that contains the image, in texture coordinates.
+    FRect getTexCoordRect() const;
+    AtlasRegionPtr getAtlasRegion() const;
     bool isCreated() const;
     bool isPremultipliedAlpha() const;
 
@@ -67,6 +74,7 @@ private:
     bool colorIsModified() const;
 
     MCTexturePtr m_pTextures[4];
+    AtlasRegionPtr m_pAtlasRegion;
     IntPoint m_Size;
     PixelFormat m_pf;
     MCTexturePtr m_pMaskTexture;
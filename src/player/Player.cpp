@@ -79,13 +79,16 @@
 #include "../base/DAG.h"
 
 #include "../graphics/BitmapLoader.h"
+#include "../graphics/BitmapPool.h"
 #include "../graphics/ShaderRegistry.h"
 #include "../graphics/Display.h"
 #include "../graphics/GLContextManager.h"
+#include "../graphics/TextureAtlas.h"
 
 #include "../imaging/Camera.h"
 
 #include "../audio/AudioEngine.h"
+#include "../video/AudioSampleLoader.h"
 
 #include <libxml/xmlmemory.h>
 
@@ -304,6 +307,30 @@ void Player::enableGLErrorChecks(bool bEnable)
 {
     GLContext::enableErrorChecks(bEnable);
 }
+
+void Player::enableDrawBatching(bool bEnable)
+{
+    GLContext::enableDrawBatching(bEnable);
+}
+
+void Player::enableTextureAtlas(bool bEnable)
+{
+    TextureAtlas::enable(bEnable);
+}
+
+void Player::enableAsyncTextureUploads(bool bEnable)
+{
+    GLContextManager::enableAsyncTexUploads(bEnable);
+}
+
+void Player::setTextureUploadBudget(int numBytes)
+{
+    if (numBytes < 0) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE,
+                "Player.setTextureUploadBudget: budget must not be negative.");
+    }
+    m_pContextManager->setTexUploadBudget(numBytes);
+}
         
 glm::vec2 Player::getScreenResolution()
 {
@@ -1106,6 +1133,9 @@ void Player::doFrame(bool bFirstFrame)
             ScopeTimer Timer(MainCanvasProfilingZone);
             m_pMainCanvas->doFrame(m_bPythonAvailable);
         }
+        if (AudioEngine::get()) {
+            AudioEngine::get()->deleteRetiredObjects();
+        }
         GLContext::mandatoryCheckError("End of frame");
         if (m_bPythonAvailable) {
             Py_BEGIN_ALLOW_THREADS;
@@ -1165,6 +1195,21 @@ size_t Player::getVideoMemUsed()
     return GLContext::getCurrent()->getVideoMemUsed();
 }
 
+int Player::getNumAtlasedTextures()
+{
+    return m_pContextManager->getTextureAtlas()->getNumRegions();
+}
+
+float Player::getTextureAtlasOccupancy()
+{
+    return m_pContextManager->getTextureAtlas()->getOccupancy();
+}
+
+int Player::getNumPendingTextureUploads()
+{
+    return m_pContextManager->getNumPendingAsyncTexUploads();
+}
+
 void Player::setGamma(float red, float green, float blue)
 {
     if (m_pDisplayEngine) {
@@ -1206,6 +1251,18 @@ void Player::initConfig()
     m_AP.m_SampleRate = atoi(pMgr->getOption("aud", "samplerate")->c_str());
     m_AP.m_OutputBufferSamples =
             atoi(pMgr->getOption("aud", "outputbuffersamples")->c_str());
+    string sResampleQuality;
+    pMgr->getStringOption("aud", "resamplequality", "medium", sResampleQuality);
+    if (sResampleQuality == "low") {
+        m_AP.m_ResampleQuality = AudioParams::RESAMPLE_LOW;
+    } else if (sResampleQuality == "medium") {
+        m_AP.m_ResampleQuality = AudioParams::RESAMPLE_MEDIUM;
+    } else if (sResampleQuality == "high") {
+        m_AP.m_ResampleQuality = AudioParams::RESAMPLE_HIGH;
+    } else {
+        throw Exception(AVG_ERR_OUT_OF_RANGE,
+               "avgrc parameter resamplequality must be low, medium or high");
+    }
 
     m_GLConfig.m_bGLES = pMgr->getBoolOption("scr", "gles", false);
     m_GLConfig.m_bUsePOTTextures = pMgr->getBoolOption("scr", "usepow2textures", false);
@@ -1608,6 +1665,16 @@ void Player::errorIfMultiDisplay(const string& sFunc) const
     }
 }
 
+AudioEngine* Player::getAudioEngine(const string& sFunc) const
+{
+    AudioEngine* pEngine = AudioEngine::get();
+    if (!pEngine || !m_bIsPlaying) {
+        throw Exception(AVG_ERR_UNSUPPORTED,
+                sFunc + " must be called after Player.play().");
+    }
+    return pEngine;
+}
+
 
 
 void Player::handleTimers()
@@ -1692,6 +1759,82 @@ float Player::getVolume() const
     return m_Volume;
 }
 
+int Player::createAudioBus(int outputBusID)
+{
+    return getAudioEngine("Player.createAudioBus")->addBus(outputBusID);
+}
+
+void Player::removeAudioBus(int busID)
+{
+    getAudioEngine("Player.removeAudioBus")->removeBus(busID);
+}
+
+void Player::setAudioBusGain(int busID, float gain)
+{
+    getAudioEngine("Player.setAudioBusGain")->setBusGain(busID, gain);
+    if (busID == 0) {
+        m_Volume = gain;
+    }
+}
+
+float Player::getAudioBusGain(int busID) const
+{
+    return getAudioEngine("Player.getAudioBusGain")->getBusGain(busID);
+}
+
+void Player::setAudioBusLimiter(int busID, bool bEnabled)
+{
+    getAudioEngine("Player.setAudioBusLimiter")->setBusLimiterEnabled(busID, bEnabled);
+}
+
+void Player::setAudioBusChannelMap(int busID, const vector<int>& channelMap)
+{
+    getAudioEngine("Player.setAudioBusChannelMap")->setBusChannelMap(busID,
+            channelMap);
+}
+
+int Player::loadAudioSample(const string& sFilename)
+{
+    AudioEngine* pEngine = getAudioEngine("Player.loadAudioSample");
+    if (!pEngine->isEnabled()) {
+        throw Exception(AVG_ERR_UNSUPPORTED,
+                "Player.loadAudioSample: Audio output is disabled.");
+    }
+    string sRealFilename = sFilename;
+    if (!isAbsPath(sRealFilename)) {
+        sRealFilename = getRootMediaDir()+sRealFilename;
+    }
+    sRealFilename = convertUTF8ToFilename(sRealFilename);
+    return pEngine->addSample(avg::loadAudioSample(sRealFilename,
+            *pEngine->getParams()));
+}
+
+void Player::unloadAudioSample(int sampleID)
+{
+    getAudioEngine("Player.unloadAudioSample")->removeSample(sampleID);
+}
+
+int Player::playAudioSample(int sampleID, float volume, float pan, int busID)
+{
+    return getAudioEngine("Player.playAudioSample")->playSample(sampleID, volume, pan,
+            busID);
+}
+
+void Player::stopAudioVoice(int voiceID)
+{
+    getAudioEngine("Player.stopAudioVoice")->stopVoice(voiceID);
+}
+
+void Player::setMaxAudioVoices(int maxVoices)
+{
+    getAudioEngine("Player.setMaxAudioVoices")->setMaxVoices(maxVoices);
+}
+
+int Player::getMaxAudioVoices() const
+{
+    return getAudioEngine("Player.getMaxAudioVoices")->getMaxVoices();
+}
+
 string Player::getConfigOption(const string& sSubsys, const string& sName) const
 {
     const string* psValue = ConfigMgr::get()->getOption(sSubsys, sName);
@@ -1717,6 +1860,15 @@ bool Player::areFullShadersSupported() const
     return (m_GLConfig.m_ShaderUsage == GLConfig::FULL);
 }
 
+bool Player::areAsyncTextureUploadsSupported() const
+{
+    if (!m_bIsPlaying) {
+        throw Exception(AVG_ERR_UNSUPPORTED,
+                "Must call Player.play() before areAsyncTextureUploadsSupported().");
+    }
+    return m_pContextManager->areAsyncTexUploadsSupported();
+}
+
 OffscreenCanvasPtr Player::getCanvasFromURL(const std::string& sURL)
 {
     if (sURL.substr(0, 7) != "canvas:") {
@@ -1745,6 +1897,7 @@ void Player::cleanup(bool bIsAbort)
     m_pLastCursorStates.clear();
     m_pTestHelper->reset();
     ThreadProfiler::get()->dumpStatistics();
+    BitmapPool::get()->dumpStatistics();
     for (unsigned i = 0; i < m_pCanvases.size(); ++i) {
         m_pCanvases[i]->stopPlayback(bIsAbort);
     }
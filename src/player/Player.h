@@ -105,6 +105,10 @@ class AVG_API Player: public Publisher
         void setMultiSampleSamples(int multiSampleSamples);
         void setAudioOptions(int samplerate, int channels);
         void enableGLErrorChecks(bool bEnable);
+        void enableDrawBatching(bool bEnable);
+        void enableTextureAtlas(bool bEnable);
+        void enableAsyncTextureUploads(bool bEnable);
+        void setTextureUploadBudget(int numBytes);
         glm::vec2 getScreenResolution();
         float getPixelsPerMM();
         glm::vec2 getPhysicalScreenDimensions();
@@ -173,6 +177,9 @@ class AVG_API Player: public Publisher
         float getVideoRefreshRate();
         size_t getVideoMemInstalled();
         size_t getVideoMemUsed();
+        int getNumAtlasedTextures();
+        float getTextureAtlasOccupancy();
+        int getNumPendingTextureUploads();
         void setGamma(float red, float green, float blue);
         DisplayEngine * getDisplayEngine() const;
         void keepWindowOpen();
@@ -180,10 +187,24 @@ class AVG_API Player: public Publisher
         bool getStopOnEscape() const;
         void setVolume(float volume);
         float getVolume() const;
+        int createAudioBus(int outputBusID=0);
+        void removeAudioBus(int busID);
+        void setAudioBusGain(int busID, float gain);
+        float getAudioBusGain(int busID) const;
+        void setAudioBusLimiter(int busID, bool bEnabled);
+        void setAudioBusChannelMap(int busID, const std::vector<int>& channelMap);
+        int loadAudioSample(const std::string& sFilename);
+        void unloadAudioSample(int sampleID);
+        int playAudioSample(int sampleID, float volume=1.f, float pan=0.f,
+                int busID=0);
+        void stopAudioVoice(int voiceID);
+        void setMaxAudioVoices(int maxVoices);
+        int getMaxAudioVoices() const;
         std::string getConfigOption(const std::string& sSubsys, const std::string& sName)
                 const;
         bool isUsingGLES() const;
         bool areFullShadersSupported() const;
+        bool areAsyncTextureUploadsSupported() const;
 
         OffscreenCanvasPtr getCanvasFromURL(const std::string& sURL);
 
@@ -236,6 +257,7 @@ class AVG_API Player: public Publisher
 
         void errorIfPlaying(const std::string& sFunc) const;
         void errorIfMultiDisplay(const std::string& sFunc) const;
+        AudioEngine* getAudioEngine(const std::string& sFunc) const;
 
         GLContextManagerPtr m_pContextManager;
         MainCanvasPtr m_pMainCanvas;
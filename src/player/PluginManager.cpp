@@ -22,6 +22,7 @@
 //
 
 #include "PluginManager.h"
+#include "TypeRegistry.h"
 
 #include "../base/DlfcnWrapper.h"
 #include "../base/FileHelper.h"
@@ -178,7 +179,15 @@ void PluginManager::registerPlugin(void* handle, const std::string& sPluginName)
        reinterpret_cast<RegisterPluginPtr>(dlsym(handle, "registerPlugin"));
 
     if (registerPlugin) {
-        PyObject* plugin = registerPlugin();
+        TypeRegistry::get()->startPluginRegistration();
+        PyObject* plugin;
+        try {
+            plugin = registerPlugin();
+        } catch (...) {
+            TypeRegistry::get()->endPluginRegistration();
+            throw;
+        }
+        TypeRegistry::get()->endPluginRegistration();
         py::object sysModule(py::handle<>(PyImport_ImportModule("sys")));
         sysModule.attr("modules")[sPluginName] = py::object(py::handle<>(plugin));
 
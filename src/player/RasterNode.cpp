@@ -77,6 +77,7 @@ RasterNode::RasterNode()
       m_Material(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, false),
       m_Color(0,0,0,0),
       m_TileSize(-1,-1),
+      m_bHasStdVertices(true),
       m_pSubVA(0),
       m_bFXDirty(true)
 {
@@ -84,6 +85,9 @@ RasterNode::RasterNode()
 
 RasterNode::~RasterNode()
 {
+    if (m_pSubVA && !m_bHasStdVertices) {
+        delete m_pSubVA;
+    }
     if (m_pSurface) {
         delete m_pSurface;
         m_pSurface = 0;
@@ -207,6 +211,7 @@ void RasterNode::setWarpedVertexCoords(const VertexGrid& grid)
         m_pSubVA = new SubVertexArray();
     }
     m_TileVertices = grid;
+    setPreRenderDirty();
 }
 
 void RasterNode::setMirror(MirrorType mirrorType)
@@ -300,6 +305,12 @@ void RasterNode::getElementsByPos(const glm::vec2& pos, vector<NodePtr>& pElemen
     }
 }
 
+bool RasterNode::getHitBounds(FRect& bounds) const
+{
+    bounds = calcHitBounds();
+    return true;
+}
+
 glm::vec3 RasterNode::getGamma() const
 {
     return m_Gamma;
@@ -351,6 +362,7 @@ void RasterNode::setEffect(FXNodePtr pFXNode)
     if (getState() == NS_CANRENDER) {
         setupFX();
     }
+    setPreRenderDirty();
 }
 
 static ProfilingZoneID FXProfilingZone("RasterNode::renderFX");
@@ -507,11 +519,19 @@ void RasterNode::checkDisplayAvailable(std::string sMsg)
 
 void RasterNode::newSurface()
 {
+    setPreRenderDirty();
     if (m_pSurface->isCreated()) {
-        m_bHasStdVertices = !(m_pSurface->getPixelFormat() == A8);
+        // The standard vertices cover the whole texture. Atlas regions need their own
+        // tex coords.
+        bool bHasOwnSubVA = m_pSubVA && !m_bHasStdVertices;
+        m_bHasStdVertices = !(m_pSurface->getPixelFormat() == A8) && 
+                !m_pSurface->getAtlasRegion();
         if (m_bHasStdVertices) {
+            if (bHasOwnSubVA) {
+                delete m_pSubVA;
+            }
             m_pSubVA = &(getCanvas()->getStdSubVA());
-        } else {
+        } else if (!bHasOwnSubVA) {
             m_pSubVA = new SubVertexArray();
         }
 
@@ -521,6 +541,13 @@ void RasterNode::newSurface()
     }
 }
 
+bool RasterNode::hasPerFrameVertexData() const
+{
+    // Nodes with standard vertices use the canvas-wide quad, nodes with effects need
+    // to schedule an FX render.
+    return !m_bHasStdVertices || m_pFXNode;
+}
+
 void RasterNode::setupFX()
 {
     if (m_pSurface && m_pSurface->getSize() != IntPoint(-1,-1) && m_pFXNode) {
@@ -540,6 +567,11 @@ void RasterNode::setupFX()
             m_pImagingProjection = ImagingProjectionPtr(new ImagingProjection(
                     m_pSurface->getSize()));
         }
+        if (m_pSurface->getAtlasRegion()) {
+            m_pImagingProjection->setTexCoordRect(m_pSurface->getTexCoordRect());
+        } else {
+            m_pImagingProjection->setTexCoordRect(FRect(0, 0, 1, 1));
+        }
     }
 }
 
@@ -618,10 +650,10 @@ void RasterNode::calcTileVertex(int x, int y, glm::vec2& Vertex)
 
 void RasterNode::calcTexCoords()
 {
-    glm::vec2 textureSize = glm::vec2(m_pSurface->getTextureSize());
     glm::vec2 imageSize = glm::vec2(m_pSurface->getSize());
-    glm::vec2 texCoordExtents = glm::vec2(imageSize.x/textureSize.x,
-            imageSize.y/textureSize.y);
+    FRect texCoordRect = m_pSurface->getTexCoordRect();
+    glm::vec2 texCoordOffset = texCoordRect.tl;
+    glm::vec2 texCoordExtents = texCoordRect.size();
 
     glm::vec2 texSizePerTile;
     if (m_TileSize.x == -1) {
@@ -638,14 +670,14 @@ void RasterNode::calcTexCoords()
     for (unsigned y = 0; y < m_TexCoords.size(); y++) {
         for (unsigned x = 0; x < m_TexCoords[y].size(); x++) {
             if (y == m_TexCoords.size()-1) {
-                m_TexCoords[y][x].y = texCoordExtents.y;
+                m_TexCoords[y][x].y = texCoordOffset.y+texCoordExtents.y;
             } else {
-                m_TexCoords[y][x].y = texSizePerTile.y*y;
+                m_TexCoords[y][x].y = texCoordOffset.y+texSizePerTile.y*y;
             }
             if (x == m_TexCoords[y].size()-1) {
-                m_TexCoords[y][x].x = texCoordExtents.x;
+                m_TexCoords[y][x].x = texCoordOffset.x+texCoordExtents.x;
             } else {
-                m_TexCoords[y][x].x = texSizePerTile.x*x;
+                m_TexCoords[y][x].x = texCoordOffset.x+texSizePerTile.x*x;
             }
         }
     }
@@ -85,6 +85,7 @@ class AVG_API RasterNode: public AreaNode
         void setMaskSize(const glm::vec2& size);
 
         void getElementsByPos(const glm::vec2& pos, std::vector<NodePtr>& pElements);
+        virtual bool getHitBounds(FRect& bounds) const;
 
         glm::vec3 getGamma() const;
         void setGamma(const glm::vec3& gamma);
@@ -113,6 +114,7 @@ class AVG_API RasterNode: public AreaNode
 
         void newSurface();
         void setupFX();
+        bool hasPerFrameVertexData() const;
 
     private:
         void downloadMask();
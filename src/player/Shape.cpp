@@ -96,6 +96,9 @@ void Shape::setVertexArray(const VertexArrayPtr& pVA)
 
 void Shape::draw(const glm::mat4& transform, float opacity)
 {
+    if (m_pImage->isUploadPending()) {
+        return;
+    }
     bool bIsTextured = (m_pImage->getSource() != Image::NONE);
     GLContext* pContext = GLContext::getCurrent();
     StandardShaderPtr pShader = pContext->getStandardShader();
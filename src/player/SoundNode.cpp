@@ -53,6 +53,8 @@ void SoundNode::registerType()
         .addArg(Arg<UTF8String>("href", "", false, offsetof(SoundNode, m_href)))
         .addArg(Arg<bool>("loop", false, false, offsetof(SoundNode, m_bLoop)))
         .addArg(Arg<float>("volume", 1.0, false, offsetof(SoundNode, m_Volume)))
+        .addArg(Arg<float>("pan", 0.0, false, offsetof(SoundNode, m_Pan)))
+        .addArg(Arg<int>("audiobus", 0, false, offsetof(SoundNode, m_AudioBus)))
         ;
     TypeRegistry::get()->registerType(def);
 }
@@ -63,6 +65,8 @@ SoundNode::SoundNode(const ArgList& args)
       m_SeekBeforeCanRenderTime(0),
       m_pDecoder(0),
       m_Volume(1.0),
+      m_Pan(0.0),
+      m_AudioBus(0),
       m_State(Unloaded),
       m_AudioID(-1)
 {
@@ -221,6 +225,32 @@ void SoundNode::setVolume(float volume)
     }
 }
 
+float SoundNode::getPan() const
+{
+    return m_Pan;
+}
+
+void SoundNode::setPan(float pan)
+{
+    m_Pan = pan;
+    if (m_AudioID != -1) {
+        AudioEngine::get()->setSourcePan(m_AudioID, pan);
+    }
+}
+
+int SoundNode::getAudioBus() const
+{
+    return m_AudioBus;
+}
+
+void SoundNode::setAudioBus(int busID)
+{
+    if (m_AudioID != -1) {
+        AudioEngine::get()->setSourceBus(m_AudioID, busID);
+    }
+    m_AudioBus = busID;
+}
+
 void SoundNode::checkReload()
 {
     string fileName (m_href);
@@ -312,6 +342,8 @@ void SoundNode::startDecoding()
     m_AudioID = pEngine->addSource(*m_pDecoder->getAudioMsgQ(), 
             *m_pDecoder->getAudioStatusQ());
     pEngine->setSourceVolume(m_AudioID, m_Volume);
+    pEngine->setSourcePan(m_AudioID, m_Pan);
+    pEngine->setSourceBus(m_AudioID, m_AudioBus);
     if (m_SeekBeforeCanRenderTime != 0) {
         seek(m_SeekBeforeCanRenderTime);
         m_SeekBeforeCanRenderTime = 0;
@@ -53,6 +53,10 @@ class AVG_API SoundNode : public AreaNode, IFrameEndListener
         void setHRef(const UTF8String& href);
         float getVolume();
         void setVolume(float volume);
+        float getPan() const;
+        void setPan(float pan);
+        int getAudioBus() const;
+        void setAudioBus(int busID);
         void checkReload();
 
         long long getDuration() const;
@@ -90,6 +94,8 @@ class AVG_API SoundNode : public AreaNode, IFrameEndListener
 
         AsyncVideoDecoder* m_pDecoder;
         float m_Volume;
+        float m_Pan;
+        int m_AudioBus;
         SoundState m_State;
         int m_AudioID;
 };
@@ -189,6 +189,17 @@ void TrackerInputDevice::resetHistory()
     m_pCmdQueue->pushCmd(boost::bind(&TrackerThread::resetHistory, _1));
 }
 
+void TrackerInputDevice::startCameraRecording(const string& sFilename)
+{
+    m_pCmdQueue->pushCmd(boost::bind(&TrackerThread::startCameraRecording, _1,
+            sFilename));
+}
+
+void TrackerInputDevice::stopCameraRecording()
+{
+    m_pCmdQueue->pushCmd(boost::bind(&TrackerThread::stopCameraRecording, _1));
+}
+
 void TrackerInputDevice::saveConfig()
 {
     m_TrackerConfig.save();
@@ -59,6 +59,8 @@ class AVG_API TrackerInputDevice: public IBlobTarget, public InputDevice
         std::string getParam(const std::string& sElement);
                 
         void resetHistory();
+        void startCameraRecording(const std::string& sFilename);
+        void stopCameraRecording();
         void setDebugImages(bool bImg, bool bFinger);
         void saveConfig();
         Bitmap * getImage(TrackerImageID imageID) const;
@@ -30,14 +30,16 @@ using namespace std;
 namespace avg {
 
 TypeDefinition::TypeDefinition() :
-      m_pBuilder(0)
+      m_pBuilder(0),
+      m_bIsPlugin(false)
 {
 }
 
 TypeDefinition::TypeDefinition(const string& sName, const string& sBaseName,
         ObjectBuilder pBuilder)
     : m_sName(sName),
-      m_pBuilder(pBuilder)
+      m_pBuilder(pBuilder),
+      m_bIsPlugin(false)
 {
     if (sBaseName != "") {
         TypeDefinition baseDef = TypeRegistry::get()->getTypeDef(sBaseName);
@@ -105,6 +107,16 @@ bool TypeDefinition::isAbstract() const
     return m_pBuilder == 0;
 }
 
+bool TypeDefinition::isPlugin() const
+{
+    return m_bIsPlugin;
+}
+
+void TypeDefinition::setPlugin(bool bPlugin)
+{
+    m_bIsPlugin = bPlugin;
+}
+
 TypeDefinition& TypeDefinition::addArg(const ArgBase& newArg)
 {
     m_Args.setArg(newArg);
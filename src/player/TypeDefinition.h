@@ -54,6 +54,9 @@ public:
     bool isChildAllowed(const std::string& sChild) const;
     bool hasChildren() const;
     bool isAbstract() const;
+    // True for types registered by a plugin.
+    bool isPlugin() const;
+    void setPlugin(bool bPlugin);
     
     TypeDefinition& addArg(const ArgBase& newArg);
     TypeDefinition& addDTDElements(const std::string& s);
@@ -66,6 +69,7 @@ private:
     ArgList m_Args;
     std::string m_sDTDElements;
     std::vector<std::string> m_sChildren;
+    bool m_bIsPlugin;
 
 };
 
@@ -37,6 +37,7 @@ namespace avg {
 TypeRegistry* TypeRegistry::s_pInstance = 0;
 
 TypeRegistry::TypeRegistry()
+    : m_bRegisteringPlugin(false)
 {
 }
 
@@ -54,7 +55,11 @@ TypeRegistry* TypeRegistry::get()
 
 void TypeRegistry::registerType(const TypeDefinition& def, const char* pParentNames[])
 {
-    m_TypeDefs.insert(TypeDefMap::value_type(def.getName(), def));
+    TypeDefMap::iterator it =
+            m_TypeDefs.insert(TypeDefMap::value_type(def.getName(), def)).first;
+    if (m_bRegisteringPlugin) {
+        it->second.setPlugin(true);
+    }
 
     if (pParentNames) {
         string sChildArray[1];
@@ -129,6 +134,16 @@ string TypeRegistry::getDTD() const
     return ss.str();
 }
 
+void TypeRegistry::startPluginRegistration()
+{
+    m_bRegisteringPlugin = true;
+}
+
+void TypeRegistry::endPluginRegistration()
+{
+    m_bRegisteringPlugin = false;
+}
+
 TypeDefinition& TypeRegistry::getTypeDef(const string& sType)
 {
     TypeDefMap::iterator it = m_TypeDefs.find(sType);
@@ -46,6 +46,10 @@ public:
     ExportedObjectPtr createObject(const std::string& Type, const py::dict& PyDict);
     
     std::string getDTD() const;
+
+    // Types registered between these calls are marked as plugin types.
+    void startPluginRegistration();
+    void endPluginRegistration();
     
 private:
     TypeRegistry();
@@ -53,6 +57,7 @@ private:
     
     typedef std::map<std::string, TypeDefinition> TypeDefMap;
     TypeDefMap m_TypeDefs;
+    bool m_bRegisteringPlugin;
 
     static TypeRegistry* s_pInstance;
 };
@@ -164,6 +164,12 @@ void VectorNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
     }
 }
 
+bool VectorNode::isPreRenderStatic() const
+{
+    // Visible vector nodes add their vertices to the frame's vertex array every frame.
+    return !isVisible();
+}
+
 void VectorNode::maybeRender(const glm::mat4& parentTransform)
 {
     AVG_ASSERT(getState() == NS_CANRENDER);
@@ -251,6 +257,7 @@ string VectorNode::lineJoin2String(LineJoin lineJoin)
 void VectorNode::setDrawNeeded()
 {
     m_bDrawNeeded = true;
+    setPreRenderDirty();
 }
         
 bool VectorNode::isDrawNeeded()
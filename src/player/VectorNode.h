@@ -84,6 +84,7 @@ class AVG_API VectorNode : public Node
 
         void setDrawNeeded();
         bool isDrawNeeded();
+        virtual bool isPreRenderStatic() const;
         bool hasVASizeChanged();
         void calcPolyLineCumulDist(std::vector<float>& cumulDist, 
                 const std::vector<glm::vec2>& pts, bool bIsClosed);
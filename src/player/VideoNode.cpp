@@ -66,10 +66,16 @@ void VideoNode::registerType()
         .addArg(Arg<int>("queuelength", 8, false, 
                 offsetof(VideoNode, m_QueueLength)))
         .addArg(Arg<float>("volume", 1.0, false, offsetof(VideoNode, m_Volume)))
+        .addArg(Arg<float>("pan", 0.0, false, offsetof(VideoNode, m_Pan)))
+        .addArg(Arg<int>("audiobus", 0, false, offsetof(VideoNode, m_AudioBus)))
         .addArg(Arg<bool>("accelerated", false, false,
                 offsetof(VideoNode, m_bUsesHardwareAcceleration)))
         .addArg(Arg<bool>("enablesound", true, false,
                 offsetof(VideoNode, m_bEnableSound)))
+        .addArg(Arg<float>("loopcachesize", 0, false,
+                offsetof(VideoNode, m_LoopCacheSize)))
+        .addArg(Arg<string>("loopcacheoverflow", "discard", false,
+                offsetof(VideoNode, m_sLoopCacheOverflow)))
         ;
     TypeRegistry::get()->registerType(def);
 }
@@ -86,6 +92,8 @@ VideoNode::VideoNode(const ArgList& args)
       m_SeekBeforeCanRenderTime(0),
       m_pDecoder(0),
       m_Volume(1.0),
+      m_Pan(0.0),
+      m_AudioBus(0),
       m_bUsesHardwareAcceleration(false),
       m_bEnableSound(true),
       m_AudioID(-1)
@@ -97,8 +105,17 @@ VideoNode::VideoNode(const ArgList& args)
         throw Exception(AVG_ERR_INVALID_ARGS, 
                 "Can't set queue length for unthreaded videos because there is no decoder queue in this case.");
     }
+    if (!m_bThreaded && m_LoopCacheSize != 0) {
+        throw Exception(AVG_ERR_INVALID_ARGS,
+                "Can't set loop cache size for unthreaded videos.");
+    }
     if (m_bThreaded) {
-        m_pDecoder = new AsyncVideoDecoder(m_QueueLength);
+        AsyncVideoDecoder* pAsyncDecoder = new AsyncVideoDecoder(m_QueueLength);
+        if (m_LoopCacheSize > 0) {
+            pAsyncDecoder->enableLoopCache((long long)(m_LoopCacheSize*1024*1024),
+                    VideoFrameCache::stringToPolicy(m_sLoopCacheOverflow));
+        }
+        m_pDecoder = pAsyncDecoder;
     } else {
         m_pDecoder = new SyncVideoDecoder();
     }
@@ -189,6 +206,28 @@ int VideoNode::getNumFramesQueued() const
     return m_pDecoder->getNumFramesQueued();
 }
 
+int VideoNode::getNumLoopCacheFrames() const
+{
+    exceptionIfUnloaded("getNumLoopCacheFrames");
+    AsyncVideoDecoder* pAsyncDecoder = dynamic_cast<AsyncVideoDecoder*>(m_pDecoder);
+    if (pAsyncDecoder && pAsyncDecoder->getLoopCache()) {
+        return pAsyncDecoder->getLoopCache()->getNumFrames();
+    } else {
+        return 0;
+    }
+}
+
+int VideoNode::getNumFramesFromLoopCache() const
+{
+    exceptionIfUnloaded("getNumFramesFromLoopCache");
+    AsyncVideoDecoder* pAsyncDecoder = dynamic_cast<AsyncVideoDecoder*>(m_pDecoder);
+    if (pAsyncDecoder) {
+        return pAsyncDecoder->getNumFramesFromCache();
+    } else {
+        return 0;
+    }
+}
+
 void VideoNode::seekToFrame(int frameNum)
 {
     if (frameNum < 0) {
@@ -361,6 +400,32 @@ void VideoNode::setVolume(float volume)
     }
 }
 
+float VideoNode::getPan() const
+{
+    return m_Pan;
+}
+
+void VideoNode::setPan(float pan)
+{
+    m_Pan = pan;
+    if (m_AudioID != -1) {
+        AudioEngine::get()->setSourcePan(m_AudioID, pan);
+    }
+}
+
+int VideoNode::getAudioBus() const
+{
+    return m_AudioBus;
+}
+
+void VideoNode::setAudioBus(int busID)
+{
+    if (m_AudioID != -1) {
+        AudioEngine::get()->setSourceBus(m_AudioID, busID);
+    }
+    m_AudioBus = busID;
+}
+
 void VideoNode::checkReload()
 {
     string fileName (m_href);
@@ -499,6 +564,8 @@ void VideoNode::startDecoding()
         m_AudioID = pAudioEngine->addSource(*pAsyncDecoder->getAudioMsgQ(), 
                 *pAsyncDecoder->getAudioStatusQ());
         pAudioEngine->setSourceVolume(m_AudioID, m_Volume);
+        pAudioEngine->setSourcePan(m_AudioID, m_Pan);
+        pAudioEngine->setSourceBus(m_AudioID, m_AudioBus);
     }
     m_bSeekPending = true;
     
@@ -592,6 +659,16 @@ int VideoNode::getQueueLength() const
     return m_QueueLength;
 }
 
+float VideoNode::getLoopCacheSize() const
+{
+    return m_LoopCacheSize;
+}
+
+const string& VideoNode::getLoopCacheOverflow() const
+{
+    return m_sLoopCacheOverflow;
+}
+
 long long VideoNode::getNextFrameTime() const
 {
     switch (m_VideoState) {
@@ -65,13 +65,21 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         void setHRef(const UTF8String& href);
         float getVolume();
         void setVolume(float volume);
+        float getPan() const;
+        void setPan(float pan);
+        int getAudioBus() const;
+        void setAudioBus(int busID);
         float getFPS() const;
         int getQueueLength() const;
+        float getLoopCacheSize() const;
+        const std::string& getLoopCacheOverflow() const;
         void checkReload();
 
         int getNumFrames() const;
         int getCurFrame() const;
         int getNumFramesQueued() const;
+        int getNumLoopCacheFrames() const;
+        int getNumFramesFromLoopCache() const;
         void seekToFrame(int frameNum);
         std::string getStreamPixelFormat() const;
         long long getDuration() const;
@@ -132,6 +140,8 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         bool m_bThreaded;
         float m_FPS;
         int m_QueueLength;
+        float m_LoopCacheSize;
+        std::string m_sLoopCacheOverflow;
         bool m_bEOFPending;
         PyObject * m_pEOFCallback;
         int m_FramesTooLate;
@@ -147,6 +157,8 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
 
         VideoDecoder * m_pDecoder;
         float m_Volume;
+        float m_Pan;
+        int m_AudioBus;
         bool m_bUsesHardwareAcceleration;
         bool m_bEnableSound;
         int m_AudioID;
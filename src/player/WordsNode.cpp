@@ -39,6 +39,7 @@
 #include "../graphics/GLContextManager.h"
 #include "../graphics/GLTexture.h"
 #include "../graphics/TextureMover.h"
+#include "../graphics/TextureAtlas.h"
 
 #include <pango/pangoft2.h>
 
@@ -267,6 +268,12 @@ glm::vec2 WordsNode::toGlobal(const glm::vec2& localPos) const
     return globalPos + getRelViewport().tl;
 }
 
+bool WordsNode::getHitBounds(FRect& bounds) const
+{
+    // Text changes move the bounds without a notification.
+    return false;
+}
+
 const FontStyle& WordsNode::getFontStyle() const
 {
     return m_FontStyle;
@@ -685,8 +692,13 @@ void WordsNode::renderText()
             setRenderColor(m_FontStyle.getColorVal());
 
             GLContextManager* pCM = GLContextManager::get();
-            MCTexturePtr pTex = pCM->createTextureFromBmp(pBmp);
-            getSurface()->create(A8, pTex);
+            AtlasRegionPtr pRegion = pCM->getTextureAtlas()->insert(pBmp);
+            if (pRegion) {
+                getSurface()->create(A8, pRegion);
+            } else {
+                MCTexturePtr pTex = pCM->createTextureFromBmp(pBmp);
+                getSurface()->create(A8, pTex);
+            }
             newSurface();
         }
         m_bRenderNeeded = false;
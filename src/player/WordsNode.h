@@ -61,6 +61,7 @@ class AVG_API WordsNode : public RasterNode
 
         glm::vec2 toLocal(const glm::vec2& globalPos) const;
         glm::vec2 toGlobal(const glm::vec2& localPos) const;
+        virtual bool getHitBounds(FRect& bounds) const;
 
         void setTextFromNodeValue(const std::string& sText);
 
@@ -26,14 +26,15 @@ from libavg import avg
 validPixFmt = list();
 for formatItem in avg.getSupportedPixelFormats():
     validPixFmt.append(formatItem);
-validDrivers = ('firewire', 'video4linux', 'directshow')
+validDrivers = ('firewire', 'video4linux', 'directshow', 'replay')
 
 def addOptions(parser):
     parser.add_option("-t", "--driver", action="store", dest="driver", 
                   choices=validDrivers, 
                   help="camera drivers (one of: %s)" %', '.join(validDrivers))
     parser.add_option("-d", "--device", action = "store", dest = "device", default = "",
-                      help = "camera device identifier (may be GUID or device path)")
+                      help = "camera device identifier (may be GUID, device path or "
+                             "name of a recording)")
     parser.add_option("-u", "--unit", action="store", dest="unit", default="-1",
               type="int", help="unit number")
     parser.add_option("-w", "--width", dest="width", default="640", type="int",
@@ -344,6 +344,46 @@ class AVTestCase(AVGTestCase):
             player.subscribe(player.ON_FRAME, onFrame)
             player.play()
 
+    def testVideoLoopCache(self):
+        def onEOF():
+            self.numEOFs += 1
+            if self.numEOFs == 3:
+                self.numCacheFrames = videoNode.getNumLoopCacheFrames()
+                self.numFramesFromCache = videoNode.getNumFramesFromLoopCache()
+                self.numFrames = videoNode.getNumFrames()
+
+        def onFrame():
+            if self.numEOFs == 3:
+                player.stop()
+
+        self.assertRaises(avg.Exception, lambda: avg.VideoNode(href="mpeg1-48x48.mov",
+                threaded=False, loopcachesize=1))
+        self.assertRaises(avg.Exception, lambda: avg.VideoNode(href="mpeg1-48x48.mov",
+                loopcachesize=1, loopcacheoverflow="foo"))
+        # The decoded clip needs about 0.1 MB, so only part of it fits into the cache.
+        for overflow in ("discard", "keepstart"):
+            self.numEOFs = 0
+            player.setFakeFPS(25)
+            root = self.loadEmptyScene()
+            videoNode = avg.VideoNode(parent=root, loop=True, fps=25,
+                    href="mpeg1-48x48.mov", loopcachesize=0.05,
+                    loopcacheoverflow=overflow)
+            self.assertAlmostEqual(videoNode.loopcachesize, 0.05)
+            self.assertEqual(videoNode.loopcacheoverflow, overflow)
+            videoNode.subscribe(avg.Node.END_OF_FILE, onEOF)
+            videoNode.play()
+            player.subscribe(player.ON_FRAME, onFrame)
+            player.play()
+            if overflow == "discard":
+                # The cache was dropped and every loop was decoded.
+                self.assertEqual(self.numCacheFrames, 0)
+                self.assertEqual(self.numFramesFromCache, 0)
+            else:
+                # The start of the clip was kept and replayed in the second and third
+                # loop.
+                self.assert_(0 < self.numCacheFrames < self.numFrames)
+                self.assert_(0 < self.numFramesFromCache <= 2*self.numCacheFrames)
+
     def testVideoMask(self):
         def testWithFile(filename, testImgName):
             def setMask(href):
@@ -520,6 +560,74 @@ class AVTestCase(AVGTestCase):
                  lambda: soundNode.seekToTime(200),
                 ))
 
+    def testAudioBus(self):
+        def createBuses():
+            self.busID = player.createAudioBus()
+            self.subBusID = player.createAudioBus(self.busID)
+            player.setAudioBusGain(self.busID, 0.5)
+            self.assertAlmostEqual(player.getAudioBusGain(self.busID), 0.5)
+            player.setAudioBusLimiter(self.subBusID, True)
+            player.setAudioBusChannelMap(self.busID, [1, 0])
+            self.assertRaises(avg.Exception,
+                    lambda: player.setAudioBusChannelMap(self.busID, [0]))
+            self.assertRaises(avg.Exception, lambda: player.removeAudioBus(0))
+            node.audiobus = self.subBusID
+            node.pan = -0.5
+            node.play()
+
+        def removeBus():
+            player.removeAudioBus(self.busID)
+            self.assertRaises(avg.Exception, lambda: player.removeAudioBus(self.busID))
+            self.assertRaises(avg.Exception, lambda: player.getAudioBusGain(self.busID))
+
+        player.setFakeFPS(-1)
+        player.volume = 0
+        self.assertRaises(avg.Exception, player.createAudioBus)
+        root = self.loadEmptyScene()
+        node = avg.SoundNode(href="44.1kHz_16bit_stereo.wav", pan=0.5, parent=root)
+        self.assertAlmostEqual(node.pan, 0.5)
+        self.assertEqual(node.audiobus, 0)
+        self.start(False,
+                (createBuses,
+                 None,
+                 removeBus,
+                 lambda: node.stop(),
+                ))
+
+
+    def testAudioSample(self):
+        def playSamples():
+            self.assertRaises(avg.Exception,
+                    lambda: player.loadAudioSample("nonexistent.wav"))
+            self.assertRaises(avg.Exception,
+                    lambda: player.loadAudioSample("mpeg1-48x48.mov"))
+            self.sampleID = player.loadAudioSample("44.1kHz_16bit_mono.wav")
+            player.setMaxAudioVoices(4)
+            self.assertEqual(player.getMaxAudioVoices(), 4)
+            self.assertRaises(avg.Exception, lambda: player.setMaxAudioVoices(0))
+            busID = player.createAudioBus()
+            for i in range(8):
+                self.voiceID = player.playAudioSample(self.sampleID, 0.5, -1, busID)
+            player.playAudioSample(self.sampleID)
+            self.assertRaises(avg.Exception,
+                    lambda: player.playAudioSample(self.sampleID, 1, 0, 100))
+
+        def unloadSample():
+            player.stopAudioVoice(self.voiceID)
+            player.unloadAudioSample(self.sampleID)
+            self.assertRaises(avg.Exception,
+                    lambda: player.playAudioSample(self.sampleID))
+
+        player.setFakeFPS(-1)
+        player.volume = 0
+        self.assertRaises(avg.Exception,
+                lambda: player.loadAudioSample("44.1kHz_16bit_mono.wav"))
+        self.loadEmptyScene()
+        self.start(False,
+                (playSamples,
+                 None,
+                 unloadSample,
+                ))
 
     def testBrokenSound(self):
         def openSound():
@@ -653,6 +761,8 @@ def AVTestSuite(tests):
             "testSound",
             "testSoundInfo",
             "testSoundSeek",
+            "testAudioBus",
+            "testAudioSample",
             "testBrokenSound",
             "testSoundEOF",
             "testVideoInfo",
@@ -665,6 +775,7 @@ def AVTestSuite(tests):
             "testVideoSeek",
             "testVideoFPS",
             "testVideoLoop",
+            "testVideoLoopCache",
             "testVideoMask",
             "testVideoEOF",
             "testVideoSeekAfterEOF",
@@ -586,6 +586,100 @@ class ImageTestCase(AVGTestCase):
                  checkAlpha,
                 ])
 
+    def testImageAtlas(self):
+        def createNodes():
+            self.nodes = []
+            for i in xrange(4):
+                self.nodes.append(avg.ImageNode(href="rgb24-65x65.png", pos=(i*40, 0),
+                        size=(32, 32), parent=root))
+                self.nodes.append(avg.ImageNode(href="rgb24alpha-64x64.png", 
+                        pos=(i*40, 40), parent=root))
+            self.nodes.append(avg.ImageNode(href="rgb24-65x65.png", maskhref="mask.png",
+                    pos=(0, 80), size=(32, 32), parent=root))
+            bmp = avg.Bitmap("media/rgb24-64x64.png")
+            self.nodes.append(avg.ImageNode(pos=(40, 80), parent=root))
+            self.nodes[-1].setBitmap(bmp)
+
+        def checkAtlased():
+            self.assert_(player.getNumAtlasedTextures() >= len(self.nodes))
+            self.assert_(player.getTextureAtlasOccupancy() > 0)
+            self.atlasBmp = player.screenshot()
+
+        def recreateWithoutAtlas():
+            numAtlased = player.getNumAtlasedTextures()
+            for node in self.nodes:
+                node.unlink(True)
+            self.assertEqual(player.getNumAtlasedTextures(), 
+                    numAtlased-len(self.nodes))
+            player.enableTextureAtlas(False)
+            createNodes()
+
+        def compareToAtlas():
+            player.enableTextureAtlas(True)
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, self.atlasBmp, 0.5, 0.5))
+
+        root = self.loadEmptyScene()
+        player.enableTextureAtlas(True)
+        createNodes()
+        self.start(False,
+                (checkAtlased,
+                 recreateWithoutAtlas,
+                 compareToAtlas,
+                ))
+
+    def testAsyncTextureUpload(self):
+        def createNode():
+            # Without pixel buffers or with several contexts, uploads fall back to
+            # synchronous ones.
+            self.bAsync = player.areAsyncTextureUploadsSupported()
+            self.emptyBmp = player.screenshot()
+            self.node = avg.ImageNode(size=(160, 120), parent=root)
+            self.node.setBitmap(bmp)
+            if self.bAsync:
+                self.assertEqual(player.getNumPendingTextureUploads(), 1)
+            else:
+                self.assertEqual(player.getNumPendingTextureUploads(), 0)
+
+        def checkPending():
+            bmp = player.screenshot()
+            if self.bAsync:
+                # The node isn't rendered until all of the bitmap has been uploaded.
+                self.assertEqual(player.getNumPendingTextureUploads(), 1)
+                self.assert_(self.areSimilarBmps(bmp, self.emptyBmp, 0.1, 0.1))
+            else:
+                self.assertEqual(player.getNumPendingTextureUploads(), 0)
+                self.assert_(not(self.areSimilarBmps(bmp, self.emptyBmp, 0.1, 0.1)))
+
+        def checkUploaded():
+            self.assertEqual(player.getNumPendingTextureUploads(), 0)
+            self.asyncBmp = player.screenshot()
+            self.node.unlink(True)
+            player.enableAsyncTextureUploads(False)
+            self.node = avg.ImageNode(size=(160, 120), parent=root)
+            self.node.setBitmap(bmp)
+            self.assertEqual(player.getNumPendingTextureUploads(), 0)
+
+        def compareToSync():
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, self.asyncBmp, 0.1, 0.1))
+            player.enableAsyncTextureUploads(True)
+            player.setTextureUploadBudget(8*1024*1024)
+
+        root = self.loadEmptyScene()
+        # 2 MB, uploaded in eight frames or more.
+        bmp = avg.Bitmap("media/rgb24-64x64.png").getResized((1024, 512))
+        player.setTextureUploadBudget(256*1024)
+        self.start(False,
+                (createNode,
+                 checkPending,
+                 checkPending,
+                 lambda: self.waitUntil(
+                        lambda: player.getNumPendingTextureUploads() == 0),
+                 checkUploaded,
+                 compareToSync,
+                ))
+
     def testSpline(self):
         spline = avg.CubicSpline([(0,3),(1,2),(2,1),(3,0)])
         self.assertAlmostEqual(spline.interpolate(0), 3)
@@ -618,6 +712,8 @@ def imageTestSuite(tests):
             "testImageMaskSize",
             "testImageMipmap",
             "testImageCompression",
+            "testImageAtlas",
+            "testAsyncTextureUpload",
             "testSpline",
             )
     return createAVGTestSuite(availableTests, ImageTestCase, tests)
@@ -369,6 +369,49 @@ class OffscreenTestCase(AVGTestCase):
             self.skip("Offscreen mipmap init failed.")
             return
 
+    def testCanvasDrawBatching(self):
+        def createCanvas():
+            canvas = player.createCanvas(id="batchcanvas", size=(160,160),
+                    autorender=False)
+            root = canvas.getRootNode()
+            for i in xrange(10):
+                y = i*12
+                avg.LineNode(pos1=(2,y+2), pos2=(50,y+10), color="FF8000",
+                        parent=root)
+                avg.RectNode(pos=(55,y+1), size=(40,10), color="00FF00",
+                        fillcolor="0000FF", fillopacity=1, parent=root)
+                avg.PolygonNode(pos=((100,y+1), (150,y+1), (125,y+11)),
+                        color="FFFFFF", fillcolor="FF0000", fillopacity=1, 
+                        parent=root)
+            # Images with the same texture, transform and opacity share a draw call.
+            for i in xrange(3):
+                avg.ImageNode(pos=(2,122), href="rgb24-32x32.png", parent=root)
+            return canvas
+
+        def renderCanvas(bBatch):
+            player.enableDrawBatching(bBatch)
+            self.__offscreenCanvas.render()
+            return (self.__offscreenCanvas.screenshot(), 
+                    self.__offscreenCanvas.getNumDrawCalls())
+
+        def compareRenderings():
+            batchedBmp, numBatchedCalls = renderCanvas(True)
+            unbatchedBmp, numUnbatchedCalls = renderCanvas(False)
+            player.enableDrawBatching(True)
+            self.assert_(self.areSimilarBmps(batchedBmp, unbatchedBmp, 0, 0))
+            self.assert_(numBatchedCalls < numUnbatchedCalls)
+
+        def deleteCanvas():
+            player.deleteCanvas("batchcanvas")
+            self.__offscreenCanvas = None
+
+        self.loadEmptyScene()
+        self.__offscreenCanvas = createCanvas()
+        self.start(False,
+                (compareRenderings,
+                 deleteCanvas,
+                ))
+
     def testCanvasDependencies(self):
         def makeCircularRef():
             self.offscreen1.getElementByID("test1").href = "canvas:offscreencanvas2"
@@ -467,6 +510,7 @@ def offscreenTestSuite(tests):
                 "testCanvasMultisampling",
                 "testCanvasMipmap",
                 "testCanvasDependencies",
+                "testCanvasDrawBatching",
                 )
         return createAVGTestSuite(availableTests, OffscreenTestCase, tests)
     else:
@@ -20,6 +20,7 @@
 #
 
 import math
+import random
 import threading
 
 from libavg import avg, player
@@ -273,6 +274,148 @@ class PlayerTestCase(AVGTestCase):
                 (lambda: self.compareImage("testOpacity"),
                 )) 
 
+    def testPreRenderSkipping(self):
+        def checkNumVisited(numVisited):
+            self.assertEqual(canvas.getNumPreRenderedNodes(), numVisited)
+            self.assertEqual(canvas.getNumSkippedPreRenderNodes(), 
+                    numNodes-numVisited)
+
+        def changeOpacity():
+            divs[3].getChild(5).opacity = 0.5
+
+        def moveDiv():
+            # Position changes don't affect preRender.
+            divs[3].pos = (10, 10)
+
+        def hideDiv():
+            # Changes the effective opacity of all children as well.
+            divs[5].opacity = 0
+
+        root = self.loadEmptyScene()
+        canvas = player.getMainCanvas()
+        divs = []
+        for i in xrange(10):
+            div = avg.DivNode(pos=(i*16,0), parent=root)
+            divs.append(div)
+            for j in xrange(20):
+                avg.ImageNode(pos=(0,j*6), href="rgb24-65x65.png", size=(16,6),
+                        parent=div)
+        numNodes = 1 + 10 + 10*20
+        # Counters are from the frame rendered before each action.
+        self.start(False,
+                (None,
+                 lambda: checkNumVisited(numNodes),
+                 lambda: checkNumVisited(1),
+                 changeOpacity,
+                 lambda: checkNumVisited(3),
+                 lambda: checkNumVisited(1),
+                 moveDiv,
+                 lambda: checkNumVisited(1),
+                 hideDiv,
+                 lambda: checkNumVisited(2+20),
+                 lambda: checkNumVisited(1),
+                ))
+
+    def testPreRenderSkippingLargeScene(self):
+        # Frames with skipped preRender look the same as frames that visit every node.
+        def checkNumVisited(numVisited):
+            self.assertEqual(canvas.getNumPreRenderedNodes(), numVisited)
+            self.assertEqual(canvas.getNumSkippedPreRenderNodes(),
+                    numNodes-numVisited)
+
+        def checkSameAs(refBmp):
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, refBmp, 0.1, 0.5))
+
+        def saveFullBmp():
+            checkNumVisited(numNodes)
+            self.fullBmp = player.screenshot()
+
+        def hideImage():
+            divs[13].getChild(5).opacity = 0
+
+        def saveChangedBmp():
+            checkNumVisited(3)
+            self.changedBmp = player.screenshot()
+            self.assertNotEqual(self.changedBmp.subtract(self.fullBmp).getAvg(), 0)
+
+        def setRootOpacity(opacity):
+            root.opacity = opacity
+
+        root = self.loadEmptyScene()
+        canvas = player.getMainCanvas()
+        divs = []
+        for i in xrange(50):
+            div = avg.DivNode(pos=((i%10)*16, (i//10)*24), parent=root)
+            divs.append(div)
+            for j in xrange(100):
+                if j%2 == 0:
+                    href = "rgb24-64x64.png"
+                else:
+                    href = "rgb24alpha-64x64.png"
+                avg.ImageNode(pos=((j%4)*4, j//4), href=href, size=(4,1), parent=div)
+        numNodes = 1 + 50 + 50*100
+        # Counters and screenshots are from the frame rendered before each action.
+        self.start(False,
+                (None,
+                 saveFullBmp,
+                 lambda: checkNumVisited(1),
+                 lambda: checkSameAs(self.fullBmp),
+                 hideImage,
+                 saveChangedBmp,
+                 lambda: checkNumVisited(1),
+                 lambda: checkSameAs(self.changedBmp),
+                 # Changing the root opacity makes the next frame visit every node.
+                 lambda: setRootOpacity(0.5),
+                 lambda: setRootOpacity(1),
+                 lambda: checkNumVisited(numNodes),
+                 lambda: checkSameAs(self.changedBmp),
+                ))
+
+    def testHitTestGrid(self):
+        def getExpectedElement(pos):
+            for i in xrange(div.getNumChildren()-1, -1, -1):
+                child = div.getChild(i)
+                localPos = child.getRelPos(pos)
+                if (localPos.x >= 0 and localPos.y >= 0 and localPos.x < child.width 
+                        and localPos.y < child.height):
+                    return child
+            return div
+
+        def checkPicking():
+            for i in xrange(200):
+                pos = avg.Point2D(random.uniform(0, 160), random.uniform(0, 120))
+                self.assertEqual(div.getElementByPos(pos), getExpectedElement(pos))
+
+        def moveNodes():
+            for i in xrange(0, 100, 7):
+                div.getChild(i).pos = (random.uniform(0, 140), random.uniform(0, 100))
+                div.getChild(i+1).angle = random.uniform(0, 3)
+                div.getChild(i+2).size = (random.uniform(0, 50), random.uniform(0, 50))
+
+        def changeChildren():
+            div.reorderChild(0, 50)
+            div.removeChild(10)
+            avg.DivNode(pos=(10,10), size=(100,100), parent=div)
+
+        # The div has enough children to use a hit test grid, so the results are
+        # compared to a linear search.
+        random.seed(1)
+        root = self.loadEmptyScene()
+        div = avg.DivNode(size=(160,120), parent=root)
+        for i in xrange(100):
+            avg.DivNode(pos=(random.uniform(0, 140), random.uniform(0, 100)), 
+                    size=(random.uniform(0, 20), random.uniform(0, 20)), parent=div)
+        self.start(False,
+                (checkPicking,
+                 moveNodes,
+                 checkPicking,
+                 changeChildren,
+                 checkPicking,
+                 moveNodes,
+                 checkPicking,
+                ))
+
     def testOutlines(self):
         root = self.__initDefaultRotateScene()
         root.elementoutlinecolor = "FFFFFF"
@@ -866,6 +1009,9 @@ def playerTestSuite(tests):
             "testRotate2",
             "testRotatePivot",
             "testOpacity",
+            "testPreRenderSkipping",
+            "testPreRenderSkippingLargeScene",
+            "testHitTestGrid",
             "testOutlines",
             "testWordsOutlines",
             "testError",
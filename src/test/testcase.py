@@ -147,6 +147,22 @@ class AVGTestCase(unittest.TestCase):
         self.__delaying = True
         player.setTimeout(time, timeout)
 
+    def waitUntil(self, condition, maxTime=10000):
+        # Holds back the next action until condition() is true or maxTime ms have
+        # passed. The next action should then check the condition.
+        def checkCondition():
+            if condition():
+                stopWaiting()
+
+        def stopWaiting():
+            player.clearInterval(timeoutID)
+            player.unsubscribe(player.ON_FRAME, subscriberID)
+            self.__delaying = False
+
+        self.__delaying = True
+        subscriberID = player.subscribe(player.ON_FRAME, checkCondition)
+        timeoutID = player.setTimeout(maxTime, stopWaiting)
+
     def compareImage(self, fileName):
         bmp = player.screenshot()
         self.compareBitmapToFile(bmp, fileName)
@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+
+# libavg - Media Playback Engine.
+# Copyright (C) 2003-2014 Ulrich von Zadow
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Lesser General Public
+# License as published by the Free Software Foundation; either
+# version 2 of the License, or (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public
+# License along with this library; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Current versions can be found at www.libavg.de
+#
+
+from libavg import *
+
+import random
+import time
+
+
+class PickSpeedDiv(app.MainDiv):
+    def onArgvParserCreated(self, parser):
+        usage = '%prog [options]\n' \
+                'Checks hit testing performance by creating lots of sensitive nodes ' \
+                'and looking up the nodes under a number of cursors every frame. ' \
+                'Executes for 20 secs and prints the average lookup time per frame.'
+        parser.set_usage(usage)
+
+        parser.add_option('--num-objs', '-n', dest='numObjs',
+                type='int', default=10000,
+                help='number of sensitive nodes to create [Default: 10000]')
+        parser.add_option('--num-cursors', '-c', dest='numCursors',
+                type='int', default=50,
+                help='number of positions to look up per frame [Default: 50]')
+        parser.add_option('--move', '-m', dest='move',
+                action='store_true', default=False,
+                help='move 1% of the nodes every frame')
+        parser.add_option('--rotate', '-r', dest='rotate',
+                action='store_true', default=False,
+                help='rotate nodes')
+
+    def onArgvParsed(self, options, args, parser):
+        self.__optNumObjs = max(options.numObjs, 1)
+        self.__optNumCursors = max(options.numCursors, 1)
+        self.__optMove = options.move
+        self.__optRotate = options.rotate
+
+    def onInit(self):
+        player.setFramerate(1000)
+        self.__nodes = []
+        for i in xrange(self.__optNumObjs):
+            node = avg.DivNode(pos=self.__randomPos(), size=(8,8), parent=self)
+            if self.__optRotate:
+                node.angle = random.uniform(0, 3.14)
+            self.__nodes.append(node)
+        self.__pickTime = 0
+        self.__numFrames = 0
+        self.__numHits = 0
+        player.setTimeout(0, lambda: player.setTimeout(20000, self.__stop))
+
+    def onFrame(self):
+        if self.__optMove:
+            for i in xrange(max(len(self.__nodes)/100, 1)):
+                random.choice(self.__nodes).pos = self.__randomPos()
+        positions = [self.__randomPos() for i in xrange(self.__optNumCursors)]
+        tstart = time.time()
+        for pos in positions:
+            if self.getElementByPos(pos) != self:
+                self.__numHits += 1
+        self.__pickTime += time.time()-tstart
+        self.__numFrames += 1
+
+    def __randomPos(self):
+        return avg.Point2D(random.uniform(0, self.width), random.uniform(0, self.height))
+
+    def __stop(self):
+        print 'Frames: %i' % self.__numFrames
+        print 'Average lookup time per frame: %f ms' % \
+                (self.__pickTime*1000/self.__numFrames)
+        print 'Hits per frame: %f' % (float(self.__numHits)/self.__numFrames)
+        player.stop()
+
+
+if __name__ == '__main__':
+    app.App().run(PickSpeedDiv(), app_resolution='800x600')
@@ -29,6 +29,7 @@
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
 #include "../base/ScopeTimer.h"
+#include "../base/Logger.h"
 
 #include "../audio/AudioParams.h"
 
@@ -42,7 +43,9 @@ using namespace std;
 using boost::dynamic_pointer_cast;
 
 #define AUDIO_MSG_QUEUE_LENGTH  50
-#define AUDIO_STATUS_QUEUE_LENGTH -1
+// Besides the status, the audio thread returns every message it took from the audio
+// message queue, so this needs room for those as well.
+#define AUDIO_STATUS_QUEUE_LENGTH 256
 #define PACKET_QUEUE_LENGTH 50
 
 namespace avg {
@@ -53,7 +56,12 @@ AsyncVideoDecoder::AsyncVideoDecoder(int queueLength)
       m_pVDecoderThread(0),
       m_pADecoderThread(0),
       m_bUseStreamFPS(true),
-      m_FPS(0)
+      m_FPS(0),
+      m_LoopCacheBytes(0),
+      m_LoopCachePolicy(VideoFrameCache::DISCARD),
+      m_bPlayingFromCache(false),
+      m_CachePos(0),
+      m_NumFramesFromCache(0)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -99,6 +107,19 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
     }
     setupDemuxer(streamIndexes);
 
+    m_bPlayingFromCache = false;
+    m_NumFramesFromCache = 0;
+    if (m_LoopCacheBytes > 0) {
+        if (getVideoInfo().m_bHasAudio || usesVDPAU()) {
+            AVG_LOG_WARNING("Video loop cache not supported for videos with sound or "
+                    "hardware decoding. Disabled.");
+        } else {
+            m_pFrameCache = VideoFrameCachePtr(
+                    new VideoFrameCache(m_LoopCacheBytes, m_LoopCachePolicy));
+            m_pFrameCache->startFilling();
+        }
+    }
+
     if (getVideoInfo().m_bHasVideo) {
         m_LastVideoFrameTime = -1;
         m_CurVideoFrameTime = -1;
@@ -106,7 +127,7 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
             m_FPS = getStreamFPS();
         }
         m_pVCmdQ = VideoDecoderThread::CQueuePtr(new VideoDecoderThread::CQueue);
-        m_pVMsgQ = VideoMsgQueuePtr(new VideoMsgQueue(m_QueueLength));
+        m_pVMsgQ = VideoMsgQueuePtr(new VideoMsgQueue(m_QueueLength, QUEUE_MPMC));
         VideoMsgQueue& packetQ = *m_PacketQs[getVStreamIndex()];
 
         m_pVDecoderThread = new boost::thread(VideoDecoderThread(
@@ -116,8 +137,10 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
     
     if (getVideoInfo().m_bHasAudio) {
         m_pACmdQ = AudioDecoderThread::CQueuePtr(new AudioDecoderThread::CQueue);
-        m_pAMsgQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_MSG_QUEUE_LENGTH));
-        m_pAStatusQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_STATUS_QUEUE_LENGTH));
+        m_pAMsgQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_MSG_QUEUE_LENGTH,
+                QUEUE_MPMC));
+        m_pAStatusQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_STATUS_QUEUE_LENGTH,
+                QUEUE_SPSC));
         VideoMsgQueue& packetQ = *m_PacketQs[getAStreamIndex()];
         m_pADecoderThread = new boost::thread(
                 AudioDecoderThread(*m_pACmdQ, *m_pAMsgQ, packetQ, getAudioStream(), *pAP));
@@ -150,6 +173,8 @@ void AsyncVideoDecoder::close()
         m_pAStatusQ = AudioMsgQueuePtr();
         m_pAMsgQ = AudioMsgQueuePtr();
     }
+    m_pFrameCache = VideoFrameCachePtr();
+    m_bPlayingFromCache = false;
     VideoDecoder::close();
     if (m_pDemuxThread) {
         deleteDemuxer();
@@ -159,6 +184,24 @@ void AsyncVideoDecoder::close()
 void AsyncVideoDecoder::seek(float destTime)
 {
     AVG_ASSERT(getState() == DECODING);
+    if (m_pFrameCache) {
+        if (m_pFrameCache->isFilling()) {
+            // Frames after the seek wouldn't continue the ones cached so far.
+            m_pFrameCache->stopFilling();
+        } else if (m_pFrameCache->getState() == VideoFrameCache::COMPLETE ||
+                (m_pFrameCache->getState() == VideoFrameCache::PARTIAL &&
+                        destTime <= m_pFrameCache->getEndTime()))
+        {
+            startCachePlayback(destTime);
+            return;
+        }
+    }
+    m_bPlayingFromCache = false;
+    sendSeek(destTime);
+}
+
+void AsyncVideoDecoder::sendSeek(float destTime)
+{
     m_bAudioEOF = false;
     m_bVideoEOF = false;
     m_NumSeeksSent++;
@@ -171,7 +214,17 @@ void AsyncVideoDecoder::loop()
     m_LastVideoFrameTime = -1;
     m_bAudioEOF = false;
     m_bVideoEOF = false;
-    seek(0);
+    if (m_pFrameCache && m_pFrameCache->isPlayable()) {
+        startCachePlayback(0);
+    } else {
+        m_bPlayingFromCache = false;
+        sendSeek(0);
+        if (m_pFrameCache && (m_pFrameCache->isFilling() ||
+                m_pFrameCache->getState() == VideoFrameCache::EMPTY))
+        {
+            m_pFrameCache->startFilling();
+        }
+    }
 }
 
 int AsyncVideoDecoder::getCurFrame() const
@@ -214,6 +267,24 @@ void AsyncVideoDecoder::setFPS(float fps)
     }
 }
 
+void AsyncVideoDecoder::enableLoopCache(long long maxBytes,
+        VideoFrameCache::OverflowPolicy policy)
+{
+    AVG_ASSERT(getState() != DECODING);
+    m_LoopCacheBytes = maxBytes;
+    m_LoopCachePolicy = policy;
+}
+
+VideoFrameCachePtr AsyncVideoDecoder::getLoopCache() const
+{
+    return m_pFrameCache;
+}
+
+int AsyncVideoDecoder::getNumFramesFromCache() const
+{
+    return m_NumFramesFromCache;
+}
+
 static ProfilingZoneID VDPAUDecodeProfilingZone("AsyncVideoDecoder: VDPAU", true);
 
 FrameAvailableCode AsyncVideoDecoder::getRenderedBmps(vector<BitmapPtr>& pBmps,
@@ -222,12 +293,17 @@ FrameAvailableCode AsyncVideoDecoder::getRenderedBmps(vector<BitmapPtr>& pBmps,
     AVG_ASSERT(getState() == DECODING);
     FrameAvailableCode frameAvailable;
     VideoMsgPtr pFrameMsg;
-    if (timeWanted == -1) {
-        waitForSeekDone();
-        pFrameMsg = getNextBmps(true);
-        frameAvailable = FA_NEW_FRAME;
-    } else {
-        pFrameMsg = getBmpsForTime(timeWanted, frameAvailable);
+    if (m_bPlayingFromCache) {
+        pFrameMsg = getCachedBmps(timeWanted, frameAvailable);
+    }
+    if (!m_bPlayingFromCache) {
+        if (timeWanted == -1) {
+            waitForSeekDone();
+            pFrameMsg = getNextBmps(true);
+            frameAvailable = FA_NEW_FRAME;
+        } else {
+            pFrameMsg = getBmpsForTime(timeWanted, frameAvailable);
+        }
     }
     if (frameAvailable == FA_NEW_FRAME) {
         AVG_ASSERT(pFrameMsg);
@@ -282,7 +358,12 @@ void AsyncVideoDecoder::throwAwayFrame(float timeWanted)
 {
     AVG_ASSERT(getState() == DECODING);
     FrameAvailableCode frameAvailable;
-    VideoMsgPtr pFrameMsg = getBmpsForTime(timeWanted, frameAvailable);
+    if (m_bPlayingFromCache) {
+        getCachedBmps(timeWanted, frameAvailable);
+    }
+    if (!m_bPlayingFromCache) {
+        getBmpsForTime(timeWanted, frameAvailable);
+    }
 }
 
 AudioMsgQueuePtr AsyncVideoDecoder::getAudioMsgQ()
@@ -299,11 +380,11 @@ void AsyncVideoDecoder::setupDemuxer(vector<int> streamIndexes)
 {
     m_pDemuxCmdQ = VideoDemuxerThread::CQueuePtr(new VideoDemuxerThread::CQueue());    
     for (unsigned i = 0; i < streamIndexes.size(); ++i) {
-        VideoMsgQueuePtr pPacketQ(new VideoMsgQueue(PACKET_QUEUE_LENGTH));
+        VideoMsgQueuePtr pPacketQ(new VideoMsgQueue(PACKET_QUEUE_LENGTH, QUEUE_MPMC));
         m_PacketQs[streamIndexes[i]] = pPacketQ;
     }
     m_pDemuxThread = new boost::thread(VideoDemuxerThread(*m_pDemuxCmdQ,
-            getFormatContext(), m_PacketQs));
+            getFormatContext(), m_PacketQs, getSeekIndex()));
 }
 
 void AsyncVideoDecoder::deleteDemuxer()
@@ -382,20 +463,82 @@ VideoMsgPtr AsyncVideoDecoder::getBmpsForTime(float timeWanted,
     return pFrameMsg;
 }
 
+void AsyncVideoDecoder::startCachePlayback(float destTime)
+{
+    m_bPlayingFromCache = true;
+    m_CachePos = m_pFrameCache->getFrameForTime(destTime-0.5f/m_FPS);
+    m_LastVideoFrameTime = destTime - 1/m_FPS;
+    m_bVideoEOF = false;
+    if (m_pFrameCache->getState() == VideoFrameCache::PARTIAL) {
+        // Let the decoder prepare the frames that follow the cached ones.
+        sendSeek(m_pFrameCache->getEndTime() + 1/m_FPS);
+    }
+}
+
+static ProfilingZoneID CachedFrameProfilingZone("AsyncVideoDecoder: cached frame", true);
+
+VideoMsgPtr AsyncVideoDecoder::getCachedBmps(float timeWanted,
+        FrameAvailableCode& frameAvailable)
+{
+    // Same timing logic as getBmpsForTime(), but frames come from the loop cache.
+    // Switches back to the decoder when the end of a partial cache is reached.
+    ScopeTimer timer(CachedFrameProfilingZone);
+    int numFrames = m_pFrameCache->getNumFrames();
+    if (timeWanted != -1) {
+        float timePerFrame = 1.0f/getFPS();
+        if (fabs(float(timeWanted-m_LastVideoFrameTime)) < 0.5*timePerFrame ||
+                m_LastVideoFrameTime > timeWanted+timePerFrame || m_bVideoEOF)
+        {
+            frameAvailable = FA_USE_LAST_FRAME;
+            return VideoMsgPtr();
+        }
+        while (m_CachePos < numFrames &&
+                m_pFrameCache->getFrame(m_CachePos)->getFrameTime()-timeWanted <
+                        -0.5*timePerFrame)
+        {
+            m_CachePos++;
+        }
+    }
+    if (m_CachePos >= numFrames) {
+        if (m_pFrameCache->getState() == VideoFrameCache::COMPLETE) {
+            m_bVideoEOF = true;
+        } else {
+            m_bPlayingFromCache = false;
+        }
+        frameAvailable = FA_USE_LAST_FRAME;
+        return VideoMsgPtr();
+    }
+    frameAvailable = FA_NEW_FRAME;
+    VideoMsgPtr pFrameMsg = m_pFrameCache->getFrame(m_CachePos);
+    m_CachePos++;
+    m_NumFramesFromCache++;
+    return pFrameMsg;
+}
+
 VideoMsgPtr AsyncVideoDecoder::getNextBmps(bool bWait)
 {
     VideoMsgPtr pMsg = m_pVMsgQ->pop(bWait);
     if (pMsg) {
         switch (pMsg->getType()) {
             case VideoMsg::FRAME:
+                if (m_pFrameCache && m_pFrameCache->isFilling()) {
+                    m_pFrameCache->addFrame(pMsg);
+                }
+                return pMsg;
             case VideoMsg::VDPAU_FRAME:
                 return pMsg;
             case VideoMsg::END_OF_FILE:
                 m_NumVSeeksDone = m_NumSeeksSent;
                 m_bVideoEOF = true;
+                if (m_pFrameCache && m_pFrameCache->isFilling()) {
+                    m_pFrameCache->setEOF();
+                }
                 return VideoMsgPtr();
             case VideoMsg::ERROR:
                 m_bVideoEOF = true;
+                if (m_pFrameCache && m_pFrameCache->isFilling()) {
+                    m_pFrameCache->stopFilling();
+                }
                 return VideoMsgPtr();
             case AudioMsg::SEEK_DONE:
                 handleVSeekDone(pMsg);
@@ -480,6 +623,10 @@ void AsyncVideoDecoder::handleAudioMsg(AudioMsgPtr pMsg)
         case AudioMsg::AUDIO_TIME:
             m_LastAudioFrameTime = pMsg->getAudioTime();
             break;
+        case AudioMsg::AUDIO:
+            // A buffer the audio thread is done with. It is freed here instead of in
+            // the audio callback.
+            break;
         default:
             // Unhandled message type.
             pMsg->dump();
@@ -489,7 +636,8 @@ void AsyncVideoDecoder::handleAudioMsg(AudioMsgPtr pMsg)
 
 void AsyncVideoDecoder::returnFrame(VideoMsgPtr pFrameMsg)
 {
-    if (pFrameMsg) {
+    // Frames that went into the loop cache must not be reused by the decoder.
+    if (pFrameMsg && !(m_pFrameCache && m_pFrameCache->isFilling())) {
         AVG_ASSERT(pFrameMsg->getType() == VideoMsg::FRAME);
         m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::returnFrame, _1, pFrameMsg));
     }
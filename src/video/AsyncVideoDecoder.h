@@ -28,6 +28,7 @@
 #include "VideoDecoderThread.h"
 #include "AudioDecoderThread.h"
 #include "VideoMsg.h"
+#include "VideoFrameCache.h"
 
 #include "../graphics/Bitmap.h"
 #include "../audio/AudioParams.h"
@@ -54,6 +55,11 @@ public:
     virtual float getCurTime() const;
     virtual float getFPS() const;
     virtual void setFPS(float fps);
+    // Must be called before startDecoding(). See VideoFrameCache.
+    void enableLoopCache(long long maxBytes, VideoFrameCache::OverflowPolicy policy);
+    VideoFrameCachePtr getLoopCache() const;
+    // Number of frames played back from the loop cache since startDecoding().
+    int getNumFramesFromCache() const;
 
     virtual FrameAvailableCode getRenderedBmps(std::vector<BitmapPtr>& pBmps, 
             float timeWanted);
@@ -67,7 +73,10 @@ public:
 private:
     void setupDemuxer(std::vector<int> streamIndexes);
     void deleteDemuxer();
+    void sendSeek(float destTime);
     VideoMsgPtr getBmpsForTime(float timeWanted, FrameAvailableCode& frameAvailable);
+    void startCachePlayback(float destTime);
+    VideoMsgPtr getCachedBmps(float timeWanted, FrameAvailableCode& frameAvailable);
     VideoMsgPtr getNextBmps(bool bWait);
     void waitForSeekDone();
     void checkForSeekDone();
@@ -108,6 +117,13 @@ private:
     float m_LastVideoFrameTime;
     float m_CurVideoFrameTime;
     float m_LastAudioFrameTime;
+
+    long long m_LoopCacheBytes;
+    VideoFrameCache::OverflowPolicy m_LoopCachePolicy;
+    VideoFrameCachePtr m_pFrameCache;
+    bool m_bPlayingFromCache;
+    int m_CachePos;
+    int m_NumFramesFromCache;
 };
 
 typedef boost::shared_ptr<AsyncVideoDecoder> AsyncVideoDecoderPtr;
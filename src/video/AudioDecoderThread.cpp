@@ -27,6 +27,10 @@
 #include "../base/TimeSource.h"
 #include "../base/ScopeTimer.h"
 
+#include "../audio/AudioMix.h"
+
+#include <boost/atomic.hpp>
+
 #if AVUTIL_VERSION_INT > AV_VERSION_INT(52, 0, 0)
 #include <libavutil/samplefmt.h>
 #endif
@@ -35,6 +39,10 @@
     #define AVCODEC_MAX_AUDIO_FRAME_SIZE 192000
 #endif
 
+// More than the audio message queue holds, so the pool usually covers all buffers
+// in flight.
+#define MAX_POOLED_BUFFERS 64
+
 using namespace std;
 
 namespace avg {
@@ -125,7 +133,6 @@ bool AudioDecoderThread::work()
 
 void AudioDecoderThread::decodePacket(AVPacket* pPacket)
 {
-    char* pDecodedData = 0;
     AVPacket* pTempPacket = new AVPacket;
     av_init_packet(pTempPacket);
     pTempPacket->data = pPacket->data;
@@ -134,7 +141,7 @@ void AudioDecoderThread::decodePacket(AVPacket* pPacket)
     AVFrame* pDecodedFrame;
     pDecodedFrame = avcodec_alloc_frame();
 #else
-    pDecodedData = (char*)av_malloc(AVCODEC_MAX_AUDIO_FRAME_SIZE +
+    char* pDecodedData = (char*)av_malloc(AVCODEC_MAX_AUDIO_FRAME_SIZE +
             FF_INPUT_BUFFER_PADDING_SIZE);
 #endif
     while (pTempPacket->size > 0) {
@@ -146,7 +153,6 @@ void AudioDecoderThread::decodePacket(AVPacket* pPacket)
         if (gotFrame) {
             bytesDecoded = av_samples_get_buffer_size(0, m_pStream->codec->channels,
                     pDecodedFrame->nb_samples, m_pStream->codec->sample_fmt, 1);
-            pDecodedData = (char*)(pDecodedFrame->data[0]);
         } else {
             bytesDecoded = 0;
         }
@@ -167,31 +173,12 @@ void AudioDecoderThread::decodePacket(AVPacket* pPacket)
         if (bytesDecoded > 0) {
             int framesDecoded = bytesDecoded/(m_pStream->codec->channels*
                     getBytesPerSample(m_InputSampleFormat));
-            AudioBufferPtr pBuffer;
-            bool bNeedsResample = (m_InputSampleRate != m_AP.m_SampleRate ||
-                    m_InputSampleFormat != SAMPLE_FMT_S16 ||
-                    m_pStream->codec->channels != m_AP.m_Channels);
-            bool bIsPlanar = false;
-#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(51, 27, 0)
-            bIsPlanar = av_sample_fmt_is_planar((SampleFormat)m_InputSampleFormat);
-            if (bIsPlanar) {
-                char* pPackedData = (char*)av_malloc(AVCODEC_MAX_AUDIO_FRAME_SIZE +
-                        FF_INPUT_BUFFER_PADDING_SIZE);
-                planarToInterleaved(pPackedData, pDecodedData, m_pStream->codec->channels,
-                        m_pStream->codec->frame_size);
-                pBuffer = resampleAudio(pPackedData, framesDecoded,
-                        av_get_packed_sample_fmt((SampleFormat)m_InputSampleFormat));
-                av_free(pPackedData);
-                bNeedsResample = false;
-            }
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 25, 0)
+            uint8_t** ppPlanes = pDecodedFrame->extended_data;
+#else
+            uint8_t** ppPlanes = (uint8_t**)&pDecodedData;
 #endif
-            if (bNeedsResample) {
-                pBuffer = resampleAudio(pDecodedData, framesDecoded,
-                        m_InputSampleFormat);
-            } else if (!bIsPlanar) {
-                pBuffer = AudioBufferPtr(new AudioBuffer(framesDecoded, m_AP));
-                memcpy(pBuffer->getData(), pDecodedData, bytesDecoded);
-            }
+            AudioBufferPtr pBuffer = convertAudio(ppPlanes, framesDecoded);
             m_LastFrameTime += float(pBuffer->getNumFrames())/m_AP.m_SampleRate;
             pushAudioMsg(pBuffer, m_LastFrameTime);
         }
@@ -243,82 +230,179 @@ void AudioDecoderThread::discardPacket(AVPacket* pPacket)
     }
 }
 
-AudioBufferPtr AudioDecoderThread::resampleAudio(char* pDecodedData, int framesDecoded,
-        int currentSampleFormat)
+AudioBufferPtr AudioDecoderThread::convertAudio(uint8_t** ppPlanes, int numFrames)
 {
-    if (!m_pResampleContext) {
-#ifdef LIBAVRESAMPLE_VERSION
-        m_pResampleContext = avresample_alloc_context();
-        av_opt_set_int(m_pResampleContext, "in_channel_layout",
-                av_get_default_channel_layout(m_pStream->codec->channels), 0);
-        av_opt_set_int(m_pResampleContext, "out_channel_layout", AV_CH_LAYOUT_STEREO, 0);
-        av_opt_set_int(m_pResampleContext, "in_sample_rate", m_InputSampleRate, 0);
-        av_opt_set_int(m_pResampleContext, "out_sample_rate", m_AP.m_SampleRate, 0);
-        av_opt_set_int(m_pResampleContext, "in_sample_fmt",
-                (SampleFormat)currentSampleFormat, 0);
-        av_opt_set_int(m_pResampleContext, "out_sample_fmt", AV_SAMPLE_FMT_S16, 0);
-        int err = avresample_open(m_pResampleContext);
-        AVG_ASSERT(err >= 0);
-#else
-        m_pResampleContext = av_audio_resample_init(m_AP.m_Channels, 
-                m_pStream->codec->channels, m_AP.m_SampleRate, m_InputSampleRate,
-                SAMPLE_FMT_S16, (SampleFormat)currentSampleFormat, 16, 10, 0, 0.8);
+    int channels = m_pStream->codec->channels;
+    if (m_InputSampleRate == m_AP.m_SampleRate && channels == m_AP.m_Channels) {
+        // Only the sample layout changes, so the resampler isn't needed.
+        switch (m_InputSampleFormat) {
+            case SAMPLE_FMT_S16: {
+                AudioBufferPtr pBuffer = getBuffer(numFrames);
+                memcpy(pBuffer->getData(), ppPlanes[0], pBuffer->getNumBytes());
+                return pBuffer;
+            }
+            case SAMPLE_FMT_FLT: {
+                AudioBufferPtr pBuffer = getBuffer(numFrames);
+                floatToS16((const float*)ppPlanes[0], pBuffer->getData(),
+                        numFrames*channels);
+                return pBuffer;
+            }
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(52, 3, 0)
+            case SAMPLE_FMT_S16P: {
+                AudioBufferPtr pBuffer = getBuffer(numFrames);
+                interleaveS16(pBuffer->getData(), (const short* const*)ppPlanes,
+                        numFrames, channels);
+                return pBuffer;
+            }
+            case SAMPLE_FMT_FLTP: {
+                AudioBufferPtr pBuffer = getBuffer(numFrames);
+                m_FloatBuffer.resize(numFrames*channels);
+                interleaveFloat(&m_FloatBuffer[0], (const float* const*)ppPlanes,
+                        numFrames, channels);
+                floatToS16(&m_FloatBuffer[0], pBuffer->getData(), numFrames*channels);
+                return pBuffer;
+            }
 #endif
-        AVG_ASSERT(m_pResampleContext);
+            default:
+                break;
+        }
+    }
+    return resampleAudio(ppPlanes, numFrames);
+}
+
+AudioBufferPtr AudioDecoderThread::resampleAudio(uint8_t** ppPlanes, int numFrames)
+{
+    if (!m_pResampleContext) {
+        initResampleContext();
     }
 #ifdef LIBAVRESAMPLE_VERSION
-    uint8_t *pResampledData;
-    int leftoverSamples = avresample_available(m_pResampleContext);
-    int framesAvailable = leftoverSamples +
-            av_rescale_rnd(avresample_get_delay(m_pResampleContext) +
-                    framesDecoded, m_AP.m_SampleRate, m_InputSampleRate, AV_ROUND_UP);
-    av_samples_alloc(&pResampledData, 0, 2, framesAvailable,
-            AV_SAMPLE_FMT_S16, 0);
-    int framesResampled = avresample_convert(m_pResampleContext, &pResampledData, 0, 
-            framesAvailable, (uint8_t**)&pDecodedData, 0, framesDecoded);
-    AudioBufferPtr pBuffer(new AudioBuffer(framesResampled, m_AP));
-    memcpy(pBuffer->getData(), pResampledData, 
-            framesResampled*m_AP.m_Channels*sizeof(short));
-    av_freep(&pResampledData);
+    // avresample reads planar input directly and writes straight into the buffer.
+    int leftoverFrames = avresample_available(m_pResampleContext);
+    int maxFrames = leftoverFrames +
+            av_rescale_rnd(avresample_get_delay(m_pResampleContext) + numFrames,
+                    m_AP.m_SampleRate, m_InputSampleRate, AV_ROUND_UP);
+    AudioBufferPtr pBuffer = getBuffer(maxFrames);
+    uint8_t* pResampledData = (uint8_t*)pBuffer->getData();
+    int framesResampled = avresample_convert(m_pResampleContext, &pResampledData, 0,
+            maxFrames, ppPlanes, 0, numFrames);
+    AVG_ASSERT(framesResampled >= 0);
+    pBuffer->setNumFrames(framesResampled);
 #else
+    char* pInput = (char*)ppPlanes[0];
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(51, 27, 0)
+    if (av_sample_fmt_is_planar((SampleFormat)m_InputSampleFormat)) {
+        int channels = m_pStream->codec->channels;
+        m_PackedBuffer.resize(numFrames*channels*getBytesPerSample(m_InputSampleFormat));
+        planarToInterleaved(&m_PackedBuffer[0], ppPlanes, channels, numFrames);
+        pInput = &m_PackedBuffer[0];
+    }
+#endif
     short pResampledData[AVCODEC_MAX_AUDIO_FRAME_SIZE/2];
     int framesResampled = audio_resample(m_pResampleContext, pResampledData,
-            (short*)pDecodedData, framesDecoded);
-    AudioBufferPtr pBuffer(new AudioBuffer(framesResampled, m_AP));
-    memcpy(pBuffer->getData(), pResampledData, 
-            framesResampled*m_AP.m_Channels*sizeof(short));
+            (short*)pInput, numFrames);
+    AudioBufferPtr pBuffer = getBuffer(framesResampled);
+    memcpy(pBuffer->getData(), pResampledData, pBuffer->getNumBytes());
 #endif
     return pBuffer;
 }
 
-void AudioDecoderThread::planarToInterleaved(char* pOutput, char* pInput, int numChannels,
-        int numSamples)
+// Resampler parameters for each AudioParams::ResampleQuality: filter length, log2 of the
+// number of filter phases, linear interpolation between phases, cutoff frequency.
+struct ResampleSettings {
+    int m_FilterSize;
+    int m_PhaseShift;
+    int m_bLinearInterp;
+    double m_Cutoff;
+};
+
+static const ResampleSettings s_ResampleSettings[] = {
+    {8, 8, 0, 0.75},
+    {16, 10, 0, 0.8},
+    {32, 10, 1, 0.95}
+};
+
+void AudioDecoderThread::initResampleContext()
 {
-    AVG_ASSERT(numChannels <= 8);
-    if (numSamples == 0) {
-        // Fishy, some ogg files have no proper frame_size set. But outputBufferSamples
-        // worked for sample ogg file.
-        numSamples = m_AP.m_OutputBufferSamples;
-    }
-    int i, j;
-    int bytesPerSample = getBytesPerSample(m_InputSampleFormat);
-    char * pPlanes[8] = {};
-    for (i=0; i<numChannels; i++) {
-        pPlanes[i] = pInput + i*(numSamples*bytesPerSample);
+    // The context is created once per stream and kept. It converts from the native
+    // decoder format, so planar input doesn't need to be interleaved first.
+    const ResampleSettings& settings = s_ResampleSettings[m_AP.m_ResampleQuality];
+#ifdef LIBAVRESAMPLE_VERSION
+    m_pResampleContext = avresample_alloc_context();
+    av_opt_set_int(m_pResampleContext, "in_channel_layout",
+            av_get_default_channel_layout(m_pStream->codec->channels), 0);
+    av_opt_set_int(m_pResampleContext, "out_channel_layout",
+            av_get_default_channel_layout(m_AP.m_Channels), 0);
+    av_opt_set_int(m_pResampleContext, "in_sample_rate", m_InputSampleRate, 0);
+    av_opt_set_int(m_pResampleContext, "out_sample_rate", m_AP.m_SampleRate, 0);
+    av_opt_set_int(m_pResampleContext, "in_sample_fmt",
+            (SampleFormat)m_InputSampleFormat, 0);
+    av_opt_set_int(m_pResampleContext, "out_sample_fmt", AV_SAMPLE_FMT_S16, 0);
+    av_opt_set_int(m_pResampleContext, "filter_size", settings.m_FilterSize, 0);
+    av_opt_set_int(m_pResampleContext, "phase_shift", settings.m_PhaseShift, 0);
+    av_opt_set_int(m_pResampleContext, "linear_interp", settings.m_bLinearInterp, 0);
+    av_opt_set_double(m_pResampleContext, "cutoff", settings.m_Cutoff, 0);
+    int err = avresample_open(m_pResampleContext);
+    AVG_ASSERT(err >= 0);
+#else
+    SampleFormat inputFormat = (SampleFormat)m_InputSampleFormat;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(51, 27, 0)
+    inputFormat = av_get_packed_sample_fmt(inputFormat);
+#endif
+    m_pResampleContext = av_audio_resample_init(m_AP.m_Channels, 
+            m_pStream->codec->channels, m_AP.m_SampleRate, m_InputSampleRate,
+            SAMPLE_FMT_S16, inputFormat, settings.m_FilterSize, settings.m_PhaseShift,
+            settings.m_bLinearInterp, settings.m_Cutoff);
+#endif
+    AVG_ASSERT(m_pResampleContext);
+}
+
+void AudioDecoderThread::planarToInterleaved(char* pOutput, uint8_t** ppPlanes,
+        int numChannels, int numFrames)
+{
+    switch (getBytesPerSample(m_InputSampleFormat)) {
+        case 2:
+            interleaveS16((short*)pOutput, (const short* const*)ppPlanes, numFrames,
+                    numChannels);
+            break;
+        case 4:
+            interleaveFloat((float*)pOutput, (const float* const*)ppPlanes, numFrames,
+                    numChannels);
+            break;
+        default: {
+            int bytesPerSample = getBytesPerSample(m_InputSampleFormat);
+            for (int i = 0; i < numFrames; ++i) {
+                for (int j = 0; j < numChannels; ++j) {
+                    memcpy(pOutput, ppPlanes[j]+i*bytesPerSample, bytesPerSample);
+                    pOutput += bytesPerSample;
+                }
+            }
+        }
     }
-    for (i=0; i<numSamples; i++) {
-        for (j=0; j<numChannels; j++) {
-            memcpy(pOutput, pPlanes[j], bytesPerSample);
-            pOutput += bytesPerSample;
-            pPlanes[j] += bytesPerSample;
+}
+
+AudioBufferPtr AudioDecoderThread::getBuffer(int numFrames)
+{
+    for (unsigned i = 0; i < m_pBufferPool.size(); ++i) {
+        if (m_pBufferPool[i].unique()) {
+            // The audio thread has released the buffer. Make sure its reads are done
+            // before the buffer is overwritten.
+            boost::atomic_thread_fence(boost::memory_order_acquire);
+            AudioBufferPtr pBuffer = m_pBufferPool[i];
+            pBuffer->setNumFrames(numFrames);
+            return pBuffer;
         }
     }
+    AudioBufferPtr pBuffer(new AudioBuffer(numFrames, m_AP));
+    if (m_pBufferPool.size() < MAX_POOLED_BUFFERS) {
+        m_pBufferPool.push_back(pBuffer);
+    }
+    return pBuffer;
 }
 
 void AudioDecoderThread::insertSilence(float duration)
 {
     int numDelaySamples = int(duration*m_AP.m_SampleRate);
-    AudioBufferPtr pBuffer(new AudioBuffer(numDelaySamples, m_AP));
+    AudioBufferPtr pBuffer = getBuffer(numDelaySamples);
     pBuffer->clear();
     pushAudioMsg(pBuffer, m_LastFrameTime);
 }
@@ -35,6 +35,7 @@
 #include <boost/thread.hpp>
 
 #include <string>
+#include <vector>
 
 namespace avg {
 
@@ -50,11 +51,13 @@ class AVG_API AudioDecoderThread : public WorkerThread<AudioDecoderThread> {
         void decodePacket(AVPacket* pPacket);
         void handleSeekDone(AVPacket* pPacket);
         void discardPacket(AVPacket* pPacket);
-        AudioBufferPtr resampleAudio(char* pDecodedData, int framesDecoded,
-                int currentSampleFormat);
+        AudioBufferPtr convertAudio(uint8_t** ppPlanes, int numFrames);
+        AudioBufferPtr resampleAudio(uint8_t** ppPlanes, int numFrames);
+        void initResampleContext();
         void insertSilence(float duration);
-        void planarToInterleaved(char* pOutput, char* pInput, int numChannels, 
-                int numSamples);
+        void planarToInterleaved(char* pOutput, uint8_t** ppPlanes, int numChannels, 
+                int numFrames);
+        AudioBufferPtr getBuffer(int numFrames);
         void pushAudioMsg(AudioBufferPtr pBuffer, float time);
         void pushSeekDone(float time, int seqNum);
         void pushEOF();
@@ -73,6 +76,11 @@ class AVG_API AudioDecoderThread : public WorkerThread<AudioDecoderThread> {
 #else
         ReSampleContext * m_pResampleContext;
 #endif
+        // Buffers handed to the audio thread. Once the pool holds the only
+        // reference, a buffer is reused.
+        std::vector<AudioBufferPtr> m_pBufferPool;
+        std::vector<float> m_FloatBuffer;
+        std::vector<char> m_PackedBuffer;
         float m_AudioStartTimestamp;
         float m_LastFrameTime;
     
@@ -0,0 +1,82 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "AudioSampleLoader.h"
+
+#include "AsyncVideoDecoder.h"
+
+#include "../base/Exception.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+namespace avg {
+
+AudioBufferPtr loadAudioSample(const string& sFilename, const AudioParams& ap)
+{
+    AsyncVideoDecoder decoder(8);
+    decoder.open(sFilename, false, true);
+    VideoInfo videoInfo = decoder.getVideoInfo();
+    if (!videoInfo.m_bHasAudio || videoInfo.m_bHasVideo) {
+        decoder.close();
+        throw Exception(AVG_ERR_VIDEO_GENERAL, "Loading audio sample " + sFilename +
+                " failed. The file must contain audio and no video.");
+    }
+    decoder.startDecoding(false, &ap);
+    AudioMsgQueuePtr pMsgQ = decoder.getAudioMsgQ();
+    vector<AudioBufferPtr> pBuffers;
+    int numFrames = 0;
+    bool bEOF = false;
+    while (!bEOF) {
+        AudioMsgPtr pMsg = pMsgQ->pop(true);
+        switch (pMsg->getType()) {
+            case AudioMsg::AUDIO: {
+                AudioBufferPtr pBuffer = pMsg->getAudioBuffer();
+                pBuffers.push_back(pBuffer);
+                numFrames += pBuffer->getNumFrames();
+                break;
+            }
+            case AudioMsg::END_OF_FILE:
+                bEOF = true;
+                break;
+            case AudioMsg::ERROR: {
+                Exception ex = pMsg->getException();
+                decoder.close();
+                throw ex;
+            }
+            default:
+                break;
+        }
+    }
+    decoder.close();
+
+    AudioBufferPtr pSample(new AudioBuffer(numFrames, ap));
+    char* pDest = (char*)pSample->getData();
+    for (unsigned i = 0; i < pBuffers.size(); ++i) {
+        memcpy(pDest, pBuffers[i]->getData(), pBuffers[i]->getNumBytes());
+        pDest += pBuffers[i]->getNumBytes();
+    }
+    return pSample;
+}
+
+}
@@ -0,0 +1,41 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _AudioSampleLoader_H_
+#define _AudioSampleLoader_H_
+
+#include "../api.h"
+#include "../audio/AudioBuffer.h"
+#include "../audio/AudioParams.h"
+
+#include <string>
+
+namespace avg {
+
+// Decodes a complete audio file into one buffer with the sample rate and channel count
+// of ap, so it can be played from memory by AudioEngine::playSample(). Meant for short
+// sounds: the whole file is kept in memory.
+AVG_API AudioBufferPtr loadAudioSample(const std::string& sFilename,
+        const AudioParams& ap);
+
+}
+
+#endif
@@ -33,8 +33,10 @@ using namespace std;
 
 namespace avg {
 
-FFMpegDemuxer::FFMpegDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes)
-    : m_pFormatContext(pFormatContext)
+FFMpegDemuxer::FFMpegDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes,
+        SeekIndexPtr pSeekIndex)
+    : m_pFormatContext(pFormatContext),
+      m_pSeekIndex(pSeekIndex)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     for (unsigned i = 0; i < streamIndexes.size(); ++i) {
@@ -110,9 +112,16 @@ AVPacket * FFMpegDemuxer::getPacket(int streamIndex)
 
     return pPacket;
 }
-        
+
+static ProfilingZoneID SeekProfilingZone("Demuxer: seek", true);
+
 void FFMpegDemuxer::seek(float destTime)
 {
+    ScopeTimer timer(SeekProfilingZone);
+    if (m_pSeekIndex && m_pSeekIndex->isValid() && seekToKeyFrame(destTime)) {
+        clearPacketCache();
+        return;
+    }
 #if LIBAVFORMAT_BUILD <= 4616
     av_seek_frame(m_pFormatContext, -1, destTime*1000000);
 #else
@@ -126,6 +135,55 @@ void FFMpegDemuxer::seek(float destTime)
     clearPacketCache();
 }
 
+bool FFMpegDemuxer::seekToKeyFrame(float destTime)
+{
+    // Seeks directly to the last keyframe before destTime. Without the index, libavformat
+    // may land on an earlier keyframe (or has to search for one), and every frame from
+    // there on needs to be decoded.
+    int streamIndex = m_pSeekIndex->getStreamIndex();
+    AVStream* pStream = m_pFormatContext->streams[streamIndex];
+    long long destPts = (long long)(destTime/av_q2d(pStream->time_base)+0.5);
+    int destFrame = m_pSeekIndex->getFrameForPts(destPts);
+    int keyFrame = m_pSeekIndex->getKeyFrame(destFrame);
+    const SeekIndex::Entry& entry = m_pSeekIndex->getEntry(keyFrame);
+    int err;
+    if (useByteSeek() && entry.m_Pos >= 0) {
+        err = av_seek_frame(m_pFormatContext, streamIndex, entry.m_Pos,
+                AVSEEK_FLAG_BYTE);
+    } else {
+        long long ts = entry.m_Dts;
+#ifdef AVFMT_SEEK_TO_PTS
+        if (m_pFormatContext->iformat->flags & AVFMT_SEEK_TO_PTS) {
+            ts = entry.m_Pts;
+        }
+#endif
+        if (ts == (long long)AV_NOPTS_VALUE) {
+            ts = entry.m_Pts;
+        }
+        err = av_seek_frame(m_pFormatContext, streamIndex, ts, AVSEEK_FLAG_BACKWARD);
+    }
+    if (err < 0) {
+        return false;
+    }
+    AVG_TRACE(Logger::category::PLAYER, Logger::severity::DEBUG,
+            "Seek to frame " << destFrame << ": decoding " << destFrame-keyFrame <<
+            " frames from keyframe " << keyFrame << ".");
+    return true;
+}
+
+bool FFMpegDemuxer::useByteSeek() const
+{
+    // Timestamp seeks in MPEG transport and program streams are binary searches over
+    // the file, so we use the packet positions from the index instead.
+    int flags = m_pFormatContext->iformat->flags;
+#ifdef AVFMT_NO_BYTE_SEEK
+    if (flags & AVFMT_NO_BYTE_SEEK) {
+        return false;
+    }
+#endif
+    return (flags & AVFMT_TS_DISCONT) != 0;
+}
+
 void FFMpegDemuxer::clearPacketCache()
 {
     map<int, PacketList>::iterator it;
@@ -25,6 +25,7 @@
 #include "../avgconfigwrapper.h"
 
 #include "WrapFFMpeg.h"
+#include "SeekIndex.h"
 
 #include <list>
 #include <vector>
@@ -36,7 +37,8 @@ namespace avg {
 
 class AVG_API FFMpegDemuxer {
     public:
-        FFMpegDemuxer(AVFormatContext * pFormatContext, std::vector<int> streamIndexes);
+        FFMpegDemuxer(AVFormatContext * pFormatContext, std::vector<int> streamIndexes,
+                SeekIndexPtr pSeekIndex=SeekIndexPtr());
         virtual ~FFMpegDemuxer();
        
         AVPacket * getPacket(int streamIndex);
@@ -44,6 +46,8 @@ class AVG_API FFMpegDemuxer {
         void dump();
         
     private:
+        bool seekToKeyFrame(float destTime);
+        bool useByteSeek() const;
         void clearPacketCache();
 
         // Packets that haven't been delivered yet.
@@ -51,6 +55,7 @@ class AVG_API FFMpegDemuxer {
         std::map<int, PacketList> m_PacketLists;
        
         AVFormatContext * m_pFormatContext;
+        SeekIndexPtr m_pSeekIndex;
 };
 
 typedef boost::shared_ptr<FFMpegDemuxer> FFMpegDemuxerPtr;
@@ -67,6 +67,40 @@ FFMpegFrameDecoder::~FFMpegFrameDecoder()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
+#ifdef AVG_REFCOUNTED_FRAMES
+// Owns a reference to a decoded frame.
+class AVFrameReleaser
+{
+public:
+    void operator()(AVFrame* pFrame)
+    {
+        av_frame_free(&pFrame);
+    }
+};
+
+typedef boost::shared_ptr<AVFrame> AVFramePtr;
+
+// Deleter for bitmaps that point into a frame. Every plane bitmap holds a reference
+// to the frame, so the frame goes back to the decoder when the last one is deleted.
+// This can happen in any thread.
+class FramePlaneReleaser
+{
+public:
+    FramePlaneReleaser(AVFramePtr pFrame)
+        : m_pFrame(pFrame)
+    {
+    }
+
+    void operator()(Bitmap* pBmp)
+    {
+        delete pBmp;
+    }
+
+private:
+    AVFramePtr m_pFrame;
+};
+#endif
+
 static ProfilingZoneID DecodePacketProfilingZone("Decode packet", true);
 
 bool FFMpegFrameDecoder::decodePacket(AVPacket* pPacket, AVFrame* pFrame,
@@ -76,9 +110,20 @@ bool FFMpegFrameDecoder::decodePacket(AVPacket* pPacket, AVFrame* pFrame,
     int bGotPicture = 0;
     AVCodecContext* pContext = m_pStream->codec;
     AVG_ASSERT(pPacket);
+#ifdef AVG_REFCOUNTED_FRAMES
+    // The decoder doesn't release the reference to the previous frame by itself.
+    av_frame_unref(pFrame);
+#endif
     avcodec_decode_video2(pContext, pFrame, &bGotPicture, pPacket);
     if (bGotPicture) {
-        m_LastFrameTime = getFrameTime(pPacket->dts, bFrameAfterSeek);
+        long long dts = pPacket->dts;
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(54, 0, 0)
+        // With frame threading, the decoder returns frames several packets late.
+        if (pContext->active_thread_type & FF_THREAD_FRAME) {
+            dts = pFrame->pkt_dts;
+        }
+#endif
+        m_LastFrameTime = getFrameTime(dts, bFrameAfterSeek);
     }
     av_free_packet(pPacket);
     delete pPacket;
@@ -94,6 +139,9 @@ bool FFMpegFrameDecoder::decodeLastFrame(AVFrame* pFrame)
     av_init_packet(&packet);
     packet.data = 0;
     packet.size = 0;
+#ifdef AVG_REFCOUNTED_FRAMES
+    av_frame_unref(pFrame);
+#endif
     avcodec_decode_video2(pContext, pFrame, &bGotPicture, &packet);
     m_bEOF = true;
 
@@ -197,6 +245,29 @@ void FFMpegFrameDecoder::copyPlaneToBmp(BitmapPtr pBmp, unsigned char * pData, i
     }
 }
 
+bool FFMpegFrameDecoder::wrapFramePlanes(AVFrame* pFrame, const IntPoint& size,
+        int numPlanes, vector<BitmapPtr>& pBmps)
+{
+#ifdef AVG_REFCOUNTED_FRAMES
+    if (!pFrame->buf[0]) {
+        return false;
+    }
+    AVFramePtr pFrameRef(av_frame_clone(pFrame), AVFrameReleaser());
+    AVG_ASSERT(pFrameRef);
+    IntPoint halfSize(size.x/2, size.y/2);
+    for (int i = 0; i < numPlanes; ++i) {
+        // Planes 1 and 2 are the subsampled chroma planes, 3 is alpha.
+        IntPoint planeSize = (i == 1 || i == 2) ? halfSize : size;
+        pBmps.push_back(BitmapPtr(new Bitmap(planeSize, I8, pFrameRef->data[i],
+                pFrameRef->linesize[i], false, "VideoFramePlane"),
+                FramePlaneReleaser(pFrameRef)));
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
 void FFMpegFrameDecoder::handleSeek()
 {
     m_LastFrameTime = -1.0f;
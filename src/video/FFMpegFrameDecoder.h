@@ -26,8 +26,12 @@
 
 #include "WrapFFMpeg.h"
 
+#include "../base/GLMHelper.h"
+
 #include <boost/shared_ptr.hpp>
 
+#include <vector>
+
 namespace avg {
 
 class Bitmap;
@@ -43,6 +47,11 @@ class AVG_API FFMpegFrameDecoder
         bool decodeLastFrame(AVFrame* pFrame);
         void convertFrameToBmp(AVFrame* pFrame, BitmapPtr pBmp);
         void copyPlaneToBmp(BitmapPtr pBmp, unsigned char * pData, int stride);
+        // Returns I8 bitmaps that point directly into the planes of pFrame. The
+        // frame's buffers stay alive until the last of these bitmaps is deleted.
+        // Returns false if the frame isn't reference counted.
+        bool wrapFramePlanes(AVFrame* pFrame, const IntPoint& size, int numPlanes,
+                std::vector<BitmapPtr>& pBmps);
 
         void handleSeek();
 
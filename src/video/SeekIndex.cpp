@@ -0,0 +1,316 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "SeekIndex.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ObjectCounter.h"
+
+#include <boost/bind.hpp>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+using namespace std;
+
+namespace avg {
+
+static const char CACHE_MAGIC[] = "AVGSEEKINDEX";
+static const int CACHE_VERSION = 2;
+// pts, dts, file position and keyframe flag.
+static const int CACHE_ENTRY_SIZE = 3*sizeof(long long)+1;
+
+// The cache is written field by field, so there is no struct padding in the file.
+template<class T>
+static void writeValue(ofstream& file, const T& value)
+{
+    file.write((const char*)&value, sizeof(T));
+}
+
+template<class T>
+static void readValue(ifstream& file, T& value)
+{
+    file.read((char*)&value, sizeof(T));
+}
+
+static bool entryPtsLess(const SeekIndex::Entry& entry1, const SeekIndex::Entry& entry2)
+{
+    return entry1.m_Pts < entry2.m_Pts;
+}
+
+SeekIndex::SeekIndex(const string& sFilename, int streamIndex)
+    : m_sFilename(sFilename),
+      m_StreamIndex(streamIndex),
+      m_bReady(false),
+      m_bStop(false)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    m_pThread = new boost::thread(boost::bind(&SeekIndex::run, this));
+}
+
+SeekIndex::~SeekIndex()
+{
+    m_bStop = true;
+    waitUntilReady();
+    delete m_pThread;
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+bool SeekIndex::isReady() const
+{
+    return m_bReady;
+}
+
+void SeekIndex::waitUntilReady()
+{
+    if (m_pThread->joinable()) {
+        m_pThread->join();
+    }
+}
+
+bool SeekIndex::isValid() const
+{
+    return m_bReady && !m_KeyFrames.empty();
+}
+
+int SeekIndex::getStreamIndex() const
+{
+    return m_StreamIndex;
+}
+
+int SeekIndex::getNumFrames() const
+{
+    return int(m_Entries.size());
+}
+
+const SeekIndex::Entry& SeekIndex::getEntry(int frameNum) const
+{
+    AVG_ASSERT(m_bReady);
+    AVG_ASSERT(frameNum >= 0 && frameNum < int(m_Entries.size()));
+    return m_Entries[frameNum];
+}
+
+int SeekIndex::getFrameForPts(long long pts) const
+{
+    Entry entry;
+    entry.m_Pts = pts;
+    vector<Entry>::const_iterator it = upper_bound(m_Entries.begin(), m_Entries.end(),
+            entry, entryPtsLess);
+    if (it == m_Entries.begin()) {
+        return 0;
+    }
+    return int(it-m_Entries.begin())-1;
+}
+
+int SeekIndex::getKeyFrame(int frameNum) const
+{
+    AVG_ASSERT(isValid());
+    vector<int>::const_iterator it = upper_bound(m_KeyFrames.begin(), m_KeyFrames.end(),
+            frameNum);
+    if (it == m_KeyFrames.begin()) {
+        return m_KeyFrames[0];
+    }
+    return *(it-1);
+}
+
+string SeekIndex::getCacheFilename(const string& sFilename)
+{
+    return sFilename+".seekindex";
+}
+
+void SeekIndex::run()
+{
+    string sCacheFilename = getCacheFilename(m_sFilename);
+    if (!load(sCacheFilename)) {
+        build();
+        if (!m_bStop && !m_KeyFrames.empty()) {
+            save(sCacheFilename);
+        }
+    }
+    m_bReady = true;
+}
+
+void SeekIndex::build()
+{
+    // Uses a format context of its own so the context used for playback stays at the
+    // start of the file.
+    AVFormatContext* pFormatContext = 0;
+    int err = avformat_open_input(&pFormatContext, m_sFilename.c_str(), 0, 0);
+    if (err < 0) {
+        AVG_LOG_WARNING(m_sFilename << ": Could not open file to build seek index.");
+        return;
+    }
+    // No avformat_find_stream_info(): It opens codecs, which isn't thread-safe, and the
+    // packets are all that is needed. This way, the index can be built without holding
+    // VideoDecoder's open mutex.
+    AVPacket packet;
+    av_init_packet(&packet);
+    while (!m_bStop && av_read_frame(pFormatContext, &packet) >= 0) {
+        if (packet.stream_index == m_StreamIndex) {
+            Entry entry;
+            entry.m_Pts = packet.pts;
+            entry.m_Dts = packet.dts;
+            entry.m_Pos = packet.pos;
+            entry.m_bKeyFrame = (packet.flags & AV_PKT_FLAG_KEY) != 0;
+            if (entry.m_Pts == (long long)AV_NOPTS_VALUE) {
+                entry.m_Pts = entry.m_Dts;
+            }
+            m_Entries.push_back(entry);
+        }
+        av_free_packet(&packet);
+    }
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(53, 21, 0)
+    avformat_close_input(&pFormatContext);
+#else
+    av_close_input_file(pFormatContext);
+#endif
+
+    if (m_bStop) {
+        // Incomplete.
+        m_Entries.clear();
+        return;
+    }
+    for (unsigned i = 0; i < m_Entries.size(); ++i) {
+        if (m_Entries[i].m_Pts == (long long)AV_NOPTS_VALUE) {
+            AVG_LOG_WARNING(m_sFilename << 
+                    ": Stream has no timestamps, seek index not available.");
+            m_Entries.clear();
+            break;
+        }
+    }
+    stable_sort(m_Entries.begin(), m_Entries.end(), entryPtsLess);
+    for (unsigned i = 0; i < m_Entries.size(); ++i) {
+        if (m_Entries[i].m_bKeyFrame) {
+            m_KeyFrames.push_back(i);
+        }
+    }
+    AVG_TRACE(Logger::category::PLAYER, Logger::severity::INFO,
+            "Built seek index for " << m_sFilename << ": " << m_Entries.size() <<
+            " frames, " << m_KeyFrames.size() << " keyframes.");
+}
+
+bool SeekIndex::load(const string& sCacheFilename)
+{
+    ifstream file(sCacheFilename.c_str(), ios::in | ios::binary);
+    if (!file) {
+        return false;
+    }
+    long long fileSize;
+    long long modTime;
+    if (!getFileInfo(fileSize, modTime)) {
+        return false;
+    }
+    char magic[sizeof(CACHE_MAGIC)];
+    int version = 0;
+    long long cachedFileSize = 0;
+    long long cachedModTime = 0;
+    int streamIndex = 0;
+    int numEntries = 0;
+    file.read(magic, sizeof(magic));
+    readValue(file, version);
+    readValue(file, cachedFileSize);
+    readValue(file, cachedModTime);
+    readValue(file, streamIndex);
+    readValue(file, numEntries);
+    if (!file || memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 ||
+            version != CACHE_VERSION || cachedFileSize != fileSize ||
+            cachedModTime != modTime || streamIndex != m_StreamIndex)
+    {
+        return false;
+    }
+    // Don't trust numEntries before allocating memory for it: The rest of the file must
+    // contain exactly that many entries.
+    streampos headerEnd = file.tellg();
+    file.seekg(0, ios::end);
+    long long dataSize = (long long)(file.tellg()-headerEnd);
+    file.seekg(headerEnd);
+    if (numEntries <= 0 || dataSize != (long long)numEntries*CACHE_ENTRY_SIZE) {
+        return false;
+    }
+    vector<Entry> entries(numEntries);
+    for (int i = 0; i < numEntries; ++i) {
+        Entry& entry = entries[i];
+        char bKeyFrame = 0;
+        readValue(file, entry.m_Pts);
+        readValue(file, entry.m_Dts);
+        readValue(file, entry.m_Pos);
+        readValue(file, bKeyFrame);
+        entry.m_bKeyFrame = (bKeyFrame != 0);
+        if (i > 0 && entry.m_Pts < entries[i-1].m_Pts) {
+            return false;
+        }
+    }
+    if (!file) {
+        return false;
+    }
+    m_Entries.swap(entries);
+    for (unsigned i = 0; i < m_Entries.size(); ++i) {
+        if (m_Entries[i].m_bKeyFrame) {
+            m_KeyFrames.push_back(i);
+        }
+    }
+    AVG_TRACE(Logger::category::PLAYER, Logger::severity::INFO,
+            "Loaded seek index from " << sCacheFilename << ".");
+    return true;
+}
+
+void SeekIndex::save(const string& sCacheFilename) const
+{
+    long long fileSize;
+    long long modTime;
+    if (!getFileInfo(fileSize, modTime)) {
+        return;
+    }
+    ofstream file(sCacheFilename.c_str(), ios::out | ios::binary | ios::trunc);
+    file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    writeValue(file, CACHE_VERSION);
+    writeValue(file, fileSize);
+    writeValue(file, modTime);
+    writeValue(file, m_StreamIndex);
+    writeValue(file, int(m_Entries.size()));
+    for (unsigned i = 0; i < m_Entries.size(); ++i) {
+        const Entry& entry = m_Entries[i];
+        writeValue(file, entry.m_Pts);
+        writeValue(file, entry.m_Dts);
+        writeValue(file, entry.m_Pos);
+        writeValue(file, char(entry.m_bKeyFrame));
+    }
+    if (!file) {
+        AVG_LOG_WARNING("Could not write seek index to " << sCacheFilename << ".");
+    }
+}
+
+bool SeekIndex::getFileInfo(long long& size, long long& modTime) const
+{
+    struct stat fileStat;
+    if (stat(m_sFilename.c_str(), &fileStat) == -1) {
+        return false;
+    }
+    size = (long long)fileStat.st_size;
+    modTime = (long long)fileStat.st_mtime;
+    return true;
+}
+
+}
@@ -0,0 +1,93 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _SeekIndex_H_
+#define _SeekIndex_H_
+
+#include "../api.h"
+
+#include "WrapFFMpeg.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+// Timestamps and file positions of all packets of one video stream, sorted by
+// presentation time so frame n of the stream is entry n. Building the index means
+// demuxing the complete file once, so the result is cached in a file next to the video.
+// The cache is used if size and modification time of the video haven't changed.
+// The index is loaded or built in a thread of its own. Until that is done, isValid()
+// returns false and seeks don't use the index.
+class AVG_API SeekIndex {
+    public:
+        struct Entry {
+            long long m_Pts;
+            long long m_Dts;
+            long long m_Pos;
+            bool m_bKeyFrame;
+        };
+
+        SeekIndex(const std::string& sFilename, int streamIndex);
+        virtual ~SeekIndex();
+
+        bool isReady() const;
+        void waitUntilReady();
+        // The accessors below may only be used if isValid() returns true.
+        bool isValid() const;
+        int getStreamIndex() const;
+        int getNumFrames() const;
+        const Entry& getEntry(int frameNum) const;
+
+        // Last frame with a presentation timestamp <= pts.
+        int getFrameForPts(long long pts) const;
+        // Last keyframe at or before frameNum.
+        int getKeyFrame(int frameNum) const;
+
+        static std::string getCacheFilename(const std::string& sFilename);
+
+    private:
+        void run();
+        void build();
+        bool load(const std::string& sCacheFilename);
+        void save(const std::string& sCacheFilename) const;
+        bool getFileInfo(long long& size, long long& modTime) const;
+
+        std::string m_sFilename;
+        int m_StreamIndex;
+        std::vector<Entry> m_Entries;
+        std::vector<int> m_KeyFrames;
+
+        boost::thread* m_pThread;
+        // Set after m_Entries and m_KeyFrames have been filled in.
+        boost::atomic<bool> m_bReady;
+        boost::atomic<bool> m_bStop;
+};
+
+typedef boost::shared_ptr<SeekIndex> SeekIndexPtr;
+
+}
+
+#endif
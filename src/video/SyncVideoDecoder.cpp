@@ -78,7 +78,7 @@ void SyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP)
     AVG_ASSERT(!m_pDemuxer);
     vector<int> streamIndexes;
     streamIndexes.push_back(getVStreamIndex());
-    m_pDemuxer = new FFMpegDemuxer(getFormatContext(), streamIndexes);
+    m_pDemuxer = new FFMpegDemuxer(getFormatContext(), streamIndexes, getSeekIndex());
 
     m_pFrameDecoder = FFMpegFrameDecoderPtr(new FFMpegFrameDecoder(getVideoStream()));
     m_pFrameDecoder->setFPS(m_FPS);
@@ -177,14 +177,22 @@ FrameAvailableCode SyncVideoDecoder::getRenderedBmps(vector<BitmapPtr>& pBmps,
     if (frameAvailable == FA_USE_LAST_FRAME || isEOF()) {
         return FA_USE_LAST_FRAME;
     } else {
-        allocFrameBmps(pBmps);
         if (pixelFormatIsPlanar(getPixelFormat())) {
-            ScopeTimer timer(CopyImageProfilingZone);
-            for (unsigned i = 0; i < pBmps.size(); ++i) {
-                m_pFrameDecoder->copyPlaneToBmp(pBmps[i], m_pFrame->data[i],
-                        m_pFrame->linesize[i]);
+            vector<BitmapPtr> pPlaneBmps;
+            if (m_pFrameDecoder->wrapFramePlanes(m_pFrame, getSize(), pBmps.size(),
+                    pPlaneBmps))
+            {
+                pBmps = pPlaneBmps;
+            } else {
+                ScopeTimer timer(CopyImageProfilingZone);
+                allocFrameBmps(pBmps);
+                for (unsigned i = 0; i < pBmps.size(); ++i) {
+                    m_pFrameDecoder->copyPlaneToBmp(pBmps[i], m_pFrame->data[i],
+                            m_pFrame->linesize[i]);
+                }
             }
         } else {
+            allocFrameBmps(pBmps);
             m_pFrameDecoder->convertFrameToBmp(m_pFrame, pBmps[0]);
         }
         return FA_NEW_FRAME;
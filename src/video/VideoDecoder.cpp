@@ -24,6 +24,7 @@
 #include "VDPAUDecoder.h"
 #endif
 
+#include "../base/ConfigMgr.h"
 #include "../base/Exception.h"
 #include "../base/Logger.h"
 #include "../base/ObjectCounter.h"
@@ -45,11 +46,17 @@ namespace avg {
 
 bool VideoDecoder::s_bInitialized = false;
 boost::mutex VideoDecoder::s_OpenMutex;
+int VideoDecoder::s_NumCodecThreadsUsed = 0;
+int VideoDecoder::s_NumVideoCodecsOpen = 0;
 
 
 VideoDecoder::VideoDecoder()
     : m_State(CLOSED),
       m_pFormatContext(0),
+      m_bUseSeekIndex(false),
+      m_NumCodecThreadsWanted(1),
+      m_CodecThreadType(SLICE_THREADS),
+      m_NumCodecThreads(0),
       m_VStreamIndex(-1),
       m_pVStream(0),
       m_PF(NO_PIXELFORMAT),
@@ -62,6 +69,13 @@ VideoDecoder::VideoDecoder()
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     initVideoSupport();
+    ConfigMgr* pMgr = ConfigMgr::get();
+    m_bUseSeekIndex = pMgr->getBoolOption("scr", "videoseekindex", false);
+    m_NumCodecThreadsWanted = pMgr->getIntOption("scr", "videocodecthreads", 1);
+    const string* psThreadType = pMgr->getOption("scr", "videothreadtype");
+    if (psThreadType && *psThreadType == "frame") {
+        m_CodecThreadType = FRAME_THREADS;
+    }
 }
 
 VideoDecoder::~VideoDecoder()
@@ -80,7 +94,7 @@ VideoDecoder::~VideoDecoder()
 void VideoDecoder::open(const string& sFilename, bool bUseHardwareAcceleration, 
         bool bEnableSound)
 {
-    lock_guard lock(s_OpenMutex);
+    boost::unique_lock<boost::mutex> lock(s_OpenMutex);
     int err;
     m_sFilename = sFilename;
     
@@ -165,6 +179,12 @@ void VideoDecoder::open(const string& sFilename, bool bUseHardwareAcceleration,
     }
 
     m_State = OPENED;
+    lock.unlock();
+    if (m_pVStream && m_bUseSeekIndex) {
+        // Loaded or built in the background. If the index isn't cached yet, this demuxes
+        // the complete file using a format context of its own.
+        m_pSeekIndex = SeekIndexPtr(new SeekIndex(sFilename, m_VStreamIndex));
+    }
 }
 
 void VideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP)
@@ -200,6 +220,33 @@ void VideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP)
     m_State = DECODING;
 }
 
+void VideoDecoder::enableSeekIndex(bool bEnable)
+{
+    AVG_ASSERT(m_State == CLOSED);
+    m_bUseSeekIndex = bEnable;
+}
+
+void VideoDecoder::waitForSeekIndex()
+{
+    if (m_pSeekIndex) {
+        m_pSeekIndex->waitUntilReady();
+    }
+}
+
+void VideoDecoder::setCodecThreading(int numThreads, CodecThreadType threadType)
+{
+    AVG_ASSERT(m_State == CLOSED);
+    AVG_ASSERT(numThreads >= 0);
+    m_NumCodecThreadsWanted = numThreads;
+    m_CodecThreadType = threadType;
+}
+
+int VideoDecoder::getNumCodecThreads() const
+{
+    AVG_ASSERT(m_State != CLOSED);
+    return max(m_NumCodecThreads, 1);
+}
+
 void VideoDecoder::close() 
 {
     lock_guard lock(s_OpenMutex);
@@ -210,6 +257,7 @@ void VideoDecoder::close()
         avcodec_close(m_pVStream->codec);
         m_pVStream = 0;
         m_VStreamIndex = -1;
+        freeCodecThreads();
     }
 
     if (m_pAStream) {
@@ -217,13 +265,14 @@ void VideoDecoder::close()
         m_pAStream = 0;
         m_AStreamIndex = -1;
     }
+    m_pSeekIndex = SeekIndexPtr();
     if (m_pFormatContext) {
 #if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(53, 21, 0)
         avformat_close_input(&m_pFormatContext);
-#else
-        av_close_input_file(m_pFormatContext);
-        m_pFormatContext = 0;
-#endif
+#else
+        av_close_input_file(m_pFormatContext);
+        m_pFormatContext = 0;
+#endif
     }
     
     m_State = CLOSED;
@@ -294,6 +343,19 @@ void VideoDecoder::logConfig()
         AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
                 "Hardware video acceleration: Off");
     }
+    ConfigMgr* pMgr = ConfigMgr::get();
+    int numThreads = pMgr->getIntOption("scr", "videocodecthreads", 1);
+    const string* psThreadType = pMgr->getOption("scr", "videothreadtype");
+    int maxThreads = pMgr->getIntOption("scr", "maxvideocodecthreads", 0);
+    AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+            "Video codec threads: " << numThreads << " (" << *psThreadType
+            << "), max. total: " << maxThreads);
+}
+
+int VideoDecoder::getNumCodecThreadsUsed()
+{
+    lock_guard lock(s_OpenMutex);
+    return s_NumCodecThreadsUsed;
 }
 
 int VideoDecoder::getNumFrames() const
@@ -369,6 +431,11 @@ AVStream* VideoDecoder::getAudioStream() const
     return m_pAStream;
 }
 
+SeekIndexPtr VideoDecoder::getSeekIndex() const
+{
+    return m_pSeekIndex;
+}
+
 void VideoDecoder::initVideoSupport()
 {
     if (!s_bInitialized) {
@@ -396,6 +463,13 @@ int VideoDecoder::openCodec(int streamIndex, bool bUseHardwareAcceleration)
 #endif
     if (!pCodec) {
         pCodec = avcodec_find_decoder(pContext->codec_id);
+        if (pCodec && streamIndex == m_VStreamIndex) {
+            allocCodecThreads(pContext);
+#ifdef AVG_REFCOUNTED_FRAMES
+            // Lets the decoder thread pass planes on without copying them.
+            pContext->refcounted_frames = 1;
+#endif
+        }
     }
     if (!pCodec) {
         return -1;
@@ -403,11 +477,65 @@ int VideoDecoder::openCodec(int streamIndex, bool bUseHardwareAcceleration)
     int rc = avcodec_open2(pContext, pCodec, 0);
 
     if (rc < 0) {
+        if (streamIndex == m_VStreamIndex) {
+            freeCodecThreads();
+        }
         return -1;
     }
     return 0;
 }
 
+void VideoDecoder::allocCodecThreads(AVCodecContext* pContext)
+{
+    // Called with s_OpenMutex locked. All open video codecs share a budget of
+    // maxvideocodecthreads libavcodec threads so that many concurrent videos don't
+    // oversubscribe the cores. Every codec counts at least one thread, and none gets
+    // more than an equal share of the budget. The thread count of an open codec can't
+    // be changed, so the share is computed from the codecs open at this point.
+    s_NumVideoCodecsOpen++;
+    int numThreads = 1;
+#if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(54, 0, 0)
+    int numCores = max(int(boost::thread::hardware_concurrency()), 1);
+    int maxThreads = ConfigMgr::get()->getIntOption("scr", "maxvideocodecthreads", 0);
+    if (maxThreads <= 0) {
+        maxThreads = numCores;
+    }
+    int numWanted = m_NumCodecThreadsWanted;
+    if (numWanted == 0) {
+        numWanted = numCores;
+    }
+    int share = max(1, maxThreads/s_NumVideoCodecsOpen);
+    numThreads = max(1, min(min(numWanted, share), maxThreads-s_NumCodecThreadsUsed));
+    if (numThreads > 1) {
+        pContext->thread_count = numThreads;
+        if (m_CodecThreadType == FRAME_THREADS) {
+            pContext->thread_type = FF_THREAD_FRAME;
+        } else {
+            pContext->thread_type = FF_THREAD_SLICE;
+        }
+    } else {
+        pContext->thread_count = 1;
+    }
+#endif
+    m_NumCodecThreads = numThreads;
+    s_NumCodecThreadsUsed += numThreads;
+    AVG_TRACE(Logger::category::PLAYER, Logger::severity::DEBUG,
+            m_sFilename << ": " << m_NumCodecThreads << " codec threads, "
+            << s_NumCodecThreadsUsed << " in use by " << s_NumVideoCodecsOpen
+            << " videos.");
+}
+
+void VideoDecoder::freeCodecThreads()
+{
+    // Called with s_OpenMutex locked.
+    if (m_NumCodecThreads > 0) {
+        s_NumCodecThreadsUsed -= m_NumCodecThreads;
+        s_NumVideoCodecsOpen--;
+        AVG_ASSERT(s_NumCodecThreadsUsed >= 0 && s_NumVideoCodecsOpen >= 0);
+    }
+    m_NumCodecThreads = 0;
+}
+
 float VideoDecoder::getDuration(StreamSelect streamSelect) const
 {
     AVG_ASSERT(m_State != CLOSED);
@@ -26,6 +26,7 @@
 #include "../avgconfigwrapper.h"
 
 #include "VideoInfo.h"
+#include "SeekIndex.h"
 
 #include "../graphics/PixelFormat.h"
 
@@ -55,11 +56,20 @@ class AVG_API VideoDecoder
 {
     public:
         enum DecoderState {CLOSED, OPENED, DECODING};
+        enum CodecThreadType {FRAME_THREADS, SLICE_THREADS};
         VideoDecoder();
         virtual ~VideoDecoder();
         virtual void open(const std::string& sFilename, bool bUseHardwareAcceleration, 
                 bool bEnableSound);
         virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP);
+        // Must be called before open(). Defaults to the videoseekindex config option.
+        void enableSeekIndex(bool bEnable);
+        // Blocks until the seek index is loaded or built. Seeks before that don't use it.
+        void waitForSeekIndex();
+        // Must be called before open(). Defaults to the videocodecthreads and
+        // videothreadtype config options. numThreads == 0 uses one thread per core.
+        void setCodecThreading(int numThreads, CodecThreadType threadType);
+        int getNumCodecThreads() const;
         virtual void close();
         virtual DecoderState getState() const;
         VideoInfo getVideoInfo() const;
@@ -82,6 +92,7 @@ class AVG_API VideoDecoder
         virtual void throwAwayFrame(float timeWanted) = 0;
 
         static void logConfig();
+        static int getNumCodecThreadsUsed();
 
     protected:
         int getNumFrames() const;
@@ -95,10 +106,13 @@ class AVG_API VideoDecoder
         AVStream* getVideoStream() const;
         int getAStreamIndex() const;
         AVStream* getAudioStream() const;
+        SeekIndexPtr getSeekIndex() const;
 
     private:
         void initVideoSupport();
         int openCodec(int streamIndex, bool bUseHardwareAcceleration);
+        void allocCodecThreads(AVCodecContext* pContext);
+        void freeCodecThreads();
         float getDuration(StreamSelect streamSelect) const;
         PixelFormat calcPixelFormat(bool bUseYCbCr);
         std::string getStreamPF() const;
@@ -106,6 +120,12 @@ class AVG_API VideoDecoder
         DecoderState m_State;
         AVFormatContext * m_pFormatContext;
         std::string m_sFilename;
+        bool m_bUseSeekIndex;
+        SeekIndexPtr m_pSeekIndex;
+        int m_NumCodecThreadsWanted;
+        CodecThreadType m_CodecThreadType;
+        // 0 if the codec isn't open or doesn't use libavcodec threads (VDPAU).
+        int m_NumCodecThreads;
 
         // Video
         int m_VStreamIndex;
@@ -121,6 +141,10 @@ class AVG_API VideoDecoder
         AVStream * m_pAStream;
         
         static bool s_bInitialized;
+        // libavcodec worker threads in use by all decoders. Single-threaded codecs count
+        // as one.
+        static int s_NumCodecThreadsUsed;
+        static int s_NumVideoCodecsOpen;
         // Prevents different decoder instances from executing open/close simultaneously
         static boost::mutex s_OpenMutex;   
 };
@@ -122,6 +122,10 @@ void VideoDecoderThread::setFPS(float fps)
 
 void VideoDecoderThread::returnFrame(VideoMsgPtr pMsg)
 {
+    if (!pMsg->getFrameBitmap(0)->ownsBits()) {
+        // The planes point into a decoded frame and can't be reused.
+        return;
+    }
     m_pBmpQ->push(pMsg->getFrameBitmap(0));
     if (pixelFormatIsPlanar(m_PF)) {
         m_pHalfBmpQ->push(pMsg->getFrameBitmap(1));
@@ -162,6 +166,7 @@ void VideoDecoderThread::handleSeekDone(VideoMsgPtr pMsg)
     pushMsg(pMsg);
 }
 
+static ProfilingZoneID WrapImageProfilingZone("Wrap image", true);
 static ProfilingZoneID CopyImageProfilingZone("Copy image", true);
 
 void VideoDecoderThread::sendFrame(AVFrame* pFrame)
@@ -173,17 +178,19 @@ void VideoDecoderThread::sendFrame(AVFrame* pFrame)
     } else {
         vector<BitmapPtr> pBmps;
         if (pixelFormatIsPlanar(m_PF)) {
-            ScopeTimer timer(CopyImageProfilingZone);
-            IntPoint halfSize(m_Size.x/2, m_Size.y/2);
-            pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
-            pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
-            pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
-            if (m_PF == YCbCrA420p) {
+            if (!wrapPlanes(pFrame, pBmps)) {
+                ScopeTimer timer(CopyImageProfilingZone);
+                IntPoint halfSize(m_Size.x/2, m_Size.y/2);
                 pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
-            }
-            for (unsigned i = 0; i < pBmps.size(); ++i) {
-                m_pFrameDecoder->copyPlaneToBmp(pBmps[i], pFrame->data[i], 
-                        pFrame->linesize[i]);
+                pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
+                pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
+                if (m_PF == YCbCrA420p) {
+                    pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
+                }
+                for (unsigned i = 0; i < pBmps.size(); ++i) {
+                    m_pFrameDecoder->copyPlaneToBmp(pBmps[i], pFrame->data[i],
+                            pFrame->linesize[i]);
+                }
             }
         } else {
             pBmps.push_back(getBmp(m_pBmpQ, m_Size, m_PF));
@@ -194,6 +201,13 @@ void VideoDecoderThread::sendFrame(AVFrame* pFrame)
     pushMsg(pMsg);
 }
 
+bool VideoDecoderThread::wrapPlanes(AVFrame* pFrame, vector<BitmapPtr>& pBmps)
+{
+    ScopeTimer timer(WrapImageProfilingZone);
+    int numPlanes = (m_PF == YCbCrA420p) ? 4 : 3;
+    return m_pFrameDecoder->wrapFramePlanes(pFrame, m_Size, numPlanes, pBmps);
+}
+
 void VideoDecoderThread::close()
 {
     m_MsgQ.clear();
@@ -61,6 +61,7 @@ class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
         void handleEOF();
         void handleSeekDone(VideoMsgPtr pMsg);
         void sendFrame(AVFrame* pFrame);
+        bool wrapPlanes(AVFrame* pFrame, std::vector<BitmapPtr>& pBmps);
         void close();
         BitmapPtr getBmp(BitmapQueuePtr pBmpQ, const IntPoint& size, PixelFormat pf);
         void pushMsg(VideoMsgPtr pMsg);
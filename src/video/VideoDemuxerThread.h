@@ -25,6 +25,7 @@
 #include "../api.h"
 #include "VideoMsg.h"
 #include "WrapFFMpeg.h"
+#include "SeekIndex.h"
 
 #include "../base/WorkerThread.h"
 #include "../base/Command.h"
@@ -39,7 +40,8 @@ typedef boost::shared_ptr<FFMpegDemuxer> FFMpegDemuxerPtr;
 class AVG_API VideoDemuxerThread: public WorkerThread<VideoDemuxerThread> {
     public:
         VideoDemuxerThread(CQueue& cmdQ, AVFormatContext* pFormatContext, 
-                const std::map<int, VideoMsgQueuePtr>& packetQs);
+                const std::map<int, VideoMsgQueuePtr>& packetQs,
+                SeekIndexPtr pSeekIndex=SeekIndexPtr());
         virtual ~VideoDemuxerThread();
         bool init();
         bool work();
@@ -56,6 +58,7 @@ class AVG_API VideoDemuxerThread: public WorkerThread<VideoDemuxerThread> {
         bool m_bEOF;
         AVFormatContext* m_pFormatContext;
         FFMpegDemuxerPtr m_pDemuxer;
+        SeekIndexPtr m_pSeekIndex;
 };
 
 }
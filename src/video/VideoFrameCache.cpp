@@ -0,0 +1,171 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "VideoFrameCache.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ObjectCounter.h"
+
+#include "../graphics/Bitmap.h"
+
+using namespace std;
+
+namespace avg {
+
+VideoFrameCache::VideoFrameCache(long long maxBytes, OverflowPolicy policy)
+    : m_MaxBytes(maxBytes),
+      m_Policy(policy),
+      m_State(EMPTY),
+      m_MemUsed(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+VideoFrameCache::~VideoFrameCache()
+{
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+void VideoFrameCache::startFilling()
+{
+    clear();
+    m_State = FILLING;
+}
+
+void VideoFrameCache::stopFilling()
+{
+    AVG_ASSERT(m_State == FILLING);
+    clear();
+    m_State = EMPTY;
+}
+
+void VideoFrameCache::addFrame(VideoMsgPtr pFrameMsg)
+{
+    AVG_ASSERT(m_State == FILLING);
+    int memNeeded = 0;
+    for (int i = 0; i < pFrameMsg->getNumFrameBitmaps(); ++i) {
+        memNeeded += pFrameMsg->getFrameBitmap(i)->getMemNeeded();
+    }
+    if (m_MemUsed+memNeeded > m_MaxBytes) {
+        if (m_Policy == DISCARD || m_pFrames.empty()) {
+            AVG_TRACE(Logger::category::PLAYER, Logger::severity::INFO,
+                    "Video frame cache budget of " << float(m_MaxBytes)/(1024*1024) << 
+                    " MB exceeded. Cache disabled.");
+            clear();
+            m_State = DISABLED;
+        } else {
+            AVG_TRACE(Logger::category::PLAYER, Logger::severity::INFO,
+                    "Video frame cache budget of " << float(m_MaxBytes)/(1024*1024) << 
+                    " MB exceeded. Caching first " << m_pFrames.size() << " frames.");
+            m_State = PARTIAL;
+        }
+    } else {
+        m_pFrames.push_back(pFrameMsg);
+        m_MemUsed += memNeeded;
+    }
+}
+
+void VideoFrameCache::setEOF()
+{
+    AVG_ASSERT(m_State == FILLING);
+    if (m_pFrames.empty()) {
+        m_State = EMPTY;
+    } else {
+        m_State = COMPLETE;
+        AVG_TRACE(Logger::category::PLAYER, Logger::severity::INFO,
+                "Video frame cache complete: " << m_pFrames.size() << " frames, " <<
+                float(m_MemUsed)/(1024*1024) << " MB.");
+    }
+}
+
+VideoFrameCache::State VideoFrameCache::getState() const
+{
+    return m_State;
+}
+
+bool VideoFrameCache::isFilling() const
+{
+    return m_State == FILLING;
+}
+
+bool VideoFrameCache::isPlayable() const
+{
+    return m_State == COMPLETE || m_State == PARTIAL;
+}
+
+int VideoFrameCache::getNumFrames() const
+{
+    return int(m_pFrames.size());
+}
+
+VideoMsgPtr VideoFrameCache::getFrame(int i) const
+{
+    AVG_ASSERT(i >= 0 && i < int(m_pFrames.size()));
+    return m_pFrames[i];
+}
+
+int VideoFrameCache::getFrameForTime(float time) const
+{
+    // Binary search for the first frame with frameTime >= time.
+    int lo = 0;
+    int hi = int(m_pFrames.size());
+    while (lo < hi) {
+        int mid = (lo+hi)/2;
+        if (m_pFrames[mid]->getFrameTime() < time) {
+            lo = mid+1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+float VideoFrameCache::getEndTime() const
+{
+    AVG_ASSERT(!m_pFrames.empty());
+    return m_pFrames.back()->getFrameTime();
+}
+
+long long VideoFrameCache::getMemUsed() const
+{
+    return m_MemUsed;
+}
+
+VideoFrameCache::OverflowPolicy VideoFrameCache::stringToPolicy(const string& sPolicy)
+{
+    if (sPolicy == "discard") {
+        return DISCARD;
+    } else if (sPolicy == "keepstart") {
+        return KEEP_START;
+    } else {
+        throw Exception(AVG_ERR_INVALID_ARGS, "Illegal loop cache overflow policy '" +
+                sPolicy + "'. Must be 'discard' or 'keepstart'.");
+    }
+}
+
+void VideoFrameCache::clear()
+{
+    m_pFrames.clear();
+    m_MemUsed = 0;
+}
+
+}
@@ -0,0 +1,84 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _VideoFrameCache_H_
+#define _VideoFrameCache_H_
+
+#include "../api.h"
+#include "VideoMsg.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+// Keeps the decoded frames of the first pass through a video so later loops can be
+// played without demuxing or decoding. Frames are added in display order starting at
+// the beginning of the video. If the memory budget is exceeded, the cache is either
+// discarded or keeps the frames from the start of the video that fit.
+class AVG_API VideoFrameCache {
+    public:
+        enum OverflowPolicy {DISCARD, KEEP_START};
+        enum State {
+            FILLING,   // First pass is running, frames are being added.
+            EMPTY,     // Filling was interrupted, starts again with the next loop.
+            COMPLETE,  // Contains the whole video.
+            PARTIAL,   // Contains the start of the video.
+            DISABLED   // Budget exceeded with DISCARD policy.
+        };
+
+        VideoFrameCache(long long maxBytes, OverflowPolicy policy);
+        virtual ~VideoFrameCache();
+
+        void startFilling();
+        void stopFilling();
+        void addFrame(VideoMsgPtr pFrameMsg);
+        void setEOF();
+
+        State getState() const;
+        bool isFilling() const;
+        bool isPlayable() const;
+        int getNumFrames() const;
+        VideoMsgPtr getFrame(int i) const;
+        // First frame that is not earlier than time.
+        int getFrameForTime(float time) const;
+        float getEndTime() const;
+        long long getMemUsed() const;
+
+        static OverflowPolicy stringToPolicy(const std::string& sPolicy);
+
+    private:
+        void clear();
+
+        long long m_MaxBytes;
+        OverflowPolicy m_Policy;
+        State m_State;
+        std::vector<VideoMsgPtr> m_pFrames;
+        long long m_MemUsed;
+};
+
+typedef boost::shared_ptr<VideoFrameCache> VideoFrameCachePtr;
+
+}
+
+#endif
@@ -78,6 +78,12 @@ BitmapPtr VideoMsg::getFrameBitmap(int i)
     return m_pBmps[i];
 }
 
+int VideoMsg::getNumFrameBitmaps()
+{
+    AVG_ASSERT(getType() == FRAME);
+    return int(m_pBmps.size());
+}
+
 float VideoMsg::getFrameTime()
 {
     AVG_ASSERT(getType() == FRAME || getType() == VDPAU_FRAME);
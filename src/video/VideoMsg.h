@@ -48,6 +48,7 @@ public:
     virtual ~VideoMsg();
 
     BitmapPtr getFrameBitmap(int i);
+    int getNumFrameBitmaps();
     float getFrameTime();
     AVPacket* getPacket();
     void freePacket();
@@ -76,6 +76,11 @@ extern "C" {
   #define AV_CODEC_ID_NONE CODEC_ID_NONE
 #endif
 
+#if LIBAVCODEC_VERSION_MAJOR > 54
+  // Decoded frames can be reference counted (AVCodecContext::refcounted_frames).
+  #define AVG_REFCOUNTED_FRAMES
+#endif
+
 #ifndef URL_WRONLY
         #define url_fopen avio_open
         #define url_fclose avio_close
@@ -0,0 +1,155 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2014 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "AsyncVideoDecoder.h"
+
+#include "../graphics/Bitmap.h"
+#include "../graphics/BitmapLoader.h"
+
+#include "../base/TimeSource.h"
+#include "../base/Exception.h"
+#include "../base/OSHelper.h"
+#include "../base/StringHelper.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+
+using namespace avg;
+using namespace std;
+
+// Decodes a number of videos concurrently without displaying them and reports the
+// frame rate each stream achieves. Usage: benchmarkvideo [numStreams] [filename]
+
+class StreamDecoder {
+public:
+    StreamDecoder(const string& sFilename, int numThreads,
+            VideoDecoder::CodecThreadType threadType)
+        : m_sFilename(sFilename),
+          m_NumThreads(numThreads),
+          m_ThreadType(threadType),
+          m_NumFrames(0),
+          m_FPS(0)
+    {
+    }
+
+    void operator()()
+    {
+        try {
+            decode();
+        } catch (Exception& ex) {
+            cerr << m_sFilename << ": " << ex.getStr() << endl;
+        }
+    }
+
+    int getNumThreads() const
+    {
+        return m_NumThreads;
+    }
+
+    float getFPS() const
+    {
+        return m_FPS;
+    }
+
+private:
+    void decode()
+    {
+        AsyncVideoDecoder decoder(8);
+        decoder.setCodecThreading(m_NumThreads, m_ThreadType);
+        decoder.open(m_sFilename, false, false);
+        m_NumThreads = decoder.getNumCodecThreads();
+        float timePerFrame = 1.0f/decoder.getFPS();
+        decoder.startDecoding(false, 0);
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        float curTime = 0;
+        BitmapPtr pBmp;
+        while (!decoder.isEOF()) {
+            FrameAvailableCode frameAvailable = decoder.getRenderedBmp(pBmp, curTime);
+            if (frameAvailable == FA_NEW_FRAME) {
+                m_NumFrames++;
+            } else {
+                msleep(0);
+            }
+            if (frameAvailable == FA_NEW_FRAME || frameAvailable == FA_USE_LAST_FRAME) {
+                curTime += timePerFrame;
+            }
+        }
+        float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000000.f;
+        m_FPS = m_NumFrames/activeTime;
+        decoder.close();
+    }
+
+    string m_sFilename;
+    int m_NumThreads;
+    VideoDecoder::CodecThreadType m_ThreadType;
+    int m_NumFrames;
+    float m_FPS;
+};
+
+void runConcurrentDecodeTest(const string& sFilename, int numStreams, int numThreads,
+        VideoDecoder::CodecThreadType threadType)
+{
+    vector<StreamDecoder> decoders(numStreams,
+            StreamDecoder(sFilename, numThreads, threadType));
+    boost::thread_group threads;
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    for (int i = 0; i < numStreams; ++i) {
+        threads.create_thread(boost::ref(decoders[i]));
+    }
+    threads.join_all();
+    float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+
+    cerr << numStreams << " streams, " << numThreads << " codec threads ("
+            << (threadType == VideoDecoder::FRAME_THREADS ? "frame" : "slice")
+            << "): " << activeTime << " ms" << endl;
+    float totalFPS = 0;
+    for (int i = 0; i < numStreams; ++i) {
+        cerr << "    Stream " << i << ": " << decoders[i].getFPS() << " fps, "
+                << decoders[i].getNumThreads() << " threads" << endl;
+        totalFPS += decoders[i].getFPS();
+    }
+    cerr << "    Total: " << totalFPS << " fps" << endl;
+}
+
+int main(int nargs, char** args)
+{
+    BitmapLoader::init(true);
+    int numStreams = 4;
+    string sSrcDir;
+    if (!getEnv("srcdir", sSrcDir)) {
+        sSrcDir = ".";
+    }
+    string sFilename = sSrcDir+"/../test/media/mjpeg-48x48.avi";
+    if (nargs > 1) {
+        numStreams = stringToInt(args[1]);
+    }
+    if (nargs > 2) {
+        sFilename = args[2];
+    }
+    runConcurrentDecodeTest(sFilename, numStreams, 1, VideoDecoder::SLICE_THREADS);
+    runConcurrentDecodeTest(sFilename, numStreams, 0, VideoDecoder::SLICE_THREADS);
+    runConcurrentDecodeTest(sFilename, numStreams, 0, VideoDecoder::FRAME_THREADS);
+    return 0;
+}
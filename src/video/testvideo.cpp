@@ -21,6 +21,7 @@
 
 #include "AsyncVideoDecoder.h"
 #include "SyncVideoDecoder.h"
+#include "AudioSampleLoader.h"
 #ifdef AVG_ENABLE_VDPAU
 #include "VDPAUDecoder.h"
 #endif
@@ -37,10 +38,15 @@
 #include "../base/ThreadProfiler.h"
 #include "../base/Directory.h"
 #include "../base/DirEntry.h"
+#include "../base/FileHelper.h"
 
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
 
 #include <glib-object.h>
 
@@ -294,6 +300,175 @@ class VideoDecoderTest: public DecoderTest {
 
 };
 
+class SeekPerfTest: public DecoderTest {
+    public:
+        SeekPerfTest(bool bThreaded, bool bUseHardwareAcceleration)
+            : DecoderTest("SeekPerfTest", bThreaded, bUseHardwareAcceleration)
+        {}
+
+        void runTests()
+        {
+            runSeekTest("mpeg1-48x48.mov");
+#ifndef AVG_ENABLE_RPI
+            runSeekTest("mjpeg-48x48.avi");
+#endif
+        }
+
+    private:
+        void runSeekTest(const string& sFilename)
+        {
+            cerr << "    Testing " << sFilename << endl;
+            string sCacheFilename = SeekIndex::getCacheFilename(getMediaLoc(sFilename));
+            remove(sCacheFilename.c_str());
+
+            vector<BitmapPtr> pBmps;
+            vector<BitmapPtr> pIndexedBmps;
+            float time = seekRandomly(sFilename, false, pBmps);
+            float indexedTime = seekRandomly(sFilename, true, pIndexedBmps);
+            // Loaded from the cache file written by the decoder.
+            SeekIndex index(getMediaLoc(sFilename), 0);
+            index.waitUntilReady();
+            cerr << "      Without index: " << time << " ms/seek, with index: " <<
+                    indexedTime << " ms/seek" << endl;
+            if (index.isValid()) {
+                int numFrames = index.getNumFrames();
+                int numFramesDecoded = 0;
+                for (int i = 0; i < numFrames; ++i) {
+                    numFramesDecoded += i-index.getKeyFrame(i);
+                }
+                cerr << "      Frames decoded before target frame: " <<
+                        float(numFramesDecoded)/numFrames << " on average." << endl;
+            }
+            for (unsigned i = 0; i < pBmps.size(); ++i) {
+                testEqual(*pIndexedBmps[i], *pBmps[i], sFilename+"_seek", 0, 0);
+            }
+            // A damaged cache file is ignored and the index is built again.
+            writeWholeFile(sCacheFilename, "AVGSEEKINDEX");
+            SeekIndex rebuiltIndex(getMediaLoc(sFilename), 0);
+            rebuiltIndex.waitUntilReady();
+            TEST(rebuiltIndex.getNumFrames() == index.getNumFrames());
+            remove(sCacheFilename.c_str());
+        }
+
+        float seekRandomly(const string& sFilename, bool bUseSeekIndex,
+                vector<BitmapPtr>& pBmps)
+        {
+            const int NUM_SEEKS = 50;
+            VideoDecoderPtr pDecoder = createDecoder();
+            pDecoder->enableSeekIndex(bUseSeekIndex);
+            pDecoder->open(getMediaLoc(sFilename), useHardwareAcceleration(), false);
+            pDecoder->startDecoding(false, 0);
+            pDecoder->waitForSeekIndex();
+            int numFrames = pDecoder->getVideoInfo().m_NumFrames;
+            srand(1);
+            long long startTime = TimeSource::get()->getCurrentMicrosecs();
+            for (int i = 0; i < NUM_SEEKS; ++i) {
+                int frameNum = rand()%numFrames;
+                pDecoder->seek(float(frameNum)/pDecoder->getStreamFPS());
+                BitmapPtr pBmp;
+                pDecoder->getRenderedBmp(pBmp, -1);
+                pBmps.push_back(BitmapPtr(new Bitmap(*pBmp)));
+            }
+            long long endTime = TimeSource::get()->getCurrentMicrosecs();
+            pDecoder->close();
+            return float(endTime-startTime)/(NUM_SEEKS*1000);
+        }
+};
+
+class CodecThreadTest: public DecoderTest {
+    public:
+        CodecThreadTest()
+            : DecoderTest("CodecThreadTest", true, false)
+        {}
+
+        void runTests()
+        {
+            // Decoders that want one thread per core share the cores. Each gets at
+            // least one thread.
+            int numCores = max(int(boost::thread::hardware_concurrency()), 1);
+            int numThreadsUsed = VideoDecoder::getNumCodecThreadsUsed();
+            vector<VideoDecoderPtr> pDecoders;
+            int numThreads = 0;
+            for (int i = 0; i < 3; ++i) {
+                VideoDecoderPtr pDecoder = createDecoder();
+                pDecoder->setCodecThreading(0, VideoDecoder::SLICE_THREADS);
+                pDecoder->open(getMediaLoc("mpeg1-48x48.mov"), false, false);
+                int numDecoderThreads = pDecoder->getNumCodecThreads();
+                TEST(numDecoderThreads >= 1 &&
+                        numDecoderThreads <= max(numCores/(i+1), 1));
+                numThreads += numDecoderThreads;
+                pDecoders.push_back(pDecoder);
+            }
+            TEST(numThreads <= max(numCores, 3));
+            TEST(VideoDecoder::getNumCodecThreadsUsed() == numThreadsUsed+numThreads);
+            for (unsigned i = 0; i < pDecoders.size(); ++i) {
+                pDecoders[i]->close();
+            }
+            TEST(VideoDecoder::getNumCodecThreadsUsed() == numThreadsUsed);
+        }
+};
+
+class LoopCacheTest: public DecoderTest {
+    public:
+        LoopCacheTest()
+            : DecoderTest("LoopCacheTest", true, false)
+        {}
+
+        void runTests()
+        {
+            // Each frame of the 30-frame test video needs 48*48*4 bytes.
+            runLoopTest(1024*1024, VideoFrameCache::DISCARD, VideoFrameCache::COMPLETE);
+            runLoopTest(100000, VideoFrameCache::KEEP_START, VideoFrameCache::PARTIAL);
+            runLoopTest(100000, VideoFrameCache::DISCARD, VideoFrameCache::DISABLED);
+        }
+
+    private:
+        void runLoopTest(long long maxBytes, VideoFrameCache::OverflowPolicy policy,
+                VideoFrameCache::State expectedState)
+        {
+            string sFilename("mpeg1-48x48.mov");
+            AsyncVideoDecoderPtr pDecoder(new AsyncVideoDecoder(8));
+            pDecoder->enableLoopCache(maxBytes, policy);
+            pDecoder->open(getMediaLoc(sFilename), false, false);
+            pDecoder->startDecoding(false, 0);
+            vector<BitmapPtr> pBmps;
+            readFrames(pDecoder, pBmps);
+            VideoFrameCachePtr pCache = pDecoder->getLoopCache();
+            TEST(pCache->getState() == expectedState);
+
+            pDecoder->loop();
+            // Give the decoder time to prepare the frames after a partial cache.
+            msleep(100);
+            vector<BitmapPtr> pLoopBmps;
+            readFrames(pDecoder, pLoopBmps);
+            TEST(pLoopBmps.size() == pBmps.size());
+            for (unsigned i = 0; i < pLoopBmps.size() && i < pBmps.size(); ++i) {
+                testEqual(*pLoopBmps[i], *pBmps[i], sFilename+"_loopcache");
+            }
+            pDecoder->close();
+        }
+
+        void readFrames(AsyncVideoDecoderPtr pDecoder, vector<BitmapPtr>& pBmps)
+        {
+            float timePerFrame = 1.0f/pDecoder->getFPS();
+            float curTime = 0;
+            BitmapPtr pBmp;
+            while (!pDecoder->isEOF()) {
+                FrameAvailableCode frameAvailable =
+                        pDecoder->getRenderedBmp(pBmp, curTime);
+                if (frameAvailable == FA_NEW_FRAME) {
+                    pBmps.push_back(pBmp);
+                } else {
+                    msleep(0);
+                }
+                if (frameAvailable == FA_NEW_FRAME || frameAvailable == FA_USE_LAST_FRAME)
+                {
+                    curTime += timePerFrame;
+                }
+            }
+        }
+};
+
 class AudioDecoderTest: public DecoderTest {
     public:
         AudioDecoderTest()
@@ -403,6 +578,140 @@ class AudioDecoderTest: public DecoderTest {
 };
 
 
+class AudioSampleLoaderTest: public DecoderTest {
+    public:
+        AudioSampleLoaderTest()
+          : DecoderTest("AudioSampleLoaderTest", true, false)
+        {}
+
+        void runTests()
+        {
+            testOneFile("44.1kHz_16bit_mono.wav");
+            testOneFile("48kHz_16bit_stereo.wav");
+            testOneFile("44.1kHz_stereo.mp3");
+            measureStartLatency("44.1kHz_16bit_stereo.wav");
+        }
+
+    private:
+        void testOneFile(const string& sFilename)
+        {
+            cerr << "    Testing " << sFilename << endl;
+            AudioBufferPtr pSample = loadAudioSample(getMediaLoc(sFilename),
+                    *getAudioParams());
+            TEST(pSample->getNumChannels() == 2);
+            TEST(pSample->getRate() == 44100);
+
+            AsyncVideoDecoderPtr pDecoder = 
+                    dynamic_pointer_cast<AsyncVideoDecoder>(createDecoder());
+            pDecoder->open(getMediaLoc(sFilename), false, true);
+            int framesInDuration = int(pDecoder->getVideoInfo().m_Duration*44100);
+            pDecoder->close();
+            if (sFilename.find(".mp3") == string::npos) {
+                TEST(abs(pSample->getNumFrames()-framesInDuration) < 65);
+            } else {
+                TEST(pSample->getNumFrames() > framesInDuration/2);
+            }
+        }
+
+        // Time from opening a file until the first decoded audio arrives. This is the
+        // startup delay of a SoundNode that samples avoid.
+        void measureStartLatency(const string& sFilename)
+        {
+            const int NUM_RUNS = 10;
+            vector<long long> latencies;
+            for (int i = 0; i < NUM_RUNS; ++i) {
+                long long startTime = TimeSource::get()->getCurrentMicrosecs();
+                AsyncVideoDecoderPtr pDecoder = 
+                        dynamic_pointer_cast<AsyncVideoDecoder>(createDecoder());
+                pDecoder->open(getMediaLoc(sFilename), false, true);
+                pDecoder->startDecoding(false, getAudioParams());
+                AudioMsgPtr pMsg = pDecoder->getAudioMsgQ()->pop(true);
+                latencies.push_back(TimeSource::get()->getCurrentMicrosecs()-startTime);
+                TEST(pMsg->getType() == AudioMsg::AUDIO);
+                pDecoder->close();
+            }
+            sort(latencies.begin(), latencies.end());
+            cerr << "      Decoder start latency (us) median: " << 
+                    latencies[NUM_RUNS/2] << ", max: " << latencies.back() << endl;
+        }
+};
+
+
+class AudioDecodeBenchmark: public DecoderTest {
+    public:
+        AudioDecodeBenchmark()
+          : DecoderTest("AudioDecodeBenchmark", true, false)
+        {}
+
+        void runTests()
+        {
+            // Needs no conversion, needs resampling, needs decoding + resampling.
+            runBenchmark("44.1kHz_16bit_stereo.wav");
+            runBenchmark("48kHz_16bit_stereo.wav");
+            runBenchmark("48kHz_stereo.mp3");
+        }
+
+    private:
+        void runBenchmark(const string& sFilename)
+        {
+            cerr << "    Testing " << sFilename << endl;
+            const char* sQualities[] = {"low", "medium", "high"};
+            for (int quality = AudioParams::RESAMPLE_LOW; 
+                    quality <= AudioParams::RESAMPLE_HIGH; ++quality)
+            {
+                float cpuTime = decodeStreams(sFilename,
+                        AudioParams::ResampleQuality(quality));
+                cerr << "      Quality " << sQualities[quality] << ": " << cpuTime << 
+                        " ms CPU time per second of audio" << endl;
+            }
+        }
+
+        // Decodes NUM_STREAMS copies of the file in parallel, like a scene with many
+        // sound effects. Returns the CPU time spent in all threads.
+        float decodeStreams(const string& sFilename, AudioParams::ResampleQuality quality)
+        {
+            const int NUM_STREAMS = 20;
+            AudioParams ap(44100, 2, 256, quality);
+            vector<AsyncVideoDecoderPtr> pDecoders;
+            for (int i = 0; i < NUM_STREAMS; ++i) {
+                AsyncVideoDecoderPtr pDecoder = 
+                        dynamic_pointer_cast<AsyncVideoDecoder>(createDecoder());
+                pDecoder->open(getMediaLoc(sFilename), false, true);
+                pDecoders.push_back(pDecoder);
+            }
+            float duration = pDecoders[0]->getVideoInfo().m_Duration;
+
+            clock_t startTime = clock();
+            for (int i = 0; i < NUM_STREAMS; ++i) {
+                pDecoders[i]->startDecoding(false, &ap);
+            }
+            int totalFramesDecoded = 0;
+            bool bAllEOF = false;
+            while (!bAllEOF) {
+                bAllEOF = true;
+                for (int i = 0; i < NUM_STREAMS; ++i) {
+                    AsyncVideoDecoderPtr pDecoder = pDecoders[i];
+                    if (!pDecoder->isEOF()) {
+                        bAllEOF = false;
+                        int framesDecoded = processAudioMsg(pDecoder->getAudioMsgQ(),
+                                pDecoder->getAudioStatusQ());
+                        AVG_ASSERT(framesDecoded != -1);
+                        totalFramesDecoded += framesDecoded;
+                        pDecoder->updateAudioStatus();
+                    }
+                }
+                msleep(0);
+            }
+            clock_t endTime = clock();
+            for (int i = 0; i < NUM_STREAMS; ++i) {
+                pDecoders[i]->close();
+            }
+            TEST(totalFramesDecoded > 0);
+            return float(endTime-startTime)*1000/CLOCKS_PER_SEC/(duration*NUM_STREAMS);
+        }
+};
+
+
 class AVDecoderTest: public DecoderTest {
     public:
         AVDecoderTest(bool bUseHardwareAcceleration)
@@ -480,6 +789,8 @@ public:
     {
         addAudioTests();
         addVideoTests(false);
+        addTest(TestPtr(new LoopCacheTest()));
+        addTest(TestPtr(new CodecThreadTest()));
         
 #ifdef AVG_ENABLE_VDPAU
         if (VDPAUDecoder::isAvailable()) {
@@ -496,12 +807,16 @@ private:
     void addAudioTests()
     {
         addTest(TestPtr(new AudioDecoderTest()));
+        addTest(TestPtr(new AudioSampleLoaderTest()));
+        addTest(TestPtr(new AudioDecodeBenchmark()));
     }
 
     void addVideoTests(bool bUseHardwareAcceleration)
     {
         addTest(TestPtr(new VideoDecoderTest(false, bUseHardwareAcceleration)));
         addTest(TestPtr(new VideoDecoderTest(true, bUseHardwareAcceleration)));
+        addTest(TestPtr(new SeekPerfTest(false, bUseHardwareAcceleration)));
+        addTest(TestPtr(new SeekPerfTest(true, bUseHardwareAcceleration)));
 
         addTest(TestPtr(new AVDecoderTest(bUseHardwareAcceleration)));
     }
@@ -60,6 +60,10 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(TestHelper_fakeTouchEvent_overloads,
         fakeTouchEvent, 4, 5)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Player_createNode_overloads,
         createNode, 2, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Player_createAudioBus_overloads,
+        createAudioBus, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Player_playAudioSample_overloads,
+        playAudioSample, 1, 4)
 
 OffscreenCanvasPtr createCanvas(const boost::python::tuple &args,
                 const boost::python::dict& params)
@@ -230,6 +234,10 @@ BOOST_PYTHON_MODULE(avg)
             .def("setOGLOptions", &Player::setOGLOptions)
             .def("setMultiSampleSamples", &Player::setMultiSampleSamples)
             .def("enableGLErrorChecks", &Player::enableGLErrorChecks)
+            .def("enableDrawBatching", &Player::enableDrawBatching)
+            .def("enableTextureAtlas", &Player::enableTextureAtlas)
+            .def("enableAsyncTextureUploads", &Player::enableAsyncTextureUploads)
+            .def("setTextureUploadBudget", &Player::setTextureUploadBudget)
             .def("getScreenResolution", &Player::getScreenResolution)
             .def("getPixelsPerMM", &Player::getPixelsPerMM)
             .def("getPhysicalScreenDimensions", &Player::getPhysicalScreenDimensions)
@@ -283,6 +291,9 @@ BOOST_PYTHON_MODULE(avg)
             .def("getVideoRefreshRate", &Player::getVideoRefreshRate)
             .def("getVideoMemInstalled", &Player::getVideoMemInstalled)
             .def("getVideoMemUsed", &Player::getVideoMemUsed)
+            .def("getNumAtlasedTextures", &Player::getNumAtlasedTextures)
+            .def("getTextureAtlasOccupancy", &Player::getTextureAtlasOccupancy)
+            .def("getNumPendingTextureUploads", &Player::getNumPendingTextureUploads)
             .def("setGamma", &Player::setGamma)
             .def("setMousePos", &Player::setMousePos)
             .def("loadPlugin", &Player::loadPlugin)
@@ -291,6 +302,22 @@ BOOST_PYTHON_MODULE(avg)
             .def("getConfigOption", &Player::getConfigOption)
             .def("isUsingGLES", &Player::isUsingGLES)
             .def("areFullShadersSupported", &Player::areFullShadersSupported)
+            .def("areAsyncTextureUploadsSupported",
+                    &Player::areAsyncTextureUploadsSupported)
+            .def("createAudioBus", &Player::createAudioBus,
+                    Player_createAudioBus_overloads())
+            .def("removeAudioBus", &Player::removeAudioBus)
+            .def("setAudioBusGain", &Player::setAudioBusGain)
+            .def("getAudioBusGain", &Player::getAudioBusGain)
+            .def("setAudioBusLimiter", &Player::setAudioBusLimiter)
+            .def("setAudioBusChannelMap", &Player::setAudioBusChannelMap)
+            .def("loadAudioSample", &Player::loadAudioSample)
+            .def("unloadAudioSample", &Player::unloadAudioSample)
+            .def("playAudioSample", &Player::playAudioSample,
+                    Player_playAudioSample_overloads())
+            .def("stopAudioVoice", &Player::stopAudioVoice)
+            .def("setMaxAudioVoices", &Player::setMaxAudioVoices)
+            .def("getMaxAudioVoices", &Player::getMaxAudioVoices)
             .add_property("pluginPath", &Player::getPluginPath, &Player::setPluginPath)
             .add_property("volume", &Player::getVolume, &Player::setVolume)
         ;
@@ -301,6 +328,10 @@ BOOST_PYTHON_MODULE(avg)
             .def("getRootNode", &Canvas::getRootNode)
             .def("getElementByID", &Canvas::getElementByID)
             .def("screenshot", &Canvas::screenshot)
+            .def("getNumPreRenderedNodes", &Canvas::getNumPreRenderedNodes)
+            .def("getNumSkippedPreRenderNodes", &Canvas::getNumSkippedPreRenderNodes)
+            .def("getNumDrawCalls", &Canvas::getNumDrawCalls)
+            .def("getNumStateChanges", &Canvas::getNumStateChanges)
         ;
 
         class_<OffscreenCanvas, boost::shared_ptr<OffscreenCanvas>, bases<Canvas>,
@@ -242,6 +242,8 @@ void export_event()
         .def("getDisplayROISize", &TrackerInputDevice::getDisplayROISize)
         .def("saveConfig", &TrackerInputDevice::saveConfig)
         .def("resetHistory", &TrackerInputDevice::resetHistory)
+        .def("startCameraRecording", &TrackerInputDevice::startCameraRecording)
+        .def("stopCameraRecording", &TrackerInputDevice::stopCameraRecording)
         .def("setDebugImages", &TrackerInputDevice::setDebugImages)
         .def("startCalibration", &TrackerInputDevice::startCalibration,
             return_value_policy<reference_existing_object>())
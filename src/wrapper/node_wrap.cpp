@@ -194,6 +194,8 @@ void export_node()
         .add_property("loop", &SoundNode::getLoop)
         .add_property("duration", &SoundNode::getDuration)
         .add_property("volume", &SoundNode::getVolume, &SoundNode::setVolume)
+        .add_property("pan", &SoundNode::getPan, &SoundNode::setPan)
+        .add_property("audiobus", &SoundNode::getAudioBus, &SoundNode::setAudioBus)
     ;
 
     class_<VectorNode, bases<Node>, boost::noncopyable>("VectorNode", 
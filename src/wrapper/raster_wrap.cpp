@@ -171,6 +171,8 @@ void export_raster()
         .def("pause", &VideoNode::pause)
         .def("getNumFrames", &VideoNode::getNumFrames)
         .def("getNumFramesQueued", &VideoNode::getNumFramesQueued)
+        .def("getNumLoopCacheFrames", &VideoNode::getNumLoopCacheFrames)
+        .def("getNumFramesFromLoopCache", &VideoNode::getNumFramesFromLoopCache)
         .def("getCurFrame", &VideoNode::getCurFrame)
         .def("seekToFrame", &VideoNode::seekToFrame)
         .def("getStreamPixelFormat", &VideoNode::getStreamPixelFormat)
@@ -192,12 +194,18 @@ void export_raster()
         .staticmethod("getVideoAccelConfig")
         .add_property("fps", &VideoNode::getFPS)
         .add_property("queuelength", &VideoNode::getQueueLength)
+        .add_property("loopcachesize", &VideoNode::getLoopCacheSize)
+        .add_property("loopcacheoverflow",
+                make_function(&VideoNode::getLoopCacheOverflow,
+                        return_value_policy<copy_const_reference>()))
         .add_property("href", 
                 make_function(&VideoNode::getHRef,
                         return_value_policy<copy_const_reference>()),
                 &VideoNode::setHRef)
         .add_property("loop", &VideoNode::getLoop)
         .add_property("volume", &VideoNode::getVolume, &VideoNode::setVolume)
+        .add_property("pan", &VideoNode::getPan, &VideoNode::setPan)
+        .add_property("audiobus", &VideoNode::getAudioBus, &VideoNode::setAudioBus)
         .add_property("threaded", &VideoNode::isThreaded)
         .add_property("accelerated", &VideoNode::isAccelerated)
     ;